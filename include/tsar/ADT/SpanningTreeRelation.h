@@ -27,9 +27,15 @@
 #define TSAR_SPANNING_TREE_RELATION_H
 
 #include "GraphNumbering.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/Support/MathExtras.h>
+#include <memory>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace tsar {
 /// Represents node relation in a tree.
@@ -44,36 +50,212 @@ enum TreeRelation : int8_t {
   NUMBER_TR = INVALID_TR
 };
 
-/// This determine relation between two nodes in a spanning tree.
+/// Numbers of a node in a spanning tree.
+struct SpanningTreeNumber {
+  /// Number of a node in preorder traversal of a tree.
+  unsigned Preorder = 0;
+  /// Number of a node in postorder traversal of a tree.
+  unsigned Postorder = 0;
+  /// Position of the first occurrence of a node in the Euler tour of a tree.
+  unsigned EulerTour = 0;
+};
+
+/// \brief Euler tour of a spanning tree.
+///
+/// This also contains a sparse table which is built over depths of nodes in
+/// the tour. It allows us to find the lowest common ancestor of two nodes
+/// in a constant time. Numbers of nodes are stored outside this class.
+template<class NodeRef> class SpanningTreeNumbering {
+public:
+  /// \brief Calculates numbers of all nodes in a tree with a specified root.
+  ///
+  /// Children of a node are accessed with GraphTraits `GT`. Numbers of a node
+  /// are stored to a storage returned by a `GetNumber(NodeRef)` call. It
+  /// returns a pair, the second value is `false` if the node has been
+  /// already visited (so the first value will be ignored).
+  template<class GT, class GetNumberT>
+  void build(NodeRef Root, GetNumberT &&GetNumber) {
+    using ChildItrT = typename GT::ChildIteratorType;
+    mTour.clear();
+    mDepth.clear();
+    mTable.clear();
+    std::vector<std::tuple<NodeRef, ChildItrT, SpanningTreeNumber *>> Stack;
+    unsigned Preorder = 0, Postorder = 0;
+    auto visit = [this, &Stack, &Preorder, &GetNumber](NodeRef N) {
+      auto Number = GetNumber(N);
+      if (!Number.second)
+        return;
+      Number.first->Preorder = Preorder++;
+      Number.first->EulerTour = mTour.size();
+      mTour.push_back(N);
+      mDepth.push_back(Stack.size());
+      Stack.emplace_back(N, GT::child_begin(N), Number.first);
+    };
+    visit(Root);
+    while (!Stack.empty()) {
+      auto &ChildItr = std::get<1>(Stack.back());
+      if (ChildItr != GT::child_end(std::get<0>(Stack.back()))) {
+        NodeRef Child = *ChildItr;
+        ++ChildItr;
+        visit(Child);
+        continue;
+      }
+      std::get<2>(Stack.back())->Postorder = Postorder++;
+      Stack.pop_back();
+      if (!Stack.empty()) {
+        mTour.push_back(std::get<0>(Stack.back()));
+        mDepth.push_back(Stack.size() - 1);
+      }
+    }
+    // The K-th row contains positions of the least deep nodes in subsequences
+    // of the tour of length 2^(K+1).
+    for (unsigned K = 0, Length = 2; Length <= mTour.size(); ++K, Length *= 2) {
+      mTable.emplace_back(mTour.size() - Length + 1);
+      auto &Row = mTable.back();
+      for (unsigned I = 0, EI = Row.size(); I < EI; ++I)
+        Row[I] = K == 0 ? least(I, I + 1) :
+          least(mTable[K - 1][I], mTable[K - 1][I + Length / 2]);
+    }
+  }
+
+  /// Returns true if numbering has not been calculated yet.
+  bool empty() const noexcept { return mTour.empty(); }
+
+  /// Returns a node at a specified position in the Euler tour.
+  NodeRef getNode(unsigned Position) const {
+    assert(Position < mTour.size() && "Position is out of range!");
+    return mTour[Position];
+  }
+
+  /// Returns the lowest common ancestor of nodes with specified numbers.
+  NodeRef findLCA(const SpanningTreeNumber &LHS,
+      const SpanningTreeNumber &RHS) const {
+    auto First = LHS.EulerTour, Last = RHS.EulerTour;
+    if (First > Last)
+      std::swap(First, Last);
+    if (First == Last)
+      return mTour[First];
+    auto K = llvm::Log2_32(Last - First + 1);
+    return mTour[least(mTable[K - 1][First],
+      mTable[K - 1][Last - (1u << K) + 1])];
+  }
+
+private:
+  /// Returns a position of the least deep node from nodes at specified
+  /// positions in the tour.
+  unsigned least(unsigned LHS, unsigned RHS) const {
+    return mDepth[LHS] <= mDepth[RHS] ? LHS : RHS;
+  }
+
+  std::vector<NodeRef> mTour;
+  std::vector<unsigned> mDepth;
+  std::vector<std::vector<unsigned>> mTable;
+};
+
+/// \brief Storage of numbers of nodes in a spanning tree.
+///
+/// This class should be specialized by graphs which store numbers of
+/// nodes in some special way. The following elements should be provided:
+/// - typedef NumberingT - Type of numbering of a graph which provides the
+///     same interface as SpanningTreeNumbering.
+/// - static std::shared_ptr<const NumberingT> getNumbering(const GraphType &)
+///     - Returns numbering of a graph, it should be calculated if necessary.
+/// - static const SpanningTreeNumber & getNumber(NodeRef, const NumberingT &)
+///     - Returns numbers of a specified node.
+///
+/// The default implementation calculates numbering for each relation and
+/// stores numbers of nodes in a map.
+template<class GraphType> struct SpanningTreeTraits {
+  using GT = llvm::GraphTraits<GraphType>;
+  using NodeRef = typename GT::NodeRef;
+
+  struct NumberingT : public SpanningTreeNumbering<NodeRef> {
+    llvm::DenseMap<NodeRef, SpanningTreeNumber> Numbers;
+  };
+
+  static std::shared_ptr<const NumberingT> getNumbering(const GraphType &G) {
+    auto Numbering = std::make_shared<NumberingT>();
+    auto &Numbers = Numbering->Numbers;
+    // Pointers to numbers must not be invalidated when the map grows.
+    Numbers.reserve(GT::size(G));
+    Numbering->template build<GT>(GT::getEntryNode(G),
+      [&Numbers](NodeRef N) {
+        auto Pair = Numbers.try_emplace(N);
+        return std::make_pair(&Pair.first->second, Pair.second);
+      });
+    return Numbering;
+  }
+
+  static const SpanningTreeNumber & getNumber(NodeRef N,
+      const NumberingT &Numbering) {
+    auto I = Numbering.Numbers.find(N);
+    assert(I != Numbering.Numbers.end() &&
+      "Node must be a node of a spanning tree!");
+    return I->second;
+  }
+};
+
+/// \brief Storage of numbers of nodes in a tree which are stored in nodes.
+///
+/// Numbering of nodes is calculated once and it is shared between relations
+/// until a tree is changed. A tree `TreeT` should contain a mutable member
+/// `mSpanningTree` of type std::shared_ptr<SpanningTreeNumbering<NodeT *>>.
+/// The tree must reset this member on each change of its structure.
+/// A node `NodeT` should contain a mutable member `mSpanningTreeNumber`
+/// of type SpanningTreeNumber. These members should be accessible from this
+/// class.
+template<class GraphType, class TreeT, class NodeT>
+struct IntrusiveSpanningTreeTraits {
+  using NodeRef = typename llvm::GraphTraits<GraphType>::NodeRef;
+  using NumberingT = SpanningTreeNumbering<NodeT *>;
+
+  static std::shared_ptr<const NumberingT> getNumbering(const GraphType &G) {
+    using GT = llvm::GraphTraits<NodeT *>;
+    const TreeT *T = G;
+    if (!T->mSpanningTree) {
+      T->mSpanningTree = std::make_shared<NumberingT>();
+      T->mSpanningTree->template build<GT>(
+        const_cast<NodeT *>(T->getTopLevelNode()), [](NodeT *N) {
+          return std::make_pair(&N->mSpanningTreeNumber, true);
+        });
+    }
+    return T->mSpanningTree;
+  }
+
+  static const SpanningTreeNumber & getNumber(NodeRef N,
+      const NumberingT &Numbering) {
+    assert(Numbering.getNode(N->mSpanningTreeNumber.EulerTour) == N &&
+      "Node must be a node of a spanning tree, has the tree been changed?");
+    return N->mSpanningTreeNumber;
+  }
+};
+
+/// \brief This determine relation between two nodes in a spanning tree.
+///
+/// Numbering of nodes should be recalculated if a graph is changed, so
+/// a relation must not be used after a change of a graph.
 template<class GraphType>
 class SpanningTreeRelation {
   using NodeRef = typename llvm::GraphTraits<GraphType>::NodeRef;
+  using STT = SpanningTreeTraits<GraphType>;
+  using NumberingT = typename STT::NumberingT;
 public:
 
   /// Performs initialization to determine relation of two nodes.
-  explicit SpanningTreeRelation(const GraphType &G) {
-    numberGraph(G, &mNumbering);
-  }
+  explicit SpanningTreeRelation(const GraphType &G) :
+    mNumbering(STT::getNumbering(G)) {}
 
   /// Determines relation between two nodes in a spanning tree.
   TreeRelation compare(NodeRef LHS, NodeRef RHS) const {
     if (LHS == RHS)
       return TR_EQUAL;
-    auto LeftItr = mNumbering.find(LHS);
-    auto RightItr = mNumbering.find(RHS);
-    assert(LeftItr != mNumbering.end() &&
-      "LHS must be a node of a spanning tree!");
-    assert(RightItr != mNumbering.end() &&
-      "RHS must be a node of a spanning tree!");
-    if (LeftItr->template get<Preorder>() <
-            RightItr->template get<Preorder>() &&
-        LeftItr->template get<ReversePostorder>() <
-            RightItr->template get<ReversePostorder>())
+    auto &LeftNumber = STT::getNumber(LHS, *mNumbering);
+    auto &RightNumber = STT::getNumber(RHS, *mNumbering);
+    if (LeftNumber.Preorder < RightNumber.Preorder &&
+        LeftNumber.Postorder > RightNumber.Postorder)
       return TR_ANCESTOR;
-    if (LeftItr->template get<Preorder>() >
-            RightItr->template get<Preorder>() &&
-      LeftItr->template get<ReversePostorder>() >
-            RightItr->template get<ReversePostorder>())
+    if (LeftNumber.Preorder > RightNumber.Preorder &&
+        LeftNumber.Postorder < RightNumber.Postorder)
       return TR_DESCENDANT;
     return TR_UNREACHABLE;
   }
@@ -97,8 +279,19 @@ public:
     return compare(LHS, RHS) == TR_UNREACHABLE;
   }
 
+  /// \brief Returns the lowest common ancestor of two nodes in a constant
+  /// time.
+  ///
+  /// The result may be equal to one of specified nodes.
+  NodeRef getLCA(NodeRef LHS, NodeRef RHS) const {
+    if (LHS == RHS)
+      return LHS;
+    return mNumbering->findLCA(STT::getNumber(LHS, *mNumbering),
+      STT::getNumber(RHS, *mNumbering));
+  }
+
 private:
-  GraphNumbering<NodeRef> mNumbering;
+  std::shared_ptr<const NumberingT> mNumbering;
 };
 
 /// \brief Returns a parent of a specified node in a spanning tree of a graph.
@@ -143,37 +336,19 @@ llvm::Optional<
     const SpanningTreeRelation<GraphType> &STR, ItrTy BeginItr, ItrTy EndItr) {
   assert(BeginItr != EndItr &&
     "At least one node must be in a iterator range!");
-  using STRTy = SpanningTreeRelation<GraphType>;
   using GT = llvm::GraphTraits<GraphType>;
   using IGT = llvm::GraphTraits<llvm::Inverse<GraphType>>;
   using NodeRef = typename IGT::NodeRef;
   static_assert(std::is_assignable<typename GT::NodeRef, NodeRef>::value ||
     std::is_convertible<NodeRef, typename GT::NodeRef>::value,
     "NodeRef of a graph must be assignable from NodeRef of an inverse graph!");
-  auto Parent = findParent(*BeginItr, STR);
-  if (!Parent.hasValue())
-    return llvm::None;
-  NodeRef LCA = *Parent;
+  NodeRef LCA = *BeginItr;
   auto CurrItr = BeginItr;
-  for (++CurrItr; CurrItr != EndItr; ++CurrItr) {
-    auto R = STR.compare(LCA, *CurrItr);
-    for (; R == TR_UNREACHABLE || R == TR_EQUAL;
-           R = STR.compare(LCA, *CurrItr)) {
-      auto Parent = findParent(LCA, STR);
-      if (!Parent.hasValue())
-        return llvm::None;
-      LCA = *Parent;
-    }
-    switch (R) {
-    case TR_ANCESTOR: break;
-    case TR_DESCENDANT:
-      auto Parent = findParent(*CurrItr, STR);
-      if (!Parent.hasValue())
-        return llvm::None;
-      LCA = *Parent;
-      break;
-    }
-  }
+  for (++CurrItr; CurrItr != EndItr; ++CurrItr)
+    LCA = STR.getLCA(LCA, *CurrItr);
+  for (CurrItr = BeginItr; CurrItr != EndItr; ++CurrItr)
+    if (STR.isEqual(LCA, *CurrItr))
+      return findParent(LCA, STR);
   return LCA;
 }
 }
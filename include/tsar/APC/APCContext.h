@@ -30,6 +30,8 @@
 #include "tsar/Support/Tags.h"
 #include <apc/apc-config.h>
 #include <bcl/utility.h>
+#include <llvm/ADT/StringRef.h>
+#include <utility>
 
 struct FuncInfo;
 struct FuncParam;
@@ -81,8 +83,27 @@ public:
   void initialize();
 
   /// Returns default region which is a whole program.
+  ///
+  /// If optimization regions are specified, the default region contains
+  /// loops which are not located in any of these regions.
   ParallelRegion & getDefaultRegion();
 
+  /// Add a parallel region with a specified name if it does not exist.
+  ///
+  /// \return A region with a specified name and `true` if it has been
+  /// created.
+  std::pair<apc::ParallelRegion *, bool> addRegion(llvm::StringRef Name);
+
+  /// Return parallel region with a specified name or nullptr.
+  apc::ParallelRegion * findRegion(llvm::StringRef Name);
+
+  /// Return number of parallel regions including the default one.
+  std::size_t getNumberOfRegions() const;
+
+  /// Return parallel region with a specified index (the default region has
+  /// index 0).
+  apc::ParallelRegion & getRegion(std::size_t Idx);
+
   /// Add a new symbol under of APCContext control, context releases memory
   /// when it becomes unused.
   ///
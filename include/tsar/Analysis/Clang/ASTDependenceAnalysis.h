@@ -33,6 +33,7 @@
 #include <bcl/utility.h>
 #include <llvm/Pass.h>
 #include <array>
+#include <map>
 #include <set>
 
 namespace tsar {
@@ -43,10 +44,22 @@ public:
   /// Sorted list of variables (to print their in algoristic order).
   using SortedVarListT = std::set<std::string, std::less<std::string>>;
 
+  /// Sorted list of arrays accessed through pointers, the value in the map is
+  /// a length of an array section which represents the whole array.
+  using ArraySectionListT = VariableCollector::ArraySectionListT;
+
+  /// Map from pointers to number of elements of arrays accessed through them.
+  using ArrayExtentMap = VariableCollector::ArrayExtentMap;
+
   /// Lists of reduction variables.
   using ReductionVarListT =
       std::array<SortedVarListT, trait::DIReduction::RK_NumberOf>;
 
+  /// Sorted list of variables with loop-carried dependencies, the value in
+  /// the map is the lowest and highest distances of dependencies.
+  using DistanceVarListT = std::map<std::string,
+    trait::DIDependence::DistanceRange, std::less<std::string>>;
+
   /// List of traits.
   using ASTRegionTraitInfo =
       bcl::tagged_tuple<bcl::tagged<SortedVarListT, trait::Private>,
@@ -54,7 +67,9 @@ public:
                         bcl::tagged<SortedVarListT, trait::LastPrivate>,
                         bcl::tagged<SortedVarListT, trait::ReadOccurred>,
                         bcl::tagged<SortedVarListT, trait::WriteOccurred>,
-                        bcl::tagged<ReductionVarListT, trait::Reduction>>;
+                        bcl::tagged<ReductionVarListT, trait::Reduction>,
+                        bcl::tagged<DistanceVarListT, trait::Flow>,
+                        bcl::tagged<DistanceVarListT, trait::Anti>>;
 
   ClangDependenceAnalyzer(clang::Stmt *Region, const GlobalOptions &GO,
       clang::DiagnosticsEngine &Diags, DIAliasTree &DIAT,
@@ -66,6 +81,14 @@ public:
     assert(Region && "Source-level region must not be null!");
   }
 
+  /// Specify number of elements of arrays which are accessed through pointers
+  /// in the region, these arrays can be described with array sections.
+  ///
+  /// This must be called before evaluation of dependencies.
+  void setArrayExtents(ArrayExtentMap Extents) {
+    mASTVars.ArrayExtents = std::move(Extents);
+  }
+
   bool evaluateDependency();
   bool evaluateDefUse();
 
@@ -73,6 +96,36 @@ public:
     return mDependenceInfo;
   }
 
+  /// Return analyzed source-level region.
+  clang::Stmt * getRegion() const noexcept { return mRegion; }
+
+  /// Return metadata-level alias tree.
+  DIAliasTree & getAliasTree() const noexcept { return mDIAT; }
+
+  /// Return metadata-level traits of memory accessed in the region.
+  DIDependenceSet & getDependenceSet() const noexcept { return mDIDepSet; }
+
+  /// Return matcher between client-side and server-side metadata-level memory.
+  ClonedDIMemoryMatcher & getDIMemoryMatcher() const noexcept {
+    return mDIMemoryMatcher;
+  }
+
+  /// Return matcher between source-level variables and metadata-level memory.
+  const ClangDIMemoryMatcher & getASTToClient() const noexcept {
+    return mASTToClient;
+  }
+
+  /// Return a variable which is not declared in the region and which is
+  /// mentioned in lists of traits with a specified name or nullptr.
+  clang::VarDecl * findDecl(llvm::StringRef Name) const;
+
+  /// Return arrays which are accessed through pointers and which are
+  /// mentioned in lists of traits, these arrays must be described with
+  /// array sections.
+  const ArraySectionListT & getArraySections() const noexcept {
+    return mArraySections;
+  }
+
 private:
   clang::Stmt *mRegion;
   const GlobalOptions &mGlobalOpts;
@@ -82,6 +135,7 @@ private:
   ClonedDIMemoryMatcher &mDIMemoryMatcher;
   const ClangDIMemoryMatcher &mASTToClient;
   ASTRegionTraitInfo mDependenceInfo;
+  ArraySectionListT mArraySections;
 
   VariableCollector mASTVars;
   llvm::SmallVector<DIAliasTrait *, 32> mInToLocalize;
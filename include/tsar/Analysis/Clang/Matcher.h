@@ -148,6 +148,21 @@ public:
     return mLocToIR->find_as(PLoc);
   }
 
+  /// \brief Stores entities expanded from macros into a location to macro map.
+  ///
+  /// \param [in] InMacro Map from a raw encoding of expansion location to
+  /// a list of entities expanded from a macro at this location
+  /// (see ASTIndex).
+  template<class MacroMapT> void addFromMacro(const MacroMapT &InMacro) {
+    for (auto &Entities : InMacro)
+      for (auto *E : Entities.second) {
+        auto Pair = mLocToMacro->insert(
+          std::make_pair(Entities.first, bcl::TransparentQueue<ASTPtrTy>(E)));
+        if (!Pair.second)
+          Pair.first->second.push(E);
+      }
+  }
+
   /// Evaluates entities located in macros.
   ///
   /// This matches entities from mLocToMacro and mLocToIR. It is recommended
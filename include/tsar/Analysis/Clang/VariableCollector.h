@@ -32,6 +32,7 @@
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
+#include <map>
 
 namespace tsar {
 class DIEstimateMemory;
@@ -46,6 +47,15 @@ struct VariableCollector
   // Sorted list of variables (to print their in algoristic order).
   using SortedVarListT = std::set<std::string, std::less<std::string>>;
 
+  /// Sorted list of arrays accessed through pointers, the value in the map is
+  /// a length of an array section which represents the whole array.
+  using ArraySectionListT =
+      std::map<std::string, std::string, std::less<std::string>>;
+
+  /// Map from canonical declaration of a pointer to a number of elements
+  /// of an array which is accessed through this pointer in an analyzed scope.
+  using ArrayExtentMap = llvm::DenseMap<clang::VarDecl *, uint64_t>;
+
   enum DeclSearch : uint8_t {
     /// Set if memory safely represent a local variable.
     CoincideLocal,
@@ -109,6 +119,20 @@ struct VariableCollector
                 const ClonedDIMemoryMatcher &ClientToServer,
                 SortedVarListT &VarNames, clang::VarDecl **Error = nullptr);
 
+  /// Check whether it is possible to use high-level syntax to create copy of a
+  /// specified memory `T` for each thread, memory accessed through a pointer
+  /// may be described with an array section.
+  ///
+  /// For example, `<*A,?>` can be represented with `A[0:10]` if `A` is
+  /// a parameter `int A[10]` or if `A` is a pointer `int *A` and
+  /// `ArrayExtents` contains 10 for it. Length of a section is stored
+  /// in `Sections`.
+  bool localize(DIMemoryTrait &T, const DIAliasNode &DIN,
+                const DIMemoryMatcher &ASTToClient,
+                const ClonedDIMemoryMatcher &ClientToServer,
+                SortedVarListT &VarNames, ArraySectionListT &Sections,
+                clang::VarDecl **Error = nullptr);
+
   /// Induction variable mentioned in a head of a canonical loop.
   ///
   /// TODO (kaniandr@gmail.com): set it to nullptr if analyzed scope is not a
@@ -130,6 +154,10 @@ struct VariableCollector
   /// declarations are stored.
   llvm::DenseSet<clang::VarDecl *> CanonicalLocals;
 
+  /// Number of elements of arrays accessed through pointers (for example,
+  /// it may be computed with IR-level delinearization of accesses).
+  ArrayExtentMap ArrayExtents;
+
   /// Map from alias node which contains global memory to one of global
   /// variables which represents this memory.
   llvm::DenseMap<DIAliasNode *, clang::VarDecl *> GlobalRefs;
@@ -35,6 +35,7 @@ class Function;
 class FunctionType;
 class Module;
 class LLVMContext;
+class StructType;
 }
 
 namespace tsar {
@@ -48,12 +49,23 @@ enum class IntrinsicId : unsigned {
   num_intrinsics
 };
 
+/// Maximum number of arguments of an intrinsic which can be stored in
+/// a buffered event record (see getEventType()), so all intrinsics which
+/// describe memory accesses including ranges can be buffered.
+constexpr unsigned EventPayloadSize = 6;
+
 /// Returns the name for an intrinsic with no overloads.
 llvm::StringRef getName(IntrinsicId Id);
 
 /// Returns the function type for an intrinsic.
 llvm::FunctionType *getType(llvm::LLVMContext &Ctx, IntrinsicId Id);
 
+/// \brief Returns type of a record which describes a buffered event.
+///
+/// The first field is an address of an intrinsic, the following
+/// EventPayloadSize fields are values of its arguments.
+llvm::StructType *getEventType(llvm::LLVMContext &Ctx);
+
 /// Creates or inserts an LLVM Function declaration for an intrinsic.
 llvm::Function * getDeclaration(llvm::Module *M, IntrinsicId Id);
 
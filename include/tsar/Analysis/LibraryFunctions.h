@@ -0,0 +1,137 @@
+//===- LibraryFunctions.h - Summaries of Library Functions ------*- C++ -*-===//
+//
+//                     Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares summaries of standard C and Fortran runtime library
+// functions. Summaries are described in LibraryFunctions.td and allow analysis
+// passes to avoid conservative assumptions about memory accessed in calls of
+// these functions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_LIBRARY_FUNCTIONS_H
+#define TSAR_LIBRARY_FUNCTIONS_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/BitmaskEnum.h>
+#include <llvm/ADT/StringRef.h>
+#include <cstdint>
+
+namespace llvm {
+class Function;
+}
+
+namespace tsar {
+LLVM_ENABLE_BITMASK_ENUMS_IN_NAMESPACE();
+
+/// Kind of access to memory which is pointed to by an argument.
+enum class LibFuncArgAccess : uint8_t { NoAccess, Read, Write, ReadWrite };
+
+/// Returns true if a specified access kind implies read from memory.
+inline bool isRead(LibFuncArgAccess Access) noexcept {
+  return Access == LibFuncArgAccess::Read ||
+         Access == LibFuncArgAccess::ReadWrite;
+}
+
+/// Returns true if a specified access kind implies write to memory.
+inline bool isWrite(LibFuncArgAccess Access) noexcept {
+  return Access == LibFuncArgAccess::Write ||
+         Access == LibFuncArgAccess::ReadWrite;
+}
+
+/// Summary of a pointer argument of a library function.
+struct LibFuncArgSummary {
+  unsigned Idx;
+  LibFuncArgAccess Access;
+  bool NoCapture;
+};
+
+/// Summary of a library function.
+class LibFuncSummary {
+public:
+  enum Property : uint8_t {
+    NoProperty = 0,
+    /// A function accesses memory which is pointed to by its arguments only.
+    NoGlobalAccess = 1u << 0,
+    /// A function never raises an exception.
+    NoThrow = 1u << 1,
+    /// A function does not write memory.
+    Pure = 1u << 2,
+    /// A function performs input/output.
+    InputOutput = 1u << 3,
+    /// A function may set 'errno', so other properties are valid only if
+    /// it does not set 'errno' (-fno-math-errno).
+    MayWriteErrno = 1u << 4,
+    LLVM_MARK_AS_BITMASK_ENUM(MayWriteErrno)
+  };
+
+  LibFuncSummary(const char *Name, Property Properties,
+      LibFuncArgAccess VarArgAccess, unsigned ArgStart, unsigned ArgEnd) :
+    mName(Name), mProperties(Properties), mVarArgAccess(VarArgAccess),
+    mArgStart(ArgStart), mArgEnd(ArgEnd) {}
+
+  /// Returns name of a function.
+  llvm::StringRef getName() const { return mName; }
+
+  /// Returns true if a function has all specified properties.
+  bool is(Property P) const noexcept { return (mProperties & P) == P; }
+
+  /// Returns true if a call of a function `F` with this summary accesses
+  /// memory which is pointed to by its arguments only.
+  ///
+  /// If a function may set 'errno' it is assumed to write a global memory
+  /// unless Clang has marked it as 'readnone' (-fno-math-errno).
+  bool onlyAccessesArgMemory(const llvm::Function &F) const;
+
+  /// Returns true if a call of a function `F` with this summary does not
+  /// write memory (see onlyAccessesArgMemory() for details about 'errno').
+  bool onlyReadsMemory(const llvm::Function &F) const;
+
+  /// Returns summaries of pointer arguments which are explicitly described.
+  llvm::ArrayRef<LibFuncArgSummary> getArgs() const;
+
+  /// Returns access to memory which is pointed to by a specified argument of
+  /// a call of a function `F` with this summary.
+  ///
+  /// Variadic arguments are accessed in the same way. If there is no
+  /// information about an argument it is conservatively assumed to be
+  /// read and written.
+  LibFuncArgAccess getArgAccess(const llvm::Function &F, unsigned ArgNo) const;
+
+  /// Returns true if a function does not capture a specified argument.
+  bool isNoCapture(unsigned ArgNo) const;
+
+private:
+  const LibFuncArgSummary * findArg(unsigned ArgNo) const;
+
+  const char *mName;
+  Property mProperties;
+  LibFuncArgAccess mVarArgAccess;
+  unsigned mArgStart;
+  unsigned mArgEnd;
+};
+
+/// Returns summary of a library function with a specified name or nullptr.
+const LibFuncSummary * findLibFuncSummary(llvm::StringRef Name);
+
+/// Returns summary of a specified function if it is an external library
+/// function, otherwise returns nullptr.
+const LibFuncSummary * findLibFuncSummary(const llvm::Function &F);
+}
+#endif//TSAR_LIBRARY_FUNCTIONS_H
@@ -33,9 +33,13 @@
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include "tsar/Support/Tags.h"
 #include <bcl/tagged.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/SmallVector.h>
+#include <functional>
 
 namespace llvm {
+class DIVariable;
 class MDNode;
 }
 
@@ -50,6 +54,14 @@ namespace tsar {
 using MDToDIMemoryMap = llvm::DenseMap<
   std::pair<llvm::Function *, llvm::MDNode *>, WeakDIMemoryHandle>;
 
+/// Callback to fill a map from raw metadata-level memory representation
+/// to a memory location in metadata-level alias tree for a specified function.
+///
+/// This callback allows to build a map lazily for each function on the first
+/// access to a memory matcher for this function.
+using MDToDIMemoryBuilder =
+  std::function<void(llvm::Function &, MDToDIMemoryMap &)>;
+
 /// This is a map from a memory location in original module to a cloned one.
 class ClonedDIMemoryMatcher :
   public Bimap<
@@ -78,10 +90,10 @@ class ClonedDIMemoryMatcherInfo {
           llvm::cast<llvm::Function>(getValPtr()));
         if (Itr == mInfo->mMatchers.end())
           return;
-        auto Pair = mInfo->insert(*F);
-        if (Pair.second)
-          *Pair.first = std::move(Itr->second);
+        auto Info = std::move(Itr->second);
         mInfo->mMatchers.erase(Itr);
+        mInfo->mMatchers.try_emplace(FunctionCallbackVH(F, mInfo),
+                                     std::move(Info));
       } else {
         mInfo->erase(llvm::cast<llvm::Function>(*getValPtr()));
       }
@@ -99,31 +111,77 @@ class ClonedDIMemoryMatcherInfo {
   struct FunctionCallbackVHDenseMapInfo :
     public llvm::DenseMapInfo<llvm::Value *> {};
 
+  /// Map from raw metadata-level representation of a cloned memory location
+  /// to this location. These locations are not matched with original ones
+  /// yet.
+  using PendingMap = llvm::DenseMap<llvm::MDNode *, WeakDIMemoryHandle>;
+
+  /// Matcher for a single function.
+  ///
+  /// Memory locations are matched on the first access to the matcher.
+  struct FunctionMatcher {
+    ClonedDIMemoryMatcher Matcher;
+    PendingMap Pending;
+  };
+
   using FunctionToMatcherMap = llvm::DenseMap<FunctionCallbackVH,
-    ClonedDIMemoryMatcher, FunctionCallbackVHDenseMapInfo>;
+    FunctionMatcher, FunctionCallbackVHDenseMapInfo>;
+
+  /// Map from a variable to a list of functions which access this variable.
+  using VariableToFunctionMap =
+    llvm::DenseMap<llvm::DIVariable *, llvm::SmallVector<llvm::Function *, 4>>;
 
 public:
   std::pair<ClonedDIMemoryMatcher *, bool> insert(llvm::Function &F) {
     auto Pair = mMatchers.try_emplace(FunctionCallbackVH(&F, this));
-    return std::make_pair(&Pair.first->second, Pair.second);
+    return std::make_pair(&Pair.first->second.Matcher, Pair.second);
   }
 
-  void erase(llvm::Function &F) {
-    auto Itr = mMatchers.find_as(&F);
-    if (Itr != mMatchers.end())
-      mMatchers.erase(Itr);
+  /// Remember a cloned memory location `M` in a function `F`. This location
+  /// is matched with an original one on the first access to a matcher for `F`.
+  ///
+  /// Callback to build a map from cloned memory to original memory must be
+  /// set (see setBuilder()) before the access to the matcher.
+  void defer(llvm::Function &F, DIMemory &M);
+
+  /// Set callback to build a map from cloned memory to original memory for
+  /// each function on demand.
+  void setBuilder(const MDToDIMemoryBuilder &Builder) { mBuilder = Builder; }
+
+  /// Set callback to build a map from cloned memory to original memory for
+  /// each function on demand.
+  void setBuilder(MDToDIMemoryBuilder &&Builder) {
+    mBuilder = std::move(Builder);
   }
 
-  void clear() { mMatchers.clear(); }
+  /// Return callback to build a map from cloned memory to original memory.
+  const MDToDIMemoryBuilder &getBuilder() const noexcept { return mBuilder; }
+
+  /// Return list of functions which access a specified variable.
+  llvm::ArrayRef<llvm::Function *> functions(llvm::DIVariable *Var) const {
+    auto Itr = mVarToFunctions.find(Var);
+    return Itr == mVarToFunctions.end() ? llvm::ArrayRef<llvm::Function *>()
+                                        : llvm::makeArrayRef(Itr->second);
+  }
+
+  void erase(llvm::Function &F);
+
+  void clear() {
+    mMatchers.clear();
+    mVarToFunctions.clear();
+    mBuilder = nullptr;
+  }
 
   ClonedDIMemoryMatcher * find(llvm::Function &F) {
     auto Itr = mMatchers.find_as(&F);
-    return Itr == mMatchers.end() ? nullptr : &Itr->second;
+    if (Itr == mMatchers.end())
+      return nullptr;
+    match(F, Itr->second);
+    return &Itr->second.Matcher;
   }
 
   const ClonedDIMemoryMatcher * find(llvm::Function &F) const {
-    auto Itr = mMatchers.find_as(&F);
-    return Itr == mMatchers.end() ? nullptr : &Itr->second;
+    return const_cast<ClonedDIMemoryMatcherInfo *>(this)->find(F);
   }
 
   ClonedDIMemoryMatcher * operator[](llvm::Function &F) { return find(F); }
@@ -132,7 +190,12 @@ public:
   }
 
 private:
+  /// Match all deferred memory locations in a specified function.
+  void match(llvm::Function &F, FunctionMatcher &FM);
+
   FunctionToMatcherMap mMatchers;
+  VariableToFunctionMap mVarToFunctions;
+  MDToDIMemoryBuilder mBuilder;
 };
 
 } // namespace tsar
@@ -155,6 +218,10 @@ createClonedDIMemoryMatcher(const tsar::MDToDIMemoryMap &CloneToOriginal);
 /// DIMemory.
 FunctionPass *createClonedDIMemoryMatcher(tsar::MDToDIMemoryMap &&);
 
+/// Create a pass which uses a specified callback to build match between cloned
+/// MDNodes and original DIMemory for each function on demand.
+FunctionPass *createClonedDIMemoryMatcher(tsar::MDToDIMemoryBuilder &&);
+
 /// Initialize a pass to store matched memory.
 void initializeClonedDIMemoryMatcherStoragePass(PassRegistry &);
 
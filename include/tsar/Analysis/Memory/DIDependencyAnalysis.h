@@ -159,6 +159,18 @@ private:
     tsar::DependenceSet &DepSet, tsar::DIDependenceSet &DIDepSet,
     tsar::DIMemoryTraitRegionPool &Pool);
 
+  /// Determine memory locations which are updated with reduction operations
+  /// only in a specified loop (for example, histogram computation `H[I[J]]++`
+  /// or summation of matrix columns `S[J] += A[I][J]`).
+  ///
+  /// Alias nodes must be already analyzed. Traits of these locations are
+  /// updated in a specified set of traits.
+  void analyzeMemoryReduction(Loop *L, Optional<unsigned> DWLang,
+    const tsar::SpanningTreeRelation<tsar::AliasTree *> &AliasSTR,
+    const tsar::SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
+    ArrayRef<const tsar::DIMemory *> LockedTraits,
+    const tsar::GlobalOptions &GlobalOpts, tsar::DIDependenceSet &DIDepSet);
+
   tsar::DIDependencInfo mDeps;
   tsar::AliasTree *mAT;
   tsar::DIMemoryTraitPool *mTraitPool;
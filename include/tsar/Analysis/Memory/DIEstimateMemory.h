@@ -28,6 +28,7 @@
 #define TSAR_DI_ESTIMATE_MEMORY_H
 
 #include "tsar/ADT/DenseMapTraits.h"
+#include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Analysis/Memory/DIMemoryLocation.h"
 #include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
@@ -567,9 +568,12 @@ protected:
     mParent->mChildren.push_back(*this);
   }
 
+  template<class, class, class> friend struct IntrusiveSpanningTreeTraits;
+
   Kind mKind;
   DIAliasNode *mParent = nullptr;
   ChildList mChildren;
+  mutable SpanningTreeNumber mSpanningTreeNumber;
 };
 
 /// This represents a root of an alias tree.
@@ -863,11 +867,27 @@ public:
   void view() const;
 
 private:
+  template<class, class, class> friend struct IntrusiveSpanningTreeTraits;
+
   AliasNodePool mNodes;
   DIAliasNode *mTopLevelNode = nullptr;
   DIMemorySet mFragments;
   llvm::Function *mFunc;
+
+  /// Numbering of nodes which is shared between all spanning tree relations,
+  /// it is reset on each change of the tree.
+  mutable std::shared_ptr<SpanningTreeNumbering<DIAliasNode *>> mSpanningTree;
 };
+
+/// Numbers of nodes in an alias tree are stored in nodes.
+template<> struct SpanningTreeTraits<DIAliasTree *> :
+  public IntrusiveSpanningTreeTraits<DIAliasTree *, DIAliasTree, DIAliasNode> {
+};
+
+/// Numbers of nodes in an alias tree are stored in nodes.
+template<> struct SpanningTreeTraits<const DIAliasTree *> :
+  public IntrusiveSpanningTreeTraits<
+    const DIAliasTree *, DIAliasTree, DIAliasNode> {};
 }
 
 namespace llvm {
@@ -19,8 +19,8 @@
 //===----------------------------------------------------------------------===//
 //
 // This file defines DIMemoryEnvironment, a container of "global" state of
-// debug-level memory locations, such as the alias trees and memory handles
-// containers.
+// debug-level memory locations, such as the alias trees, memory handles
+// containers and cached source-level representations of memory locations.
 //
 //===----------------------------------------------------------------------===//
 
@@ -29,9 +29,11 @@
 
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/ValueHandle.h>
 #include <memory>
+#include <string>
 
 namespace tsar {
 class DIAliasTree;
@@ -82,6 +84,19 @@ public:
   /// Map from a memory to list of handles.
   using DIMemoryHandleMap = llvm::DenseMap<DIMemory *, DIMemoryHandleBase *>;
 
+  /// Source-level representation of a memory location in a specified
+  /// language, `IsValid` is `false` if the location can not be unparsed.
+  struct SourceRepresentation {
+    unsigned DWLang;
+    bool IsMinimal;
+    bool IsValid;
+    std::string Str;
+  };
+
+  /// Map from a memory to its source-level representations.
+  using SourceRepresentationMap = llvm::DenseMap<const DIMemory *,
+    llvm::SmallVector<SourceRepresentation, 1>>;
+
   /// Resets alias tree for a specified function with a specified alias tree
   /// and returns pointer to a new tree.
   DIAliasTree * reset(llvm::Function &F, std::unique_ptr<DIAliasTree> &&AT) {
@@ -127,7 +142,17 @@ public:
     return mMemoryHandles[M];
   }
 
+  /// Returns cached source-level representations of memory locations.
+  ///
+  /// Representations of a memory are removed when this memory is destroyed
+  /// or its flags are changed.
+  SourceRepresentationMap & getSourceRepresentations() noexcept {
+    return mSourceRepresentations;
+  }
+
 private:
+  // Representations must be available until all alias trees are destroyed.
+  SourceRepresentationMap mSourceRepresentations;
   FunctionToTreeMap mTrees;
   DIMemoryHandleMap mMemoryHandles;
 };
@@ -148,7 +148,12 @@ using DIMemoryTraitTaggeds = bcl::TypeList<
   bcl::tagged<trait::DICoverage, trait::Redundant>,
   bcl::tagged<trait::DICoverage, trait::IndirectAccess>>;
 
-/// Set of descriptions of metadata-level memory traits.
+/// \brief Set of descriptions of metadata-level memory traits.
+///
+/// Descriptions are available for a small number of traits (dependencies,
+/// inductions, reductions and coverage) and a memory location usually has
+/// at most a couple of them. So, descriptions are stored in a map with two
+/// inline buckets which does not allocate memory in the common case.
 using DIMemoryTraitSet = bcl::TraitSet<MemoryDescriptor,
   llvm::SmallDenseMap<bcl::TraitKey, void *, 2>, DIMemoryTraitTaggeds>;
 
@@ -156,6 +161,11 @@ class DIMemoryTraitHandle;
 class DIMemoryTrait;
 
 /// This is a set of metadata-level memory traits in a region of a code.
+///
+/// Each memory location has a separate entry in a persistent map. Entries are
+/// referenced through persistent iterators (see DIMemoryTraitRef) and updated
+/// by memory handles on RAUW and deletion, so traits are not packed into
+/// a flat bit array indexed by a number of a memory location.
 using DIMemoryTraitRegionPool = PersistentMap<
   DIMemoryTraitHandle, DIMemoryTraitSet, DIMemoryMapInfo, DIMemoryTrait>;
 
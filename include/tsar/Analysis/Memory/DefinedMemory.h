@@ -44,6 +44,7 @@
 #include <bcl/utility.h>
 #include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/Analysis/AliasSetTracker.h>
 #ifdef LLVM_DEBUG
 # include <llvm/IR/Instruction.h>
@@ -51,6 +52,7 @@
 #include <llvm/Pass.h>
 
 namespace llvm {
+class AllocaInst;
 class DominatorTree;
 class Value;
 class Instruction;
@@ -366,15 +368,20 @@ public:
 
   /// Creates data-flow framework.
   ReachDFFwk(AliasTree &AT, llvm::TargetLibraryInfo &TLI,
-      const llvm::DominatorTree *DT, DefinedMemoryInfo &DefInfo) :
-    mAliasTree(&AT), mTLI(&TLI), mDT(DT), mDefInfo(&DefInfo) {}
+      const DFRegionInfo &RI, const llvm::DominatorTree *DT,
+      DefinedMemoryInfo &DefInfo) :
+    mAliasTree(&AT), mTLI(&TLI), mDT(DT), mDefInfo(&DefInfo) {
+    initializeLocalAllocas(RI);
+  }
 
   /// Creates data-flow framework.
   ReachDFFwk(AliasTree &AT, llvm::TargetLibraryInfo &TLI,
-      const llvm::DominatorTree *DT, DefinedMemoryInfo &DefInfo,
-      InterprocDefUseInfo &InterprocDUInfo) :
+      const DFRegionInfo &RI, const llvm::DominatorTree *DT,
+      DefinedMemoryInfo &DefInfo, InterprocDefUseInfo &InterprocDUInfo) :
     mAliasTree(&AT), mTLI(&TLI), mDT(DT), mDefInfo(&DefInfo),
-    mInterprocDUInfo(&InterprocDUInfo) {}
+    mInterprocDUInfo(&InterprocDUInfo) {
+    initializeLocalAllocas(RI);
+  }
 
   /// Return results of interprocedural analysis or nullptr.
   InterprocDefUseInfo * getInterprocDefUseInfo() noexcept {
@@ -406,16 +413,37 @@ public:
   void collapse(DFRegion *R);
 
 private:
+  /// \brief Collects loops which contain lifetime markers of allocas.
+  ///
+  /// A pair (alloca, loop) is stored if the loop contains both
+  /// 'lifetime.start' and 'lifetime.end' for the alloca. So, memory allocated
+  /// with this alloca is local for each iteration of the loop.
+  void initializeLocalAllocas(const DFRegionInfo &RI);
+
+  /// Returns an alloca which allocates memory for a top-level parent of a
+  /// specified location or nullptr.
+  const llvm::AllocaInst * findTopLevelAlloca(const MemoryLocationRange &Loc);
+
   AliasTree *mAliasTree;
   llvm::TargetLibraryInfo *mTLI;
   const llvm::DominatorTree *mDT;
   DefinedMemoryInfo *mDefInfo;
   InterprocDefUseInfo *mInterprocDUInfo = nullptr;
+  llvm::DenseSet<std::pair<const llvm::AllocaInst *, const DFNode *>>
+    mLocalAllocas;
+  llvm::DenseMap<MemoryLocationRange, const llvm::AllocaInst *> mLocToAlloca;
 };
 
 /// This represents results of interprocedural reach definition analysis.
 typedef ReachDFFwk::InterprocDefUseInfo InterprocDefUseInfo;
 
+/// Remove results of interprocedural reach definition analysis for functions
+/// which have bodies.
+///
+/// Results for declarations are imported from summaries of other translation
+/// units, so they do not depend on a current stage of processing.
+void clearDefinitions(InterprocDefUseInfo &Info);
+
 /// This covers IN and OUT value for a must/may reach definition analysis.
 typedef ReachDFFwk::ReachSet ReachSet;
 
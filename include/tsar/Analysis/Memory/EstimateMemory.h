@@ -51,6 +51,7 @@
 #ifndef TSAR_ESTIMATE_MEMORY_H
 #define TSAR_ESTIMATE_MEMORY_H
 
+#include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/DataFlowGraph.h"
 #include "tsar/Analysis/Memory/MemoryLocationRange.h"
 #include "tsar/Analysis/Memory/Passes.h"
@@ -72,6 +73,7 @@
 #include <llvm/Pass.h>
 #include <array>
 #include <iterator>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -780,11 +782,14 @@ protected:
     return std::make_pair(false, nullptr);
   }
 
+  template<class, class, class> friend struct IntrusiveSpanningTreeTraits;
+
   Kind mKind;
   mutable AliasNode *mParent = nullptr;
   ChildList mChildren;
   mutable AliasNode *mForward = nullptr;
   mutable unsigned mRefCount = 0;
+  mutable SpanningTreeNumber mSpanningTreeNumber;
 };
 
 /// This represents a root of an alias tree.
@@ -1188,6 +1193,8 @@ private:
   std::tuple<EstimateMemory *, bool, bool>
     insert(const llvm::MemoryLocation &Base);
 
+  template<class, class, class> friend struct IntrusiveSpanningTreeTraits;
+
   llvm::AAResults *mAA;
   const llvm::DataLayout *mDL;
   const llvm::DominatorTree *mDT;
@@ -1196,6 +1203,10 @@ private:
   tsar::AmbiguousRef::AmbiguousPool mAmbiguousPool;
   StrippedMap mBases;
   mutable llvm::DenseMap<llvm::MemoryLocation, EstimateMemory *> mSearchCache;
+
+  /// Numbering of nodes which is shared between all spanning tree relations,
+  /// it is reset on each change of the tree.
+  mutable std::shared_ptr<SpanningTreeNumbering<AliasNode *>> mSpanningTree;
 };
 
 inline void EstimateMemory::setAliasNode(
@@ -1258,6 +1269,15 @@ inline void AliasNode::release(const AliasTree &G) const {
   if (--mRefCount == 0)
     const_cast<AliasTree &>(G).removeNode(const_cast<AliasNode *>(this));
 }
+
+/// Numbers of nodes in an alias tree are stored in nodes.
+template<> struct SpanningTreeTraits<AliasTree *> :
+  public IntrusiveSpanningTreeTraits<AliasTree *, AliasTree, AliasNode> {};
+
+/// Numbers of nodes in an alias tree are stored in nodes.
+template<> struct SpanningTreeTraits<const AliasTree *> :
+  public IntrusiveSpanningTreeTraits<
+    const AliasTree *, AliasTree, AliasNode> {};
 }
 
 inline const tsar::EstimateMemory *
@@ -26,6 +26,7 @@
 #define TSAR_ESTIMATE_MEMORY_UTILS_H
 
 #include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Analysis/LibraryFunctions.h"
 #include <bcl/trait.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
@@ -73,6 +74,8 @@ void for_each_memory(llvm::Instruction &I, llvm::TargetLibraryInfo &TLI,
     auto Callee =
       llvm::dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
     llvm::LibFunc LibId;
+    bool OnlyAccessesArgMemory = CS.onlyAccessesArgMemory();
+    bool OnlyReadsMemory = CS.onlyReadsMemory();
     if (auto II = llvm::dyn_cast<IntrinsicInst>(CS.getInstruction())) {
       bool IsMarker = isMemoryMarkerIntrinsic(II->getIntrinsicID());
       foreachIntrinsicMemArg(*II,
@@ -84,6 +87,24 @@ void for_each_memory(llvm::Instruction &I, llvm::TargetLibraryInfo &TLI,
           (CS.doesNotReadMemory() || IsMarker) ? AccessInfo::No : AccessInfo::May,
           (CS.onlyReadsMemory() || IsMarker) ? AccessInfo::No : AccessInfo::May);
       });
+    } else if (auto *Summary = Callee ? findLibFuncSummary(*Callee) : nullptr) {
+      OnlyAccessesArgMemory |= Summary->onlyAccessesArgMemory(*Callee);
+      OnlyReadsMemory |= Summary->onlyReadsMemory(*Callee);
+      for (unsigned Idx = 0; Idx < CS.arg_size(); ++Idx) {
+        if (!CS.getArgument(Idx)->getType()->isPointerTy())
+          continue;
+        auto Access = Summary->getArgAccess(*Callee, Idx);
+        if (Access == LibFuncArgAccess::NoAccess)
+          continue;
+        auto Loc = MemoryLocation::getForArgument(CS, Idx, TLI);
+        if (!isValidPtr(Loc.Ptr))
+          continue;
+        Func(*CS.getInstruction(), std::move(Loc), Idx,
+          !isRead(Access) || CS.doesNotReadMemory() ?
+            AccessInfo::No : AccessInfo::May,
+          !isWrite(Access) || OnlyReadsMemory ?
+            AccessInfo::No : AccessInfo::May);
+      }
     } else if (Callee && TLI.getLibFunc(*Callee, LibId)) {
       foreachLibFuncMemArg(LibId,
           [&CS, &TLI, &Func, &isValidPtr](unsigned Idx) {
@@ -108,10 +129,10 @@ void for_each_memory(llvm::Instruction &I, llvm::TargetLibraryInfo &TLI,
          CS.onlyReadsMemory() ? AccessInfo::No : AccessInfo::May);
       }
     }
-    if (!CS.onlyAccessesArgMemory())
+    if (!OnlyAccessesArgMemory)
       UnknownFunc(*CS.getInstruction(),
         CS.doesNotReadMemory() ? AccessInfo::No : AccessInfo::May,
-        CS.onlyReadsMemory() ? AccessInfo::No : AccessInfo::May);
+        OnlyReadsMemory ? AccessInfo::No : AccessInfo::May);
   };
   switch (I.getOpcode()) {
   default:
@@ -156,6 +156,14 @@ void initializeDelinearizationPassPass(PassRegistry &Registry);
 /// Create a pass to delinearize array accesses.
 FunctionPass * createDelinearizationPass();
 
+/// Initialize a pass to look for arrays of structures which layout should be
+/// changed to reduce memory traffic.
+void initializeStructLayoutAdvisorPass(PassRegistry &Registry);
+
+/// Create a pass to look for arrays of structures which layout should be
+/// changed to reduce memory traffic.
+ModulePass * createStructLayoutAdvisor();
+
 /// Initialize a pass to perform iterprocedural live memory analysis.
 void initializeGlobalLiveMemoryPass(PassRegistry& Registry);
 
@@ -191,6 +199,17 @@ ImmutablePass *createGlobalDefinedMemoryStorage();
 /// analysis.
 void initializeGlobalDefinedMemoryWrapperPass(PassRegistry &Registry);
 
+/// Initialize a pass to release results of interprocedural analysis of
+/// defined and live memory locations.
+void initializeGlobalMemoryReleasePass(PassRegistry &Registry);
+
+/// Create a pass to release results of interprocedural analysis of
+/// defined and live memory locations.
+///
+/// These results become outdated after transformations, so this pass should be
+/// executed when all passes which use these results have been finished.
+ModulePass *createGlobalMemoryReleasePass();
+
 /// Create analysis server.
 ModulePass *createDIMemoryAnalysisServer();
 
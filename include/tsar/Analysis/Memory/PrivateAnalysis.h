@@ -41,6 +41,7 @@
 #include <bcl/utility.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Pass.h>
+#include <chrono>
 #include <forward_list>
 #include <tuple>
 
@@ -51,6 +52,7 @@ class DefUseSet;
 class DFLoop;
 class EstimateMemory;
 class BitMemoryTrait;
+struct GlobalOptions;
 template<class GraphType> class SpanningTreeRelation;
 
 /// This determine relation between two nodes in an alias tree.
@@ -178,6 +180,7 @@ public:
     mDL = nullptr;
     mTLI = nullptr;
     mSE = nullptr;
+    mGlobalOpts = nullptr;
   }
 
   /// Specifies a list of analyzes  that are necessary for this pass.
@@ -190,6 +193,10 @@ public:
 private:
   /// Uses dependence analysis pass to collect loop-carried dependencies in
   /// a specified loop.
+  ///
+  /// If analysis budget of a loop or a function is exceeded all memory
+  /// accessed in the loop is conservatively assumed to be dependent. Warning
+  /// is emitted only for the first such loop in a function.
   void collectDependencies(Loop *L, DependenceMap &Deps,
     tsar::detail::DependenceCache &Cache);
 
@@ -357,6 +364,9 @@ private:
   const DataLayout *mDL = nullptr;
   TargetLibraryInfo *mTLI = nullptr;
   ScalarEvolution *mSE = nullptr;
+  const tsar::GlobalOptions *mGlobalOpts = nullptr;
+  std::chrono::steady_clock::time_point mStartTime;
+  bool mIsBudgetReported = false;
 };
 }
 #endif//TSAR_PRIVATE_ANALYSIS_H
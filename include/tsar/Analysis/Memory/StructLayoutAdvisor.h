@@ -0,0 +1,116 @@
+//===- StructLayoutAdvisor.h - Structure Layout Advisor ---------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a pass which looks for arrays of structures traversed
+// in loops which access a small part of each structure. For each such array
+// the pass estimates amount of memory traffic which could be saved if
+// the array is converted to a structure of arrays or if rarely accessed
+// (cold) fields are moved to a separate structure.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_STRUCT_LAYOUT_ADVISOR_H
+#define TSAR_STRUCT_LAYOUT_ADVISOR_H
+
+#include "tsar/Analysis/Memory/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/SmallBitVector.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Pass.h>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class DIVariable;
+class Function;
+}
+
+namespace tsar {
+/// Summary of accesses to an array of structures in loops.
+struct AoSInfo {
+  /// Name of an array and name of a structure in a source code.
+  std::string Name;
+  std::string TypeName;
+
+  /// Source-level description of an array if it is available.
+  llvm::DIVariable *Var = nullptr;
+
+  /// Function which contains a local array, it is nullptr for global arrays.
+  llvm::Function *Func = nullptr;
+
+  /// Names of fields in order of their definition.
+  llvm::SmallVector<std::string, 8> FieldNames;
+
+  /// Size of a structure and sizes of its fields in bytes.
+  uint64_t Size = 0;
+  llvm::SmallVector<uint64_t, 8> FieldSize;
+
+  /// Accumulated weight of loops which access each field.
+  llvm::SmallVector<uint64_t, 8> FieldWeight;
+
+  /// Fields accessed in each loop which traverses an array and weight
+  /// of this loop (estimated number of traversed elements).
+  llvm::SmallVector<std::pair<llvm::SmallBitVector, uint64_t>, 4> Loops;
+
+  /// True if an array is not visible outside a translation unit.
+  bool IsLocal = false;
+
+  /// Number of bytes transferred in case of current layout.
+  uint64_t AoSBytes = 0;
+
+  /// Number of bytes which could be saved in case of structure of arrays.
+  uint64_t SoASaved = 0;
+
+  /// Fields which should be moved to a separate structure.
+  llvm::SmallBitVector Cold;
+
+  /// Number of bytes which could be saved in case of hot/cold splitting.
+  uint64_t SplitSaved = 0;
+};
+}
+
+namespace llvm {
+/// This pass looks for arrays of structures which should be converted to
+/// structures of arrays or which cold fields should be split.
+class StructLayoutAdvisor : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  StructLayoutAdvisor() : ModulePass(ID) {
+    initializeStructLayoutAdvisorPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+  void print(raw_ostream &OS, const Module *M) const override;
+
+  void releaseMemory() override { mCandidates.clear(); }
+
+  /// Return arrays which layout should be changed in order of decreasing
+  /// amount of memory traffic which could be saved.
+  const std::vector<tsar::AoSInfo> & getCandidates() const noexcept {
+    return mCandidates;
+  }
+
+private:
+  std::vector<tsar::AoSInfo> mCandidates;
+};
+}
+#endif//TSAR_STRUCT_LAYOUT_ADVISOR_H
@@ -43,5 +43,11 @@ void initializeParallelLoopPassPass(PassRegistry &Registry);
 /// Initialize a pass to determine loops which could be executed
 /// in a parallel way.
 FunctionPass *createParallelLoopPass();
+
+/// Initialize a pass to determine innermost loops which could be vectorized.
+void initializeSIMDLoopPassPass(PassRegistry &Registry);
+
+/// Create a pass to determine innermost loops which could be vectorized.
+FunctionPass *createSIMDLoopPass();
 }
 #endif//TSAR_PARALLEL_ANALYSIS_PASSES_H
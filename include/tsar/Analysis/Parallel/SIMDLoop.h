@@ -0,0 +1,120 @@
+//===- SIMDLoop.h ------------------------- SIMD Loop Analysis --*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a pass to determine innermost loops which could be
+// vectorized.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_ANALYSIS_SIMD_LOOP_H
+#define TSAR_ANALYSIS_SIMD_LOOP_H
+
+#include "tsar/Analysis/Parallel/Passes.h"
+#include "bcl/utility.h"
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Pass.h>
+
+namespace llvm {
+class Loop;
+}
+
+namespace tsar {
+/// Classification of an innermost loop from the vectorization point of view.
+class SIMDInfo {
+public:
+  /// Reasons which prevent vectorization.
+  enum Reason : uint8_t {
+    NoReason = 0,
+    UnsafeCFG,
+    Call,
+    NoAnalysis,
+    DataDependence,
+    Aliasing,
+    UnknownReduction,
+    UnknownDistance,
+    ShortDistance
+  };
+
+  /// Create description of a vectorizable loop, if `SafeLength` is not zero
+  /// number of concurrently executed iterations must not exceed it.
+  explicit SIMDInfo(unsigned SafeLength = 0)
+    : mSafeLength(SafeLength), mReason(NoReason) {}
+
+  /// Create description of a loop which can not be vectorized due to
+  /// a specified reason.
+  explicit SIMDInfo(Reason R) : mSafeLength(0), mReason(R) {
+    assert(R != NoReason && "Reason must be specified!");
+  }
+
+  /// Return true if a loop can be vectorized.
+  bool isVectorizable() const noexcept { return mReason == NoReason; }
+
+  /// Return true if vector length is limited for a vectorizable loop.
+  bool hasSafeLength() const noexcept { return mSafeLength != 0; }
+
+  /// Return maximum number of iterations which can be executed concurrently
+  /// or zero if it is not limited.
+  unsigned getSafeLength() const noexcept { return mSafeLength; }
+
+  /// Return reason which prevents vectorization.
+  Reason getReason() const noexcept { return mReason; }
+
+  /// Return description of a reason which prevents vectorization.
+  llvm::StringRef getReasonDescription() const;
+
+private:
+  unsigned mSafeLength;
+  Reason mReason;
+};
+
+/// Classification of innermost loops in order of their traversal.
+using SIMDLoopInfo = llvm::MapVector<const llvm::Loop *, SIMDInfo>;
+}
+
+namespace llvm {
+/// Determine innermost loops which could be vectorized.
+class SIMDLoopPass : public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  SIMDLoopPass() : FunctionPass(ID) {
+    initializeSIMDLoopPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override { mSIMDLoops.clear(); }
+
+  /// Return classification of innermost loops.
+  tsar::SIMDLoopInfo &getSIMDLoopInfo() noexcept { return mSIMDLoops; }
+
+  /// Return classification of innermost loops.
+  const tsar::SIMDLoopInfo &getSIMDLoopInfo() const noexcept {
+    return mSIMDLoops;
+  }
+
+private:
+  tsar::SIMDLoopInfo mSIMDLoops;
+};
+}
+
+#endif//TSAR_ANALYSIS_SIMD_LOOP_H
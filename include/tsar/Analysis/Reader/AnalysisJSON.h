@@ -27,6 +27,7 @@
 
 #include "tsar/Analysis/Memory/MemoryTrait.h"
 #include <bcl/Json.h>
+#include <cstdint>
 
 namespace tsar{
 namespace trait {
@@ -52,8 +53,13 @@ JSON_OBJECT_BEGIN(Distance)
 JSON_OBJECT_END(Distance)
 
 /// Definition of a JSON-object which represents a loop and its properties.
+///
+/// If `Sampled` is set, properties have been collected for some iterations
+/// of the loop or of some of inner loops only. `Iterations` is a total number
+/// of executed iterations of the loop (for all its executions), zero means
+/// that the number of iterations is unknown.
 JSON_OBJECT_BEGIN(Loop)
-JSON_OBJECT_PAIR_11(Loop,
+JSON_OBJECT_PAIR_13(Loop,
   File, std::string,
   Line, LineTy,
   Column, ColumnTy,
@@ -64,7 +70,9 @@ JSON_OBJECT_PAIR_11(Loop,
   Output, std::set<IdTy>,
   WriteOccurred, std::set<IdTy>,
   ReadOccurred, std::set<IdTy>,
-  UseAfterLoop, std::set<IdTy>)
+  UseAfterLoop, std::set<IdTy>,
+  Sampled, bool,
+  Iterations, std::uint64_t)
 JSON_OBJECT_END(Loop)
 
 /// Definition of a top-level JSON-object with name 'Info', which contains
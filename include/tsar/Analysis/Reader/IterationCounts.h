@@ -0,0 +1,69 @@
+//===- IterationCounts.h --- Loop Iteration Counts --------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a storage of numbers of executed loop iterations which
+// are loaded from external analysis results (see AnalysisJSON.h).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_ITERATION_COUNTS_H
+#define TSAR_ITERATION_COUNTS_H
+
+#include <bcl/utility.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <cstdint>
+#include <map>
+#include <tuple>
+
+namespace llvm {
+class LLVMContext;
+class MDNode;
+}
+
+namespace tsar {
+/// Total numbers of executed iterations of loops in external analysis results.
+class LoopIterationCounts : private bcl::Uncopyable {
+public:
+  /// Loads iteration counts from a specified file.
+  ///
+  /// A loop without iterations in the file (the number of iterations is
+  /// omitted or it is zero) is considered as a loop with unknown number of
+  /// iterations.
+  ///
+  /// Errors are reported with diagnostics in a specified context. This
+  /// function returns `false` if the file can not be read or parsed.
+  bool load(llvm::StringRef DataFile, llvm::LLVMContext &Ctx);
+
+  /// Returns a total number of executed iterations of a loop with
+  /// a specified ID or `None` if it is unknown.
+  llvm::Optional<std::uint64_t> find(const llvm::MDNode *LoopID) const;
+
+  /// Returns `true` if there are no known iteration counts.
+  bool empty() const { return mCounts.empty(); }
+
+private:
+  using LocationT = std::tuple<llvm::sys::fs::UniqueID, unsigned, unsigned>;
+
+  std::map<LocationT, std::uint64_t> mCounts;
+};
+}
+#endif//TSAR_ITERATION_COUNTS_H
@@ -258,15 +258,26 @@ protected:
 class InstrLLVMQueryManager : public EmitLLVMQueryManager {
 public:
   explicit InstrLLVMQueryManager(llvm::StringRef InstrEntry = "",
-      llvm::ArrayRef<std::string> InstrStart = {}) :
-    mInstrEntry(InstrEntry),
-    mInstrStart(InstrStart.begin(), InstrStart.end()) {}
+      llvm::ArrayRef<std::string> InstrStart = {},
+      unsigned InstrBufferSize = 0, unsigned InstrSampleFirst = 0,
+      unsigned InstrSamplePeriod = 0, bool InstrRange = false,
+      const GlobalOptions *Options = nullptr) :
+    mGlobalOptions(Options), mInstrEntry(InstrEntry),
+    mInstrStart(InstrStart.begin(), InstrStart.end()),
+    mInstrBufferSize(InstrBufferSize),
+    mInstrSampleFirst(InstrSampleFirst),
+    mInstrSamplePeriod(InstrSamplePeriod), mInstrRange(InstrRange) {}
 
   void run(llvm::Module *M, tsar::TransformationContext *) override;
 
 private:
+  const GlobalOptions *mGlobalOptions;
   std::string mInstrEntry;
   std::vector<std::string> mInstrStart;
+  unsigned mInstrBufferSize;
+  unsigned mInstrSampleFirst;
+  unsigned mInstrSamplePeriod;
+  bool mInstrRange;
 };
 
 /// This performs a specified source-level transformation.
@@ -292,6 +303,22 @@ private:
   ASTImportInfo mImportInfo;
 };
 
+/// This performs interprocedural analysis which is necessary to export
+/// summaries of externally visible functions (see GlobalOptions::SummaryExport)
+/// and does nothing else.
+class SummaryQueryManager : public QueryManager {
+public:
+  explicit SummaryQueryManager(const GlobalOptions *Options) :
+    mGlobalOptions(Options) {
+    assert(Options && "Global options must not be null!");
+  }
+
+  void run(llvm::Module *M, TransformationContext *Ctx) override;
+
+private:
+  const GlobalOptions *mGlobalOptions;
+};
+
 /// This performs a check of user-define properties.
 class CheckQueryManager : public QueryManager {
 public:
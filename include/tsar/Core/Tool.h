@@ -96,7 +96,18 @@ private:
   ///
   void storePrintOptions(OptionList &IncompatibleOpts);
 
+  /// \brief Analyzes sources in multiple processes.
+  ///
+  /// At first, summaries of functions are computed for each source in
+  /// a separate process. Then, sources are partitioned into shards in
+  /// accordance with calls between them and each shard is analyzed in
+  /// a separate process. Merged summaries of all sources are used to analyze
+  /// calls of functions defined in other shards.
+  /// \return Zero on success.
+  int runShards();
+
   GlobalOptions mGlobalOpts;
+  std::vector<std::string> mArgs;
   std::vector<std::string> mCommandLine;
   std::vector<std::string> mSources;
   std::vector<const llvm::PassInfo *> mOutputPasses;
@@ -114,10 +125,16 @@ private:
   bool mCheck = false;
   bool mPrint = false;
   bool mServer = false;
+  bool mSummaryOnly = false;
+  unsigned mAnalysisJobs = 1;
   std::string mOutputFilename;
   std::string mLanguage;
   std::string mInstrEntry;
   std::vector<std::string> mInstrStart;
+  unsigned mInstrBuffer = 0;
+  unsigned mInstrSampleFirst = 0;
+  unsigned mInstrSamplePeriod = 0;
+  bool mInstrRange = false;
 };
 }
 #endif//TSAR_TOOL_H
@@ -34,6 +34,7 @@
 #include <llvm/IR/Module.h>
 #include <llvm/Pass.h>
 #include <functional>
+#include <memory>
 
 namespace clang {
 class Decl;
@@ -42,6 +43,8 @@ class ASTContext;
 }
 
 namespace tsar {
+class ASTIndex;
+
 /// \brief A prototype of a filename adjuster.
 ///
 /// Filename adjuster is responsible for modification of filenames before the
@@ -131,6 +134,8 @@ public:
   TransformationContext(clang::ASTContext &Ctx, clang::CodeGenerator &Gen,
     llvm::ArrayRef<std::string> CL);
 
+  ~TransformationContext();
+
   /// \brief Returns an input source file.
   ///
   /// \pre Transformation instance must be configured.
@@ -156,6 +161,13 @@ public:
   /// \pre Transformation instance must be configured.
   clang::Decl * getDeclForMangledName(llvm::StringRef Name);
 
+  /// \brief Returns index of entities in a specified declaration.
+  ///
+  /// The index is built at the first request and it is shared between all
+  /// passes which process the current translation unit.
+  /// \pre Transformation instance must be configured.
+  const ASTIndex & getASTIndex(clang::Decl &D);
+
   /// Returns true if transformation engine is configured.
   bool hasInstance() const { return mGen && mCtx; }
 
@@ -194,13 +206,14 @@ public:
   /// \brief Resets existence configuration of transformation engine.
   ///
   /// \post Transformation engine is NOT configured.
-  void reset() { mGen = nullptr; mCtx = nullptr; }
+  void reset() { mGen = nullptr; mCtx = nullptr; mASTIndexes.clear(); }
 
 private:
   clang::Rewriter mRewriter;
   clang::CodeGenerator *mGen;
   clang::ASTContext *mCtx;
   std::vector<std::string> mCommandLine;
+  llvm::DenseMap<const clang::Decl *, std::unique_ptr<ASTIndex>> mASTIndexes;
 };
 }
 
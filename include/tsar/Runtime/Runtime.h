@@ -0,0 +1,105 @@
+//===--- Runtime.h -------- Dynamic Analysis Runtime ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares functions of a reference runtime library which implements
+// intrinsics inserted by the instrumentation pass (see Intrinsics.td).
+//
+// Usage:
+// (1) tsar -instr-llvm Example.c
+// (2) clang++ Example.ll -lTSARRuntime
+// (3) SAPFOR_RUNTIME_OUTPUT=Example.json ./a.out
+// (4) tsar Example.c -analysis-use=Example.json ...
+//
+// The runtime uses shadow memory to detect data dependencies in loops.
+// Results are written at exit in a format of trait::Info (see AnalysisJSON.h).
+// Memory accesses from different threads are processed concurrently if they
+// touch different shards of shadow memory, other events are serialized.
+// Loops are tracked in a single stack, so the runtime is intended for analysis
+// of sequential programs. Buffered events of a thread are processed when
+// the thread exits or when the program calls exit().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_RUNTIME_H
+#define TSAR_RUNTIME_H
+
+#include <cstdint>
+
+extern "C" {
+/// Record which describes a buffered event (see getEventType()).
+struct SapforEvent {
+  /// Address of an intrinsic which has been replaced with this record.
+  uint64_t Kind;
+  /// Arguments of the intrinsic.
+  uint64_t Args[6];
+};
+
+//===------ Initialization of metadata and registration of types ----------===//
+void sapforInitDI(void **DI, char *DIString, uint64_t Offset);
+void sapforAllocatePool(void ***PoolPtr, uint64_t Size);
+void sapforDeclTypes(uint64_t Num, uint64_t *Ids, uint64_t *Sizes);
+
+//===------------------ Registration of memory accesses -------------------===//
+void sapforRegVar(void *DIVar, void *Addr);
+void sapforRegArr(void *DIVar, uint64_t ArrSize, void *Addr);
+void sapforReadVar(void *DILoc, void *Addr, void *DIVar);
+void sapforReadArr(void *DILoc, void *Addr, void *DIVar, void *ArrBase);
+void sapforWriteVarEnd(void *DILoc, void *Addr, void *DIVar);
+void sapforWriteArrEnd(void *DILoc, void *Addr, void *DIVar, void *ArrBase);
+void sapforReadArrRange(void *DILoc, void *Addr, uint64_t Stride,
+  uint64_t Count, void *DIVar, void *ArrBase);
+void sapforWriteArrRange(void *DILoc, void *Addr, uint64_t Stride,
+  uint64_t Count, void *DIVar, void *ArrBase);
+
+//===--------------------- Registration of a function ---------------------===//
+void sapforFuncBegin(void *DIFunc);
+void sapforFuncEnd(void *DIFunc);
+void sapforRegDummyVar(void *DIVar, void *Addr, void *DIFunc,
+  uint64_t Position);
+void sapforRegDummyArr(void *DIVar, uint64_t ArrSize, void *Addr,
+  void *DIFunc, uint64_t Position);
+void sapforFuncCallBegin(void *DILoc, void *DIFunc);
+void sapforFuncCallEnd(void *DIFunc);
+
+//===---------------------- Registration of a loop ------------------------===//
+void sapforSLBegin(void *DILoop, uint64_t Start, uint64_t End, uint64_t Step);
+void sapforSLEnd(void *DILoop);
+void sapforSLIter(void *DILoop, uint64_t Iter);
+
+//===------------------- Processing of buffered events --------------------===//
+void sapforFlushEvents(SapforEvent *Events, uint64_t Size);
+void sapforRegEventBuffer(uint64_t *Buffer);
+}
+
+namespace tsar {
+namespace rt {
+/// Writes collected results to a specified file, if `Path` is `nullptr` a file
+/// specified in SAPFOR_RUNTIME_OUTPUT environment variable or 'sapfor.da.json'
+/// is used.
+///
+/// This function is automatically called at exit if metadata pool has been
+/// allocated. It returns `false` if the file can not be written.
+bool writeResults(const char *Path = nullptr);
+
+/// Returns number of processed events.
+uint64_t getNumberOfEvents();
+}
+}
+#endif//TSAR_RUNTIME_H
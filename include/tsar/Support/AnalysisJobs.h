@@ -0,0 +1,68 @@
+//===--- AnalysisJobs.h ------- Parallel Analysis Jobs ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//===----------------------------------------------------------------------===//
+//
+// This file declares utilities to analyze parts of sources in separate
+// processes which are executed concurrently.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_ANALYSIS_JOBS_H
+#define TSAR_ANALYSIS_JOBS_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Program.h>
+#include <string>
+#include <vector>
+
+namespace tsar {
+/// A process which analyzes a part of sources.
+struct AnalysisJob {
+  std::vector<std::string> Args;
+  llvm::SmallString<128> Out;
+  llvm::SmallString<128> Err;
+  llvm::sys::ProcessInfo PI;
+  bool IsLaunched = false;
+};
+
+/// Run jobs in at most `MaxProcs` concurrent processes.
+///
+/// Outputs of jobs are printed in order of jobs. This function returns `false`
+/// if some of jobs fails.
+bool executeJobs(llvm::StringRef Program,
+  llvm::MutableArrayRef<AnalysisJob> Jobs, unsigned MaxProcs);
+
+/// Return arguments of a job which are common for all jobs.
+///
+/// Sources from `Sources` and options from `Options` (with their values) are
+/// removed from a command line `Args`. Arguments after '--' are passed to
+/// a compiler and they are never removed.
+std::vector<std::string> getBaseJobArgs(llvm::ArrayRef<std::string> Args,
+  llvm::ArrayRef<std::string> Sources, llvm::ArrayRef<llvm::StringRef> Options);
+
+/// Return arguments of a job which analyzes `Sources`.
+///
+/// Sources and options from `Extra` are inserted in `BaseArgs` before
+/// arguments of a compiler.
+std::vector<std::string> getJobArgs(llvm::ArrayRef<std::string> BaseArgs,
+  llvm::ArrayRef<std::string> Sources, llvm::ArrayRef<std::string> Extra);
+}
+
+#endif//TSAR_ANALYSIS_JOBS_H
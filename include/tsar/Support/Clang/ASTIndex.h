@@ -0,0 +1,100 @@
+//===--- ASTIndex.h ------- Index of Function Body --------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an immutable index of entities in a function body.
+// The index is built in a single traversal of AST and it is shared between
+// passes which match entities in a source code and in LLVM IR, so these
+// passes do not traverse AST by themselves.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_CLANG_AST_INDEX_H
+#define TSAR_CLANG_AST_INDEX_H
+
+#include <bcl/utility.h>
+#include <llvm/ADT/DenseMap.h>
+#include <vector>
+
+namespace clang {
+class Decl;
+class SourceManager;
+class Stmt;
+class VarDecl;
+}
+
+namespace tsar {
+/// \brief Index of entities in a declaration (usually in a function).
+///
+/// All lists contain entities in the order of traversal of AST with
+/// clang::RecursiveASTVisitor. Entities expanded from macros are stored
+/// in these lists and they are also grouped by expansion locations.
+class ASTIndex : private bcl::Uncopyable {
+public:
+  using StmtList = std::vector<clang::Stmt *>;
+  using VarList = std::vector<clang::VarDecl *>;
+
+  /// Map from a raw encoding of expansion location to a list of entities
+  /// which are expanded from a macro at this location.
+  template<class T>
+  using MacroMap = llvm::DenseMap<unsigned, std::vector<T *>>;
+
+  /// Builds index for a specified declaration.
+  ASTIndex(clang::Decl &D, const clang::SourceManager &SrcMgr);
+
+  /// Returns all statements.
+  const StmtList & getStmts() const noexcept { return mStmts; }
+
+  /// Returns for, while and do-while loops.
+  const StmtList & getLoops() const noexcept { return mLoops; }
+
+  /// Returns call expressions.
+  const StmtList & getCalls() const noexcept { return mCalls; }
+
+  /// Returns variable declarations.
+  const VarList & getVars() const noexcept { return mVars; }
+
+  /// Returns loops expanded from macros.
+  const MacroMap<clang::Stmt> & getLoopsInMacro() const noexcept {
+    return mLoopsInMacro;
+  }
+
+  /// Returns call expressions expanded from macros.
+  const MacroMap<clang::Stmt> & getCallsInMacro() const noexcept {
+    return mCallsInMacro;
+  }
+
+  /// Returns variable declarations expanded from macros.
+  const MacroMap<clang::VarDecl> & getVarsInMacro() const noexcept {
+    return mVarsInMacro;
+  }
+
+private:
+  friend class ASTIndexBuilder;
+
+  StmtList mStmts;
+  StmtList mLoops;
+  StmtList mCalls;
+  VarList mVars;
+  MacroMap<clang::Stmt> mLoopsInMacro;
+  MacroMap<clang::Stmt> mCallsInMacro;
+  MacroMap<clang::VarDecl> mVarsInMacro;
+};
+}
+#endif//TSAR_CLANG_AST_INDEX_H
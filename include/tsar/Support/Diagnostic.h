@@ -46,5 +46,14 @@ inline void emitTypeOverflow(llvm::LLVMContext &Ctx, const llvm::Function &F,
   llvm::DiagnosticInfoUnsupported Diag(F, "type overflow", Loc, Severity);
   Ctx.diagnose(Diag);
 }
+
+inline void emitBudgetExceeded(llvm::LLVMContext &Ctx, const llvm::Function &F,
+    const llvm::DebugLoc &Loc,
+    llvm::DiagnosticSeverity Severity = llvm::DS_Warning) {
+  llvm::DiagnosticInfoUnsupported Diag(F,
+    "analysis budget exceeded, conservative dependencies are assumed",
+    Loc, Severity);
+  Ctx.diagnose(Diag);
+}
 }
 #endif//TSAR_IR_DIANGOSTIC_H
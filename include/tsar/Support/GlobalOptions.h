@@ -36,6 +36,8 @@ namespace tsar {
 struct GlobalOptions {
   /// Print only names of files instead of full paths.
   bool PrintFilenameOnly = false;
+  /// Print memory usage when each processing step finishes.
+  bool PrintMemoryUsage = false;
   /// Disallow unsafe integer type cast in analysis passes.
   bool IsSafeTypeCast = true;
   /// Assume that subscript expression is in bounds value of an array dimension.
@@ -58,8 +60,23 @@ struct GlobalOptions {
   bool UnsafeTfmAnalysis = false;
   /// Assume that functions are never called outside the analyzed module.
   bool NoExternalCalls = false;
+  /// Maximum time (in milliseconds) to search for dependencies in a loop,
+  /// `0` means unlimited time.
+  unsigned LoopTimeBudget = 0;
+  /// Maximum time (in milliseconds) to search for dependencies in all loops
+  /// of a function, `0` means unlimited time.
+  unsigned FunctionTimeBudget = 0;
+  /// Maximum number of queries to alias and dependence analysis which are
+  /// performed to search for dependencies in a loop, `0` means unlimited
+  /// number of queries.
+  unsigned LoopQueryBudget = 0;
   /// Pass to external analysis results which is used to clarify analysis/
   std::string AnalysisUse = "";
+  /// Store summaries of externally visible functions to this file.
+  std::string SummaryExport = "";
+  /// Use summaries of functions from this file to analyze calls of functions
+  /// which are defined in other translation units.
+  std::string SummaryUse = "";
   /// List of regions which should be optimized.
   std::vector<std::string> OptRegions;
   /// This suffix should be add to transformed sources before extension.
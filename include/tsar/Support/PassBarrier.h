@@ -20,20 +20,35 @@
 // Some function passes (for example DefinedMemoryPass) may use results of
 // module passes and these results becomes invalid after transformations.
 // A pass in this file do nothing but allow us to finish processing of
-// all functions before transformations.
+// all functions before transformations. A barrier also reports memory usage
+// of a finished stage if it is requested.
 //
 //===----------------------------------------------------------------------===//
 
 #ifndef TSAR_PASS_BARRIER_H
 #define TSAR_PASS_BARRIER_H
 
+#include <llvm/ADT/StringRef.h>
+#include <cstddef>
+
 namespace llvm {
 class ModulePass;
 class PassRegistry;
 
 void initializePassBarrierPass(PassRegistry &Registry);
 
-ModulePass *createPassBarrier();
+/// Create a barrier which finishes a specified stage of processing.
+///
+/// If GlobalOptions::PrintMemoryUsage is set, current memory usage and its
+/// change since the previous barrier are printed when all passes of the stage
+/// have been finished.
+ModulePass *createPassBarrier(StringRef Stage = "");
+}
+
+namespace tsar {
+/// Return current resident set size (in bytes) of the current process or 0 if
+/// it is unknown.
+std::size_t getMemoryUsage();
 }
 
 #endif//TSAR_PASS_BARRIER_H
@@ -79,6 +79,26 @@ void initializeClangOpenMPParallelizationPass(PassRegistry &Registry);
 /// Create a pass to perform OpenMP-based parallelization.
 ModulePass* createClangOpenMPParallelization();
 
+/// Initialize a pass to insert OpenMP simd directives before innermost loops.
+void initializeClangOpenMPSimdPass(PassRegistry &Registry);
+
+/// Create a pass to insert OpenMP simd directives before innermost loops.
+ModulePass* createClangOpenMPSimd();
+
+/// Initialize a pass to distribute loops in order to separate parallel
+/// statements from sequential ones.
+void initializeClangLoopDistributionPass(PassRegistry &Registry);
+
+/// Create a pass to distribute loops in order to separate parallel
+/// statements from sequential ones.
+ModulePass* createClangLoopDistribution();
+
+/// Initialize a pass to convert arrays of structures to structures of arrays.
+void initializeClangStructToArraysPass(PassRegistry &Registry);
+
+/// Create a pass to convert arrays of structures to structures of arrays.
+ModulePass* createClangStructToArrays();
+
 /// Initialize a pass to perform DVMH-based parallelization for shared memory.
 void initializeClangDVMHSMParallelizationPass(PassRegistry &Registry);
 
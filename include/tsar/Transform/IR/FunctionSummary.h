@@ -0,0 +1,158 @@
+//===- FunctionSummary.h - Interprocedural Function Summaries ---*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file describes summaries of externally visible functions in JSON
+// format. Summaries are exported after interprocedural analysis of a
+// translation unit and allow analysis of other translation units to avoid
+// conservative assumptions about calls of these functions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_FUNCTION_SUMMARY_H
+#define TSAR_FUNCTION_SUMMARY_H
+
+#include <bcl/Json.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tsar {
+namespace summary {
+/// Summary of a pointer argument of a function.
+JSON_OBJECT_BEGIN(Argument)
+JSON_OBJECT_PAIR_4(Argument,
+  Index, unsigned,
+  Read, bool,
+  Write, bool,
+  NoCapture, bool)
+
+  Argument() : JSON_INIT(Argument, 0, true, true, false) {}
+JSON_OBJECT_END(Argument)
+
+/// Memory location which is accessed in a function.
+///
+/// The location is a part of memory pointed to by an argument (`Arg` is its
+/// number) or a part of an externally visible global variable (`Arg` is -1
+/// and `Global` is its name). Bounds are offsets in bytes from the beginning
+/// of the memory, `Upper` is UINT64_MAX if it is unknown.
+JSON_OBJECT_BEGIN(Location)
+JSON_OBJECT_PAIR_4(Location,
+  Arg, int,
+  Global, std::string,
+  Lower, std::uint64_t,
+  Upper, std::uint64_t)
+
+  Location() : JSON_INIT(Location, -1, "", 0, UINT64_MAX) {}
+JSON_OBJECT_END(Location)
+
+/// Results of interprocedural reach definition analysis for a function.
+///
+/// If `Known` is not set, a function accesses memory which can not be
+/// described in terms of its arguments and global variables. `Addresses`
+/// is a list of global variables addresses of which are evaluated.
+JSON_OBJECT_BEGIN(DefUse)
+JSON_OBJECT_PAIR_5(DefUse,
+  Known, bool,
+  Defs, std::vector<Location>,
+  MayDefs, std::vector<Location>,
+  Uses, std::vector<Location>,
+  Addresses, std::set<std::string>)
+
+  DefUse() : JSON_INIT(DefUse, false, {}, {}, {}, {}) {}
+JSON_OBJECT_END(DefUse)
+
+/// Summary of a function which is defined in a translation unit.
+///
+/// If `NoGlobalAccess` is set, a function accesses memory which is pointed to
+/// by its arguments only. If `ReadOnly` is set, a function does not write
+/// memory. A def-use set is imported and attached to declarations of
+/// a function.
+JSON_OBJECT_BEGIN(Function)
+JSON_OBJECT_PAIR_9(Function,
+  Name, std::string,
+  NoThrow, bool,
+  NoMemoryAccess, bool,
+  NoGlobalAccess, bool,
+  ReadOnly, bool,
+  NoIO, bool,
+  AlwaysReturn, bool,
+  Args, std::vector<Argument>,
+  DefUseSet, DefUse)
+
+  Function() :
+    JSON_INIT(Function, "", false, false, false, false, false, false, {},
+      DefUse()) {}
+JSON_OBJECT_END(Function)
+
+/// Summaries of functions defined in a translation unit, `Calls` is a list of
+/// external functions which are called in this unit.
+JSON_OBJECT_BEGIN(Unit)
+JSON_OBJECT_PAIR_3(Unit,
+  File, std::string,
+  Functions, std::vector<Function>,
+  Calls, std::set<std::string>)
+JSON_OBJECT_END(Unit)
+
+/// Definition of a top-level JSON-object which contains summaries of all
+/// analyzed translation units.
+JSON_OBJECT_BEGIN(Summary)
+  JSON_OBJECT_ROOT_PAIR_1(Summary, Units, std::vector<Unit>)
+  Summary() : JSON_INIT_ROOT{}
+JSON_OBJECT_END(Summary)
+}
+
+/// Load summaries from a specified file.
+///
+/// On failure this function returns `false` and a description of errors is
+/// stored in `ErrMsg` (if it is not null).
+bool loadFunctionSummary(llvm::StringRef File, summary::Summary &S,
+  std::string *ErrMsg = nullptr);
+
+/// Store summaries to a specified file.
+///
+/// On failure this function returns `false` and a description of errors is
+/// stored in `ErrMsg` (if it is not null).
+bool storeFunctionSummary(llvm::StringRef File, const summary::Summary &S,
+  std::string *ErrMsg = nullptr);
+
+/// Partition sources into at most `ShardNum` shards.
+///
+/// Each source is described with its summaries `Summaries` and its weight
+/// `Weights`. Sources which call functions defined in each other are placed in
+/// the same shard. Groups of related sources are assigned to the least loaded
+/// shard in order of decreasing weight. Each shard is a sorted list of indices
+/// of sources, empty shards are not returned.
+std::vector<std::vector<std::size_t>> partitionByLocality(
+  llvm::ArrayRef<summary::Summary> Summaries,
+  llvm::ArrayRef<std::uint64_t> Weights, unsigned ShardNum);
+}
+
+JSON_DEFAULT_TRAITS(tsar::summary::, Argument)
+JSON_DEFAULT_TRAITS(tsar::summary::, Location)
+JSON_DEFAULT_TRAITS(tsar::summary::, DefUse)
+JSON_DEFAULT_TRAITS(tsar::summary::, Function)
+JSON_DEFAULT_TRAITS(tsar::summary::, Unit)
+JSON_DEFAULT_TRAITS(tsar::summary::, Summary)
+
+#endif//TSAR_FUNCTION_SUMMARY_H
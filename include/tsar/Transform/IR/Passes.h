@@ -59,6 +59,30 @@ void initializeRPOFunctionAttrsAnalysisPass(PassRegistry &Registry);
 /// Create a pass which deduce function attributes in RPO.
 ModulePass * createRPOFunctionAttrsAnalysis();
 
+/// Initialize a pass which adds attributes to library functions in
+/// accordance with their summaries.
+void initializeLibFuncAttrsAnalysisPass(PassRegistry &Registry);
+
+/// Create a pass which adds attributes to library functions in accordance
+/// with their summaries.
+ModulePass * createLibFuncAttrsAnalysis();
+
+/// Initialize a pass which stores summaries of externally visible functions.
+void initializeFunctionSummaryExportPassPass(PassRegistry &Registry);
+
+/// Create a pass which stores summaries of externally visible functions
+/// to a file specified with GlobalOptions::SummaryExport.
+ModulePass * createFunctionSummaryExportPass();
+
+/// Initialize a pass which adds attributes to declarations of functions in
+/// accordance with imported summaries.
+void initializeFunctionSummaryImportPassPass(PassRegistry &Registry);
+
+/// Create a pass which adds attributes to declarations of functions in
+/// accordance with summaries from a file specified with
+/// GlobalOptions::SummaryUse.
+ModulePass * createFunctionSummaryImportPass();
+
 /// Initialize a pass which deduce loop attributes.
 void initializeLoopAttributesDeductionPassPass(PassRegistry &Registry);
 
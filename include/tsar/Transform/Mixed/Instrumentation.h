@@ -26,15 +26,23 @@
 #define TSAR_INSTRUMENTATION_H
 
 #include "tsar/ADT/ItemRegister.h"
+#include "tsar/Analysis/Intrinsics.h"
 #include "tsar/Analysis/Clang/CanonicalLoop.h"
 #include "tsar/Transform/Mixed/Passes.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/BitmaskEnum.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/IR/InstVisitor.h>
 #include <llvm/Pass.h>
+#include <vector>
+
+namespace tsar {
+class OptimizationRegion;
+}
 
 namespace llvm {
 class DominatorTree;
@@ -60,9 +68,27 @@ public:
   /// If `StartFrom` is not empty all mentioned functions and transitive
   /// callees from these functions should be processed only.
   /// Other functions will be marked with sapfor.da.ignore metadata.
-  InstrumentationPass(StringRef InstrEntry, ArrayRef<std::string> StartFrom) :
+  ///
+  /// If `EventBufferSize` is not zero events are accumulated in a thread-local
+  /// buffer which can store a specified number of records.
+  ///
+  /// If `SamplePeriod` is not zero iterations of innermost loops are sampled:
+  /// the first `SampleFirst` iterations and each `SamplePeriod`-th iteration
+  /// are instrumented only.
+  ///
+  /// If `RegisterRanges` is `true` strided accesses in canonical loops are
+  /// registered once in a loop preheader (see regStridedAccesses()).
+  ///
+  /// If a source code contains optimization regions ('#pragma spf region')
+  /// only loops and functions in these regions are instrumented.
+  InstrumentationPass(StringRef InstrEntry, ArrayRef<std::string> StartFrom,
+      unsigned EventBufferSize = 0, unsigned SampleFirst = 0,
+      unsigned SamplePeriod = 0, bool RegisterRanges = false) :
       ModulePass(ID), mInstrEntry(InstrEntry),
-      mStartFrom(StartFrom.begin(), StartFrom.end()) {
+      mStartFrom(StartFrom.begin(), StartFrom.end()),
+      mEventBufferSize(EventBufferSize),
+      mSampleFirst(SampleFirst), mSamplePeriod(SamplePeriod),
+      mRegisterRanges(RegisterRanges) {
     initializeInstrumentationPassPass(*PassRegistry::getPassRegistry());
   }
 
@@ -78,9 +104,36 @@ public:
   /// Return names of functions where instrumentation is started.
   ArrayRef<std::string> getStartFrom() const { return mStartFrom; }
 
+  /// Return number of records in a buffer of events, zero means that events
+  /// should not be buffered.
+  unsigned getEventBufferSize() const { return mEventBufferSize; }
+
+  /// Return number of the first iterations of a loop which are always
+  /// instrumented if sampling is enabled.
+  unsigned getSampleFirst() const { return mSampleFirst; }
+
+  /// Return period of instrumented iterations of a loop, zero means that
+  /// sampling is disabled.
+  unsigned getSamplePeriod() const { return mSamplePeriod; }
+
+  /// Return `true` if strided accesses in loops should be registered once
+  /// per loop entry.
+  bool registerRanges() const { return mRegisterRanges; }
+
+  /// Return optimization regions which should be instrumented, empty list
+  /// means that the whole program should be instrumented.
+  ArrayRef<const tsar::OptimizationRegion *> getRegions() const {
+    return mRegions;
+  }
+
 private:
   std::string mInstrEntry;
   std::vector<std::string> mStartFrom;
+  unsigned mEventBufferSize = 0;
+  unsigned mSampleFirst = 0;
+  unsigned mSamplePeriod = 0;
+  bool mRegisterRanges = false;
+  SmallVector<const tsar::OptimizationRegion *, 4> mRegions;
 };
 }
 
@@ -106,6 +159,17 @@ llvm::Function * createEmptyInitDI(llvm::Module &M, llvm::Type &IdTy);
 /// 'sapfor.di.pool' name already exists and it can not be used as a pool.
 llvm::GlobalVariable *getOrCreateDIPool(llvm::Module &M);
 
+/// \brief Returns thread-local variable which refers to
+/// a "sapfor.event.buffer" in a specified module.
+///
+/// The buffer contains number of stored events and a storage for `Size`
+/// records (see getEventType()). It has 'linkonce' linkage, so a single buffer
+/// is shared between all modules if they use the same size of the buffer.
+/// \return This function returns 'nullptr', if a global value with the
+/// 'sapfor.event.buffer' name already exists and it can not be used as
+/// a buffer.
+llvm::GlobalVariable *getOrCreateEventBuffer(llvm::Module &M, unsigned Size);
+
 /// \brief Processes a specified entry point.
 ///
 /// This function performs instrumentation of a specified entry point.
@@ -116,6 +180,8 @@ llvm::GlobalVariable *getOrCreateDIPool(llvm::Module &M);
 /// - An external pool must be declared in each module (see getOrCreateDIPool).
 /// - Named metadata for each module must contain description of objects
 /// that should be initialized (see addNamedDAMetadata).
+/// \post If events are buffered in some of modules, the buffer is flushed
+/// before exit from the entry point.
 void visitEntryPoint(llvm::Function &Entry,
   llvm::ArrayRef<llvm::Module *> Modules);
 
@@ -145,6 +211,14 @@ class Instrumentation : public llvm::InstVisitor<Instrumentation> {
     LoopBoundUnsigned = 1u << 3,
     LLVM_MARK_AS_BITMASK_ENUM(LoopBoundUnsigned)
   };
+
+  /// Description of a loop which iterations should be sampled.
+  struct SampledLoop {
+    llvm::BasicBlock *Header;
+    llvm::SmallVector<llvm::BasicBlock *, 2> Latches;
+    /// Call of sapforSLIter() which has been inserted into the loop header.
+    llvm::CallInst *Iter;
+  };
 public:
   /// Processes a specified module.
   static void visit(llvm::Module &M, llvm::InstrumentationPass &IP) {
@@ -175,9 +249,31 @@ private:
   /// for example, functions which are marked as 'sapfor.da'.
   /// \post If -instr-start option is specified all functions except
   /// mentioned functions and transitive callees from these functions
-  /// will be marked with 'sapfor.da.ignore'.
+  /// will be marked with 'sapfor.da.ignore'. If optimization regions are
+  /// specified functions which neither contain regions nor are executed
+  /// after regions will be also marked with 'sapfor.da.ignore'.
   void excludeFunctions(llvm::Module &M);
 
+  /// Determines parts of a specified function which are contained
+  /// in optimization regions (see isInRegion()) and parts which may be
+  /// executed after regions (see isAfterRegion()).
+  void collectRegionBlocks(llvm::Function &F, llvm::LoopInfo &LI);
+
+  /// Return true if a specified basic block in a currently processed function
+  /// should be instrumented.
+  bool isInRegion(const llvm::BasicBlock &BB) const {
+    return mIsFunctionInRegion || mRegionBlocks.count(&BB);
+  }
+
+  /// Return true if a specified basic block in a currently processed function
+  /// may be executed after some optimization region.
+  ///
+  /// Only memory accesses are registered in such blocks, because traits of
+  /// loops in regions (for example, UseAfterLoop) depend on them.
+  bool isAfterRegion(const llvm::BasicBlock &BB) const {
+    return mAfterRegionBlocks.count(&BB);
+  }
+
   void regReadMemory(llvm::Instruction &I, llvm::Value &Ptr);
   void regWriteMemory(llvm::Instruction &I, llvm::Value &Ptr);
 
@@ -212,6 +308,13 @@ private:
     regMemoryAccessArgs(llvm::Value *Ptr, const llvm::DebugLoc &DbgLoc,
       llvm::Instruction &InsertBefore);
 
+  /// \brief Returns index of a metadata string for a base of accessed memory.
+  ///
+  /// If the base has not been registered yet, it will be registered before
+  /// a specified instruction.
+  DIStringRegister::IdTy regMemoryBase(llvm::Value *BasePtr,
+    llvm::Instruction &InsertBefore);
+
   /// \brief Registers a metadata string and a variable.
   ///
   /// \post Insert calls of `sapforInitDI` and `sapforRegVar/sapforRegArr`.
@@ -307,7 +410,30 @@ private:
 
   /// Registers metadata string which describes a loop and inserts call of
   /// sapforSLBegin() function.
-  void loopBeginInstr(llvm::Loop *L, DIStringRegister::IdTy DILoopIdx,
+  ///
+  /// If `IsSampled` is `true` the sampling policy is also stored in
+  /// the metadata string. If `HasSampledNested` is `true` some of nested loops
+  /// are sampled, so accesses in the loop are not completely registered.
+  /// \return <start,end,step,signed> tuple which has been computed to
+  /// register the loop (see computeLoopBounds()).
+  std::tuple<llvm::Value *, llvm::Value *, llvm::Value *, bool>
+    loopBeginInstr(llvm::Loop *L, DIStringRegister::IdTy DILoopIdx,
+      bool IsSampled, bool HasSampledNested, llvm::ScalarEvolution &SE,
+      llvm::DominatorTree &DT, DFRegionInfo &RI, const CanonicalLoopSet &CS);
+
+  /// \brief Registers strided accesses to memory in a specified loop at once.
+  ///
+  /// An access is summarized if it is executed once at each iteration of
+  /// a canonical loop and its address is an add recurrence of this loop.
+  /// A call of sapforReadArrRange()/sapforWriteArrRange() is inserted into
+  /// the loop preheader for each such access, so the access is not
+  /// instrumented inside the loop. Hence, order of the access and other
+  /// accesses at the same iteration is lost and a runtime library must not
+  /// rely on it.
+  /// \pre The loop must be registered with loopBeginInstr() and
+  /// `Start`, `End`, `Step` must be computed bounds of the loop.
+  void regStridedAccesses(llvm::Loop *L, llvm::Value *Start,
+    llvm::Value *End, llvm::Value *Step, bool Signed, llvm::LoopInfo &LI,
     llvm::ScalarEvolution &SE, llvm::DominatorTree &DT,
     DFRegionInfo &RI, const CanonicalLoopSet &CS);
 
@@ -320,7 +446,26 @@ private:
   /// A start value of the counter is 1. The counter is an argument for
   /// sapforSIter() function. Note, that this counter has not been presented in
   /// a source code.
-  void loopIterInstr(llvm::Loop *L, DIStringRegister::IdTy DILoopIdx);
+  /// \return Inserted call of sapforSLIter().
+  llvm::CallInst * loopIterInstr(llvm::Loop *L,
+    DIStringRegister::IdTy DILoopIdx);
+
+  /// \brief Returns `true` if iterations of a specified loop can be sampled.
+  ///
+  /// Innermost loops which do not call instrumented functions are sampled
+  /// only, because calls inside uninstrumented iterations would produce
+  /// events which are not bound to any iteration.
+  bool isSampled(llvm::Loop &L);
+
+  /// \brief Creates an uninstrumented version of a specified loop body and
+  /// dispatches iterations between instrumented and uninstrumented versions.
+  ///
+  /// The body is cloned after instrumentation of the whole function and
+  /// all calls of intrinsics which are marked with 'sapfor.da' metadata are
+  /// removed from the clone. Instructions which are placed in the loop header
+  /// are not cloned, so they are instrumented at each iteration.
+  /// The sapforSLIter() call is moved to the instrumented version.
+  void sampleLoop(SampledLoop &SL);
 
   /// \brief Creates instructions to compute bounds and step of canonical loop.
   ///
@@ -333,6 +478,21 @@ private:
       llvm::ScalarEvolution &SE, llvm::DominatorTree &DT,
       DFRegionInfo &RI, const CanonicalLoopSet &CS);
 
+  /// \brief Replaces calls of intrinsics in a specified function with
+  /// instructions which store appropriate events in the buffer of events.
+  ///
+  /// The buffer is flushed when it is full, before calls of intrinsics which
+  /// can not be buffered and before calls of functions which do not return.
+  /// An empty buffer is registered with sapforRegEventBuffer() when the
+  /// first event is stored into it, so a runtime library is able to flush
+  /// the buffer at thread exit or at exit from uninstrumented code.
+  /// \pre The function has been already instrumented.
+  void bufferEvents(llvm::Function &F);
+
+  /// Replaces a specified call of intrinsic `Id` with instructions
+  /// which append an appropriate record to the buffer of events.
+  void bufferEvent(llvm::CallInst &Call, IntrinsicId Id);
+
   /// Recursively delete instruction with empty list of uses (for all deleted
   /// instructions a parent must be specified).
   void deleteDeadInstructions(llvm::Instruction *From);
@@ -351,8 +511,32 @@ private:
   DIStringRegister mDIStrings;
   llvm::GlobalVariable *mDIPool = nullptr;
   llvm::Function *mInitDIAll = nullptr;
+  /// Thread-local buffer of events, it is `nullptr` if events should not be
+  /// buffered.
+  llvm::GlobalVariable *mEventBuffer = nullptr;
   /// Dominator tree of a currently processed function.
   llvm::DominatorTree *mDT = nullptr;
+  /// Accesses in a currently processed function which have been already
+  /// registered with regStridedAccesses().
+  llvm::DenseSet<llvm::Instruction *> mStridedAccesses;
+  /// Loops in a currently processed function which should be sampled.
+  std::vector<SampledLoop> mSampledLoops;
+  /// This is `true` if the whole currently processed function is contained
+  /// in optimization regions.
+  bool mIsFunctionInRegion = true;
+  /// Basic blocks of loops in optimization regions, this set is used if
+  /// only some of loops in a currently processed function are contained
+  /// in optimization regions.
+  llvm::DenseSet<const llvm::BasicBlock *> mRegionBlocks;
+  /// Basic blocks out of optimization regions which may be executed after
+  /// regions in a currently processed function.
+  llvm::DenseSet<const llvm::BasicBlock *> mAfterRegionBlocks;
+  /// Functions which are contained in optimization regions, which contain
+  /// some of regions or which transitively call such functions.
+  llvm::DenseSet<const llvm::Function *> mRegionFunctions;
+  /// Functions which do not execute regions, however they may be called after
+  /// some region.
+  llvm::DenseSet<const llvm::Function *> mAfterRegionFunctions;
 };
 }
 
@@ -44,8 +44,17 @@ void initializeMixedTransform(PassRegistry &Registry);
 void initializeInstrumentationPassPass(PassRegistry &Registry);
 
 /// Create a pass to perform low-level (LLVM IR) instrumentation of program.
+///
+/// If `EventBufferSize` is not zero, events are stored in a thread-local
+/// buffer of a specified size instead of separate calls of intrinsics.
+/// If `SamplePeriod` is not zero, only the first `SampleFirst` iterations and
+/// each `SamplePeriod`-th iteration of innermost loops are instrumented.
+/// If `RegisterRanges` is `true`, strided accesses in canonical loops are
+/// registered once per loop entry.
 ModulePass * createInstrumentationPass(llvm::StringRef InstrEntry = "",
-  llvm::ArrayRef<std::string> StartFrom = {});
+  llvm::ArrayRef<std::string> StartFrom = {}, unsigned EventBufferSize = 0,
+  unsigned SampleFirst = 0, unsigned SamplePeriod = 0,
+  bool RegisterRanges = false);
 
 /// Initialize a pass which retrieves some debug information for a loop if
 /// it is not presented in LLVM IR.
@@ -37,6 +37,7 @@ class Module;
 
 namespace tsar {
 struct DIMemoryLocation;
+class DIEstimateMemory;
 
 /// Unparses the expression (in a specified language DWLang) and appends result
 /// to a specified string, returns true on success.
@@ -50,6 +51,24 @@ bool unparsePrint(unsigned DWLang,
   const DIMemoryLocation &Loc, llvm::raw_ostream &OS,
   bool IsMinimal = true);
 
+/// Unparses a memory location (in a specified language DWLang) and appends
+/// result to a specified string, returns true on success.
+///
+/// The result is cached in the environment of the memory, so the location
+/// is unparsed only once until the memory is destroyed.
+bool unparseToString(unsigned DWLang,
+  const DIEstimateMemory &M, llvm::SmallVectorImpl<char> &S,
+  bool IsMinimal = true);
+
+/// Unparses a memory location (in a specified language DWLang) and prints
+/// result to a specified stream returns true on success.
+///
+/// The result is cached in the environment of the memory, so the location
+/// is unparsed only once until the memory is destroyed.
+bool unparsePrint(unsigned DWLang,
+  const DIEstimateMemory &M, llvm::raw_ostream &OS,
+  bool IsMinimal = true);
+
 /// Unparses the expression (in a specified language DWLang) and prints result
 /// to the debug stream returns true on success.
 bool unparseDump(unsigned DWLang, const DIMemoryLocation &Loc,
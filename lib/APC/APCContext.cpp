@@ -26,6 +26,7 @@
 #include "APCContextImpl.h"
 #include "tsar/APC/APCContext.h"
 #include "tsar/APC/Passes.h"
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Pass.h>
 #include <map>
 
@@ -71,6 +72,32 @@ ParallelRegion & APCContext::getDefaultRegion() {
   return *mImpl->ParallelRegions.front();
 }
 
+std::pair<apc::ParallelRegion *, bool> APCContext::addRegion(StringRef Name) {
+  assert(mIsInitialized && "Context must be initialized!");
+  if (auto *R = findRegion(Name))
+    return std::make_pair(R, false);
+  mImpl->ParallelRegions.push_back(
+    make_unique<ParallelRegion>(mImpl->ParallelRegions.size(), Name.str()));
+  return std::make_pair(mImpl->ParallelRegions.back().get(), true);
+}
+
+apc::ParallelRegion * APCContext::findRegion(StringRef Name) {
+  auto I = find_if(mImpl->ParallelRegions,
+    [Name](const std::unique_ptr<ParallelRegion> &R) {
+      return R->GetName() == Name;
+  });
+  return I != mImpl->ParallelRegions.end() ? I->get() : nullptr;
+}
+
+std::size_t APCContext::getNumberOfRegions() const {
+  return mImpl->ParallelRegions.size();
+}
+
+apc::ParallelRegion & APCContext::getRegion(std::size_t Idx) {
+  assert(Idx < mImpl->ParallelRegions.size() && "Index is out of range!");
+  return *mImpl->ParallelRegions[Idx];
+}
+
 void APCContext::addSymbol(apc::Symbol *S) {
   mImpl->Symbols.emplace_back(S);
 }
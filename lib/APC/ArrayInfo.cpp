@@ -45,6 +45,8 @@
 #include <llvm/IR/Dominators.h>
 #include <llvm/Pass.h>
 #include <llvm/Support/Format.h>
+#include <set>
+#include <string>
 
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "apc-array-info"
@@ -161,10 +163,15 @@ bool APCArrayInfoPass::runOnFunction(Function &F) {
     assert(RawDIM && "Unknown raw memory!");
     auto APCSymbol = new apc::Symbol(*DILoc);
     APCCtx.addSymbol(APCSymbol);
+    // An array may be accessed in any parallel region because regions may
+    // contain calls of functions which accept this array as a parameter.
+    std::set<std::string> RegionNames;
+    for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I)
+      RegionNames.insert(APCCtx.getRegion(I).GetName());
     auto APCArray = new apc::Array(UniqueName, DILoc->Var->getName(),
       A->getNumberOfDims(), APCCtx.getNumberOfArrays(),
       Filename, ShrinkedDeclLoc, std::move(DeclScope), APCSymbol,
-      { APCCtx.getDefaultRegion().GetName() }, getSize(DIElementTy));
+      RegionNames, getSize(DIElementTy));
     if (!APCCtx.addArray(RawDIM, APCArray)) {
       // This pass may be executed in analysis mode. It depends on -print-only
       // and -print-step options. In case of parallelization pass manager must
@@ -29,6 +29,7 @@
 #include "tsar/APC/APCContext.h"
 #include "tsar/Analysis/Clang/GlobalInfoExtractor.h"
 #include "tsar/Analysis/Clang/MemoryMatcher.h"
+#include "tsar/Analysis/Clang/Passes.h"
 #include "tsar/Analysis/Clang/DIMemoryMatcher.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Analysis/Passes.h"
@@ -46,6 +47,7 @@
 #include <bcl/utility.h>
 #include <clang/AST/Decl.h>
 #include <clang/AST/ASTContext.h>
+#include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Lex/Lexer.h>
 #include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/DenseMap.h>
@@ -55,6 +57,7 @@
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/raw_ostream.h>
 #include <llvm/Transforms/InstCombine/InstCombine.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Utils.h>
@@ -97,6 +100,82 @@ private:
   DeclarationInfoMap &mDecls;
 };
 
+/// Collect statements which are marked with '#pragma spf region'.
+class RegionStmtCollector : public RecursiveASTVisitor<RegionStmtCollector> {
+public:
+  /// Description of a statement which is marked with a region directive.
+  struct RegionStmt {
+    Stmt *S;
+    /// Names of regions which are mentioned in a directive.
+    SmallVector<StringRef, 1> Names;
+    /// Index of the closest enclosing region statement (-1 if there is no
+    /// such statement).
+    int Parent;
+    /// Canonical declarations of variables which are referenced in a statement.
+    DenseSet<const VarDecl *> Refs;
+  };
+
+  /// List of region statements, the parent statement precedes its children.
+  using RegionStmtList = std::vector<RegionStmt>;
+
+  explicit RegionStmtCollector(RegionStmtList &Regions) : mRegions(Regions) {}
+
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    Pragma P(*S);
+    if (P) {
+      mNames.clear();
+      mIsPending = P.getDirectiveId() == DirectiveId::Region;
+      if (!mIsPending)
+        return true;
+      SmallVector<Stmt *, 1> Clauses;
+      if (findClause(P, ClauseId::RegionName, Clauses)) {
+        for (auto *RawClause : Clauses) {
+          auto C = Pragma::clause(&RawClause);
+          for (auto NameStmt : C) {
+            auto Cast = dyn_cast<ImplicitCastExpr>(NameStmt);
+            // In case of C there will be ImplicitCastExpr,
+            // however in case of C++ it will be omitted.
+            auto LiteralStmt = Cast ? *Cast->child_begin() : NameStmt;
+            mNames.push_back(
+              cast<clang::StringLiteral>(LiteralStmt)->getString());
+          }
+        }
+      } else {
+        mNames.push_back("");
+      }
+      return true;
+    }
+    if (!mIsPending || !(isa<CompoundStmt>(S) || isa<ForStmt>(S) ||
+                         isa<WhileStmt>(S) || isa<DoStmt>(S))) {
+      mIsPending = false;
+      return RecursiveASTVisitor::TraverseStmt(S);
+    }
+    mIsPending = false;
+    mRegions.push_back(
+      { S, std::move(mNames), mActive.empty() ? -1 : mActive.back(), {} });
+    mNames.clear();
+    mActive.push_back(mRegions.size() - 1);
+    auto Res = RecursiveASTVisitor::TraverseStmt(S);
+    mActive.pop_back();
+    return Res;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+    if (auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      for (auto Idx : mActive)
+        mRegions[Idx].Refs.insert(VD->getCanonicalDecl());
+    return true;
+  }
+
+private:
+  RegionStmtList &mRegions;
+  SmallVector<int, 4> mActive;
+  SmallVector<StringRef, 1> mNames;
+  bool mIsPending = false;
+};
+
 class APCClangDVMHWriter : public ModulePass, private bcl::Uncopyable {
   /// Description of a template which is necessary for source-to-source
   /// transformation.
@@ -116,6 +195,9 @@ class APCClangDVMHWriter : public ModulePass, private bcl::Uncopyable {
   using DeclarationInfo = DeclarationInfoExtractor::DeclarationInfo;
   using DeclarationInfoMap = DeclarationInfoExtractor::DeclarationInfoMap;
 
+  /// Map from an array to its alignment rule.
+  using AlignRuleMap = DenseMap<apc::Array *, const apc::AlignRule *>;
+
 public:
   static char ID;
 
@@ -158,6 +240,27 @@ private:
     const DeclarationInfoMap &Decls, const apc::AlignRule &AR,
     const VarDecl *VD);
 
+  /// Insert `realign` directives which switch distribution of arrays between
+  /// parallel regions.
+  ///
+  /// Arrays are aligned at declarations according to `InitialRules`.
+  /// Transitions are inserted at boundaries of statements marked with
+  /// '#pragma spf region' only, so loops and calls inside a statement use
+  /// distribution of its region without further realignment. Before
+  /// a statement arrays are realigned according to rules of its region and
+  /// after a statement they are realigned back to rules of the enclosing
+  /// region statement (or to `InitialRules`). Only arrays which are visible
+  /// at a statement are realigned. Local arrays should also be referenced in
+  /// a statement, global arrays may be accessed in called functions.
+  /// \post Templates mentioned in inserted directives are stored in
+  /// the `Templates` container.
+  void insertTransitions(llvm::Module &M, APCContext &APCCtx,
+    const AlignRuleMap &InitialRules, TemplateInFileUsage &Templates);
+
+  /// Insert `Enter` directives before a specified statement and `Exit`
+  /// directives after it. Emit diagnostics in case of errors.
+  bool insertTransition(const Stmt &S, StringRef Enter, StringRef Exit);
+
   /// Insert inherit directive for all redeclarations of a specified function.
   void insertInherit(FunctionDecl *FD, const DeclarationInfoMap &Decls,
     ArrayRef<const DILocalVariable *> InheritArgs,
@@ -294,6 +397,44 @@ using APCClangDVMHWriterProvider = FunctionPassProvider<
   TransformationEnginePass,
   MemoryMatcherImmutableWrapper,
   ClangDIMemoryMatcherPass>;
+
+/// Add a specification of an alignment '[...]...[...] with <template>[...]'
+/// to a specified string.
+void addAlignmentSpec(const apc::AlignRule &AR, SmallVectorImpl<char> &Str) {
+  raw_svector_ostream OS(Str);
+  // Add dimension which should be aligned '... [...]...'
+  for (std::size_t I = 0, EI = AR.alignRule.size(); I < EI; ++I) {
+    assert((AR.alignRule[I].first == 0 || AR.alignRule[I].first == 1) &&
+      AR.alignRule[I].second == 0 && "Invalid align rule!");
+    OS << "[";
+    if (AR.alignRule[I].first == 1 && AR.alignRule[I].second == 0)
+      OS << AR.alignNames[I];
+    OS << "]";
+  }
+  auto TplDimAR = extractTplDimsAlignmentIndexes(AR);
+  // Add " ... with <template>[...]...[...]".
+  OS << " with " << AR.alignWith->GetShortName();
+  for (auto DimARIdx : TplDimAR) {
+    OS << "[";
+    if (DimARIdx < TplDimAR.size())
+      OS << genStringExpr(
+        AR.alignNames[AR.alignRuleWith[DimARIdx].first],
+        AR.alignRuleWith[DimARIdx].second);
+    OS << "]";
+  }
+}
+
+/// Add `#pragma dvm realign(...)` directive to a specified string.
+void addRealign(const apc::AlignRule &AR, SmallVectorImpl<char> &Str) {
+  SmallString<128> Realign;
+  getPragmaText(DirectiveId::DvmRealign, Realign);
+  Realign.pop_back();
+  Realign += "(";
+  Realign += AR.alignArray->GetShortName();
+  addAlignmentSpec(AR, Realign);
+  Realign += ")\n";
+  Str.append(Realign.begin(), Realign.end());
+}
 }
 
 char APCClangDVMHWriter::ID = 0;
@@ -305,6 +446,8 @@ class APCClangDVMHWriterInfo final : public PassGroupInfo {
     Passes.add(createMemoryMatcherPass());
     Passes.add(createDIMemoryEnvironmentStorage());
     Passes.add(createAPCContextStorage());
+    // Each optimization region produces a separate parallel region.
+    Passes.add(createClangRegionCollector());
     Passes.add(createAPCLoopInfoBasePass());
     Passes.add(createDIEstimateMemoryPass());
     Passes.add(createCFGSimplificationPass());
@@ -386,11 +529,17 @@ bool APCClangDVMHWriter::runOnModule(llvm::Module &M) {
     Import = &ImportPass->getImportInfo();
   auto &GIP = getAnalysis<ClangGlobalInfoPass>();
   auto &APCCtx = getAnalysis<APCContextWrapper>().get();
-  auto &APCRegion = APCCtx.getDefaultRegion();
-  auto &DataDirs = APCRegion.GetDataDir();
+  // Arrays are aligned at declarations according to rules of the default
+  // region. If an array is not distributed in the default region, rules of
+  // the first parallel region which distributes this array are used.
+  AlignRuleMap InitialRules;
+  for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I)
+    for (auto &AR : APCCtx.getRegion(I).GetDataDir().alignRules)
+      InitialRules.try_emplace(AR.alignArray, &AR);
   DenseSet<const AlignRule *> GlobalArrays;
   DenseMap<DISubprogram *, SmallVector<const AlignRule *, 16>> LocalVariables;
-  for (auto &AR : DataDirs.alignRules) {
+  for (auto &Info : InitialRules) {
+    auto &AR = *Info.second;
     auto *APCSymbol = AR.alignArray->GetDeclSymbol();
     assert(APCSymbol && "Symbol must not be null!");
     assert(APCSymbol->getMemory().isValid() && "Memory must be valid!");
@@ -463,13 +612,121 @@ bool APCClangDVMHWriter::runOnModule(llvm::Module &M) {
     insertAlignAndCollectTpl(*Itr->get<AST>(), *AR);
     NotDistrCanonicalDecls.erase(Itr->get<AST>());
   }
+  insertTransitions(M, APCCtx, InitialRules, Templates);
   checkNotDistributedDecls(NotDistrCanonicalDecls);
-  insertDistibution(APCRegion, DataDirs, Templates);
-  for (auto &TplInfo : DataDirs.distrRules)
-    GIP.getRawInfo().Identifiers.insert(TplInfo.first->GetShortName());
+  for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I) {
+    auto &APCRegion = APCCtx.getRegion(I);
+    auto &DataDirs = APCRegion.GetDataDir();
+    insertDistibution(APCRegion, DataDirs, Templates);
+    for (auto &TplInfo : DataDirs.distrRules)
+      GIP.getRawInfo().Identifiers.insert(TplInfo.first->GetShortName());
+  }
   return false;
 }
 
+void APCClangDVMHWriter::insertTransitions(llvm::Module &M,
+    APCContext &APCCtx, const AlignRuleMap &InitialRules,
+    TemplateInFileUsage &Templates) {
+  if (APCCtx.getNumberOfRegions() < 2)
+    return;
+  auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
+  DenseMap<apc::ParallelRegion *, AlignRuleMap> RegionRules;
+  auto getRules = [&RegionRules](apc::ParallelRegion *R) -> AlignRuleMap & {
+    auto Info = RegionRules.try_emplace(R);
+    if (Info.second)
+      for (auto &AR : R->GetDataDir().alignRules)
+        Info.first->second.try_emplace(AR.alignArray, &AR);
+    return Info.first->second;
+  };
+  for (auto &F : M) {
+    if (F.isDeclaration() || !APCCtx.findFunction(F))
+      continue;
+    auto *FD = dyn_cast_or_null<FunctionDecl>(
+      mTfmCtx->getDeclForMangledName(F.getName()));
+    if (!FD || !FD->hasBody())
+      continue;
+    RegionStmtCollector::RegionStmtList RegionStmts;
+    RegionStmtCollector(RegionStmts).TraverseDecl(FD);
+    if (RegionStmts.empty())
+      continue;
+    auto &Provider = getAnalysis<APCClangDVMHWriterProvider>(F);
+    auto &Matcher = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
+    SmallVector<apc::ParallelRegion *, 4> Regions;
+    for (auto &RS : RegionStmts) {
+      apc::ParallelRegion *Region = nullptr;
+      for (auto Name : RS.Names)
+        if ((Region = APCCtx.findRegion(Name)))
+          break;
+      Regions.push_back(Region);
+      auto *OuterRegion = RS.Parent < 0 ? nullptr : Regions[RS.Parent];
+      if (!Region || Region == OuterRegion)
+        continue;
+      auto isAccessible = [&F, &RS, &Matcher, &SrcMgr](apc::Array *A) {
+        auto *DIVar = A->GetDeclSymbol()->getMemory().Var;
+        if (isa<DIGlobalVariable>(DIVar))
+          return true;
+        auto Scope = DIVar->getScope();
+        while (Scope && !isa<DISubprogram>(Scope))
+          Scope = Scope->getScope().resolve();
+        if (Scope != F.getSubprogram())
+          return false;
+        auto Itr = Matcher.find<MD>(cast<DILocalVariable>(DIVar));
+        if (Itr == Matcher.end() ||
+            !RS.Refs.count(Itr->get<AST>()->getCanonicalDecl()))
+          return false;
+        // Variables which are declared inside a statement are not visible
+        // before it.
+        auto Loc = Itr->get<AST>()->getLocation();
+        return !SrcMgr.isPointWithin(Loc, RS.S->getLocStart(),
+                                     RS.S->getLocEnd());
+      };
+      SmallString<256> Enter, Exit;
+      SmallVector<const apc::AlignRule *, 8> UsedRules;
+      for (auto &AR : Region->GetDataDir().alignRules) {
+        auto *OuterAR = InitialRules.lookup(AR.alignArray);
+        if (OuterRegion)
+          if (auto *ParentAR = getRules(OuterRegion).lookup(AR.alignArray))
+            OuterAR = ParentAR;
+        if (!OuterAR || OuterAR == &AR || !isAccessible(AR.alignArray))
+          continue;
+        addRealign(AR, Enter);
+        addRealign(*OuterAR, Exit);
+        UsedRules.push_back(&AR);
+        UsedRules.push_back(OuterAR);
+      }
+      if (Enter.empty() || !insertTransition(*RS.S, Enter, Exit))
+        continue;
+      // Templates should be declared in a file before 'realign' directives.
+      auto FID = SrcMgr.getFileID(RS.S->getLocStart());
+      auto TplItr = Templates.try_emplace(FID).first;
+      for (auto *AR : UsedRules)
+        TplItr->second.try_emplace(AR->alignWith);
+    }
+  }
+}
+
+bool APCClangDVMHWriter::insertTransition(const Stmt &S, StringRef Enter,
+    StringRef Exit) {
+  auto &Ctx = mTfmCtx->getContext();
+  auto &SrcMgr = Ctx.getSourceManager();
+  auto &Diags = Ctx.getDiagnostics();
+  auto StartLoc = S.getLocStart();
+  Token SemiTok;
+  auto EndLoc = (!getRawTokenAfter(S.getLocEnd(), SrcMgr,
+      Ctx.getLangOpts(), SemiTok) && SemiTok.is(tok::semi))
+    ? SemiTok.getLocation() : S.getLocEnd();
+  if (StartLoc.isMacroID() || EndLoc.isMacroID()) {
+    auto Loc = StartLoc.isMacroID() ? StartLoc : EndLoc;
+    toDiag(Diags, Loc, diag::err_apc_insert_dvm_directive) << Enter.trim();
+    toDiag(Diags, Loc, diag::note_apc_insert_macro_prevent);
+    return false;
+  }
+  insertDirective(StartLoc, Enter);
+  EndLoc = getLocationToTransform(EndLoc);
+  mTfmCtx->getRewriter().InsertTextAfterToken(EndLoc, ("\n" + Exit).str());
+  return true;
+}
+
 void APCClangDVMHWriter::initializeDeclInfo(const TranslationUnitDecl &Unit,
     const ASTImportInfo &ImportInfo, DeclarationInfoMap &Decls,
     DeclarationSet &CanonicalDecls) {
@@ -574,28 +831,7 @@ SourceLocation APCClangDVMHWriter::insertAlignment(const  ASTImportInfo &Import,
   getPragmaText(ClauseId::DvmAlign, Align);
   Align.pop_back();
   Align += "(";
-  // Add dimension which should be aligned '... [...]...'
-  for (std::size_t I = 0, EI = AR.alignRule.size(); I < EI; ++I) {
-    assert((AR.alignRule[I].first == 0 || AR.alignRule[I].first == 1) &&
-      AR.alignRule[I].second == 0 && "Invalid align rule!");
-    Align += "[";
-    if (AR.alignRule[I].first == 1 && AR.alignRule[I].second == 0)
-     Align += AR.alignNames[I];
-    Align += "]";
-  }
-  auto TplDimAR = extractTplDimsAlignmentIndexes(AR);
-  // Add " ... with <template>[...]...[...]".
-  Align += " with ";
-  Align += AR.alignWith->GetShortName();
-  for (auto DimARIdx : TplDimAR) {
-    Align += "[";
-    if (DimARIdx < TplDimAR.size()) {
-      Align += genStringExpr(
-        AR.alignNames[AR.alignRuleWith[DimARIdx].first],
-        AR.alignRuleWith[DimARIdx].second);
-    }
-    Align += "]";
-  }
+  addAlignmentSpec(AR, Align);
   Align += ")\n";
   auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
   SourceLocation DefinitionLoc;
@@ -27,6 +27,7 @@
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
+#include "tsar/Analysis/Reader/IterationCounts.h"
 #include "tsar/APC/APCContext.h"
 #include "tsar/APC/Passes.h"
 #include "tsar/Core/Query.h"
@@ -78,6 +79,58 @@ using ArrayAccessPool = std::vector<bcl::ValuePtrWrapper<apc::ArrayInfo>>;
 using LoopToArrayMap =
   std::map<apc::LoopGraph *, std::map<apc::Array*, const apc::ArrayInfo*>>;
 
+/// Number of iterations of a loop if it can not be estimated.
+constexpr double DefaultTripCount = 100.0;
+
+/// Estimates of a number of executions of loop bodies in a function.
+///
+/// If a total number of executed iterations of a loop is known from external
+/// analysis results it is used. Otherwise, the number of executions of a loop
+/// body is a product of a maximum trip count of the loop and the number of
+/// executions of a body of the outer loop. So, the estimate grows with a loop
+/// depth if trip counts are unknown.
+class LoopWeightEstimator {
+public:
+  LoopWeightEstimator(ScalarEvolution &SE, const LoopIterationCounts &Counts)
+    : mSE(&SE), mCounts(&Counts) {}
+
+  /// Returns estimated number of executions of a specified instruction.
+  double getWeight(const LoopInfo &LI, const Instruction &I) {
+    auto *L = LI.getLoopFor(I.getParent());
+    return L ? getWeight(*L) : 1.0;
+  }
+
+  /// Returns estimated number of executions of a body of a specified loop.
+  double getWeight(const Loop &L) {
+    auto Itr = mWeights.find(&L);
+    if (Itr != mWeights.end())
+      return Itr->second;
+    double Weight = 0.0;
+    Optional<std::uint64_t> Iterations;
+    if (auto *LoopID = L.getLoopID())
+      Iterations = mCounts->find(LoopID);
+    if (Iterations) {
+      Weight = *Iterations;
+    } else {
+      auto *Parent = L.getParentLoop();
+      Weight = getTripCount(L) * (Parent ? getWeight(*Parent) : 1.0);
+    }
+    return mWeights.try_emplace(&L, Weight).first->second;
+  }
+
+private:
+  double getTripCount(const Loop &L) {
+    auto *BTC = dyn_cast<SCEVConstant>(mSE->getMaxBackedgeTakenCount(&L));
+    if (!BTC || BTC->getValue()->getValue().getActiveBits() > 64)
+      return DefaultTripCount;
+    return static_cast<double>(BTC->getValue()->getZExtValue()) + 1.0;
+  }
+
+  ScalarEvolution *mSE;
+  const LoopIterationCounts *mCounts;
+  DenseMap<const Loop *, double> mWeights;
+};
+
 class APCDataDistributionPass : public ModulePass, private bcl::Uncopyable {
   /// Map from a file name to a list of functions which are located in a file.
   using FileToFuncMap = std::map<std::string, std::vector<apc::FuncInfo *>>;
@@ -130,6 +183,7 @@ struct IRToArrayInfoFunctor {
   APCContext &APCCtx;
   const GlobalOptions &GlobalOpts;
   APCDataDistributionProvider &Provider;
+  LoopWeightEstimator &Weights;
   ArrayAccessPool &AccessPool;
   LoopToArrayMap &Accesses;
   apc::Array *APCArray;
@@ -190,11 +244,11 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
     [&MemEnv](DIMemoryEnvironmentWrapper &Env) {
     Env.set(MemEnv);
   });
-  auto &APCRegion = APCCtx.getDefaultRegion();
-  if (!APCRegion.GetDataDir().distrRules.empty()) {
-    mMultipleLaunch = true;
-    return false;
-  }
+  for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I)
+    if (!APCCtx.getRegion(I).GetDataDir().distrRules.empty()) {
+      mMultipleLaunch = true;
+      return false;
+    }
   // TODO (kaniandr@gmail.com): what should we do if an array is a function
   // parameter, however it is not accessed in a function. In this case,
   // this array is not processed by this pass and it will not be added in
@@ -206,6 +260,11 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
   ArrayAccessSummary ArrayRWs;
   ArrayAccessPool AccessPool;
   LoopToArrayMap Accesses;
+  // Weights of accesses are estimated according to the number of their
+  // executions, so hot loops dominate in a distribution graph.
+  LoopIterationCounts IterationCounts;
+  if (!GlobalOpts.AnalysisUse.empty())
+    IterationCounts.load(GlobalOpts.AnalysisUse, M.getContext());
   for (auto &F : M) {
     auto *FI = APCCtx.findFunction(F);
     if (!FI)
@@ -220,6 +279,8 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
     auto &DI = Provider.get<DelinearizationPass>().getDelinearizeInfo();
     auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
     auto &DIAT = Provider.get<DIEstimateMemoryPass>().getAliasTree();
+    LoopWeightEstimator Weights(
+      Provider.get<ScalarEvolutionWrapperPass>().getSE(), IterationCounts);
     for (auto *A : DI.getArrays()) {
       if (!A->isDelinearized() || !A->hasMetadata())
         continue;
@@ -248,7 +309,7 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
             TSAR_LLVM_DUMP(cast<Instruction>(U)->getDebugLoc().dump());
             dbgs() << "\n");
           for_each_memory(cast<Instruction>(*U), TLI,
-            IRToArrayInfoFunctor{APCCtx, GlobalOpts, Provider,
+            IRToArrayInfoFunctor{APCCtx, GlobalOpts, Provider, Weights,
               AccessPool, Accesses, APCArray, Range },
             [](Instruction &I, AccessInfo IsRead, AccessInfo IsWrite) {});
         }
@@ -261,21 +322,37 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
   createLinksBetweenFormalAndActualParams(
     FileToFunc, FormalToActual, ArrayRWs, APCMsgs);
   processLoopInformationForFunction(Accesses);
-  addToDistributionGraph(Accesses, FormalToActual);
-  auto &G = APCRegion.GetGraphToModify();
-  auto &ReducedG = APCRegion.GetReducedGraphToModify();
-  auto &AllArrays = APCRegion.GetAllArraysToModify();
-  createOptimalDistribution(G, ReducedG, AllArrays, APCRegion.GetId(), false);
-  auto &DataDirs = APCRegion.GetDataDirToModify();
-  createDistributionDirs(
-    ReducedG, AllArrays, DataDirs, APCMsgs, FormalToActual);
-  createAlignDirs(
-    ReducedG, AllArrays, DataDirs, APCRegion.GetId(), FormalToActual, APCMsgs);
-  std::vector<int> FullDistrVariant;
-  FullDistrVariant.reserve(DataDirs.distrRules.size());
-  for (auto TplInfo : DataDirs.distrRules)
-    FullDistrVariant.push_back(TplInfo.second.size() - 1);
-  APCRegion.SetCurrentVariant(std::move(FullDistrVariant));
+  // Each parallel region has its own graph of arrays, so different regions
+  // may prefer different distributions of the same arrays.
+  std::map<apc::ParallelRegion *, LoopToArrayMap> RegionToAccesses;
+  for (auto &LoopAccesses : Accesses)
+    RegionToAccesses[LoopAccesses.first->region].insert(LoopAccesses);
+  for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I) {
+    auto &APCRegion = APCCtx.getRegion(I);
+    auto RegionItr = RegionToAccesses.find(&APCRegion);
+    if (RegionItr == RegionToAccesses.end()) {
+      if (&APCRegion != &APCCtx.getDefaultRegion())
+        continue;
+    } else {
+      LLVM_DEBUG(dbgs() << "[APC DATA DISTRIBUTION]: build graph of arrays "
+                           "for region " << APCRegion.GetName() << "\n");
+      addToDistributionGraph(RegionItr->second, FormalToActual);
+    }
+    auto &G = APCRegion.GetGraphToModify();
+    auto &ReducedG = APCRegion.GetReducedGraphToModify();
+    auto &AllArrays = APCRegion.GetAllArraysToModify();
+    createOptimalDistribution(G, ReducedG, AllArrays, APCRegion.GetId(), false);
+    auto &DataDirs = APCRegion.GetDataDirToModify();
+    createDistributionDirs(
+      ReducedG, AllArrays, DataDirs, APCMsgs, FormalToActual);
+    createAlignDirs(ReducedG, AllArrays, DataDirs, APCRegion.GetId(),
+      FormalToActual, APCMsgs);
+    std::vector<int> FullDistrVariant;
+    FullDistrVariant.reserve(DataDirs.distrRules.size());
+    for (auto TplInfo : DataDirs.distrRules)
+      FullDistrVariant.push_back(TplInfo.second.size() - 1);
+    APCRegion.SetCurrentVariant(std::move(FullDistrVariant));
+  }
   LLVM_DEBUG(print(dbgs(), &M));
   return false;
 }
@@ -285,18 +362,22 @@ void APCDataDistributionPass::print(raw_ostream &OS, const Module *M) const {
     OS << "warning: possible multiple launches of the pass for the same "
           "module: print results for the first successful launch\n";
   auto &APCCtx = getAnalysis<APCContextWrapper>().get();
-  auto &APCRegion = APCCtx.getDefaultRegion();
-  auto &DataDirs = APCRegion.GetDataDir();
-  dbgs() << "List of templates:\n";
-  for (auto &TemplateInfo : DataDirs.distrRules) {
-    dbgs() << "  " << TemplateInfo.first->GetShortName().c_str();
-    for (auto S : TemplateInfo.first->GetSizes())
-      dbgs() << "[" << S.first << ":" << S.second << "]";
-    dbgs() << "\n";
+  for (std::size_t I = 0, EI = APCCtx.getNumberOfRegions(); I < EI; ++I) {
+    auto &APCRegion = APCCtx.getRegion(I);
+    if (EI > 1)
+      OS << "Parallel region " << APCRegion.GetName() << ":\n";
+    auto &DataDirs = APCRegion.GetDataDir();
+    dbgs() << "List of templates:\n";
+    for (auto &TemplateInfo : DataDirs.distrRules) {
+      dbgs() << "  " << TemplateInfo.first->GetShortName().c_str();
+      for (auto S : TemplateInfo.first->GetSizes())
+        dbgs() << "[" << S.first << ":" << S.second << "]";
+      dbgs() << "\n";
+    }
+    dbgs() << "List of aligns:\n";
+    for (auto &Rule : DataDirs.GenAlignsRules())
+      OS << "  " << Rule << "\n";
   }
-  dbgs() << "List of aligns:\n";
-  for (auto &Rule : DataDirs.GenAlignsRules())
-    OS << "  " << Rule << "\n";
 }
 
 void IRToArrayInfoFunctor::operator()(Instruction &I, MemoryLocation &&Loc,
@@ -305,6 +386,7 @@ void IRToArrayInfoFunctor::operator()(Instruction &I, MemoryLocation &&Loc,
     return;
   auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
   auto &SE = Provider.get<ScalarEvolutionWrapperPass>().getSE();
+  auto Weight = Weights.getWeight(LI, I);
   for (std::size_t DimIdx = 0, DimIdxE = Range.Subscripts.size();
        DimIdx < DimIdxE; ++DimIdx) {
     auto *S = Range.Subscripts[DimIdx];
@@ -352,12 +434,13 @@ void IRToArrayInfoFunctor::operator()(Instruction &I, MemoryLocation &&Loc,
     auto *APCArrayAccesses = const_cast<ArrayInfo *>(APCArrayAccessesC);
     LLVM_DEBUG(dbgs() << "[APC DATA DISTRIBUTION]: dimension " << DimIdx
                       << " subscript " << ABPair.first << " * I + "
-                      << ABPair.second << " access type";
+                      << ABPair.second << " weight " << Weight
+                      << " access type";
                if (IsWrite != AccessInfo::No) dbgs() << " write";
                if (IsRead != AccessInfo::No) dbgs() << " read"; dbgs() << "\n");
     if (IsWrite != AccessInfo::No)
-      APCArrayAccesses->writeOps[DimIdx].coefficients.emplace(ABPair, 1.0);
+      APCArrayAccesses->writeOps[DimIdx].coefficients[ABPair] += Weight;
     if (IsRead != AccessInfo::No)
-      APCArrayAccesses->readOps[DimIdx].coefficients.emplace(ABPair, 1.0);
+      APCArrayAccesses->readOps[DimIdx].coefficients[ABPair] += Weight;
   }
 }
@@ -31,6 +31,7 @@
 #include "tsar/Analysis/KnownFunctionTraits.h"
 #include "tsar/Analysis/Clang/CanonicalLoop.h"
 #include "tsar/Analysis/Clang/PerfectLoop.h"
+#include "tsar/Analysis/Clang/RegionDirectiveInfo.h"
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
 #include "tsar/APC/APCContext.h"
 #include "tsar/APC/Passes.h"
@@ -38,6 +39,7 @@
 #include "tsar/Core/Query.h"
 #include "tsar/Support/NumericUtils.h"
 #include "tsar/Support/Diagnostic.h"
+#include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Unparse/SourceUnparserUtils.h"
 #include <apc/GraphLoop/graph_loops.h>
@@ -72,6 +74,7 @@ public:
   void print(raw_ostream &OS, const Module *M) const override;
   void releaseMemory() override {
     mOuterLoops.clear();
+    mOptRegions.clear();
 #if !defined NDEBUG
     mAPCContext = nullptr;
     mRegions = nullptr;
@@ -99,6 +102,13 @@ private:
   // in subsequent passes.
   void initNoAnalyzed(apc::LoopGraph &L) noexcept;
 
+  /// Return a parallel region for a specified loop.
+  ///
+  /// Each optimization region (see '#pragma spf region') produces a separate
+  /// parallel region. Loops outside optimization regions are located in
+  /// the default region.
+  apc::ParallelRegion & getParallelRegion(const Loop &L);
+
   APCContext *mAPCContext = nullptr;
   DFRegionInfo *mRegions = nullptr;
   ClangPerfectLoopPass *mPerfect = nullptr;
@@ -106,6 +116,7 @@ private:
   ScalarEvolution *mSE = nullptr;
   DominatorTree *mDT = nullptr;
   AAResults *mAA = nullptr;
+  SmallVector<const OptimizationRegion *, 4> mOptRegions;
 
   std::vector<apc::LoopGraph *> mOuterLoops;
 };
@@ -124,6 +135,8 @@ INITIALIZE_PASS_IN_GROUP_BEGIN(APCLoopInfoBasePass, "apc-loop-info",
   INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
   INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
   INITIALIZE_PASS_DEPENDENCY(AAResultsWrapperPass)
+  INITIALIZE_PASS_DEPENDENCY(ClangRegionCollector)
+  INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_IN_GROUP_END(APCLoopInfoBasePass, "apc-loop-info",
   "Loop Graph Builder (APC)", true, true,
     DefaultQueryManager::PrintPassGroup::getPassRegistry())
@@ -140,6 +153,18 @@ bool APCLoopInfoBasePass::runOnFunction(Function &F) {
   mCanonical = &getAnalysis<CanonicalLoopPass>();
   mSE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
   mAA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
+  if (auto *RC = getAnalysisIfAvailable<ClangRegionCollector>()) {
+    auto *GO = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    auto &RegionInfo = RC->getRegionInfo();
+    if (!GO || !GO->isSpecified() || GO->getOptions().OptRegions.empty()) {
+      transform(RegionInfo, std::back_inserter(mOptRegions),
+                [](const OptimizationRegion &R) { return &R; });
+    } else {
+      for (auto &Name : GO->getOptions().OptRegions)
+        if (auto *R = RegionInfo.get(Name))
+          mOptRegions.push_back(R);
+    }
+  }
   auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
   for (auto I = LI.rbegin(), EI = LI.rend(); I != EI; ++I) {
     auto APCLoop = new apc::LoopGraph;
@@ -162,9 +187,19 @@ void APCLoopInfoBasePass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<ScalarEvolutionWrapperPass>();
   AU.addRequired<DominatorTreeWrapperPass>();
   AU.addRequired<AAResultsWrapperPass>();
+  AU.addUsedIfAvailable<ClangRegionCollector>();
+  AU.addUsedIfAvailable<GlobalOptionsImmutableWrapper>();
   AU.setPreservesAll();
 }
 
+apc::ParallelRegion & APCLoopInfoBasePass::getParallelRegion(const Loop &L) {
+  auto I = find_if(mOptRegions,
+    [&L](const OptimizationRegion *R) { return R->contain(L); });
+  if (I == mOptRegions.end())
+    return mAPCContext->getDefaultRegion();
+  return *mAPCContext->addRegion((*I)->getName()).first;
+}
+
 void APCLoopInfoBasePass::traverseInnerLoops(
     const Loop &L, apc::LoopGraph &Outer) {
   for (auto I = L.rbegin(), EI = L.rend(); I != EI; ++I) {
@@ -187,7 +222,7 @@ void APCLoopInfoBasePass::runOnLoop(Loop &L, apc::LoopGraph &APCLoop) {
   initNoAnalyzed(APCLoop);
   auto *M = L.getHeader()->getModule();
   auto *F = L.getHeader()->getParent();
-  APCLoop.region = &mAPCContext->getDefaultRegion();
+  APCLoop.region = &getParallelRegion(L);
   auto LocRange = L.getLocRange();
   if (auto &Loc = LocRange.getStart()) {
     if (!bcl::shrinkPair(Loc.getLine(), Loc.getCol(), APCLoop.lineNum))
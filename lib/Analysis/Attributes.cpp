@@ -24,7 +24,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Attributes.h"
-#include <bcl/utility.h>
+#include "tsar/Analysis/LibraryFunctions.h"
 #include <llvm/IR/Function.h>
 
 using namespace llvm;
@@ -56,22 +56,8 @@ bool hasFnAttr(llvm::Function &F, AttrKind Kind) {
   return F.hasFnAttribute(getAsString(Kind));
 }
 
-/// Table of string names of input/output library functions.
-static const char * const IOFunctionNameTable[] = {
-#define GET_IO_FUNCTIONS
-#include "tsar/Analysis/LibraryFunctions.def"
-#undef GET_IO_FUNCTIONS
-};
-
 bool isIOLibFuncName(StringRef FuncName) {
-  const char* const *Start = &IOFunctionNameTable[0];
-  const char* const *End =
-    &IOFunctionNameTable[bcl::array_sizeof(IOFunctionNameTable)];
-  if (FuncName.empty())
-    return false;
-  const char* const *I = std::find(Start, End, FuncName);
-  if (I != End)
-    return true;
-  return false;
+  auto *Summary = findLibFuncSummary(FuncName);
+  return Summary && Summary->is(LibFuncSummary::InputOutput);
 }
 }
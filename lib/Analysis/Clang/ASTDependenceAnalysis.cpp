@@ -33,6 +33,33 @@ using namespace clang;
 using namespace llvm;
 using namespace tsar;
 
+/// Remember distances of a dependence of a specified kind `Tag` for all
+/// variables from a list.
+///
+/// \return false if distance of a dependence is unknown.
+template<class Tag>
+static bool addDistance(DIMemoryTrait &T,
+    const ClangDependenceAnalyzer::SortedVarListT &VarNames,
+    ClangDependenceAnalyzer::DistanceVarListT &Distances) {
+  if (!T.is<Tag>())
+    return true;
+  auto *Dep = T.get<Tag>();
+  if (!Dep || !Dep->isKnownDistance())
+    return false;
+  auto &Dist = Dep->getDistance();
+  for (auto &Name : VarNames) {
+    auto Info = Distances.emplace(Name, Dist);
+    if (Info.second)
+      continue;
+    auto &Range = Info.first->second;
+    if (APSInt::compareValues(*Dist.first, *Range.first) < 0)
+      Range.first = Dist.first;
+    if (APSInt::compareValues(*Dist.second, *Range.second) > 0)
+      Range.second = Dist.second;
+  }
+  return true;
+}
+
 bool ClangDependenceAnalyzer::evaluateDependency() {
   DenseSet<const DIAliasNode *> Coverage, RedundantCoverage;
   DenseSet<const DIAliasNode *> *RedundantCoverageRef = &Coverage;
@@ -145,7 +172,7 @@ bool ClangDependenceAnalyzer::evaluateDependency() {
             mDependenceInfo.get<trait::Reduction>()[CurrentKind];
         clang::VarDecl *Status = nullptr;
         if (!mASTVars.localize(**I, *TS.getNode(), mASTToClient,
-              mDIMemoryMatcher, ReductionList, &Status) &&
+              mDIMemoryMatcher, ReductionList, mArraySections, &Status) &&
             !IgnoreRedundant) {
           toDiag(mDiags, mRegion->getLocStart(),
                  clang::diag::warn_parallel_loop);
@@ -169,8 +196,8 @@ bool ClangDependenceAnalyzer::evaluateDependency() {
             }
           } else {
             clang::VarDecl *Status = nullptr;
-            if (!mASTVars.localize(**I, *TS.getNode(),
-                  mASTToClient, mDIMemoryMatcher, ReductionList, &Status) &&
+            if (!mASTVars.localize(**I, *TS.getNode(), mASTToClient,
+                  mDIMemoryMatcher, ReductionList, mArraySections, &Status) &&
                 !IgnoreRedundant) {
               toDiag(mDiags, mRegion->getLocStart(),
                      clang::diag::warn_parallel_loop);
@@ -182,6 +209,36 @@ bool ClangDependenceAnalyzer::evaluateDependency() {
           }
         }
       }
+    } else if (Dptr.is_any<trait::Flow, trait::Anti>()) {
+      // Loop-carried dependencies with known distances do not prevent
+      // pipelined execution of a loop, so remember distances for each variable.
+      for (auto &T : TS) {
+        SortedVarListT VarNames;
+        clang::VarDecl *Status = nullptr;
+        if (!mASTVars.localize(*T, *TS.getNode(), mASTToClient,
+              mDIMemoryMatcher, VarNames, &Status)) {
+          if (IgnoreRedundant)
+            continue;
+          toDiag(mDiags, mRegion->getLocStart(),
+                 clang::diag::warn_parallel_loop);
+          toDiag(mDiags, Status ? Status->getLocation() : mRegion->getLocStart(),
+                 clang::diag::note_parallel_localize_dependence_unable);
+          return false;
+        }
+        if ((!addDistance<trait::Flow>(*T, VarNames,
+               mDependenceInfo.get<trait::Flow>()) ||
+             !addDistance<trait::Anti>(*T, VarNames,
+               mDependenceInfo.get<trait::Anti>())) &&
+            !IgnoreRedundant) {
+          toDiag(mDiags, mRegion->getLocStart(),
+                 clang::diag::warn_parallel_loop);
+          toDiag(mDiags, mRegion->getLocStart(),
+                 clang::diag::note_parallel_dependence_unknown_distance);
+          return false;
+        }
+      }
+      mInToLocalize.push_back(&TS);
+      mOutToLocalize.push_back(&TS);
     } else {
       if (Dptr.is<trait::SecondToLastPrivate>()) {
         clang::VarDecl *Status = nullptr;
@@ -272,3 +329,11 @@ bool ClangDependenceAnalyzer::evaluateDefUse() {
   }
   return true;
 }
+
+VarDecl * ClangDependenceAnalyzer::findDecl(StringRef Name) const {
+  for (auto &VarRef : mASTVars.CanonicalRefs)
+    if (!mASTVars.CanonicalLocals.count(VarRef.first) &&
+        VarRef.first->getName() == Name)
+      return VarRef.first;
+  return nullptr;
+}
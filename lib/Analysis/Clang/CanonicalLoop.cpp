@@ -36,6 +36,7 @@
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/Clang/ASTIndex.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Support/Tags.h"
 #include "tsar/Unparse/Utils.h"
@@ -570,9 +571,8 @@ private:
 };
 
 /// Returns LoopMatcher that matches loops that can be canonical.
-DeclarationMatcher makeLoopMatcher() {
-  return functionDecl(forEachDescendant(
-      forStmt(
+StatementMatcher makeLoopMatcher() {
+  return forStmt(
         hasLoopInit(eachOf(
           declStmt(hasSingleDecl(
             varDecl(hasType(isInteger()))
@@ -672,7 +672,7 @@ DeclarationMatcher makeLoopMatcher() {
               hasSourceExpression(declRefExpr(to(
                 varDecl(hasType(isInteger()))
                 .bind("SecondConditionVarName")))))))).bind("LoopCondition")))
-      .bind("forLoop")));
+      .bind("forLoop");
 }
 }
 
@@ -693,13 +693,20 @@ bool CanonicalLoopPass::runOnFunction(Function &F) {
   auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
   auto &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
   auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
-  DeclarationMatcher LoopMatcher = makeLoopMatcher();
+  StatementMatcher LoopMatcher = makeLoopMatcher();
   DIMemoryClientServerInfo DIMInfo(
       getAnalysis<DIEstimateMemoryPass>().getAliasTree(), *this, F);
   CanonicalLoopLabeler Labeler(RgnInfo, LoopInfo, MemInfo, ATree,
       TLI, SE, DT, DIMInfo, &mCanonicalLoopInfo);
   auto &Context = FuncDecl->getASTContext();
-  auto Nodes = match<DeclarationMatcher, Decl>(LoopMatcher, *FuncDecl, Context);
+  // Loops are taken from the index of the function body, so the matcher
+  // does not traverse the whole function.
+  SmallVector<BoundNodes, 8> Nodes;
+  for (auto *S : TfmCtx->getASTIndex(*FuncDecl).getLoops())
+    if (isa<ForStmt>(S)) {
+      auto LoopNodes = match(LoopMatcher, *S, Context);
+      Nodes.append(LoopNodes.begin(), LoopNodes.end());
+    }
   while (!Nodes.empty()) {
     MatchFinder::MatchResult Result(Nodes.back(), &Context);
     Labeler.run(Result);
@@ -28,8 +28,8 @@
 #include "tsar/Analysis/Clang/MemoryMatcher.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/ASTIndex.h"
 #include <clang/AST/Decl.h>
-#include <clang/AST/RecursiveASTVisitor.h>
 #include <llvm/Support/Debug.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/ADT/SmallVector.h>
@@ -75,36 +75,16 @@ using MatchDIVisitorBase = MatchASTBase<DIVariable, VarDecl,
   ClangDIMemoryMatcherPass::DIMemoryMatcher,
   ClangDIMemoryMatcherPass::MemoryASTSet>;
 
-class MatchDIVisitor :
-    public MatchDIVisitorBase,
-    public RecursiveASTVisitor<MatchDIVisitor> {
+class MatchDIVisitor : public MatchDIVisitorBase {
 public:
   MatchDIVisitor(SourceManager &SrcMgr, Matcher &MM,
       UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
     MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
 
-  /// Evaluates declarations expanded from a macro and stores such
-  /// declaration into location to macro map.
-  void VisitFromMacro(VarDecl *D) {
-    assert(D->getLocStart().isMacroID() &&
-      "Declaration must be expanded from macro!");
-    auto Loc = D->getLocStart();
-    if (Loc.isInvalid())
-      return;
-    Loc = mSrcMgr->getExpansionLoc(Loc);
-    if (Loc.isInvalid())
-      return;
-    auto Pair = mLocToMacro->insert(
-      std::make_pair(Loc.getRawEncoding(), bcl::TransparentQueue<VarDecl>(D)));
-    if (!Pair.second)
-      Pair.first->second.push(D);
-  }
-
   bool VisitVarDecl(VarDecl *D) {
-    if (D->getLocStart().isMacroID()) {
-      VisitFromMacro(D);
+    // Declarations expanded from macros are evaluated separately.
+    if (D->getLocStart().isMacroID())
       return true;
-    }
     auto VarLoc = D->getLocation();
     if (auto *AI = findIRForLocation(VarLoc)) {
       mMatcher->emplace(D->getCanonicalDecl(), AI);
@@ -150,7 +130,10 @@ bool ClangDIMemoryMatcherPass::runOnFunction(Function &F) {
       }
     }
   }
-  MatchDIVar.TraverseDecl(FuncDecl);
+  auto &Index = TfmCtx->getASTIndex(*FuncDecl);
+  MatchDIVar.addFromMacro(Index.getVarsInMacro());
+  for (auto *D : Index.getVars())
+    MatchDIVar.VisitVarDecl(D);
   MatchDIVar.matchInMacro(
     NumMatchMemory, NumNonMatchASTMemory, NumNonMatchDIMemory);
   auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
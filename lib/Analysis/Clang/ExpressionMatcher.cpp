@@ -27,7 +27,8 @@
 #include "tsar/Analysis/Clang/ExpressionMatcher.h"
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Core/TransformationContext.h"
-#include <clang/AST/RecursiveASTVisitor.h>
+#include "tsar/Support/Clang/ASTIndex.h"
+#include <clang/AST/Expr.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/CallSite.h>
@@ -44,36 +45,16 @@ STATISTIC(NumNonMatchIRExpr, "Number of non-matched IR expressions");
 STATISTIC(NumNonMatchASTExpr, "Number of non-matched AST expressions");
 
 namespace {
-class MatchExprVisitor :
-  public MatchASTBase<Value, Stmt>,
-  public RecursiveASTVisitor<MatchExprVisitor> {
+class MatchExprVisitor : public MatchASTBase<Value, Stmt> {
 public:
   MatchExprVisitor(SourceManager &SrcMgr, Matcher &MM,
     UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
       MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
 
-  /// Evaluates declarations expanded from a macro and stores such
-  /// declaration into location to macro map.
-  void VisitFromMacro(Stmt *S) {
-    assert(S->getLocStart().isMacroID() &&
-      "Expression must be expanded from macro!");
-    auto Loc = S->getLocStart();
-    if (Loc.isInvalid())
-      return;
-    Loc = mSrcMgr->getExpansionLoc(Loc);
-    if (Loc.isInvalid())
-      return;
-    auto Pair = mLocToMacro->insert(
-      std::make_pair(Loc.getRawEncoding(), bcl::TransparentQueue<Stmt>(S)));
-    if (!Pair.second)
-      Pair.first->second.push(S);
-  }
-
-   bool VisitCallExpr(Expr *E) {
-    if (E->getLocStart().isMacroID()) {
-      VisitFromMacro(E);
+  bool VisitCallExpr(Stmt *E) {
+    // Expressions expanded from macros are evaluated separately.
+    if (E->getLocStart().isMacroID())
       return true;
-    }
     auto ExprLoc = E->getLocStart();
     if (auto *I = findIRForLocation(ExprLoc)) {
       mMatcher->emplace(E, I);
@@ -118,7 +99,10 @@ bool ClangExprMatcherPass::runOnFunction(Function &F) {
   auto FuncDecl = TfmCtx->getDeclForMangledName(F.getName());
   if (!FuncDecl)
     return false;
-  MatchExpr.TraverseDecl(FuncDecl);
+  auto &Index = TfmCtx->getASTIndex(*FuncDecl);
+  MatchExpr.addFromMacro(Index.getCallsInMacro());
+  for (auto *E : Index.getCalls())
+    MatchExpr.VisitCallExpr(E);
   MatchExpr.matchInMacro(NumMatchExpr, NumNonMatchASTExpr, NumNonMatchIRExpr);
   return false;
 }
@@ -26,9 +26,9 @@
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Core/TransformationContext.h"
 #include "tsar/Support/IRUtils.h"
+#include "tsar/Support/Clang/ASTIndex.h"
 #include <bcl/transparent_queue.h>
 #include <clang/AST/Decl.h>
-#include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/AST/Stmt.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/ADT/DenseMap.h>
@@ -62,9 +62,7 @@ INITIALIZE_PASS_END(LoopMatcherPass, "loop-matcher",
 
 namespace {
 /// This matches explicit for, while and do-while loops.
-class MatchExplicitVisitor :
-  public MatchASTBase<Loop, Stmt>,
-  public RecursiveASTVisitor<MatchExplicitVisitor> {
+class MatchExplicitVisitor : public MatchASTBase<Loop, Stmt> {
 public:
 
   /// Constructor.
@@ -77,44 +75,21 @@ public:
   /// low-level representation will be stored in ImplicitMap. This map is also a
   /// map from location to loop but
   /// a key is always location of terminator in a loop header.
-  /// \param MacroMap All explicit loops defined in macros is going to store
-  /// in this map. These loops will not inserted in LM map and must be evaluated
-  /// further. The key in this map is a raw encoding for expansion location.
-  /// To decode it use SourceLocation::getFromRawEncoding() method.
+  /// \param MacroMap All explicit loops defined in macros must be stored
+  /// in this map (see addFromMacro()). These loops will not inserted in LM
+  /// map and must be evaluated further. The key in this map is a raw encoding
+  /// for expansion location. To decode it use
+  /// SourceLocation::getFromRawEncoding() method.
   MatchExplicitVisitor(SourceManager &SrcMgr,
       Matcher &LM, UnmatchedASTSet &Unmatched,
       LocToIRMap &LocMap, LocToIRMap &ImplicitMap, LocToASTMap &MacroMap) :
     MatchASTBase(SrcMgr, LM, Unmatched, LocMap, MacroMap),
     mLocToImplicit(&ImplicitMap) {}
 
-  /// \brief Evaluates statements expanded from a macro.
-  ///
-  /// Implicit loops which are expanded from macro are not going to be
-  /// evaluated, because in LLVM IR these loops have locations equal to
-  /// expansion location. So it is not possible to determine token in macro
-  /// body where these loops starts without additional analysis of AST.
-  void VisitFromMacro(Stmt *S) {
-    assert(S->getLocStart().isMacroID() &&
-      "Statement must be expanded from macro!");
-    if (!isa<WhileStmt>(S) && !isa<DoStmt>(S) && !isa<ForStmt>(S))
-      return;
-    auto Loc = S->getLocStart();
-    if (Loc.isInvalid())
-      return;
-    Loc = mSrcMgr->getExpansionLoc(Loc);
-    if (Loc.isInvalid())
-      return;
-    auto Pair = mLocToMacro->insert(
-      std::make_pair(Loc.getRawEncoding(), bcl::TransparentQueue<Stmt>(S)));
-    if (!Pair.second)
-      Pair.first->second.push(S);
-  }
-
   bool VisitStmt(Stmt *S) {
-    if (S->getLocStart().isMacroID()) {
-      VisitFromMacro(S);
+    // Statements expanded from macros are evaluated separately.
+    if (S->getLocStart().isMacroID())
       return true;
-    }
     if (auto *For = dyn_cast<ForStmt>(S)) {
       // To determine appropriate loop in LLVM IR it is necessary to use start
       // location of initialization instruction, if it is available.
@@ -187,9 +162,7 @@ private:
 };
 
 /// This matches implicit loops.
-class MatchImplicitVisitor :
-  public MatchASTBase<Loop, Stmt>,
-  public RecursiveASTVisitor<MatchImplicitVisitor> {
+class MatchImplicitVisitor : public MatchASTBase<Loop, Stmt> {
 public:
   MatchImplicitVisitor(SourceManager &SrcMgr, Matcher &LM,
     UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
@@ -290,12 +263,20 @@ bool LoopMatcherPass::runOnFunction(Function &F) {
   auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
   MatchExplicitVisitor::LocToIRMap LocToImplicit;
   MatchExplicitVisitor::LocToASTMap LocToMacro;
+  auto &Index = TfmCtx->getASTIndex(*mFuncDecl);
   MatchExplicitVisitor MatchExplicit(SrcMgr, mMatcher, mUnmatchedAST,
     LocToLoop, LocToImplicit, LocToMacro);
-  MatchExplicit.TraverseDecl(mFuncDecl);
+  // Implicit loops which are expanded from macro are not going to be
+  // evaluated, because in LLVM IR these loops have locations equal to
+  // expansion location. So it is not possible to determine token in macro
+  // body where these loops starts without additional analysis of AST.
+  MatchExplicit.addFromMacro(Index.getLoopsInMacro());
+  for (auto *S : Index.getStmts())
+    MatchExplicit.VisitStmt(S);
   MatchImplicitVisitor MatchImplicit(SrcMgr, mMatcher, mUnmatchedAST,
     LocToImplicit, LocToMacro);
-  MatchImplicit.TraverseDecl(mFuncDecl);
+  for (auto *S : Index.getStmts())
+    MatchImplicit.VisitStmt(S);
   MatchExplicit.matchInMacro(
     NumMatchLoop, NumNonMatchASTLoop, NumNonMatchIRLoop);
   return MatchImplicit.isDILoopChanged();
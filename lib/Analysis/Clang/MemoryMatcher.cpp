@@ -26,10 +26,10 @@
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Analysis/Clang/Passes.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/ASTIndex.h"
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/Decl.h>
 #include <llvm/ADT/DenseMap.h>
-#include <clang/AST/RecursiveASTVisitor.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Module.h>
@@ -124,36 +124,16 @@ STATISTIC(NumNonMatchASTMemory, "Number of non-matched AST variables");
 
 namespace {
 /// This matches allocas (IR) and variables (AST).
-class MatchAllocaVisitor :
-  public MatchASTBase<Value, VarDecl>,
-  public RecursiveASTVisitor<MatchAllocaVisitor> {
+class MatchAllocaVisitor : public MatchASTBase<Value, VarDecl> {
 public:
   MatchAllocaVisitor(SourceManager &SrcMgr, Matcher &MM,
     UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
       MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
 
-  /// Evaluates declarations expanded from a macro and stores such
-  /// declaration into location to macro map.
-  void VisitFromMacro(VarDecl *D) {
-    assert(D->getLocStart().isMacroID() &&
-      "Declaration must be expanded from macro!");
-    auto Loc = D->getLocStart();
-    if (Loc.isInvalid())
-      return;
-    Loc = mSrcMgr->getExpansionLoc(Loc);
-    if (Loc.isInvalid())
-      return;
-    auto Pair = mLocToMacro->insert(
-      std::make_pair(Loc.getRawEncoding(), bcl::TransparentQueue<VarDecl>(D)));
-    if (!Pair.second)
-      Pair.first->second.push(D);
-  }
-
   bool VisitVarDecl(VarDecl *D) {
-    if (D->getLocStart().isMacroID()) {
-      VisitFromMacro(D);
+    // Declarations expanded from macros are evaluated separately.
+    if (D->getLocStart().isMacroID())
       return true;
-    }
     auto VarLoc = D->getLocation();
     if (auto *AI = findIRForLocation(VarLoc)) {
       mMatcher->emplace(D->getCanonicalDecl(), AI);
@@ -214,7 +194,10 @@ bool MemoryMatcherPass::runOnModule(llvm::Module &M) {
     auto FuncDecl = TfmCtx->getDeclForMangledName(F.getName());
     if (!FuncDecl)
       continue;
-    MatchAlloca.TraverseDecl(FuncDecl);
+    auto &Index = TfmCtx->getASTIndex(*FuncDecl);
+    MatchAlloca.addFromMacro(Index.getVarsInMacro());
+    for (auto *D : Index.getVars())
+      MatchAlloca.VisitVarDecl(D);
     MatchAlloca.matchInMacro(
       NumMatchMemory, NumNonMatchASTMemory, NumNonMatchIRMemory);
   }
@@ -194,3 +194,41 @@ bool VariableCollector::localize(DIMemoryTrait &T, const DIAliasNode &DIN,
   }
   return true;
 }
+
+bool VariableCollector::localize(DIMemoryTrait &T, const DIAliasNode &DIN,
+    const DIMemoryMatcher &ASTToClient,
+    const ClonedDIMemoryMatcher &ClientToServer,
+    SortedVarListT &VarNames, ArraySectionListT &Sections,
+    clang::VarDecl **Error) {
+  auto Search = findDecl(*T.getMemory(), ASTToClient, ClientToServer);
+  if (Search.second != VariableCollector::Derived ||
+      CanonicalLocals.count(Search.first))
+    return localize(T, DIN, ASTToClient, ClientToServer, VarNames, Error);
+  // Memory must represent all elements of an array which is accessed through
+  // a pointer. The original type of a parameter specifies the length of
+  // a section if an array is passed to a function. Otherwise, the length
+  // is known if all accesses to the array have been delinearized.
+  auto ASTRefItr = CanonicalRefs.find(Search.first);
+  if (ASTRefItr != CanonicalRefs.end() &&
+      ASTRefItr->second.size() > 1 && ASTRefItr->second[1] == T.getMemory()) {
+    auto *Parm = dyn_cast<ParmVarDecl>(Search.first);
+    if (auto *ArrayTy = Parm ? dyn_cast<ConstantArrayType>(
+            Parm->getOriginalType().getCanonicalType()) : nullptr) {
+      VarNames.insert(Parm->getName());
+      Sections.try_emplace(Parm->getName(),
+                           ArrayTy->getSize().toString(10, false));
+      return true;
+    }
+    auto ExtentItr = ArrayExtents.find(Search.first);
+    if (ExtentItr != ArrayExtents.end() &&
+        Search.first->getType()->isPointerType()) {
+      VarNames.insert(Search.first->getName());
+      Sections.try_emplace(Search.first->getName(),
+                           std::to_string(ExtentItr->second));
+      return true;
+    }
+  }
+  if (Error)
+    *Error = Search.first;
+  return false;
+}
@@ -85,6 +85,7 @@ static Type * DecodeType(LLVMContext &Ctx, unsigned &Start) {
   case Void: ++Start; return Type::getVoidTy(Ctx);
   case Any:  ++Start; return Type::getInt8Ty(Ctx);
   case Size: ++Start; return Type::getInt64Ty(Ctx);
+  case Event: ++Start; return getEventType(Ctx);
   case Pointer: return PointerType::getUnqual(DecodeType(Ctx, ++Start));
   default:
     llvm_unreachable("Unknown kind of intrinsic parameter type!");
@@ -108,6 +109,12 @@ FunctionType *getType(LLVMContext &Ctx, IntrinsicId Id) {
   return FunctionType::get(ResultTy, ArgsTys, false);
 }
 
+StructType *getEventType(LLVMContext &Ctx) {
+  SmallVector<Type *, EventPayloadSize + 1> Fields(
+    EventPayloadSize + 1, Type::getInt64Ty(Ctx));
+  return StructType::get(Ctx, Fields);
+}
+
 llvm::Function * getDeclaration(Module *M, IntrinsicId Id) {
   return cast<Function>(
     M->getOrInsertFunction(getName(Id), getType(M->getContext(), Id)));
@@ -0,0 +1,106 @@
+//===- LibraryFunctions.cpp - Summaries of Library Functions ----*- C++ -*-===//
+//
+//                     Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements lookup of summaries of library functions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/LibraryFunctions.h"
+#include <bcl/utility.h>
+#include <llvm/IR/Function.h>
+#include <algorithm>
+
+using namespace llvm;
+using namespace tsar;
+
+/// Table of summaries of pointer arguments, summaries of arguments of each
+/// function are sorted by argument numbers.
+static constexpr LibFuncArgSummary ArgumentTable[] = {
+#define ARGUMENT(Idx, Access, NoCapture) \
+  { Idx, LibFuncArgAccess::Access, NoCapture },
+#define GET_LIBRARY_FUNCTION_ARGUMENT_TABLE
+#include "tsar/Analysis/LibraryFunctions.gen"
+#undef GET_LIBRARY_FUNCTION_ARGUMENT_TABLE
+#undef ARGUMENT
+  { 0, LibFuncArgAccess::ReadWrite, false } // the table must not be empty
+};
+
+/// Table of summaries of library functions sorted by name.
+static const LibFuncSummary FunctionTable[] = {
+#define PROPERTY(Kind) | LibFuncSummary::Kind
+#define LIBRARY_FUNCTION(Name, Properties, VarArgAccess, ArgStart, ArgEnd) \
+  { Name, LibFuncSummary::NoProperty Properties, \
+    LibFuncArgAccess::VarArgAccess, ArgStart, ArgEnd },
+#define GET_LIBRARY_FUNCTION_TABLE
+#include "tsar/Analysis/LibraryFunctions.gen"
+#undef GET_LIBRARY_FUNCTION_TABLE
+#undef LIBRARY_FUNCTION
+#undef PROPERTY
+};
+
+namespace tsar {
+ArrayRef<LibFuncArgSummary> LibFuncSummary::getArgs() const {
+  return makeArrayRef(&ArgumentTable[mArgStart], &ArgumentTable[mArgEnd]);
+}
+
+const LibFuncArgSummary * LibFuncSummary::findArg(unsigned ArgNo) const {
+  auto Args = getArgs();
+  auto I = std::lower_bound(Args.begin(), Args.end(), ArgNo,
+    [](const LibFuncArgSummary &LHS, unsigned RHS) { return LHS.Idx < RHS; });
+  return I != Args.end() && I->Idx == ArgNo ? I : nullptr;
+}
+
+bool LibFuncSummary::onlyAccessesArgMemory(const Function &F) const {
+  return is(NoGlobalAccess) && (!is(MayWriteErrno) || F.doesNotAccessMemory());
+}
+
+bool LibFuncSummary::onlyReadsMemory(const Function &F) const {
+  return is(Pure) && (!is(MayWriteErrno) || F.doesNotAccessMemory());
+}
+
+LibFuncArgAccess LibFuncSummary::getArgAccess(const Function &F,
+    unsigned ArgNo) const {
+  if (auto *Arg = findArg(ArgNo))
+    return Arg->Access;
+  return F.isVarArg() && ArgNo >= F.arg_size() ?
+    mVarArgAccess : LibFuncArgAccess::ReadWrite;
+}
+
+bool LibFuncSummary::isNoCapture(unsigned ArgNo) const {
+  auto *Arg = findArg(ArgNo);
+  return Arg && Arg->NoCapture;
+}
+
+const LibFuncSummary * findLibFuncSummary(StringRef Name) {
+  auto *Start = &FunctionTable[0];
+  auto *End = &FunctionTable[bcl::array_sizeof(FunctionTable)];
+  auto I = std::lower_bound(Start, End, Name,
+    [](const LibFuncSummary &LHS, StringRef RHS) {
+      return LHS.getName() < RHS;
+  });
+  return I != End && I->getName() == Name ? I : nullptr;
+}
+
+const LibFuncSummary * findLibFuncSummary(const Function &F) {
+  if (!F.isDeclaration() || F.isIntrinsic() || F.hasLocalLinkage())
+    return nullptr;
+  return findLibFuncSummary(F.getName());
+}
+}
@@ -28,6 +28,7 @@
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Unparse/Utils.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Pass.h>
 #include <llvm/Support/Debug.h>
 
@@ -78,10 +79,31 @@ public:
     initializeClonedDIMemoryMatcherPassPass(*PassRegistry::getPassRegistry());
   }
 
+  /// Create a pass which builds match between cloned MDNodes and original
+  /// DIMemory for each function on demand.
+  ClonedDIMemoryMatcherPass(MDToDIMemoryBuilder &&Builder)
+      : FunctionPass(ID), mBuilder(std::move(Builder)) {
+    initializeClonedDIMemoryMatcherPassPass(*PassRegistry::getPassRegistry());
+  }
+
   bool runOnFunction(Function &F) override {
     auto &DIAT = getAnalysis<DIEstimateMemoryPass>().getAliasTree();
-    auto *OriginToClone =
-        getAnalysis<ClonedDIMemoryMatcherWrapper>()->insert(F).first;
+    auto &Info = getAnalysis<ClonedDIMemoryMatcherWrapper>().get();
+    // Memory locations are matched on demand. Server-side locations are
+    // remembered here, because the alias tree may be rebuilt later and
+    // handles track these changes. The callback is moved to the matcher, so
+    // captured client-side handles are destroyed when the matcher is cleared.
+    if (mBuilder) {
+      Info.setBuilder(std::move(mBuilder));
+      mBuilder = nullptr;
+    }
+    if (Info.getBuilder()) {
+      Info.insert(F);
+      for (auto &DIM : make_range(DIAT.memory_begin(), DIAT.memory_end()))
+        Info.defer(F, DIM);
+      return false;
+    }
+    auto *OriginToClone = Info.insert(F).first;
     assert(OriginToClone && "Unable to create memory matcher!");
     for (auto &DIM : make_range(DIAT.memory_begin(), DIAT.memory_end())) {
       auto Itr = mCloneToOrigin.find(std::make_pair(&F, DIM.getAsMDNode()));
@@ -110,9 +132,61 @@ public:
   }
 
   MDToDIMemoryMap mCloneToOrigin;
+  MDToDIMemoryBuilder mBuilder;
 };
 }
 
+void ClonedDIMemoryMatcherInfo::defer(Function &F, DIMemory &M) {
+  auto &FM = mMatchers.try_emplace(FunctionCallbackVH(&F, this)).first->second;
+  FM.Pending.try_emplace(M.getAsMDNode(), &M);
+  if (auto *EM = dyn_cast<DIEstimateMemory>(&M)) {
+    auto &Functions = mVarToFunctions[EM->getVariable()];
+    if (Functions.empty() || Functions.back() != &F)
+      Functions.push_back(&F);
+  }
+}
+
+void ClonedDIMemoryMatcherInfo::erase(Function &F) {
+  auto Itr = mMatchers.find_as(&F);
+  if (Itr == mMatchers.end())
+    return;
+  for (auto &VarToFunctions : mVarToFunctions)
+    llvm::erase_if(VarToFunctions.second,
+                   [&F](Function *Used) { return Used == &F; });
+  mMatchers.erase(Itr);
+}
+
+void ClonedDIMemoryMatcherInfo::match(Function &F, FunctionMatcher &FM) {
+  if (FM.Pending.empty() || !mBuilder)
+    return;
+  LLVM_DEBUG(dbgs() << "[CLONED DI MEMORY]: match memory in function '"
+                    << F.getName() << "'\n");
+  MDToDIMemoryMap CloneToOrigin;
+  mBuilder(F, CloneToOrigin);
+  auto *OriginToClone = &FM.Matcher;
+  for (auto &Pending : FM.Pending) {
+    // Cloned memory location may be destroyed after it has been deferred.
+    if (!Pending.second)
+      continue;
+    auto Itr = CloneToOrigin.find(std::make_pair(&F, Pending.first));
+    // Some memory locations are always distinct after tree rebuilding.
+    // So, this memory locations does not exist in the map.
+    if (Itr == CloneToOrigin.end() || !Itr->second) {
+      LLVM_DEBUG(dbgs() << "[CLONED DI MEMORY]: original memory location "
+                           "is not found for '";
+                 if (auto DWLang = getLanguage(F))
+                     printDILocationSource(*DWLang, *Pending.second, dbgs());
+                 dbgs() << "'\n");
+      continue;
+    }
+    OriginToClone->emplace(ClonedDIMemoryMatcher::value_type(
+      std::piecewise_construct,
+      std::forward_as_tuple(Itr->second, OriginToClone),
+      std::forward_as_tuple(Pending.second, OriginToClone)));
+  }
+  FM.Pending.clear();
+}
+
 char ClonedDIMemoryMatcherPass::ID = 0;
 INITIALIZE_PASS_BEGIN(ClonedDIMemoryMatcherPass, "cloned-di-memory-matcher",
   "Cloned Memory Matcher (Metadata)", false, false)
@@ -147,3 +221,8 @@ FunctionPass* llvm::createClonedDIMemoryMatcher(
     tsar::MDToDIMemoryMap &&CloneToOriginal) {
   return new ClonedDIMemoryMatcherPass(std::move(CloneToOriginal));
 }
+
+FunctionPass* llvm::createClonedDIMemoryMatcher(
+    tsar::MDToDIMemoryBuilder &&Builder) {
+  return new ClonedDIMemoryMatcherPass(std::move(Builder));
+}
@@ -51,9 +51,11 @@
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/ScalarEvolutionExpressions.h>
 #include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/Debug.h>
 #include <llvm/Transforms/Utils/Local.h>
+#include <algorithm>
 #include <tuple>
 #include <utility>
 
@@ -543,6 +545,121 @@ trait::Reduction::Kind getReductionKind(
   return trait::DIReduction::RK_NoReduction;
 }
 
+/// Convert IR-level operation which updates memory to metadata-level
+/// reduction kind, return RK_NoReduction if it is not a reduction operation.
+trait::Reduction::Kind getReductionKind(const BinaryOperator &Op) {
+  switch (Op.getOpcode()) {
+  case Instruction::Add: case Instruction::FAdd:
+    return trait::DIReduction::RK_Add;
+  case Instruction::Mul: case Instruction::FMul:
+    return trait::DIReduction::RK_Mult;
+  case Instruction::Or: return trait::DIReduction::RK_Or;
+  case Instruction::And: return trait::DIReduction::RK_And;
+  case Instruction::Xor: return trait::DIReduction::RK_Xor;
+  }
+  return trait::DIReduction::RK_NoReduction;
+}
+
+/// Return true if both pointers always point to the same address.
+bool isSameAddress(const Value *LHS, const Value *RHS) {
+  if (LHS == RHS)
+    return true;
+  auto *LHSInst = dyn_cast<GetElementPtrInst>(LHS);
+  auto *RHSInst = dyn_cast<GetElementPtrInst>(RHS);
+  return LHSInst && RHSInst && LHSInst->isIdenticalTo(RHSInst);
+}
+
+/// Check whether a specified store updates memory with a reduction operation
+/// (for example, `H[I] = H[I] + X`) and return kind of this operation.
+///
+/// On success `Update` is set to a load which reads the previous value.
+trait::Reduction::Kind getMemoryReductionKind(const StoreInst &SI,
+    const LoadInst *&Update) {
+  auto *Op = dyn_cast<BinaryOperator>(SI.getValueOperand());
+  if (!SI.isSimple() || !Op || !Op->hasOneUse() ||
+      Op->getParent() != SI.getParent())
+    return trait::DIReduction::RK_NoReduction;
+  Update = nullptr;
+  for (auto &Operand : Op->operands()) {
+    auto *LI = dyn_cast<LoadInst>(Operand);
+    if (!LI || !isSameAddress(LI->getPointerOperand(), SI.getPointerOperand()))
+      continue;
+    // Both operands read the updated memory, so this is not a reduction.
+    if (Update)
+      return trait::DIReduction::RK_NoReduction;
+    Update = LI;
+  }
+  if (!Update || !Update->isSimple() || !Update->hasOneUse() ||
+      Update->getParent() != SI.getParent())
+    return trait::DIReduction::RK_NoReduction;
+  // Memory must not be accessed between read and write of the updated value.
+  // Otherwise, updates of the same element from different statements may
+  // interleave.
+  for (auto *I = Update->getNextNode(); I != &SI; I = I->getNextNode())
+    if (!I || I->mayReadOrWriteMemory())
+      return trait::DIReduction::RK_NoReduction;
+  return getReductionKind(*Op);
+}
+
+/// Find IR-level alias nodes which contain memory updated in a specified loop
+/// with reduction operations only (for example, `H[I[J]] += X`).
+///
+/// The loop must not contain any other accesses to memory which may alias
+/// this memory. So, the order of updates is not important and distinct
+/// iterations may accumulate values in private copies of memory.
+void findMemoryReductions(const Loop &L, AliasTree &AT,
+    const SpanningTreeRelation<AliasTree *> &AliasSTR,
+    SmallDenseMap<AliasNode *, trait::Reduction::Kind, 8> &Reductions) {
+  SmallDenseMap<AliasNode *, trait::Reduction::Kind, 8> Candidates;
+  SmallPtrSet<const LoadInst *, 8> UpdateLoads;
+  SmallVector<std::pair<AliasNode *, Instruction *>, 32> Accesses;
+  for (auto *BB : L.getBlocks())
+    for (auto &I : *BB) {
+      if (!I.mayReadOrWriteMemory())
+        continue;
+      if (auto *II = dyn_cast<IntrinsicInst>(&I))
+        if (isDbgInfoIntrinsic(II->getIntrinsicID()) ||
+            isMemoryMarkerIntrinsic(II->getIntrinsicID()))
+          continue;
+      // Calls may access memory in an unknown way.
+      if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+        return;
+      auto *EM = AT.find(MemoryLocation::get(&I));
+      if (!EM)
+        return;
+      Accesses.emplace_back(EM->getAliasNode(AT), &I);
+    }
+  for (auto &Access : Accesses) {
+    auto RK = trait::DIReduction::RK_NoReduction;
+    if (auto *SI = dyn_cast<StoreInst>(Access.second)) {
+      const LoadInst *Update = nullptr;
+      RK = getMemoryReductionKind(*SI, Update);
+      if (RK != trait::DIReduction::RK_NoReduction)
+        UpdateLoads.insert(Update);
+    }
+    auto Info = Candidates.try_emplace(Access.first, RK);
+    if (!Info.second && Info.first->second != RK)
+      Info.first->second = trait::DIReduction::RK_NoReduction;
+  }
+  // Loads which read updated values have been checked with stores, so
+  // discard nodes with other loads only.
+  for (auto &Access : Accesses)
+    if (isa<LoadInst>(Access.second) &&
+        !UpdateLoads.count(cast<LoadInst>(Access.second)))
+      Candidates[Access.first] = trait::DIReduction::RK_NoReduction;
+  for (auto &Candidate : Candidates) {
+    if (Candidate.second == trait::DIReduction::RK_NoReduction)
+      continue;
+    if (any_of(Candidates, [&Candidate, &AliasSTR](
+            const std::pair<AliasNode *, trait::Reduction::Kind> &Other) {
+          return Other.first != Candidate.first &&
+                 !AliasSTR.isUnreachable(Candidate.first, Other.first);
+        }))
+      continue;
+    Reductions.try_emplace(Candidate.first, Candidate.second);
+  }
+}
+
 /// Update traits of metadata-level locations related to a specified Phi-node
 /// in a specified loop. This function uses a specified `TraitInserter` functor
 /// to update traits for a single memory location.
@@ -1847,6 +1964,53 @@ void DIDependencyAnalysisPass::analyzeNode(DIAliasMemoryNode &DIN,
   // promoted locations or by the private recognition pass).
 }
 
+void DIDependencyAnalysisPass::analyzeMemoryReduction(Loop *L,
+    Optional<unsigned> DWLang,
+    const SpanningTreeRelation<AliasTree *> &AliasSTR,
+    const SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
+    ArrayRef<const DIMemory *> LockedTraits, const GlobalOptions &GlobalOpts,
+    DIDependenceSet &DIDepSet) {
+  SmallDenseMap<AliasNode *, trait::Reduction::Kind, 8> Reductions;
+  findMemoryReductions(*L, *mAT, AliasSTR, Reductions);
+  if (Reductions.empty())
+    return;
+  SmallPtrSet<const DIMemory *, 8> Updated;
+  for (auto &TS : DIDepSet) {
+    auto *DIN = dyn_cast<DIAliasMemoryNode>(TS.getNode());
+    if (!DIN)
+      continue;
+    auto *AN = findBoundAliasNode(*mAT, AliasSTR,
+                                  const_cast<DIAliasMemoryNode &>(*DIN));
+    auto RedItr = AN ? Reductions.find(AN) : Reductions.end();
+    if (RedItr == Reductions.end())
+      continue;
+    for (auto &DIMTraitItr : TS) {
+      auto *DIM = DIMTraitItr->getMemory();
+      if (DIM->getAliasNode() != DIN || DIM->emptyBinding() ||
+          !DIMTraitItr->is_any<trait::Flow, trait::Anti, trait::Output>() ||
+          isLockedTrait(*DIMTraitItr, LockedTraits, DIAliasSTR))
+        continue;
+      LLVM_DEBUG(if (DWLang) {
+        dbgs() << "[DA DI]: update traits for ";
+        printDILocationSource(*DWLang, *DIM, dbgs());
+        dbgs() << "\n";
+      });
+      DIMTraitItr->unset<trait::Flow, trait::Anti, trait::Output>();
+      DIMTraitItr->set<trait::Reduction>(
+          new trait::DIReduction(RedItr->second));
+      LLVM_DEBUG(dbgs() << "[DA DI]: memory reduction found\n");
+      ++NumTraits.get<trait::Reduction>();
+      Updated.insert(DIM);
+    }
+  }
+  // Traits of updated locations may be also combined in traits of ancestors.
+  for (auto &TS : DIDepSet)
+    if (any_of(TS, [&Updated](const DIMemoryTraitRef &DIMTraitItr) {
+          return Updated.count(DIMTraitItr->getMemory());
+        }))
+      combineTraits(GlobalOpts.IgnoreRedundantMemory, TS);
+}
+
 /// Recurse through all subloops and all loops  into LQ.
 static void addLoopIntoQueue(DFNode *DFN, std::deque<DFLoop *> &LQ) {
   if (auto *DFL = dyn_cast<DFLoop>(DFN)) {
@@ -1908,6 +2072,28 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
   std::deque<DFLoop *> LQ;
   for (auto *DFN : DFF->getRegions())
     addLoopIntoQueue(DFN, LQ);
+  // Structure of the metadata-level alias tree does not depend on a loop, so
+  // collect its nodes in post order and IR-level nodes bound to them once.
+  // Traits for a loop are computed for nodes touched in this loop and for
+  // their ancestors only. There are no traits for other nodes, so memory from
+  // these nodes is treated as not accessed in a loop.
+  std::vector<DIAliasMemoryNode *> PostOrder;
+  DenseMap<const DIAliasNode *, unsigned> PostOrderIdx;
+  DenseMap<const AliasNode *, SmallVector<DIAliasMemoryNode *, 1>> BoundNodes;
+  DenseMap<DIVariable *, DIMemory *> VarToMemory;
+  for (auto *DIN : post_order(&DIAT)) {
+    if (isa<DIAliasTopNode>(DIN))
+      continue;
+    auto &DIMN = cast<DIAliasMemoryNode>(*DIN);
+    PostOrderIdx.try_emplace(&DIMN, PostOrder.size());
+    PostOrder.push_back(&DIMN);
+    if (auto *AN = findBoundAliasNode(*mAT, AliasSTR, DIMN))
+      BoundNodes[AN].push_back(&DIMN);
+    for (auto &DIM : DIMN)
+      if (auto *DIEM = dyn_cast<DIEstimateMemory>(&DIM))
+        if (DIEM->getExpression()->getNumElements() == 0)
+          VarToMemory.try_emplace(DIEM->getVariable(), DIEM);
+  }
   for (auto *DFL : LQ) {
     auto L = DFL->getLoop();
     /// TODO (kaniandr@gmail.com): use other identifier because LLVM identifier
@@ -1934,17 +2120,35 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
     auto &DepSet = PI.find(DFL)->get<DependenceSet>();
     auto &DIDepSet = mDeps.try_emplace(DILoop, DepSet.size()).first->second;
     analyzePromoted(L, DWLang, DIAliasSTR, LockedTraits, *Pool);
-    DenseMap<DIVariable *, DIMemory *> VarToMemory;
-    for (auto *DIN : post_order(&DIAT)) {
-      if (isa<DIAliasTopNode>(DIN))
-        continue;
-      analyzeNode(cast<DIAliasMemoryNode>(*DIN), DWLang, AliasSTR, DIAliasSTR,
-        LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
-      for (auto &DIM : cast<DIAliasMemoryNode>(*DIN))
-        if (auto *DIEM = dyn_cast<DIEstimateMemory>(&DIM))
-          if (DIEM->getExpression()->getNumElements() == 0)
-            VarToMemory.try_emplace(DIEM->getVariable(), DIEM);
+    // A node may obtain traits if it is bound to an IR-level node with known
+    // traits, if some of its locations already have traits in the pool or if
+    // some of its descendants obtain traits.
+    SmallVector<unsigned, 32> Touched;
+    SmallPtrSet<const DIAliasNode *, 32> Visited;
+    auto touch = [&PostOrderIdx, &Touched, &Visited](const DIAliasNode *N) {
+      for (; N && !isa<DIAliasTopNode>(N); N = N->getParent()) {
+        auto IdxItr = PostOrderIdx.find(N);
+        if (IdxItr == PostOrderIdx.end() || !Visited.insert(N).second)
+          return;
+        Touched.push_back(IdxItr->second);
+      }
+    };
+    for (auto &AT : DepSet) {
+      auto BoundItr = BoundNodes.find(AT.getNode());
+      if (BoundItr != BoundNodes.end())
+        for (auto *DIN : BoundItr->second)
+          touch(DIN);
     }
+    for (auto &T : *Pool)
+      touch(T.getMemory()->getAliasNode());
+    std::sort(Touched.begin(), Touched.end());
+    LLVM_DEBUG(dbgs() << "[DA DI]: analyze " << Touched.size() << " of "
+                      << PostOrder.size() << " alias nodes\n");
+    for (auto Idx : Touched)
+      analyzeNode(*PostOrder[Idx], DWLang, AliasSTR, DIAliasSTR,
+        LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
+    analyzeMemoryReduction(L, DWLang, AliasSTR, DIAliasSTR, LockedTraits,
+      GlobalOpts, DIDepSet);
     LLVM_DEBUG(dbgs() << "[DA DI]: set traits for a top level node\n");
     auto TopDIN = DIAT.getTopLevelNode();
     auto TopTraitItr = DIDepSet.insert(DIAliasTrait(TopDIN)).first;
@@ -1972,13 +2176,21 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
     // All descendant nodes for nodes in `Coverage` access some part of
     // explicitly accessed memory. The conservativeness of analysis implies
     // that memory accesses from this nodes arise loop carried dependencies.
-    for (auto *N : Coverage)
-      for (auto &Child : make_range(N->child_begin(), N->child_end()))
-        for (auto *Descendant : make_range(df_begin(&Child), df_end(&Child))) {
-          auto I = DIDepSet.find_as(Descendant);
-          if (I != DIDepSet.end() && !I->is<trait::NoAccess>())
-            I->set<trait::Flow, trait::Anti, trait::Output>();
+    // Only nodes with traits should be updated, so check ancestors of these
+    // nodes instead of visiting all descendants of nodes in `Coverage`.
+    if (Coverage.empty())
+      continue;
+    SmallPtrSet<const DIAliasNode *, 8> CoverageSet(Coverage.begin(),
+      Coverage.end());
+    for (auto &AT : DIDepSet) {
+      if (AT.is<trait::NoAccess>())
+        continue;
+      for (auto *N = AT.getNode()->getParent(); N; N = N->getParent())
+        if (CoverageSet.count(N)) {
+          AT.set<trait::Flow, trait::Anti, trait::Output>();
+          break;
         }
+    }
   }
   return false;
 }
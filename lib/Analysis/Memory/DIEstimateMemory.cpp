@@ -109,6 +109,9 @@ void findBoundAliasNodes(const DIMemory &DIM, AliasTree &AT,
 DIMemory::~DIMemory() {
   if (hasMemoryHandle())
     DIMemoryHandleBase::memoryIsDeleted(this);
+  // Handles may print this memory, so representations are removed after
+  // handles are notified.
+  getEnv().getSourceRepresentations().erase(this);
 }
 
 void DIMemory::replaceAllUsesWith(DIMemory *M) {
@@ -319,6 +322,8 @@ void DIMemory::setFlags(uint64_t F) {
   auto *FlagMD = llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
    Type::getInt64Ty(Ctx), CInt->getZExtValue() | F));
     MD->replaceOperandWith(OpIdx, FlagMD);
+  // Flags may change source-level representation of this location.
+  getEnv().getSourceRepresentations().erase(this);
 }
 
 llvm::MDNode * DIUnknownMemory::getMetadata() {
@@ -518,6 +523,7 @@ DIAliasTree::addNewNode(
     "Memory location is already attached to a node!");
   ++NumAliasNode, ++NumEstimateNode;
   auto *N = new DIAliasEstimateNode;
+  mSpanningTree.reset();
   mNodes.push_back(N);
   N->setParent(Parent);
   Itr->setAliasNode(*N);
@@ -539,6 +545,7 @@ DIAliasTree::addNewUnknownNode(
     "Memory location is already attached to a node!");
   ++NumAliasNode, ++NumUnknownNode;
   auto *N = new DIAliasUnknownNode;
+  mSpanningTree.reset();
   mNodes.push_back(N);
   N->setParent(Parent);
   Itr->setAliasNode(*N);
@@ -565,6 +572,7 @@ DIAliasTree::addToNode(std::unique_ptr<DIMemory> &&M, DIAliasMemoryNode &N) {
 }
 
 void DIAliasTree::erase(DIAliasMemoryNode &N) {
+  mSpanningTree.reset();
   for (auto &M : N) {
     mFragments.erase(&M);
     delete &M;
@@ -24,6 +24,7 @@
 
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/LibraryFunctions.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/Utils.h"
@@ -40,6 +41,7 @@
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/Support/Debug.h>
 #include <functional>
 
@@ -69,10 +71,10 @@ bool llvm::DefinedMemoryPass::runOnFunction(Function & F) {
   auto *DFF = cast<DFFunction>(RegionInfo.getTopLevelRegion());
   auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (GDM) {
-    ReachDFFwk ReachDefFwk(AliasTree, TLI, DT, mDefInfo, *GDM);
+    ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, mDefInfo, *GDM);
     solveDataFlowUpward(&ReachDefFwk, DFF);
   } else {
-    ReachDFFwk ReachDefFwk(AliasTree, TLI, DT, mDefInfo);
+    ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, mDefInfo);
     solveDataFlowUpward(&ReachDefFwk, DFF);
   }
   return false;
@@ -390,7 +392,9 @@ void DataFlowTraits<ReachDFFwk*>::initialize(
       bool UnknownAddressAccess = true;
       auto F =
         llvm::dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
-      if (F && InterDUInfo) {
+      if (auto *Summary = F ? findLibFuncSummary(*F) : nullptr) {
+        UnknownAddressAccess = !Summary->onlyAccessesArgMemory(*F);
+      } else if (F && InterDUInfo) {
         auto InterDUItr = InterDUInfo->find(F);
         if (InterDUItr != InterDUInfo->end()) {
           auto &DUS = InterDUItr->get<DefUseSet>();
@@ -467,6 +471,16 @@ void DataFlowTraits<ReachDFFwk*>::initialize(
               case ModRefInfo::ModRef:
                 W = R = AccessInfo::May; break;
             }
+          // Alias analysis may be unaware of library functions, so the
+          // summary of a callee is used to clarify the access.
+          if (!InterprocAvailable && F)
+            if (auto *Summary = findLibFuncSummary(*F)) {
+              auto Access = Summary->getArgAccess(*F, Idx);
+              if (!isRead(Access))
+                R = AccessInfo::No;
+              if (!isWrite(Access))
+                W = AccessInfo::No;
+            }
         }
         switch (W) {
         case AccessInfo::No:
@@ -565,11 +579,63 @@ bool DataFlowTraits<ReachDFFwk*>::transferFunction(
   return false;
 }
 
+void ReachDFFwk::initializeLocalAllocas(const DFRegionInfo &RI) {
+  auto *DFF = dyn_cast_or_null<DFFunction>(RI.getTopLevelRegion());
+  if (!DFF)
+    return;
+  // We're looking for alloca->bitcast->lifetime.start/end instructions.
+  auto getMarkedAlloca = [](Instruction &I, Intrinsic::ID ID) {
+    auto *II = dyn_cast<IntrinsicInst>(&I);
+    if (!II || II->getIntrinsicID() != ID)
+      return static_cast<AllocaInst *>(nullptr);
+    auto *BC = dyn_cast<BitCastInst>(II->getArgOperand(1));
+    return BC ? dyn_cast<AllocaInst>(BC->getOperand(0)) : nullptr;
+  };
+  DenseSet<std::pair<const AllocaInst *, const DFNode *>> StartInLoop;
+  SmallVector<std::pair<const AllocaInst *, const DFNode *>, 16> Ends;
+  for (auto &I : instructions(DFF->getFunction())) {
+    bool IsStart = true;
+    auto *AI = getMarkedAlloca(I, Intrinsic::lifetime_start);
+    if (!AI) {
+      AI = getMarkedAlloca(I, Intrinsic::lifetime_end);
+      IsStart = false;
+    }
+    if (!AI)
+      continue;
+    auto *N = RI.getRegionFor(I.getParent());
+    if (!N)
+      continue;
+    if (!IsStart) {
+      Ends.emplace_back(AI, N);
+      continue;
+    }
+    for (auto *R = N->getParent(); R; R = R->getParent())
+      if (isa<DFLoop>(R))
+        StartInLoop.insert(std::make_pair(AI, R));
+  }
+  for (auto &End : Ends)
+    for (auto *R = End.second->getParent(); R; R = R->getParent())
+      if (isa<DFLoop>(R) && StartInLoop.count(std::make_pair(End.first, R)))
+        mLocalAllocas.insert(std::make_pair(End.first, R));
+}
+
+const AllocaInst * ReachDFFwk::findTopLevelAlloca(
+    const MemoryLocationRange &Loc) {
+  // The same locations are usually used in nested regions, so lookup in
+  // the alias tree is performed only once for each location.
+  auto Pair = mLocToAlloca.try_emplace(Loc, nullptr);
+  if (Pair.second) {
+    auto *EM = getAliasTree().find(Loc);
+    assert(EM && "Estimate memory location must not be null!");
+    Pair.first->second =
+      dyn_cast<AllocaInst>(EM->getTopLevelParent()->front());
+  }
+  return Pair.first->second;
+}
+
 void ReachDFFwk::collapse(DFRegion *R) {
   assert(R && "Region must not be null!");
   typedef RegionDFTraits<ReachDFFwk *> RT;
-  auto &AT = getAliasTree();
-  auto &AA = AT.getAliasAnalysis();
   auto Pair = getDefInfo().insert(std::make_pair(R, std::make_tuple(
     llvm::make_unique<DefUseSet>(), llvm::make_unique<ReachSet>())));
   auto &DefUse = Pair.first->get<DefUseSet>();
@@ -590,41 +656,12 @@ void ReachDFFwk::collapse(DFRegion *R) {
     // which get values outside the loop or from previous loop iterations.
     // These locations can not be privatized.
     for (auto &Loc : DU->getUses()) {
-      bool StartInLoop = false, EndInLoop = false;
-      auto *EM = AT.find(Loc);
-      EM = EM->getTopLevelParent();
-      auto *V = EM->front();
-      // We're looking for alloca->bitcast->lifetime.start/end instructions
-      // in loops to exclude arrays that can be marked private
-      if (auto *AI = dyn_cast<AllocaInst>(V)) {
-        for (auto *V1 : AI->users()) {
-          if (auto *BC = dyn_cast<BitCastInst>(V1)) {
-            for (auto *V2 : BC->users()) {
-              if (auto *II = dyn_cast<IntrinsicInst>(V2)) {
-                auto *BB = II->getParent();
-                if (auto *DFL = dyn_cast<DFLoop>(R)) {
-                  auto *L = DFL->getLoop();
-                  if (L->contains(BB)) {
-                    auto ID = II->getIntrinsicID();
-                    if (!StartInLoop &&
-                        ID == llvm::Intrinsic::lifetime_start) {
-                      StartInLoop = true;
-                    } else if (!EndInLoop &&
-                               ID == llvm::Intrinsic::lifetime_end) {
-                      EndInLoop = true;
-                    }
-                    if (StartInLoop && EndInLoop)
-                      break;
-                  }
-                }
-              }
-            }
-          }
-          if (StartInLoop && EndInLoop)
-            break;
-        }
-      }
-      if (!RS->getIn().MustReach.contain(Loc) && !(StartInLoop && EndInLoop))
+      if (RS->getIn().MustReach.contain(Loc))
+        continue;
+      // Arrays which are allocated and released on each iteration of the loop
+      // can be privatized (see initializeLocalAllocas()).
+      auto *AI = findTopLevelAlloca(Loc);
+      if (!AI || !mLocalAllocas.count(std::make_pair(AI, R)))
         DefUse->addUse(Loc);
     }
     // It is possible that some locations are only written in the loop.
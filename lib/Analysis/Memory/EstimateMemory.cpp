@@ -469,6 +469,7 @@ void AliasTree::add(const MemoryLocation &Loc) {
   assert(!isa<UndefValue>(Loc.Ptr) && "Pointer to memory location must be valid!");
   LLVM_DEBUG(dbgs() << "[ALIAS TREE]: add memory location\n");
   mSearchCache.clear();
+  mSpanningTree.reset();
   using CT = bcl::ChainTraits<EstimateMemory, Hierarchy>;
   MemoryLocation Base(Loc);
   EstimateMemory *PrevChainEnd = nullptr;
@@ -559,6 +560,7 @@ void AliasTree::add(const MemoryLocation &Loc) {
 void tsar::AliasTree::addUnknown(llvm::Instruction *I) {
   assert(I && "Instruction which accesses unknown memory must not be null!");
   LLVM_DEBUG(dbgs() << "[ALIAS TREE]: add unknown memory location\n");
+  mSpanningTree.reset();
   if (auto *II = dyn_cast<IntrinsicInst>(I))
     if (isMemoryMarkerIntrinsic(II->getIntrinsicID()) ||
         isDbgInfoIntrinsic(II->getIntrinsicID()))
@@ -605,6 +607,7 @@ void tsar::AliasTree::addUnknown(llvm::Instruction *I) {
 }
 
 void AliasTree::removeNode(AliasNode *N) {
+  mSpanningTree.reset();
   if (auto *Fwd = N->mForward) {
     Fwd->release(*this);
     N->mForward = nullptr;
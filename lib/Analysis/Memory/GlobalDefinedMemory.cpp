@@ -139,11 +139,17 @@ ImmutablePass *llvm::createGlobalDefinedMemoryStorage() {
   return new GlobalDefinedMemoryStorage;
 }
 
+void tsar::clearDefinitions(InterprocDefUseInfo &Info) {
+  for (auto I = Info.begin(), EI = Info.end(); I != EI; ++I)
+    if (!I->get<Function>()->isDeclaration())
+      Info.erase(I);
+}
+
 bool GlobalDefinedMemory::runOnModule(Module &SCC) {
   auto &Wrapper = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (!Wrapper)
     return false;
-  Wrapper->clear();
+  clearDefinitions(*Wrapper);
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
   auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
   for (scc_iterator<CallGraph *> SCC = scc_begin(&CG); !SCC.isAtEnd(); ++SCC) {
@@ -168,7 +174,7 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
     LLVM_DEBUG(DT = &Provider.get<DominatorTreeWrapperPass>().getDomTree());
     auto *DFF = cast<DFFunction>(RegInfo.getTopLevelRegion());
     DefinedMemoryInfo DefInfo;
-    ReachDFFwk ReachDefFwk(AT, TLI, DT, DefInfo, *Wrapper);
+    ReachDFFwk ReachDefFwk(AT, TLI, RegInfo, DT, DefInfo, *Wrapper);
     solveDataFlowUpward(&ReachDefFwk, DFF);
     auto DefUseSetItr = ReachDefFwk.getDefInfo().find(DFF);
     assert(DefUseSetItr != ReachDefFwk.getDefInfo().end() &&
@@ -66,6 +66,34 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override;
 };
 
+/// Release results of interprocedural memory analyses.
+///
+/// These results describe IR at the current stage of processing only and they
+/// are recomputed after the next stage of transformations. So, it is not
+/// necessary to keep them until recomputation.
+class GlobalMemoryRelease : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  GlobalMemoryRelease() : ModulePass(ID) {
+    initializeGlobalMemoryReleasePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override {
+    if (auto *Wrapper = getAnalysisIfAvailable<GlobalLiveMemoryWrapper>())
+      if (*Wrapper)
+        (*Wrapper)->clear();
+    if (auto *Wrapper = getAnalysisIfAvailable<GlobalDefinedMemoryWrapper>())
+      if (*Wrapper)
+        clearDefinitions(**Wrapper);
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+};
+
 class GlobalLiveMemoryStorage :
   public ImmutablePass, private bcl::Uncopyable {
 public:
@@ -227,6 +255,14 @@ ModulePass *llvm::createGlobalLiveMemoryPass() {
   return new GlobalLiveMemory;
 }
 
+char GlobalMemoryRelease::ID = 0;
+INITIALIZE_PASS(GlobalMemoryRelease, "global-mem-release",
+  "Release Results of Interprocedural Memory Analysis", true, true)
+
+ModulePass *llvm::createGlobalMemoryReleasePass() {
+  return new GlobalMemoryRelease;
+}
+
 ImmutablePass *llvm::createGlobalLiveMemoryStorage() {
   return new GlobalLiveMemoryStorage;
 }
@@ -239,6 +275,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
   auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
   auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
   std::vector<CallGraphNode *> Worklist;
   SmallPtrSet<CallGraphNode *, 32> HasExternalCalls;
   for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
@@ -257,13 +294,17 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
         isDbgInfoIntrinsic(F->getIntrinsicID()) ||
         isMemoryMarkerIntrinsic(F->getIntrinsicID()))
       continue;
+    // Results of analysis for a function defined in another translation unit
+    // may be imported from a summary, so it can be processed as a library
+    // function.
+    if (F->empty() && GDM && GDM->count(F))
+      continue;
     if (F->empty() || !hasFnAttr(*F, AttrKind::DirectUserCallee))
       return false;
     if (!checkCallsFrom(*CGN))
       return false;
     Worklist.push_back(CGN);
   }
-  auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (GDM) {
     GlobalLiveMemoryProvider::initialize<GlobalDefinedMemoryWrapper>(
         [&GDM](GlobalDefinedMemoryWrapper &Wrapper) { Wrapper.set(*GDM); });
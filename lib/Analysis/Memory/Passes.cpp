@@ -43,6 +43,8 @@ void llvm::initializeMemoryAnalysis(PassRegistry &Registry) {
   initializeProcessDIMemoryTraitPassPass(Registry);
   initializeNotInitializedMemoryAnalysisPass(Registry);
   initializeDelinearizationPassPass(Registry);
+  initializeStructLayoutAdvisorPass(Registry);
   initializeGlobalDefinedMemoryPass(Registry);
   initializeGlobalLiveMemoryPass(Registry);
+  initializeGlobalMemoryReleasePass(Registry);
 }
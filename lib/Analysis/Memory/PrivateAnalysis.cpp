@@ -38,6 +38,7 @@
 #include "tsar/Analysis/Memory/MemoryTraitUtils.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Core/Query.h"
+#include "tsar/Support/Diagnostic.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/Utils.h"
@@ -97,6 +98,40 @@ struct DependenceCache {
   using CacheT = DenseMap<SrcDstPair, DependenceConfusedPair>;
   CacheT Impl;
 };
+
+/// Limits resources which are available to search for dependencies in a loop.
+///
+/// Resources are the number of queries to alias and dependence analysis and
+/// time spent to analyze the loop and all previous loops in the function.
+class DependenceBudget {
+  using ClockT = std::chrono::steady_clock;
+public:
+  DependenceBudget(const GlobalOptions &GO, ClockT::time_point FuncStart) :
+      mLoopEnd(ClockT::time_point::max()), mFuncEnd(ClockT::time_point::max()),
+      mQueryLimit(GO.LoopQueryBudget) {
+    if (GO.LoopTimeBudget > 0)
+      mLoopEnd = ClockT::now() + std::chrono::milliseconds(GO.LoopTimeBudget);
+    if (GO.FunctionTimeBudget > 0)
+      mFuncEnd = FuncStart + std::chrono::milliseconds(GO.FunctionTimeBudget);
+  }
+
+  /// Accounts a single query, returns `false` if the budget is exhausted.
+  bool query() {
+    if (mQueryLimit > 0 && ++mNumQueries > mQueryLimit)
+      return false;
+    if (mLoopEnd == ClockT::time_point::max() &&
+        mFuncEnd == ClockT::time_point::max())
+      return true;
+    auto Now = ClockT::now();
+    return Now < mLoopEnd && Now < mFuncEnd;
+  }
+
+private:
+  ClockT::time_point mLoopEnd;
+  ClockT::time_point mFuncEnd;
+  unsigned mQueryLimit;
+  unsigned mNumQueries = 0;
+};
 }
 }
 
@@ -105,6 +140,9 @@ bool PrivateRecognitionPass::runOnFunction(Function &F) {
   auto &GlobalOpts = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
   if (!GlobalOpts.AnalyzeLibFunc && hasFnAttr(F, AttrKind::LibFunc))
     return false;
+  mGlobalOpts = &GlobalOpts;
+  mStartTime = std::chrono::steady_clock::now();
+  mIsBudgetReported = false;
 #ifdef LLVM_DEBUG
   for (const BasicBlock &BB : F)
     assert((&F.getEntryBlock() == &BB || BB.getNumUses() > 0 )&&
@@ -484,6 +522,37 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
   for (auto *BB : L->getBlocks())
     for (auto &I : *BB)
       LoopInsts.push_back(&I);
+  DependenceBudget Budget(*mGlobalOpts, mStartTime);
+  // If budget is exhausted some pairs of accesses are not checked, so
+  // all memory accessed in the loop is assumed to be dependent.
+  auto assumeDependencies = [this, L, &LoopInsts, &Deps]() {
+    LLVM_DEBUG(dbgs() << "[PRIVATE]: analysis budget exceeded, assume "
+                         "conservative dependencies\n");
+    if (!mIsBudgetReported) {
+      emitBudgetExceeded(L->getHeader()->getContext(),
+        *L->getHeader()->getParent(), L->getStartLoc());
+      mIsBudgetReported = true;
+    }
+    DependenceImp::Descriptor Dptr;
+    Dptr.set<trait::Flow, trait::Anti, trait::Output>();
+    trait::Dependence::Flag Flag = trait::Dependence::May |
+      trait::Dependence::UnknownDistance | trait::Dependence::UnknownCause;
+    for (auto *I : LoopInsts) {
+      if (!I->mayReadOrWriteMemory())
+        continue;
+      if (auto II = dyn_cast<IntrinsicInst>(I))
+        if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
+          continue;
+      for_each_memory(*I, *mTLI,
+        [this, &Dptr, Flag, &Deps](Instruction &, MemoryLocation &&Loc,
+            unsigned, AccessInfo R, AccessInfo W) {
+          if (R == AccessInfo::No && W == AccessInfo::No)
+            return;
+          updateDependence(mAliasTree->find(Loc), Dptr, Flag, nullptr, Deps);
+        },
+        [](Instruction &, AccessInfo, AccessInfo) {});
+    }
+  };
   for (auto SrcItr = LoopInsts.begin(), EndItr = LoopInsts.end();
        SrcItr != EndItr; ++SrcItr) {
     if (!(**SrcItr).mayReadOrWriteMemory())
@@ -500,6 +569,10 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
         if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
           if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
             continue;
+        if (!Budget.query()) {
+          assumeDependencies();
+          return;
+        }
         ImmutableCallSite DstCS(*DstItr);
         trait::Dependence::Flag Flag = trait::Dependence::May |
           trait::Dependence::UnknownDistance |
@@ -531,6 +604,10 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
           if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
             if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
               continue;
+          if (!Budget.query()) {
+            assumeDependencies();
+            return;
+          }
           if (AA.getModRefInfo(*DstItr, Src) == ModRefInfo::NoModRef)
             continue;
           ImmutableCallSite DstCS(*DstItr);
@@ -554,6 +631,10 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
             Dep = CacheItr->second.first.get();
             ConfusedLevels = CacheItr->second.second;
           } else {
+            if (!Budget.query()) {
+              assumeDependencies();
+              return;
+            }
             auto D = mDepInfo->depends(*SrcItr, *DstItr, true, &ConfusedLevels);
             Dep = D.get();
             Cache.Impl.try_emplace(std::make_pair(*SrcItr, *DstItr),
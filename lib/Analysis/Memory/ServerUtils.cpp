@@ -27,17 +27,37 @@
 #include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Support/MetadataUtils.h"
-#include <llvm/IR/InstIterator.h>
-#include "llvm/IR/InstVisitor.h"
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Pass.h>
+#include <memory>
 
 #define DEBUG_TYPE "di-memory-handle"
 
 using namespace llvm;
 using namespace tsar;
 
+namespace {
+/// Map from a function to debug intrinsics which describe its variables.
+using DbgIntrinsicIndex =
+  DenseMap<const Function *, SmallVector<DbgInfoIntrinsic *, 16>>;
+
+/// Build index of debug intrinsics in a specified module.
+///
+/// Only uses of intrinsic declarations are visited, so the index is built
+/// without traversal of each instruction in the module.
+void buildDbgIntrinsicIndex(Module &M, DbgIntrinsicIndex &Index) {
+  for (auto &F : M) {
+    if (!F.isIntrinsic())
+      continue;
+    for (auto *U : F.users())
+      if (auto *DDI = dyn_cast<DbgInfoIntrinsic>(U))
+        Index[DDI->getFunction()].push_back(DDI);
+  }
+}
+}
+
 void ClientToServerMemory::prepareToClone(
     llvm::Module &ClientM, llvm::ValueToValueMapTy &ClientToServer) {
   // By default global metadata variables and some of local variables are not
@@ -45,9 +65,12 @@ void ClientToServerMemory::prepareToClone(
   // For example, traverse of MetadataAsValue for the mentioned variables
   // visits DbgInfo intrinsics in both modules (clone and origin).
   // So, we perform preliminary manual cloning of local variables.
+  DbgIntrinsicIndex DbgIntrinsics;
+  buildDbgIntrinsicIndex(ClientM, DbgIntrinsics);
   for (auto &F : ClientM) {
-    for (auto &I : instructions(F))
-      if (auto DDI = dyn_cast<DbgInfoIntrinsic>(&I)) {
+    auto DbgItr = DbgIntrinsics.find(&F);
+    if (DbgItr != DbgIntrinsics.end())
+      for (auto *DDI : DbgItr->second) {
         MapMetadata(cast<MDNode>(DDI->getVariable()), ClientToServer);
         SmallVector<std::pair<unsigned, MDNode *>, 1> MDs;
         DDI->getAllMetadata(MDs);
@@ -110,17 +133,24 @@ void ClientToServerMemory::initializeServer(
   for (auto *CU : Search.CUs)
     if (Visited.insert(CU).second)
       ServerCUs->addOperand(CU);
-  // Prepare to mapping from origin to cloned DIMemory.
-  auto &Env = P.getAnalysis<DIMemoryEnvironmentWrapper>();
-  MDToDIMemoryMap CloneToOrigin;
-  for (auto &ClientF: ClientM) {
-    auto DIAT = Env->get(ClientF);
+  // Prepare to mapping from origin to cloned DIMemory. Client-side memory
+  // locations are captured here, so handles follow changes of client-side
+  // alias trees (RAUW) until the mapping is requested. The mapping for each
+  // function is passed to the matcher on demand when server-side memory
+  // locations in this function are matched for the first time.
+  auto &Env = P.getAnalysis<DIMemoryEnvironmentWrapper>().get();
+  auto CloneToOrigin =
+      std::make_shared<DenseMap<const Function *, MDToDIMemoryMap>>();
+  for (auto &ClientF : ClientM) {
+    auto DIAT = Env.get(ClientF);
     if (!DIAT)
       continue;
-    auto F = ClientToServer[&ClientF];
-    assert(F && "Mapped function for a specified one must exist!");
+    Value *V = ClientToServer.lookup(&ClientF);
+    assert(V && "Mapped function for a specified one must exist!");
+    auto *F = cast<Function>(V);
     LLVM_DEBUG(dbgs() << "[CLONED DI MEMORY]: create mapping for function '"
                       << F->getName() << "'\n");
+    auto &FuncCloneToOrigin = (*CloneToOrigin)[F];
     for (auto &DIM : make_range(DIAT->memory_begin(), DIAT->memory_end())) {
       LLVM_DEBUG(dbgs() << "[CLONED DI MEMORY]: add to map: ";
                  if (auto DWLang = getLanguage(ClientF))
@@ -128,15 +158,23 @@ void ClientToServerMemory::initializeServer(
                  dbgs() << "\n");
       auto MD = ClientToServer.getMappedMD(DIM.getAsMDNode());
       assert(MD && "Mapped metadata for a specified memory must exist!");
-      CloneToOrigin.try_emplace(
-        std::make_pair(cast<Function>(F), cast<MDNode>(*MD)), &DIM);
+      FuncCloneToOrigin.try_emplace(std::make_pair(F, cast<MDNode>(*MD)),
+                                    &DIM);
     }
   }
+  auto BuildCloneToOrigin = [CloneToOrigin](Function &F,
+                                            MDToDIMemoryMap &FuncMap) {
+    auto Itr = CloneToOrigin->find(&F);
+    if (Itr == CloneToOrigin->end())
+      return;
+    FuncMap = std::move(Itr->second);
+    CloneToOrigin->erase(Itr);
+  };
   // Passes are removed in backward direction and handlers should be removed
   // before memory environment.
   PM.add(createClonedDIMemoryMatcherStorage());
   PM.add(createDIMemoryEnvironmentStorage());
-  PM.add(createClonedDIMemoryMatcher(std::move(CloneToOrigin)));
+  PM.add(createClonedDIMemoryMatcher(std::move(BuildCloneToOrigin)));
 }
 
 namespace llvm {
@@ -0,0 +1,317 @@
+//===- StructLayoutAdvisor.cpp - Structure Layout Advisor -------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass which looks for arrays of structures traversed
+// in loops which access a small part of each structure. For each such array
+// the pass estimates amount of memory traffic which could be saved if
+// the array is converted to a structure of arrays or if rarely accessed
+// (cold) fields are moved to a separate structure.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Memory/StructLayoutAdvisor.h"
+#include "tsar/Analysis/Memory/DIMemoryLocation.h"
+#include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Support/MetadataUtils.h"
+#include "tsar/Support/PassProvider.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/GetElementPtrTypeIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "struct-layout"
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Number of iterations which is assumed for a loop with unknown trip count.
+constexpr uint64_t UnknownTripCount = 100;
+
+/// A field is cold if it is accessed at least HotFieldRatio times less
+/// often than the hottest field of a structure.
+constexpr uint64_t HotFieldRatio = 10;
+
+using StructLayoutProvider =
+    FunctionPassProvider<LoopInfoWrapperPass, ScalarEvolutionWrapperPass>;
+
+/// Return a structure and a number of its field which is accessed through
+/// a specified pointer.
+///
+/// If the whole structure is accessed the number of fields is returned
+/// as a field number. On failure the structure is nullptr.
+std::pair<StructType *, unsigned> getAccessedField(Value *Ptr) {
+  if (auto *GEP = dyn_cast<GEPOperator>(Ptr))
+    for (auto I = gep_type_begin(GEP), EI = gep_type_end(GEP); I != EI; ++I)
+      if (auto *STy = I.getStructTypeOrNull())
+        return std::make_pair(STy, static_cast<unsigned>(
+          cast<ConstantInt>(I.getOperand())->getZExtValue()));
+  if (auto *STy = dyn_cast<StructType>(
+        cast<PointerType>(Ptr->getType())->getElementType()))
+    return std::make_pair(STy, STy->getNumElements());
+  return std::make_pair(nullptr, 0u);
+}
+
+/// Return estimated number of iterations of a specified loop including
+/// iterations of all outer loops.
+uint64_t getLoopWeight(const Loop &L, ScalarEvolution &SE) {
+  uint64_t Weight = 1;
+  for (auto *Curr = &L; Curr; Curr = Curr->getParentLoop()) {
+    uint64_t TripCount = SE.getSmallConstantTripCount(Curr);
+    Weight = SaturatingMultiply(Weight,
+                                TripCount ? TripCount : UnknownTripCount);
+  }
+  return Weight;
+}
+
+/// Return source-level description of a structure which is an element of
+/// a specified variable or nullptr.
+DICompositeType * getStructDIType(const DIVariable &Var) {
+  auto DITy = arrayElementDIType(Var.getType());
+  if (!DITy.resolve())
+    DITy = stripDIType(Var.getType());
+  auto *DICTy = dyn_cast_or_null<DICompositeType>(DITy.resolve());
+  return DICTy && DICTy->getTag() == dwarf::DW_TAG_structure_type ?
+    DICTy : nullptr;
+}
+
+/// Initialize names of an array, a structure and its fields.
+void initializeNames(const Value &Base, StructType &STy, const DataLayout &DL,
+    AoSInfo &Info) {
+  Info.TypeName = STy.hasName() ? STy.getName() : "<unnamed>";
+  Info.Name = Base.hasName() ? Base.getName() : "<unnamed>";
+  for (unsigned I = 0, EI = STy.getNumElements(); I < EI; ++I)
+    Info.FieldNames.push_back(("#" + Twine(I)).str());
+  SmallVector<DIMemoryLocation, 1> DILocs;
+  auto DILoc = findMetadata(&Base, DILocs);
+  if (!DILoc || !DILoc->Var)
+    return;
+  Info.Var = DILoc->Var;
+  Info.Name = DILoc->Var->getName();
+  auto *DICTy = getStructDIType(*DILoc->Var);
+  if (!DICTy)
+    return;
+  if (!DICTy->getName().empty())
+    Info.TypeName = DICTy->getName();
+  auto *SL = DL.getStructLayout(&STy);
+  for (auto *El : DICTy->getElements()) {
+    auto *Member = dyn_cast_or_null<DIDerivedType>(El);
+    if (!Member || Member->getTag() != dwarf::DW_TAG_member)
+      continue;
+    auto Offset = Member->getOffsetInBits() / 8;
+    if (Offset >= SL->getSizeInBytes())
+      continue;
+    auto Idx = SL->getElementContainingOffset(Offset);
+    if (SL->getElementOffset(Idx) == Offset)
+      Info.FieldNames[Idx] = Member->getName();
+  }
+}
+
+/// Estimate memory traffic which could be saved if a layout of an array
+/// is changed.
+void estimate(AoSInfo &Info) {
+  auto MaxWeight =
+    *std::max_element(Info.FieldWeight.begin(), Info.FieldWeight.end());
+  SmallBitVector Hot(Info.FieldWeight.size());
+  uint64_t HotSize = 0;
+  for (unsigned I = 0, EI = Info.FieldWeight.size(); I < EI; ++I)
+    if (SaturatingMultiply(Info.FieldWeight[I], HotFieldRatio) > MaxWeight) {
+      Hot.set(I);
+      HotSize += Info.FieldSize[I];
+    }
+  Info.Cold = Hot;
+  Info.Cold.flip();
+  for (auto &L : Info.Loops) {
+    uint64_t AccessSize = 0;
+    for (auto I : L.first.set_bits())
+      AccessSize += Info.FieldSize[I];
+    Info.AoSBytes =
+      SaturatingAdd(Info.AoSBytes, SaturatingMultiply(Info.Size, L.second));
+    Info.SoASaved = SaturatingAdd(Info.SoASaved,
+      SaturatingMultiply(Info.Size - std::min(Info.Size, AccessSize),
+                         L.second));
+    if (Info.Cold.none() || (L.first & Info.Cold).any())
+      continue;
+    Info.SplitSaved = SaturatingAdd(Info.SplitSaved,
+      SaturatingMultiply(Info.Size - std::min(Info.Size, HotSize), L.second));
+  }
+}
+}
+
+char StructLayoutAdvisor::ID = 0;
+
+INITIALIZE_PROVIDER_BEGIN(StructLayoutProvider, "struct-layout-provider",
+                          "Structure Layout Advisor (Provider)")
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PROVIDER_END(StructLayoutProvider, "struct-layout-provider",
+                        "Structure Layout Advisor (Provider)")
+
+INITIALIZE_PASS_IN_GROUP_BEGIN(StructLayoutAdvisor, "struct-layout",
+  "Structure Layout Advisor", true, true,
+  DefaultQueryManager::PrintPassGroup::getPassRegistry())
+  INITIALIZE_PASS_DEPENDENCY(StructLayoutProvider)
+INITIALIZE_PASS_IN_GROUP_END(StructLayoutAdvisor, "struct-layout",
+  "Structure Layout Advisor", true, true,
+  DefaultQueryManager::PrintPassGroup::getPassRegistry())
+
+ModulePass * llvm::createStructLayoutAdvisor() {
+  return new StructLayoutAdvisor;
+}
+
+void StructLayoutAdvisor::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<StructLayoutProvider>();
+  AU.setPreservesAll();
+}
+
+bool StructLayoutAdvisor::runOnModule(Module &M) {
+  releaseMemory();
+  auto &DL = M.getDataLayout();
+  MapVector<std::pair<const Value *, StructType *>, AoSInfo> Arrays;
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto &Provider = getAnalysis<StructLayoutProvider>(F);
+    auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
+    auto &SE = Provider.get<ScalarEvolutionWrapperPass>().getSE();
+    for (auto *L : LI.getLoopsInPreorder()) {
+      // Accesses are attributed to the innermost loop which contains them.
+      MapVector<std::pair<const Value *, StructType *>, SmallBitVector>
+        Accesses;
+      for (auto *BB : L->blocks()) {
+        if (LI.getLoopFor(BB) != L)
+          continue;
+        for (auto &I : *BB) {
+          Value *Ptr = nullptr;
+          if (auto *Load = dyn_cast<LoadInst>(&I))
+            Ptr = Load->getPointerOperand();
+          else if (auto *Store = dyn_cast<StoreInst>(&I))
+            Ptr = Store->getPointerOperand();
+          else
+            continue;
+          StructType *STy;
+          unsigned FieldIdx;
+          std::tie(STy, FieldIdx) = getAccessedField(Ptr);
+          if (!STy || !STy->isSized() || STy->getNumElements() < 2)
+            continue;
+          // Only arrays which are traversed element by element are
+          // considered, so each element is fetched from memory once.
+          auto *AddRec = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(Ptr));
+          if (!AddRec || AddRec->getLoop() != L)
+            continue;
+          auto *Step = dyn_cast<SCEVConstant>(AddRec->getStepRecurrence(SE));
+          if (!Step ||
+              Step->getAPInt().abs() != DL.getTypeAllocSize(STy))
+            continue;
+          auto *Base = GetUnderlyingObject(Ptr, DL, 0);
+          auto &Fields = Accesses[std::make_pair(Base, STy)];
+          Fields.resize(STy->getNumElements());
+          if (FieldIdx < STy->getNumElements())
+            Fields.set(FieldIdx);
+          else
+            Fields.set();
+        }
+      }
+      if (Accesses.empty())
+        continue;
+      auto Weight = getLoopWeight(*L, SE);
+      for (auto &Access : Accesses) {
+        auto Itr = Arrays.find(Access.first);
+        if (Itr == Arrays.end()) {
+          auto *STy = Access.first.second;
+          auto &Info = Arrays[Access.first];
+          Info.Size = DL.getTypeAllocSize(STy);
+          for (auto *ElTy : STy->elements())
+            Info.FieldSize.push_back(DL.getTypeAllocSize(ElTy));
+          Info.FieldWeight.resize(STy->getNumElements(), 0);
+          auto *Base = Access.first.first;
+          Info.IsLocal = isa<AllocaInst>(Base) ||
+            isa<GlobalVariable>(Base) &&
+              cast<GlobalVariable>(Base)->hasLocalLinkage();
+          if (isa<AllocaInst>(Base))
+            Info.Func = &F;
+          initializeNames(*Base, *STy, DL, Info);
+          Itr = Arrays.find(Access.first);
+        }
+        auto &Info = Itr->second;
+        for (auto I : Access.second.set_bits())
+          Info.FieldWeight[I] = SaturatingAdd(Info.FieldWeight[I], Weight);
+        Info.Loops.emplace_back(std::move(Access.second), Weight);
+      }
+    }
+  }
+  for (auto &Array : Arrays) {
+    auto &Info = Array.second;
+    estimate(Info);
+    LLVM_DEBUG(dbgs() << "[STRUCT LAYOUT]: array " << Info.Name
+                      << " of structures " << Info.TypeName << " transfers "
+                      << Info.AoSBytes << " bytes, structure of arrays saves "
+                      << Info.SoASaved << " bytes, hot/cold splitting saves "
+                      << Info.SplitSaved << " bytes\n");
+    // Ignore arrays if the most part of each element is used.
+    if (Info.SoASaved < Info.AoSBytes / 2)
+      continue;
+    mCandidates.push_back(std::move(Info));
+  }
+  std::stable_sort(mCandidates.begin(), mCandidates.end(),
+    [](const AoSInfo &LHS, const AoSInfo &RHS) {
+      return LHS.SoASaved > RHS.SoASaved;
+  });
+  return false;
+}
+
+void StructLayoutAdvisor::print(raw_ostream &OS, const Module *M) const {
+  for (auto &Info : mCandidates) {
+    OS << "array '" << Info.Name << "' of structures '" << Info.TypeName
+       << "' (" << Info.Size << " bytes)";
+    if (Info.IsLocal)
+      OS << " is local to translation unit";
+    OS << "\n";
+    SmallBitVector Accessed(Info.FieldWeight.size());
+    for (auto &L : Info.Loops)
+      Accessed |= L.first;
+    OS << "  accessed fields:";
+    for (auto I : Accessed.set_bits())
+      OS << " " << Info.FieldNames[I];
+    OS << "\n";
+    OS << "  structure of arrays saves " << Info.SoASaved << " of "
+       << Info.AoSBytes << " bytes\n";
+    if (Info.SplitSaved == 0)
+      continue;
+    OS << "  hot/cold splitting saves " << Info.SplitSaved << " of "
+       << Info.AoSBytes << " bytes, cold fields:";
+    for (auto I : Info.Cold.set_bits())
+      OS << " " << Info.FieldNames[I];
+    OS << "\n";
+  }
+}
@@ -29,4 +29,5 @@ using namespace llvm;
 
 void llvm::initializeParallelizationAnalysis(PassRegistry &Registry) {
   initializeParallelLoopPassPass(Registry);
+  initializeSIMDLoopPassPass(Registry);
 }
@@ -0,0 +1,215 @@
+//===- SIMDLoop.cpp ----------------------- SIMD Loop Analysis --*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass to determine innermost loops which could be
+// vectorized. Metadata-level dependence analysis results are used, so
+// a loop may be classified as vectorizable even if a compiler is not able to
+// prove absence of aliasing by itself.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Parallel/SIMDLoop.h"
+#include "tsar/Analysis/AnalysisServer.h"
+#include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Analysis/Memory/DIDependencyAnalysis.h"
+#include "tsar/Analysis/Memory/DIEstimateMemory.h"
+#include "tsar/Analysis/Memory/MemoryTraitUtils.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/IRUtils.h"
+#include "tsar/Support/Utils.h"
+#include "tsar/Transform/IR/InterprocAttr.h"
+#include <llvm/Analysis/LoopInfo.h>
+#include <limits>
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "simd-loop"
+
+using namespace llvm;
+using namespace tsar;
+
+char SIMDLoopPass::ID = 0;
+INITIALIZE_PASS_BEGIN(SIMDLoopPass, "simd-loop", "SIMD Loop Analysis",
+                      true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(LoopAttributesDeductionPass)
+INITIALIZE_PASS_END(SIMDLoopPass, "simd-loop", "SIMD Loop Analysis",
+                    true, true)
+
+FunctionPass *llvm::createSIMDLoopPass() { return new SIMDLoopPass; }
+
+StringRef SIMDInfo::getReasonDescription() const {
+  switch (mReason) {
+  case NoReason: return "";
+  case UnsafeCFG: return "unsafe control flow";
+  case Call: return "call of a function which accesses memory";
+  case NoAnalysis: return "absence of dependence analysis results";
+  case DataDependence: return "data dependence";
+  case Aliasing: return "memory aliasing";
+  case UnknownReduction: return "unknown reduction operation";
+  case UnknownDistance: return "unknown distance of loop-carried dependence";
+  case ShortDistance: return "loop-carried dependence with distance 1";
+  }
+  llvm_unreachable("Unknown reason which prevents vectorization!");
+}
+
+namespace {
+/// Update safe length `SafeLength` in accordance with a dependence
+/// of a specified kind `Tag`.
+///
+/// \return A reason which prevents vectorization or `NoReason`.
+template<class Tag> SIMDInfo::Reason updateSafeLength(
+    const DIMemoryTrait &T, unsigned &SafeLength) {
+  if (!T.is<Tag>())
+    return SIMDInfo::NoReason;
+  auto *Info = T.get<Tag>();
+  if (!Info || !Info->isKnownDistance())
+    return SIMDInfo::UnknownDistance;
+  auto &Lowest = Info->getDistance().first;
+  if (!Lowest->isStrictlyPositive())
+    return SIMDInfo::UnknownDistance;
+  auto Distance = static_cast<unsigned>(
+      Lowest->getLimitedValue(std::numeric_limits<unsigned>::max()));
+  if (Distance == 1)
+    return SIMDInfo::ShortDistance;
+  if (SafeLength == 0 || Distance < SafeLength)
+    SafeLength = Distance;
+  return SIMDInfo::NoReason;
+}
+}
+
+void SIMDLoopPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.addRequired<LoopInfoWrapperPass>();
+  AU.addRequired<LoopAttributesDeductionPass>();
+  AU.setPreservesAll();
+}
+
+bool SIMDLoopPass::runOnFunction(Function &F) {
+  releaseMemory();
+  auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  auto &LoopAttr = getAnalysis<LoopAttributesDeductionPass>();
+  DIAliasTree *DIAT = nullptr;
+  DIDependencInfo *DIDepInfo = nullptr;
+  std::function<ObjectID(ObjectID)> getLoopID = [](ObjectID ID) { return ID; };
+  if (auto *SInfo = getAnalysisIfAvailable<AnalysisSocketImmutableWrapper>()) {
+    if (auto *Socket = (*SInfo)->getActiveSocket()) {
+      if (auto R = Socket->getAnalysis<AnalysisClientServerMatcherWrapper>()) {
+        auto *Matcher = R->value<AnalysisClientServerMatcherWrapper *>();
+        getLoopID = [Matcher](ObjectID ID) {
+          auto ServerID = (*Matcher)->getMappedMD(ID);
+          return ServerID ? cast<MDNode>(*ServerID) : nullptr;
+        };
+        if (auto R = Socket->getAnalysis<
+          DIEstimateMemoryPass, DIDependencyAnalysisPass>(F)) {
+          DIAT = &R->value<DIEstimateMemoryPass *>()->getAliasTree();
+          DIDepInfo =
+              &R->value<DIDependencyAnalysisPass *>()->getDependencies();
+        }
+      }
+    }
+  }
+  if (!DIAT || !DIDepInfo) {
+    LLVM_DEBUG(dbgs() << "[SIMD LOOP]: analysis server is not available\n");
+    if (auto *P = getAnalysisIfAvailable<DIEstimateMemoryPass>())
+      DIAT = &P->getAliasTree();
+    else
+      return false;
+    if (auto *P = getAnalysisIfAvailable<DIDependencyAnalysisPass>())
+      DIDepInfo = &P->getDependencies();
+    else
+      return false;
+    LLVM_DEBUG(dbgs() << "[SIMD LOOP]: use dependence analysis from client\n");
+  }
+  auto classify = [&GO, &LoopAttr, &getLoopID, DIAT, DIDepInfo](Loop *L) {
+    if (!LoopAttr.hasAttr(*L, AttrKind::AlwaysReturn) ||
+        !LoopAttr.hasAttr(*L, AttrKind::NoIO) ||
+        !LoopAttr.hasAttr(*L, Attribute::NoUnwind) ||
+        LoopAttr.hasAttr(*L, Attribute::ReturnsTwice))
+      return SIMDInfo(SIMDInfo::UnsafeCFG);
+    // Vector variants of user-defined functions are unknown, so only calls
+    // which do not access memory (math intrinsics for example) are allowed.
+    for (auto *BB : L->getBlocks())
+      for (auto &I : *BB) {
+        CallSite CS(&I);
+        if (!CS)
+          continue;
+        auto Callee =
+            dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+        if (!Callee)
+          return SIMDInfo(SIMDInfo::Call);
+        if (isa<IntrinsicInst>(I) &&
+            (isDbgInfoIntrinsic(Callee->getIntrinsicID()) ||
+             isMemoryMarkerIntrinsic(Callee->getIntrinsicID())))
+          continue;
+        if (!Callee->doesNotAccessMemory())
+          return SIMDInfo(SIMDInfo::Call);
+      }
+    auto *LoopID = L->getLoopID();
+    if (!LoopID || !(LoopID = getLoopID(LoopID)))
+      return SIMDInfo(SIMDInfo::NoAnalysis);
+    auto DepItr = DIDepInfo->find(LoopID);
+    if (DepItr == DIDepInfo->end())
+      return SIMDInfo(SIMDInfo::NoAnalysis);
+    auto &DIDepSet = DepItr->get<DIDependenceSet>();
+    DenseSet<const DIAliasNode *> Coverage;
+    accessCoverage<bcl::SimpleInserter>(DIDepSet, *DIAT, Coverage,
+                                        GO.IgnoreRedundantMemory);
+    unsigned SafeLength = 0;
+    for (auto &TS : DIDepSet) {
+      if (!Coverage.count(TS.getNode()))
+        continue;
+      if (TS.is_any<trait::AddressAccess, trait::Output>() ||
+          TS.is<trait::DynamicPrivate>() && !TS.is<trait::Shared>())
+        return SIMDInfo(SIMDInfo::DataDependence);
+      if (TS.size() > 1 && !TS.is_any<trait::Shared, trait::Readonly>())
+        return SIMDInfo(SIMDInfo::Aliasing);
+      auto &DIMTraitItr = *TS.begin();
+      if (DIMTraitItr->is<trait::Reduction>() &&
+          !DIMTraitItr->get<trait::Reduction>())
+        return SIMDInfo(SIMDInfo::UnknownReduction);
+      auto R = updateSafeLength<trait::Flow>(*DIMTraitItr, SafeLength);
+      if (R == SIMDInfo::NoReason)
+        R = updateSafeLength<trait::Anti>(*DIMTraitItr, SafeLength);
+      if (R != SIMDInfo::NoReason)
+        return SIMDInfo(R);
+    }
+    return SIMDInfo(SafeLength);
+  };
+  for_each_loop(LI, [this, &classify](Loop *L) {
+    if (!L->empty())
+      return;
+    auto Info = classify(L);
+    LLVM_DEBUG(dbgs() << "[SIMD LOOP]: loop at ";
+               L->getStartLoc().print(dbgs());
+               if (Info.isVectorizable()) {
+                 dbgs() << " is vectorizable";
+                 if (Info.hasSafeLength())
+                   dbgs() << " with safe length " << Info.getSafeLength();
+               } else {
+                 dbgs() << " is not vectorizable due to "
+                        << Info.getReasonDescription();
+               }
+               dbgs() << "\n");
+    mSIMDLoops.insert(std::make_pair(L, Info));
+  });
+  return false;
+}
@@ -29,6 +29,7 @@
 #include "tsar/Analysis/Memory/MemoryTraitJSON.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Analysis/Reader/AnalysisJSON.h"
+#include "tsar/Analysis/Reader/IterationCounts.h"
 #include "tsar/Analysis/Reader/Passes.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/Tags.h"
@@ -237,25 +238,52 @@ TraitCache buildTraitCache(const trait::Info &Info, const trait::Loop &L) {
   return Res;
 }
 
-/// Find traits for a specified loop in external analysis results.
-const trait::Loop * findLoop(const MDNode *LoopID, const LoopCache &Cache,
-    const trait::Info &Info) {
+/// Return location of a loop with a specified ID.
+Optional<LocationT> getLoopLocation(const MDNode *LoopID) {
   DILocation *Loc = nullptr;
   for (unsigned I = 1, EI = LoopID->getNumOperands(); I < EI; ++I)
     if (Loc = dyn_cast<DILocation>(LoopID->getOperand(I)))
       break;
   if (!Loc)
-    return nullptr;
+    return None;
   sys::fs::UniqueID ID;
   if (sys::fs::getUniqueID(Loc->getFilename(), ID))
+    return None;
+  return LocationT{ ID, Loc->getLine(), Loc->getColumn() };
+}
+
+/// Find traits for a specified loop in external analysis results.
+const trait::Loop * findLoop(const MDNode *LoopID, const LoopCache &Cache,
+    const trait::Info &Info) {
+  auto LoopKey = getLoopLocation(LoopID);
+  if (!LoopKey)
     return nullptr;
-  auto LoopKey =
-    LocationT{ ID, Loc->getLine(), Loc->getColumn() };
-  auto LoopItr = Cache.find(LoopKey);
+  auto LoopItr = Cache.find(*LoopKey);
   return (LoopItr == Cache.end() ? nullptr :
     &Info[trait::Info::Loops][LoopItr->second]);
 }
 
+/// Load external analysis results from a specified file.
+bool parseInfo(StringRef DataFile, LLVMContext &Ctx, trait::Info &Info) {
+  auto FileOrErr = MemoryBuffer::getFile(DataFile);
+  if (auto EC = FileOrErr.getError()) {
+    Ctx.diagnose(DiagnosticInfoPGOProfile(DataFile.data(),
+      Twine("unable to open file: ") + EC.message()));
+    return false;
+  }
+  json::Parser<> Parser((**FileOrErr).getBuffer().str());
+  if (!Parser.parse(Info)) {
+    for (auto D : Parser.errors()) {
+      DiagnosticInfoPGOProfile Diag(DataFile.data(), D, DS_Note);
+      Ctx.diagnose(Diag);
+    }
+    Ctx.diagnose(DiagnosticInfoPGOProfile(DataFile.data(),
+      "unable to parse external analysis results"));
+    return false;
+  }
+  return true;
+}
+
 /// Update description `DITrait` of a specified trait `TraitTag` according to
 /// external information `TraitItr`.
 template<class TraitTag> void updateAntiFlowDep(
@@ -300,6 +328,25 @@ void updateOutputDep(
   F &= (~trait::Dependence::Flag::May);
   DITrait.template set<trait::Output>(new trait::DIDependence(F, Dep->getDistance()));
 }
+
+/// Mark a dependence `TraitTag` in `DITrait` as definite if it has been
+/// observed according to external information `TraitItr`, distance of
+/// the dependence is not changed.
+template<class TraitTag> void confirmDep(
+    const TraitCache::iterator &TraitItr, DIMemoryTrait &DITrait) {
+  if (!TraitItr->second.template get<TraitTag>() ||
+      !DITrait.template is<TraitTag>())
+    return;
+  auto Dep = DITrait.template get<TraitTag>();
+  if (!Dep)
+    return;
+  LLVM_DEBUG(dbgs() << "[ANALYSIS READER]: confirm " << TraitTag::toString()
+                    << " dependence\n");
+  auto F = Dep->getFlags();
+  F &= (~trait::Dependence::Flag::May);
+  DITrait.template set<TraitTag>(
+    new trait::DIDependence(F, Dep->getDistance()));
+}
 }
 
 INITIALIZE_PASS_BEGIN(AnalysisReader, "analysis-reader",
@@ -328,24 +375,10 @@ bool AnalysisReader::runOnFunction(Function &F) {
     else
       return false;
   }
-  auto FileOrErr = MemoryBuffer::getFile(mDataFile);
-  if (auto EC = FileOrErr.getError()) {
-    F.getContext().diagnose(DiagnosticInfoPGOProfile(mDataFile.data(),
-      Twine("unable to open file: ") + EC.message()));
-    return false;
-  }
   auto &TraitPool = getAnalysis<DIMemoryTraitPoolWrapper>().get();
-  json::Parser<> Parser((**FileOrErr).getBuffer().str());
   trait::Info Info;
-  if (!Parser.parse(Info)) {
-    for (auto D : Parser.errors()) {
-      DiagnosticInfoPGOProfile Diag(mDataFile.data(), D, DS_Note);
-      F.getContext().diagnose(Diag);
-    }
-    F.getContext().diagnose(DiagnosticInfoPGOProfile(mDataFile.data(),
-      "unable to parse external analysis results"));
+  if (!parseInfo(mDataFile, F.getContext(), Info))
     return false;
-  }
   auto LoopCache = buildLoopCache(Info);
   for (auto &TraitLoop : TraitPool) {
     auto LoopID = cast<MDNode>(TraitLoop.get<Region>());
@@ -357,6 +390,11 @@ bool AnalysisReader::runOnFunction(Function &F) {
                       << (*L)[trait::Loop::Line] << ":"
                       << (*L)[trait::Loop::Column] << "\n");
     auto TraitCache = buildTraitCache(Info, *L);
+    // Traits of a sampled loop have been collected for some iterations of
+    // this loop or of nested loops (including loops in callees) only.
+    // So, they confirm observed dependencies but do not prove absence of
+    // other dependencies.
+    bool IsSampled = (*L)[trait::Loop::Sampled];
     for (auto &DITrait : *TraitLoop.get<Pool>()) {
       if (DITrait.is_any<trait::NoAccess, trait::Readonly, trait::Reduction,
                          trait::Induction>())
@@ -408,6 +446,12 @@ bool AnalysisReader::runOnFunction(Function &F) {
             dbgs() << "[ANALYSIS READER]: no external traits are provided\n");
         continue;
       }
+      if (IsSampled) {
+        confirmDep<trait::Flow>(TraitItr, DITrait);
+        confirmDep<trait::Anti>(TraitItr, DITrait);
+        confirmDep<trait::Output>(TraitItr, DITrait);
+        continue;
+      }
       if (isOnlyAnyOf<trait::UseAfterLoop, trait::WriteOccurred,
                       trait::ReadOccurred>(TraitItr->second)) {
         if (TraitItr->second.get<trait::WriteOccurred>())
@@ -449,3 +493,32 @@ bool AnalysisReader::runOnFunction(Function &F) {
   }
   return false;
 }
+
+bool LoopIterationCounts::load(StringRef DataFile, LLVMContext &Ctx) {
+  trait::Info Info;
+  if (!parseInfo(DataFile, Ctx, Info))
+    return false;
+  for (auto &L : Info[trait::Info::Loops]) {
+    // Zero means that a number of iterations is not specified or it is
+    // unknown, for example, if iterations of a loop have been sampled.
+    if (L[trait::Loop::Iterations] == 0)
+      continue;
+    sys::fs::UniqueID ID;
+    if (sys::fs::getUniqueID(L[trait::Loop::File], ID))
+      continue;
+    mCounts[std::make_tuple(ID, L[trait::Loop::Line], L[trait::Loop::Column])]
+      += L[trait::Loop::Iterations];
+  }
+  return true;
+}
+
+Optional<std::uint64_t>
+LoopIterationCounts::find(const MDNode *LoopID) const {
+  auto Loc = getLoopLocation(LoopID);
+  if (!Loc)
+    return None;
+  auto I = mCounts.find(std::make_tuple(
+    Loc->get<File>(), Loc->get<Line>(), Loc->get<Column>()));
+  return I == mCounts.end() || I->second == 0 ? Optional<std::uint64_t>()
+                                               : I->second;
+}
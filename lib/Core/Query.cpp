@@ -90,6 +90,8 @@ void addInitialTransformations(legacy::PassManager &Passes) {
   // In other cases 'clang' automatically deletes unreachable blocks.
   Passes.add(createUnreachableBlockEliminationPass());
   Passes.add(createInferFunctionAttrsLegacyPass());
+  Passes.add(createLibFuncAttrsAnalysis());
+  Passes.add(createFunctionSummaryImportPass());
   Passes.add(createPostOrderFunctionAttrsLegacyPass());
   Passes.add(createReversePostOrderFunctionAttrsPass());
   Passes.add(createRPOFunctionAttrsAnalysis());
@@ -118,7 +120,10 @@ void addAfterSROAAnalysis(const GlobalOptions &GO, const DataLayout &DL,
   // module passes and these results becomes invalid after transformations.
   // So, to prevent access to invalid (destroyed) values we finish processing of
   // all functions.
-  Passes.add(createPassBarrier());
+  Passes.add(createPassBarrier("analysis before transformations"));
+  // Results of interprocedural analysis have been already consumed at this
+  // moment, so release them before the next stage.
+  Passes.add(createGlobalMemoryReleasePass());
   Passes.add(createCFGSimplificationPass());
   // Do not add 'instcombine' here, because in this case some metadata may be
   // lost after SROA (for example, if a promoted variable is a structure).
@@ -146,7 +151,8 @@ void addAfterSROAAnalysis(const GlobalOptions &GO, const DataLayout &DL,
 }
 
 void addAfterLoopRotateAnalysis(legacy::PassManager &Passes) {
-  Passes.add(createPassBarrier());
+  Passes.add(createPassBarrier("analysis after SROA"));
+  Passes.add(createGlobalMemoryReleasePass());
   Passes.add(
       createProcessDIMemoryTraitPass(markIf<trait::Lock, trait::HeaderAccess>));
   Passes.add(createLoopRotatePass());
@@ -276,6 +282,8 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationContext *Ctx) {
                  PrintPassGroup::getPassRegistry(), Passes);
 #endif
   addBeforeTfmAnalysis(Passes);
+  if (!mGlobalOptions->SummaryExport.empty())
+    Passes.add(createFunctionSummaryExportPass());
   addPrint(BeforeTfmAnalysis);
   addOutput(BeforeTfmAnalysis);
   addAfterSROAAnalysis(*mGlobalOptions, M->getDataLayout(), Passes);
@@ -311,6 +319,8 @@ void EmitLLVMQueryManager::run(llvm::Module *M, TransformationContext *) {
 void InstrLLVMQueryManager::run(llvm::Module *M, TransformationContext *Ctx) {
   assert(M && "Module must not be null!");
   legacy::PassManager Passes;
+  if (mGlobalOptions)
+    Passes.add(createGlobalOptionsImmutableWrapper(mGlobalOptions));
   if (Ctx) {
     auto TEP = static_cast<TransformationEnginePass *>(
       createTransformationEnginePass());
@@ -322,7 +332,12 @@ void InstrLLVMQueryManager::run(llvm::Module *M, TransformationContext *Ctx) {
   Passes.add(createDINodeRetrieverPass());
   Passes.add(createMemoryMatcherPass());
   Passes.add(createDILoopRetrieverPass());
-  Passes.add(createInstrumentationPass(mInstrEntry, mInstrStart));
+  // Optimization regions are collected after loops are marked with
+  // identifiers, these identifiers are used to recognize loops in regions.
+  if (Ctx && Ctx->hasInstance())
+    Passes.add(createClangRegionCollector());
+  Passes.add(createInstrumentationPass(mInstrEntry, mInstrStart,
+    mInstrBufferSize, mInstrSampleFirst, mInstrSamplePeriod, mInstrRange));
   Passes.add(createPrintModulePass(*mOS, "", mCodeGenOpts->EmitLLVMUseLists));
   Passes.run(*M);
 }
@@ -354,6 +369,21 @@ void TransformationQueryManager::run(llvm::Module *M,
   Passes.run(*M);
 }
 
+void SummaryQueryManager::run(llvm::Module *M, TransformationContext *) {
+  assert(M && "Module must not be null!");
+  legacy::PassManager Passes;
+  Passes.add(createGlobalOptionsImmutableWrapper(mGlobalOptions));
+  addImmutableAliasAnalysis(Passes);
+  addInitialTransformations(Passes);
+  Passes.add(createGlobalDefinedMemoryStorage());
+  Passes.add(createCallExtractorPass());
+  Passes.add(createGlobalDefinedMemoryPass());
+  Passes.add(createFunctionMemoryAttrsAnalysis());
+  Passes.add(createFunctionSummaryExportPass());
+  Passes.add(createVerifierPass());
+  Passes.run(*M);
+}
+
 void CheckQueryManager::run(llvm::Module *M, TransformationContext* Ctx) {
   assert(M && "Module must not be null!");
   legacy::PassManager Passes;
@@ -31,17 +31,22 @@
 #include "tsar/Frontend/Clang/Action.h"
 #include "tsar/Frontend/Clang/ASTMergeAction.h"
 #include "tsar/Patch/llvm/IR/LegacyPassNameParser.h"
+#include "tsar/Support/AnalysisJobs.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/Clang/Pragma.h"
+#include "tsar/Transform/IR/FunctionSummary.h"
 #ifdef APC_FOUND
 # include "tsar/APC/Utils.h"
 #endif
 #include <clang/Frontend/FrontendActions.h>
 #include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/CommandLine.h>
+#include <algorithm>
 #ifdef lp_solve_FOUND
 # include <lp_solve/lp_solve_config.h>
 #endif
@@ -97,6 +102,10 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> InstrLLVM;
   llvm::cl::opt<std::string> InstrEntry;
   llvm::cl::list<std::string> InstrStart;
+  llvm::cl::opt<unsigned> InstrBuffer;
+  llvm::cl::opt<unsigned> InstrSampleFirst;
+  llvm::cl::opt<unsigned> InstrSamplePeriod;
+  llvm::cl::opt<bool> InstrRange;
   llvm::cl::opt<bool> EmitAST;
   llvm::cl::opt<bool> MergeAST;
   llvm::cl::alias MergeASTA;
@@ -113,6 +122,7 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> PrintAST;
   llvm::cl::opt<bool> DumpAST;
   llvm::cl::opt<bool> TimeReport;
+  llvm::cl::opt<bool> MemoryReport;
   llvm::cl::opt<bool> UseServer;
 
   llvm::cl::opt<bool> PrintAll;
@@ -141,6 +151,13 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> NoMathErrno;
   llvm::cl::opt<std::string> AnalysisUse;
   llvm::cl::list<std::string> OptRegion;
+  llvm::cl::opt<unsigned> LoopTimeBudget;
+  llvm::cl::opt<unsigned> FunctionTimeBudget;
+  llvm::cl::opt<unsigned> LoopQueryBudget;
+  llvm::cl::opt<unsigned> AnalysisJobs;
+  llvm::cl::opt<std::string> SummaryExport;
+  llvm::cl::opt<std::string> SummaryUse;
+  llvm::cl::opt<bool> SummaryOnly;
 
   llvm::cl::OptionCategory TransformCategory;
   llvm::cl::opt<bool> NoFormat;
@@ -173,6 +190,17 @@ Options::Options() :
   InstrStart("instr-start", cl::cat(CompileCategory), cl::value_desc("functions"),
     cl::ZeroOrMore, cl::ValueRequired, cl::CommaSeparated,
     cl::desc("Add start point for instrumentation")),
+  InstrBuffer("instr-buffer", cl::cat(CompileCategory), cl::value_desc("size"),
+    cl::init(0),
+    cl::desc("Accumulate instrumentation events in a buffer of a given size")),
+  InstrSampleFirst("instr-sample-first", cl::cat(CompileCategory),
+    cl::value_desc("number"), cl::init(10),
+    cl::desc("Number of the first instrumented iterations of a sampled loop")),
+  InstrSamplePeriod("instr-sample-period", cl::cat(CompileCategory),
+    cl::value_desc("number"), cl::init(0),
+    cl::desc("Instrument only each N-th iteration of innermost loops")),
+  InstrRange("instr-range", cl::cat(CompileCategory),
+    cl::desc("Register strided accesses in loops once per loop entry")),
   EmitAST("emit-ast", cl::cat(CompileCategory),
     cl::desc("Emit Clang AST files for source inputs")),
   MergeAST("merge-ast", cl::cat(CompileCategory),
@@ -202,6 +230,8 @@ Options::Options() :
     cl::desc("Build ASTs and then debug dump them")),
   TimeReport("ftime-report", cl::cat(DebugCategory),
     cl::desc("Print some statistics about the time consumed by each pass when it finishes")),
+  MemoryReport("fmemory-report", cl::cat(DebugCategory),
+    cl::desc("Print memory usage when each processing step finishes")),
   UseServer("use-analysis-server", cl::cat(DebugCategory),
     cl::desc("Run default workflow on analysis server")),
   PrintAll("print-all", cl::cat(DebugCategory),
@@ -249,6 +279,26 @@ Options::Options() :
   OptRegion("foptimize-only", cl::cat(AnalysisCategory), cl::value_desc("regions"),
     cl::ZeroOrMore, cl::ValueRequired, cl::CommaSeparated,
     cl::desc("Allow optimization of specified regions (comma separated list of region names")),
+  LoopTimeBudget("floop-time-budget", cl::cat(AnalysisCategory),
+    cl::value_desc("milliseconds"), cl::init(0),
+    cl::desc("Limit time of dependence analysis of a loop (0 means no limit)")),
+  FunctionTimeBudget("ffunction-time-budget", cl::cat(AnalysisCategory),
+    cl::value_desc("milliseconds"), cl::init(0),
+    cl::desc("Limit time of dependence analysis of loops in a function (0 means no limit)")),
+  LoopQueryBudget("floop-query-budget", cl::cat(AnalysisCategory),
+    cl::value_desc("number"), cl::init(0),
+    cl::desc("Limit number of dependence tests in a loop (0 means no limit)")),
+  AnalysisJobs("fanalysis-jobs", cl::cat(AnalysisCategory),
+    cl::value_desc("number"), cl::init(1),
+    cl::desc("Analyze sources in a specified number of processes which exchange summaries of functions")),
+  SummaryExport("fsummary-export", cl::cat(AnalysisCategory),
+    cl::value_desc("filename"),
+    cl::desc("Store summaries of externally visible functions to a file")),
+  SummaryUse("fsummary-use", cl::cat(AnalysisCategory),
+    cl::value_desc("filename"),
+    cl::desc("Use summaries of functions from a file to analyze calls")),
+  SummaryOnly("fsummary-only", cl::cat(AnalysisCategory),
+    cl::desc("Only compute summaries of functions (use with -fsummary-export)")),
   TransformCategory("Transformation options"),
   NoFormat("no-format", cl::cat(TransformCategory),
     cl::desc("Disable format of transformed sources")),
@@ -339,6 +389,7 @@ static std::vector<const char *> addInternalArgs(int Argc, const char **Argv) {
 Tool::Tool(int Argc, const char **Argv) {
   assert(Argv && "List of command line arguments must not be null!");
   Options::get(); // At first, initialize command line options.
+  mArgs.assign(Argv, Argv + Argc);
   std::string Descr = std::string(TSAR_DESCRIPTION) + "(TSAR)";
   // Passes should be initialized previously then command line options are
   // parsed, due to initialize list of available passes.
@@ -368,8 +419,12 @@ inline static EmitLLVMQueryManager * getEmitLLVMQM() {
 }
 
 inline static InstrLLVMQueryManager * getInstrLLVMQM(
-    StringRef InstrEntry, ArrayRef<std::string> InstrStart) {
-  static InstrLLVMQueryManager QM(InstrEntry, InstrStart);
+    StringRef InstrEntry, ArrayRef<std::string> InstrStart,
+    unsigned InstrBuffer, unsigned InstrSampleFirst,
+    unsigned InstrSamplePeriod, bool InstrRange,
+    const GlobalOptions &GlobalOpts) {
+  static InstrLLVMQueryManager QM(InstrEntry, InstrStart, InstrBuffer,
+    InstrSampleFirst, InstrSamplePeriod, InstrRange, &GlobalOpts);
   return &QM;
 }
 
@@ -379,6 +434,12 @@ inline static TransformationQueryManager * getTransformationQM(
   return &QM;
 }
 
+inline static SummaryQueryManager * getSummaryQM(
+    const GlobalOptions &GlobalOpts) {
+  static SummaryQueryManager QM(&GlobalOpts);
+  return &QM;
+}
+
 inline static CheckQueryManager * getCheckQM() {
   static CheckQueryManager QM;
   return &QM;
@@ -399,6 +460,7 @@ void Tool::storePrintOptions(OptionList &IncompatibleOpts) {
       DefaultQueryManager::PrintPassGroup::getPassRegistry().end());
   }
   mGlobalOpts.PrintFilenameOnly = Options::get().PrintFilename;
+  mGlobalOpts.PrintMemoryUsage = Options::get().MemoryReport;
   if (mGlobalOpts.PrintFilenameOnly && !mPrint)
     errs() << "WARNING: The -print-filename option is ignored when "
       "passes to be printed are not set.\n";
@@ -531,6 +593,17 @@ void Tool::storeCLOptions() {
   }
   mGlobalOpts.OptRegions = Options::get().OptRegion;
   mGlobalOpts.AnalysisUse = Options::get().AnalysisUse;
+  mGlobalOpts.LoopTimeBudget = Options::get().LoopTimeBudget;
+  mGlobalOpts.FunctionTimeBudget = Options::get().FunctionTimeBudget;
+  mGlobalOpts.LoopQueryBudget = Options::get().LoopQueryBudget;
+  mGlobalOpts.SummaryExport = Options::get().SummaryExport;
+  mGlobalOpts.SummaryUse = Options::get().SummaryUse;
+  mSummaryOnly = Options::get().SummaryOnly;
+  if (mSummaryOnly && mGlobalOpts.SummaryExport.empty())
+    errs() << "WARNING: The -fsummary-only option is ignored when "
+              "the -fsummary-export option is not set.\n";
+  mSummaryOnly &= !mGlobalOpts.SummaryExport.empty();
+  mAnalysisJobs = std::max(1u, (unsigned)Options::get().AnalysisJobs);
   mEmitAST = addLLIfSet(addIfSet(Options::get().EmitAST));
   mMergeAST = mEmitAST ?
     addLLIfSet(addIfSet(Options::get().MergeAST)) :
@@ -542,7 +615,13 @@ void Tool::storeCLOptions() {
   mInstrLLVM = addIfSet(Options::get().InstrLLVM);
   mInstrEntry = Options::get().InstrEntry;
   mInstrStart = Options::get().InstrStart;
-  if (!mInstrLLVM && (!mInstrEntry.empty() || !mInstrStart.empty()))
+  mInstrBuffer = Options::get().InstrBuffer;
+  mInstrSampleFirst = Options::get().InstrSampleFirst;
+  mInstrSamplePeriod = Options::get().InstrSamplePeriod;
+  mInstrRange = Options::get().InstrRange;
+  if (!mInstrLLVM &&
+      (!mInstrEntry.empty() || !mInstrStart.empty() || mInstrBuffer != 0 ||
+       mInstrSamplePeriod != 0 || mInstrRange))
     errs() << "WARNING: Instrumentation options are ignored when "
               "-instr-llvm is not set.\n";
   mCheck = addLLIfSet(Options::get().Check);
@@ -589,7 +668,99 @@ void Tool::storeCLOptions() {
   }
 }
 
+int Tool::runShards() {
+  auto Program = sys::fs::getMainExecutable(mArgs.front().c_str(),
+    (void *)(intptr_t)&addInternalArgs);
+  // Remove sources and options which are set for each job separately.
+  auto BaseArgs = getBaseJobArgs(mArgs, mSources,
+    { "-fanalysis-jobs", "-fsummary-export", "-fsummary-use" });
+  // At first, compute summaries for each source separately.
+  std::vector<AnalysisJob> SummaryJobs(mSources.size());
+  std::vector<SmallString<128>> SummaryFiles(mSources.size());
+  for (std::size_t I = 0, EI = mSources.size(); I < EI; ++I) {
+    if (auto EC = sys::fs::createTemporaryFile(
+          "tsar-summary", "json", SummaryFiles[I])) {
+      errs() << "error: unable to create temporary file: " << EC.message()
+             << "\n";
+      return 1;
+    }
+    SummaryJobs[I].Args = getJobArgs(BaseArgs, mSources[I],
+      { "-fsummary-only", ("-fsummary-export=" + SummaryFiles[I]).str() });
+    if (!mGlobalOpts.SummaryUse.empty())
+      SummaryJobs[I].Args.push_back("-fsummary-use=" + mGlobalOpts.SummaryUse);
+  }
+  bool Success = executeJobs(Program, SummaryJobs, mAnalysisJobs);
+  // Merge summaries and use them to analyze each shard.
+  std::vector<summary::Summary> Summaries(mSources.size());
+  std::vector<uint64_t> Weights(mSources.size(), 0);
+  summary::Summary Merged;
+  if (!mGlobalOpts.SummaryUse.empty()) {
+    std::string ErrMsg;
+    if (!loadFunctionSummary(mGlobalOpts.SummaryUse, Merged, &ErrMsg))
+      errs() << "error: " << mGlobalOpts.SummaryUse << ": " << ErrMsg << "\n";
+  }
+  for (std::size_t I = 0, EI = mSources.size(); I < EI; ++I) {
+    if (sys::fs::file_size(mSources[I], Weights[I]))
+      Weights[I] = 0;
+    std::string ErrMsg;
+    if (loadFunctionSummary(SummaryFiles[I], Summaries[I], &ErrMsg))
+      for (auto &U : Summaries[I][summary::Summary::Units])
+        Merged[summary::Summary::Units].push_back(U);
+    sys::fs::remove(SummaryFiles[I]);
+  }
+  SmallString<128> MergedFile;
+  std::string ErrMsg;
+  if (auto EC = sys::fs::createTemporaryFile(
+        "tsar-summary", "json", MergedFile)) {
+    errs() << "error: unable to create temporary file: " << EC.message()
+           << "\n";
+    return 1;
+  }
+  if (!storeFunctionSummary(MergedFile, Merged, &ErrMsg)) {
+    errs() << "error: " << MergedFile << ": " << ErrMsg << "\n";
+    return 1;
+  }
+  if (!mGlobalOpts.SummaryExport.empty() &&
+      !storeFunctionSummary(mGlobalOpts.SummaryExport, Merged, &ErrMsg)) {
+    errs() << "error: " << mGlobalOpts.SummaryExport << ": " << ErrMsg << "\n";
+    Success = false;
+  }
+  // Sources are analyzed separately unless ASTs are merged, so a shard can not
+  // benefit from locality and a separate job is used for each source. Jobs are
+  // ordered by their first source, so results are printed in source order.
+  std::vector<std::vector<std::size_t>> Shards;
+  if (mMergeAST) {
+    Shards = partitionByLocality(Summaries, Weights,
+      std::min<std::size_t>(mAnalysisJobs, mSources.size()));
+    std::sort(Shards.begin(), Shards.end(),
+      [](const std::vector<std::size_t> &LHS,
+         const std::vector<std::size_t> &RHS) {
+        return LHS.front() < RHS.front();
+    });
+  } else {
+    for (std::size_t I = 0, EI = mSources.size(); I < EI; ++I)
+      Shards.push_back({ I });
+  }
+  std::vector<AnalysisJob> ShardJobs(Shards.size());
+  for (std::size_t I = 0, EI = Shards.size(); I < EI; ++I) {
+    std::vector<std::string> Sources;
+    for (auto Idx : Shards[I])
+      Sources.push_back(mSources[Idx]);
+    ShardJobs[I].Args = getJobArgs(BaseArgs, Sources,
+      { "-fanalysis-jobs=1", ("-fsummary-use=" + MergedFile).str() });
+  }
+  Success &= executeJobs(Program, ShardJobs, mAnalysisJobs);
+  sys::fs::remove(MergedFile);
+  return Success ? 0 : 1;
+}
+
 int Tool::run(QueryManager *QM) {
+  // Summaries are appended to the existing file, so remove outdated results.
+  if (!mGlobalOpts.SummaryExport.empty())
+    sys::fs::remove(mGlobalOpts.SummaryExport);
+  if (!QM && mAnalysisJobs > 1 && mSources.size() > 1 && !mSummaryOnly &&
+      !mEmitAST && !mPrintAST && !mDumpAST && !mEmitLLVM && !mInstrLLVM)
+    return runShards();
   std::vector<std::string> NoASTSources;
   std::vector<std::string> SourcesToMerge;
   std::vector<std::string> LLSources;
@@ -658,10 +829,13 @@ int Tool::run(QueryManager *QM) {
       newFrontendActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
   }
   if (!QM) {
-    if (mEmitLLVM)
+    if (mSummaryOnly)
+      QM = getSummaryQM(mGlobalOpts);
+    else if (mEmitLLVM)
       QM = getEmitLLVMQM();
     else if (mInstrLLVM)
-      QM = getInstrLLVMQM(mInstrEntry, mInstrStart);
+      QM = getInstrLLVMQM(mInstrEntry, mInstrStart, mInstrBuffer,
+        mInstrSampleFirst, mInstrSamplePeriod, mInstrRange, mGlobalOpts);
     else if (mTfmPass)
       QM = getTransformationQM(mTfmPass, mGlobalOpts);
     else if (mCheck)
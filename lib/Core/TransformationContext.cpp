@@ -24,6 +24,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/ASTIndex.h"
 #include <clang/AST/ASTContext.h>
 #include <clang/CodeGen/ModuleBuilder.h>
 #include <clang/Frontend/FrontendDiagnostic.h>
@@ -130,6 +131,8 @@ TransformationContext::TransformationContext(
   mRewriter(Ctx.getSourceManager(), Ctx.getLangOpts()),
   mCtx(&Ctx), mGen(&Gen), mCommandLine(CL) { }
 
+TransformationContext::~TransformationContext() = default;
+
 llvm::StringRef TransformationContext::getInput() const {
   assert(hasInstance() && "Rewriter is not configured!");
   SourceManager &SM = mRewriter.getSourceMgr();
@@ -144,18 +147,28 @@ clang::Decl * TransformationContext::getDeclForMangledName(StringRef Name) {
   return const_cast<Decl *>(mGen->GetDeclForMangledName(Name));
 }
 
+const ASTIndex & TransformationContext::getASTIndex(clang::Decl &D) {
+  assert(hasInstance() && "Rewriter is not configured!");
+  auto &Index = mASTIndexes[&D];
+  if (!Index)
+    Index.reset(new ASTIndex(D, mRewriter.getSourceMgr()));
+  return *Index;
+}
+
 void TransformationContext::reset(clang::ASTContext &Ctx,
   clang::CodeGenerator &Gen, llvm::ArrayRef<std::string> CL) {
   mRewriter.setSourceMgr(Ctx.getSourceManager(), Ctx.getLangOpts());
   mCtx = &Ctx;
   mGen = &Gen;
   mCommandLine = CL;
+  mASTIndexes.clear();
 }
 
 void TransformationContext::reset(clang::ASTContext &Ctx, clang::CodeGenerator &Gen) {
   mRewriter.setSourceMgr(Ctx.getSourceManager(), Ctx.getLangOpts());
   mCtx = &Ctx;
   mGen = &Gen;
+  mASTIndexes.clear();
 }
 
 std::pair<std::string, bool> TransformationContext::release(
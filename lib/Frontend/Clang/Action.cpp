@@ -139,6 +139,13 @@ public:
     mQueryManager->run(M, mTransformContext);
     if (llvm::TimePassesIsEnabled)
       LLVMIRAnalysis.stopTimer();
+    // All passes have been finished, so release IR and a code generator right
+    // now. Otherwise, they are kept alive until the AST is destroyed.
+    // Note, that rewrite buffers in the transformation context are not released.
+    mTransformContext->reset();
+    mModule.reset();
+    mGen.reset();
+    mLLVMContext.reset();
   }
 
   void HandleTagDeclDefinition(TagDecl *D) override {
@@ -0,0 +1,959 @@
+//===--- Runtime.cpp ------ Dynamic Analysis Runtime ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a reference runtime library for instrumented programs.
+//
+// Each metadata string is parsed once in sapforInitDI() and a pointer to
+// the parsed description is stored in the pool instead of the string.
+// For each active loop a shadow memory remembers the last iterations which
+// read and write each accessed byte. Data dependencies are recognized
+// when a byte is accessed at different iterations of a loop.
+//
+// Shadow memory is stored in granules of consecutive bytes. Granules are
+// distributed between shards and each shard has its own lock, so memory
+// accesses which touch different shards are processed concurrently. Other
+// events are serialized with a separate lock and events which update
+// the whole shadow memory (for example, the beginning of a loop) also lock
+// all shards.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Runtime/Runtime.h"
+#include "tsar/Analysis/Reader/AnalysisJSON.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace tsar;
+
+namespace {
+/// Number of bytes in a granule of shadow memory.
+constexpr unsigned GranuleSize = 8;
+
+/// Number of shards of shadow memory, each shard has its own lock.
+constexpr unsigned NumShards = 16;
+
+/// Set of bytes in a granule, the I-th bit corresponds to the I-th byte.
+using ByteMask = uint8_t;
+
+/// Set of all bytes in a granule.
+constexpr ByteMask FullMask = static_cast<ByteMask>((1u << GranuleSize) - 1);
+
+/// Parsed metadata string.
+struct DIDescriptor {
+  enum Kind : uint8_t {
+    Unknown,
+    Location,
+    Function,
+    Variable,
+    Array,
+    Loop
+  };
+
+  Kind K = Unknown;
+  std::string File;
+  std::string Name;
+  trait::LineTy Line = 0;
+  trait::ColumnTy Column = 0;
+  uint64_t TypeId = 0;
+  bool IsLocal = false;
+  /// Iterations of a loop are sampled.
+  bool IsSampled = false;
+  /// Iterations of some of nested loops are sampled.
+  bool HasSampledNested = false;
+  /// Index of a variable in the list of variables in analysis results.
+  trait::IdTy VarId = 0;
+  bool HasVarId = false;
+  /// Index of a loop in the list of loops in analysis results.
+  trait::IdTy LoopId = 0;
+  bool HasLoopId = false;
+};
+
+/// Observed distances of a dependence.
+struct Dependence {
+  bool Occurred = false;
+  uint64_t Min = 0;
+  uint64_t Max = 0;
+
+  void add(uint64_t Distance) {
+    if (!Occurred) {
+      Occurred = true;
+      Min = Max = Distance;
+    } else {
+      Min = std::min(Min, Distance);
+      Max = std::max(Max, Distance);
+    }
+  }
+
+  void merge(const Dependence &D) {
+    if (D.Occurred) {
+      add(D.Min);
+      add(D.Max);
+    }
+  }
+};
+
+/// Traits of a variable in a loop, they are accumulated for all executions
+/// of the loop.
+struct VarTraits {
+  bool Read = false;
+  bool Write = false;
+  /// Value of some element of a variable is read before it is written at
+  /// the same iteration.
+  bool Exposed = false;
+  bool UseAfterLoop = false;
+  /// Value of some element of a variable which is used after the loop has not
+  /// been written at the last iteration of the loop which writes memory.
+  bool StaleAfterLoop = false;
+  bool Output = false;
+  Dependence Flow;
+  Dependence Anti;
+
+  void merge(const VarTraits &T) {
+    Read |= T.Read;
+    Write |= T.Write;
+    Exposed |= T.Exposed;
+    UseAfterLoop |= T.UseAfterLoop;
+    StaleAfterLoop |= T.StaleAfterLoop;
+    Output |= T.Output;
+    Flow.merge(T.Flow);
+    Anti.merge(T.Anti);
+  }
+};
+
+/// Traits of variables, identifiers of variables are used as keys.
+using VarTraitsMap = std::unordered_map<trait::IdTy, VarTraits>;
+
+/// Accumulated traits of a loop.
+struct LoopTraits {
+  DIDescriptor *DILoop = nullptr;
+  uint64_t Iterations = 0;
+  /// Some of accesses in the loop have not been registered, because some of
+  /// iterations of this loop or of a loop executed inside it were sampled.
+  bool Sampled = false;
+  /// Traits are collected separately for each shard of shadow memory and
+  /// they are merged when results are written.
+  std::array<VarTraitsMap, NumShards> Vars;
+};
+
+/// The last iterations (starting with 1) which access some address.
+struct Shadow {
+  uint64_t LastWrite = 0;
+  uint64_t LastRead = 0;
+  /// True if the last write has been registered as a part of a range, so its
+  /// order relative to other accesses at the same iteration is unknown.
+  bool UnorderedWrite = false;
+};
+
+/// Shadow of consecutive bytes.
+///
+/// Bytes which are always accessed together share a single shadow. Separate
+/// shadows are created on the first access to a part of a granule.
+struct ShadowGranule {
+  Shadow Whole;
+  std::unique_ptr<std::array<Shadow, GranuleSize>> Bytes;
+
+  /// Calls `F` for shadows of bytes from a specified set.
+  template<class FuncT> void forEach(ByteMask Mask, FuncT &&F) {
+    if (!Bytes) {
+      if (Mask == FullMask) {
+        F(Whole);
+        return;
+      }
+      Bytes.reset(new std::array<Shadow, GranuleSize>);
+      Bytes->fill(Whole);
+    }
+    for (unsigned B = 0; B < GranuleSize; ++B)
+      if (Mask & (1u << B))
+        F((*Bytes)[B]);
+  }
+
+  const Shadow & get(unsigned B) const { return Bytes ? (*Bytes)[B] : Whole; }
+
+  /// Forgets accesses to bytes from a specified set, return `true` if
+  /// the granule has not been accessed.
+  bool forget(ByteMask Mask) {
+    if (Mask == FullMask)
+      return true;
+    forEach(Mask, [](Shadow &S) { S = Shadow(); });
+    return std::all_of(Bytes->begin(), Bytes->end(), [](const Shadow &S) {
+      return S.LastWrite == 0 && S.LastRead == 0;
+    });
+  }
+};
+
+/// Part of shadow memory of a loop which is protected with a shard lock.
+struct ShadowShard {
+  /// Map from an index of a granule to its shadow.
+  std::unordered_map<uintptr_t, ShadowGranule> Memory;
+  /// The last iteration which writes some memory in this shard.
+  uint64_t LastWriteIteration = 0;
+};
+
+/// Accesses to a sequence of elements which are performed at consecutive
+/// iterations of a loop (see sapforReadArrRange()). These accesses are
+/// replayed at the beginning of each iteration, so they are order-insensitive
+/// inside an iteration.
+struct RangeAccess {
+  trait::IdTy VarId;
+  uint64_t Size;
+  uintptr_t Addr;
+  uint64_t Stride;
+  uint64_t Count;
+  bool IsWrite;
+};
+
+/// Execution of a loop which has not been finished yet.
+struct LoopExecution {
+  explicit LoopExecution(LoopTraits &T) : Traits(&T) {}
+
+  LoopTraits *Traits;
+  /// Current iteration is updated without locks of shards.
+  std::atomic<uint64_t> Iteration{0};
+  std::array<ShadowShard, NumShards> Shadows;
+  std::vector<RangeAccess> Ranges;
+};
+
+void flushThreadEvents();
+
+/// Loop which has written some bytes in a granule.
+struct WrittenInLoop {
+  LoopTraits *Traits;
+  /// Bytes which have been written in the loop.
+  ByteMask Mask;
+  /// Bytes which have been written at the last iteration of the loop which
+  /// writes memory.
+  ByteMask LastMask;
+};
+
+/// Map from an index of a granule to loops which have written it, the list
+/// is cleared when written bytes are accessed after the loop.
+using WrittenInLoopMap =
+  std::unordered_map<uintptr_t, std::vector<WrittenInLoop>>;
+
+/// Return bytes of a granule `G` which are in [Addr, Addr + Size).
+ByteMask getMask(uintptr_t G, uintptr_t Addr, uint64_t Size) {
+  auto Begin = std::max<uint64_t>(Addr, G * GranuleSize);
+  auto End = std::min<uint64_t>(Addr + Size, (G + 1) * GranuleSize);
+  if (Begin >= End)
+    return 0;
+  Begin -= G * GranuleSize;
+  End -= G * GranuleSize;
+  return static_cast<ByteMask>(((1u << End) - 1) & ~((1u << Begin) - 1));
+}
+
+/// Local variables which have been registered in a function.
+using Frame = std::vector<std::pair<uintptr_t, uint64_t>>;
+
+class Runtime {
+public:
+  /// This locks the runtime and all shards, so the whole state of
+  /// the runtime is available.
+  class ExclusiveLock {
+  public:
+    explicit ExclusiveLock(Runtime &RT) : mRT(RT) {
+      mRT.mMutex.lock();
+      for (auto &S : mRT.mShards)
+        S.Mutex.lock();
+    }
+    ~ExclusiveLock() {
+      for (auto I = mRT.mShards.rbegin(), EI = mRT.mShards.rend(); I != EI; ++I)
+        I->Mutex.unlock();
+      mRT.mMutex.unlock();
+    }
+    ExclusiveLock(const ExclusiveLock &) = delete;
+    ExclusiveLock & operator=(const ExclusiveLock &) = delete;
+  private:
+    Runtime &mRT;
+  };
+
+  static Runtime & get() {
+    static Runtime RT;
+    return RT;
+  }
+
+  /// Return lock which serializes events other than memory accesses.
+  std::mutex & getMutex() noexcept { return mMutex; }
+
+  /// \pre All shards must be locked.
+  uint64_t getNumberOfEvents() const noexcept {
+    auto NumEvents = mNumEvents;
+    for (auto &S : mShards)
+      NumEvents += S.NumEvents;
+    return NumEvents;
+  }
+
+  void allocatePool(void ***PoolPtr, uint64_t Size) {
+    ++mNumEvents;
+    *PoolPtr = static_cast<void **>(std::calloc(Size, sizeof(void *)));
+    if (!mIsExitRegistered) {
+      std::atexit([]() {
+        flushThreadEvents();
+        tsar::rt::writeResults();
+      });
+      mIsExitRegistered = true;
+    }
+  }
+
+  void initDI(void **DI, const char *Str) {
+    ++mNumEvents;
+    mDescriptors.emplace_back(new DIDescriptor(parse(Str)));
+    *DI = mDescriptors.back().get();
+  }
+
+  void declTypes(uint64_t Num, uint64_t *Ids, uint64_t *Sizes) {
+    ++mNumEvents;
+    for (uint64_t I = 0; I < Num; ++I)
+      mTypeSizes[Ids[I]] = (Sizes[I] + 7) / 8;
+  }
+
+  void regVar(void *DIVar, void *Addr, uint64_t Count) {
+    ++mNumEvents;
+    auto *DI = static_cast<DIDescriptor *>(DIVar);
+    getVarId(*DI);
+    auto Size = Count * getElementSize(*DI);
+    auto Base = reinterpret_cast<uintptr_t>(Addr);
+    forget(Base, Size);
+    if (DI->IsLocal && !mFrames.empty())
+      mFrames.back().emplace_back(Base, Size);
+  }
+
+  void funcBegin() {
+    ++mNumEvents;
+    mFrames.emplace_back();
+  }
+
+  void funcEnd() {
+    ++mNumEvents;
+    if (mFrames.empty())
+      return;
+    for (auto &Local : mFrames.back())
+      forget(Local.first, Local.second);
+    mFrames.pop_back();
+  }
+
+  void call() { ++mNumEvents; }
+
+  /// Registers access to a specified address.
+  ///
+  /// Only shards which contain accessed bytes are locked, so this method
+  /// must be called without locks.
+  void access(void *Addr, void *DIVar, bool IsWrite) {
+    auto Base = reinterpret_cast<uintptr_t>(Addr);
+    auto &DI = *static_cast<DIDescriptor *>(DIVar);
+    auto G = Base / GranuleSize;
+    std::unique_lock<std::mutex> Lock(getShard(G).Mutex);
+    if (!DI.HasVarId) {
+      // Identifier of a variable is assigned on the first access to this
+      // variable, so the whole state should be locked.
+      Lock.unlock();
+      {
+        ExclusiveLock AllLock(*this);
+        getVarId(DI);
+      }
+      Lock.lock();
+    }
+    ++getShard(G).NumEvents;
+    auto Size = getElementSize(DI);
+    auto VarId = DI.VarId;
+    // The first granule is processed under the lock which has been already
+    // acquired, other shards are locked one by one.
+    accessGranule(G, getMask(G, Base, Size), VarId, IsWrite, true);
+    Lock.unlock();
+    for (auto Last = (Base + Size - 1) / GranuleSize; G < Last;) {
+      ++G;
+      std::lock_guard<std::mutex> GranuleLock(getShard(G).Mutex);
+      accessGranule(G, getMask(G, Base, Size), VarId, IsWrite, true);
+    }
+  }
+
+  /// \pre All shards must be locked.
+  void accessRange(void *Addr, uint64_t Stride, uint64_t Count, void *DIVar,
+      bool IsWrite) {
+    ++mNumEvents;
+    if (mLoops.empty())
+      return;
+    auto &DI = *static_cast<DIDescriptor *>(DIVar);
+    mLoops.back().Ranges.push_back(RangeAccess{getVarId(DI),
+      getElementSize(DI), reinterpret_cast<uintptr_t>(Addr), Stride, Count,
+      IsWrite});
+  }
+
+  void loopBegin(void *DILoop) {
+    ++mNumEvents;
+    auto *DI = static_cast<DIDescriptor *>(DILoop);
+    mLoops.emplace_back(getLoop(*DI));
+    // Loops which are executed now (including loops in callers) observe
+    // accesses from sampled iterations only.
+    if (DI->IsSampled)
+      for (auto &L : mLoops)
+        L.Traits->Sampled = true;
+    else if (DI->HasSampledNested)
+      mLoops.back().Traits->Sampled = true;
+  }
+
+  void loopIter(void *DILoop, uint64_t Iteration) {
+    ++mNumEvents;
+    if (mLoops.empty() || mLoops.back().Traits->DILoop != DILoop)
+      return;
+    auto &Current = mLoops.back();
+    Current.Iteration = Iteration;
+    // Iterations of a loop are numbered from 1, so the I-th element of
+    // a range is accessed at the I-th iteration.
+    for (auto &R : Current.Ranges)
+      if (Iteration <= R.Count)
+        access(R.Addr + (Iteration - 1) * R.Stride, R.Size, R.VarId,
+          R.IsWrite, false);
+  }
+
+  void loopEnd(void *DILoop) {
+    ++mNumEvents;
+    if (mLoops.empty() || mLoops.back().Traits->DILoop != DILoop)
+      return;
+    auto &Current = mLoops.back();
+    Current.Traits->Iterations += Current.Iteration;
+    uint64_t LastWriteIteration = 0;
+    for (auto &SS : Current.Shadows)
+      LastWriteIteration = std::max(LastWriteIteration, SS.LastWriteIteration);
+    for (unsigned Idx = 0; Idx < NumShards; ++Idx)
+      for (auto &SG : Current.Shadows[Idx].Memory) {
+        ByteMask Mask = 0, LastMask = 0;
+        for (unsigned B = 0; B < GranuleSize; ++B) {
+          auto LastWrite = SG.second.get(B).LastWrite;
+          if (LastWrite == 0)
+            continue;
+          Mask |= 1u << B;
+          if (LastWrite == LastWriteIteration)
+            LastMask |= 1u << B;
+        }
+        if (Mask == 0)
+          continue;
+        auto &Loops = mShards[Idx].WrittenInLoop[SG.first];
+        if (Loops.empty() || Loops.back().Traits != Current.Traits)
+          Loops.push_back(WrittenInLoop{Current.Traits, 0, 0});
+        auto &Written = Loops.back();
+        Written.Mask |= Mask;
+        Written.LastMask = (Written.LastMask & ~Mask) | LastMask;
+      }
+    mLoops.pop_back();
+  }
+
+  bool writeResults(const char *Path) {
+    trait::Info Info;
+    auto &Vars = Info[trait::Info::Vars];
+    for (auto *DI : mVars) {
+      trait::Var V;
+      V[trait::Var::File] = DI->File;
+      V[trait::Var::Line] = DI->Line;
+      V[trait::Var::Column] = DI->Column;
+      V[trait::Var::Name] = DI->Name;
+      Vars.push_back(std::move(V));
+    }
+    auto &Loops = Info[trait::Info::Loops];
+    for (auto &LT : mLoopTraits) {
+      trait::Loop L;
+      L[trait::Loop::File] = LT->DILoop->File;
+      L[trait::Loop::Line] = LT->DILoop->Line;
+      L[trait::Loop::Column] = LT->DILoop->Column;
+      L[trait::Loop::Sampled] = LT->Sampled;
+      L[trait::Loop::Iterations] = LT->Iterations;
+      VarTraitsMap Traits;
+      for (auto &ShardTraits : LT->Vars)
+        for (auto &VarToTraits : ShardTraits)
+          Traits[VarToTraits.first].merge(VarToTraits.second);
+      for (auto &VarToTraits : Traits) {
+        auto VarId = VarToTraits.first;
+        auto &T = VarToTraits.second;
+        if (T.Read)
+          L[trait::Loop::ReadOccurred].insert(VarId);
+        if (T.Write)
+          L[trait::Loop::WriteOccurred].insert(VarId);
+        if (T.UseAfterLoop)
+          L[trait::Loop::UseAfterLoop].insert(VarId);
+        // A value which is used after the loop must be written at the last
+        // iteration, otherwise it can not be computed in a private copy.
+        if (T.Write && !T.Exposed && !T.StaleAfterLoop)
+          L[trait::Loop::Private].insert(VarId);
+        if (T.Flow.Occurred)
+          L[trait::Loop::Flow].emplace(VarId, toDistance(T.Flow));
+        if (T.Anti.Occurred)
+          L[trait::Loop::Anti].emplace(VarId, toDistance(T.Anti));
+        if (T.Output)
+          L[trait::Loop::Output].insert(VarId);
+      }
+      Loops.push_back(std::move(L));
+    }
+    if (!Path)
+      Path = std::getenv("SAPFOR_RUNTIME_OUTPUT");
+    if (!Path)
+      Path = "sapfor.da.json";
+    std::ofstream OS(Path);
+    if (!OS)
+      return false;
+    OS << json::Parser<trait::Info>::unparse(Info) << '\n';
+    return static_cast<bool>(OS);
+  }
+
+private:
+  Runtime() = default;
+
+  /// Parses a metadata string which contains '*'-separated list of
+  /// 'key=value' pairs.
+  static DIDescriptor parse(const char *Str) {
+    DIDescriptor DI;
+    bool HasLine = false, HasColumn = false;
+    for (const char *Pos = Str; *Pos;) {
+      const char *End = std::strchr(Pos, '*');
+      if (!End)
+        End = Pos + std::strlen(Pos);
+      const char *Eq = std::find(Pos, End, '=');
+      if (Eq != End) {
+        std::string Key(Pos, Eq), Value(Eq + 1, End);
+        if (Key == "type") {
+          if (Value == "file_name")
+            DI.K = DIDescriptor::Location;
+          else if (Value == "function")
+            DI.K = DIDescriptor::Function;
+          else if (Value == "var_name")
+            DI.K = DIDescriptor::Variable;
+          else if (Value == "arr_name")
+            DI.K = DIDescriptor::Array;
+          else if (Value == "seqloop")
+            DI.K = DIDescriptor::Loop;
+        } else if (Key == "file" && DI.File.empty()) {
+          DI.File = std::move(Value);
+        } else if (Key == "name1" && DI.Name.empty()) {
+          DI.Name = std::move(Value);
+          // Instrumentation replaces '*' with '^' in names of variables.
+          std::replace(DI.Name.begin(), DI.Name.end(), '^', '*');
+        } else if (Key == "line1" && !HasLine) {
+          DI.Line = std::strtoul(Value.c_str(), nullptr, 10);
+          HasLine = true;
+        } else if (Key == "col1" && !HasColumn) {
+          DI.Column = std::strtoul(Value.c_str(), nullptr, 10);
+          HasColumn = true;
+        } else if (Key == "vtype") {
+          DI.TypeId = std::strtoull(Value.c_str(), nullptr, 10);
+        } else if (Key == "local") {
+          DI.IsLocal = Value == "1";
+        } else if (Key == "sample") {
+          if (Value == "nested")
+            DI.HasSampledNested = true;
+          else
+            DI.IsSampled = true;
+        }
+      }
+      Pos = *End ? End + 1 : End;
+    }
+    return DI;
+  }
+
+  static trait::Distance toDistance(const Dependence &D) {
+    return trait::Distance(static_cast<trait::DistanceTy>(D.Min),
+      static_cast<trait::DistanceTy>(D.Max));
+  }
+
+  trait::IdTy getVarId(DIDescriptor &DI) {
+    if (!DI.HasVarId) {
+      DI.VarId = mVars.size();
+      DI.HasVarId = true;
+      mVars.push_back(&DI);
+    }
+    return DI.VarId;
+  }
+
+  LoopTraits & getLoop(DIDescriptor &DI) {
+    if (!DI.HasLoopId) {
+      DI.LoopId = mLoopTraits.size();
+      DI.HasLoopId = true;
+      mLoopTraits.emplace_back(new LoopTraits);
+      mLoopTraits.back()->DILoop = &DI;
+    }
+    return *mLoopTraits[DI.LoopId];
+  }
+
+  uint64_t getElementSize(const DIDescriptor &DI) const {
+    auto I = mTypeSizes.find(DI.TypeId);
+    return I == mTypeSizes.end() || I->second == 0 ? 1 : I->second;
+  }
+
+  /// Part of the runtime state which is protected with a separate lock.
+  struct Shard {
+    std::mutex Mutex;
+    WrittenInLoopMap WrittenInLoop;
+    /// Number of memory accesses which start in this shard.
+    uint64_t NumEvents = 0;
+  };
+
+  Shard & getShard(uintptr_t G) { return mShards[G % NumShards]; }
+
+  /// Forgets all accesses to a specified memory, for example if
+  /// memory has been reallocated.
+  void forget(uintptr_t Addr, uint64_t Size) {
+    if (Size == 0)
+      return;
+    for (unsigned Idx = 0; Idx < NumShards; ++Idx) {
+      for (auto &L : mLoops)
+        forget(L.Shadows[Idx].Memory, Idx, Addr, Size,
+          [](ShadowGranule &SG, ByteMask Mask) { return SG.forget(Mask); });
+      forget(mShards[Idx].WrittenInLoop, Idx, Addr, Size,
+        [](std::vector<WrittenInLoop> &Loops, ByteMask Mask) {
+          for (auto &Written : Loops)
+            Written.Mask &= ~Mask;
+          Loops.erase(std::remove_if(Loops.begin(), Loops.end(),
+            [](const WrittenInLoop &W) { return W.Mask == 0; }), Loops.end());
+          return Loops.empty();
+        });
+    }
+  }
+
+  /// Forgets bytes in [Addr, Addr + Size) in a map from granules of a shard
+  /// `Idx` to their descriptions. The `Clear` function forgets bytes in
+  /// a granule and returns `true` if the granule should be erased.
+  ///
+  /// Complexity is linear in the minimum of the number of granules in memory
+  /// and the number of granules in the map.
+  template<class MapT, class FuncT>
+  static void forget(MapT &Map, unsigned Idx, uintptr_t Addr, uint64_t Size,
+      FuncT &&Clear) {
+    auto First = Addr / GranuleSize;
+    auto Last = (Addr + Size - 1) / GranuleSize;
+    auto clear = [&Map, &Clear, Addr, Size](typename MapT::iterator I) {
+      return Clear(I->second, getMask(I->first, Addr, Size)) ? Map.erase(I)
+                                                             : std::next(I);
+    };
+    if (Map.size() < (Last - First) / NumShards + 1) {
+      for (auto I = Map.begin(), EI = Map.end(); I != EI;)
+        I = I->first >= First && I->first <= Last ? clear(I) : std::next(I);
+    } else {
+      for (auto G = First + (Idx + NumShards - First % NumShards) % NumShards;
+           G <= Last; G += NumShards) {
+        auto I = Map.find(G);
+        if (I != Map.end())
+          clear(I);
+      }
+    }
+  }
+
+  /// Registers access to bytes in [Addr, Addr + Size).
+  ///
+  /// If `IsOrdered` is false then order of this access and other accesses
+  /// at the current iteration is unknown. Accesses at different iterations
+  /// are always ordered, so loop-carried dependencies are still precise.
+  /// However, a read which may follow a write at the same iteration
+  /// is conservatively assumed to be exposed.
+  ///
+  /// Shards are locked one by one, so they must not be locked before.
+  void access(uintptr_t Addr, uint64_t Size, trait::IdTy VarId, bool IsWrite,
+      bool IsOrdered) {
+    auto Last = (Addr + Size - 1) / GranuleSize;
+    for (auto G = Addr / GranuleSize; G <= Last; ++G) {
+      std::lock_guard<std::mutex> Lock(getShard(G).Mutex);
+      accessGranule(G, getMask(G, Addr, Size), VarId, IsWrite, IsOrdered);
+    }
+  }
+
+  /// Registers access to bytes `Mask` in a granule `G` (see access()).
+  ///
+  /// \pre A shard which contains the granule must be locked.
+  void accessGranule(uintptr_t G, ByteMask Mask, trait::IdTy VarId,
+      bool IsWrite, bool IsOrdered) {
+    auto Idx = G % NumShards;
+    for (auto &L : mLoops) {
+      auto &SS = L.Shadows[Idx];
+      auto &SG = SS.Memory[G];
+      auto &T = L.Traits->Vars[Idx][VarId];
+      uint64_t I = L.Iteration;
+      if (IsWrite) {
+        T.Write = true;
+        SS.LastWriteIteration = I;
+      } else {
+        T.Read = true;
+      }
+      SG.forEach(Mask, [&T, I, IsWrite, IsOrdered](Shadow &S) {
+        if (IsWrite) {
+          if (S.LastRead != 0 && S.LastRead < I)
+            T.Anti.add(I - S.LastRead);
+          if (S.LastWrite != 0 && S.LastWrite < I)
+            T.Output = true;
+          S.LastWrite = I;
+          S.UnorderedWrite = !IsOrdered;
+        } else {
+          if (S.LastWrite != I || !IsOrdered || S.UnorderedWrite)
+            T.Exposed = true;
+          if (S.LastWrite != 0 && S.LastWrite < I)
+            T.Flow.add(I - S.LastWrite);
+          S.LastRead = I;
+        }
+      });
+    }
+    auto &WrittenMap = mShards[Idx].WrittenInLoop;
+    auto WrittenItr = WrittenMap.find(G);
+    if (WrittenItr == WrittenMap.end())
+      return;
+    auto &Loops = WrittenItr->second;
+    for (auto &Written : Loops) {
+      if (!(Written.Mask & Mask))
+        continue;
+      if (!IsWrite) {
+        auto &T = Written.Traits->Vars[Idx][VarId];
+        T.UseAfterLoop = true;
+        T.StaleAfterLoop |= (Written.Mask & Mask & ~Written.LastMask) != 0;
+      }
+      Written.Mask &= ~Mask;
+    }
+    Loops.erase(std::remove_if(Loops.begin(), Loops.end(),
+      [](const WrittenInLoop &W) { return W.Mask == 0; }), Loops.end());
+    if (Loops.empty())
+      WrittenMap.erase(WrittenItr);
+  }
+
+  std::mutex mMutex;
+  std::array<Shard, NumShards> mShards;
+  bool mIsExitRegistered = false;
+  /// Number of events other than memory accesses.
+  uint64_t mNumEvents = 0;
+  std::vector<std::unique_ptr<DIDescriptor>> mDescriptors;
+  std::vector<DIDescriptor *> mVars;
+  std::vector<std::unique_ptr<LoopTraits>> mLoopTraits;
+  std::unordered_map<uint64_t, uint64_t> mTypeSizes;
+  std::deque<LoopExecution> mLoops;
+  std::vector<Frame> mFrames;
+};
+
+using LockT = std::lock_guard<std::mutex>;
+using ExclusiveLockT = Runtime::ExclusiveLock;
+
+/// Buffer of events which has been registered in the current thread, the
+/// first element is a number of events (see sapforRegEventBuffer()).
+thread_local uint64_t *ThreadEventBuffer = nullptr;
+
+/// Process all events from the buffer of the current thread.
+void flushThreadEvents() {
+  if (!ThreadEventBuffer || *ThreadEventBuffer == 0)
+    return;
+  auto Size = *ThreadEventBuffer;
+  *ThreadEventBuffer = 0;
+  sapforFlushEvents(reinterpret_cast<SapforEvent *>(ThreadEventBuffer + 1),
+    Size);
+}
+
+/// This flushes buffered events when a thread exits.
+struct ThreadExitGuard {
+  bool IsActive = false;
+  ~ThreadExitGuard() {
+    flushThreadEvents();
+    ThreadEventBuffer = nullptr;
+  }
+};
+
+thread_local ThreadExitGuard ThreadExit;
+}
+
+namespace tsar {
+namespace rt {
+bool writeResults(const char *Path) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  return RT.writeResults(Path);
+}
+
+uint64_t getNumberOfEvents() {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  return RT.getNumberOfEvents();
+}
+}
+}
+
+extern "C" {
+void sapforInitDI(void **DI, char *DIString, uint64_t) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.initDI(DI, DIString);
+}
+
+void sapforAllocatePool(void ***PoolPtr, uint64_t Size) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.allocatePool(PoolPtr, Size);
+}
+
+void sapforDeclTypes(uint64_t Num, uint64_t *Ids, uint64_t *Sizes) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.declTypes(Num, Ids, Sizes);
+}
+
+void sapforRegVar(void *DIVar, void *Addr) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.regVar(DIVar, Addr, 1);
+}
+
+void sapforRegArr(void *DIVar, uint64_t ArrSize, void *Addr) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.regVar(DIVar, Addr, ArrSize);
+}
+
+void sapforReadVar(void *, void *Addr, void *DIVar) {
+  auto &RT = Runtime::get();
+  RT.access(Addr, DIVar, false);
+}
+
+void sapforReadArr(void *, void *Addr, void *DIVar, void *) {
+  auto &RT = Runtime::get();
+  RT.access(Addr, DIVar, false);
+}
+
+void sapforWriteVarEnd(void *, void *Addr, void *DIVar) {
+  auto &RT = Runtime::get();
+  RT.access(Addr, DIVar, true);
+}
+
+void sapforWriteArrEnd(void *, void *Addr, void *DIVar, void *) {
+  auto &RT = Runtime::get();
+  RT.access(Addr, DIVar, true);
+}
+
+void sapforReadArrRange(void *, void *Addr, uint64_t Stride,
+    uint64_t Count, void *DIVar, void *) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.accessRange(Addr, Stride, Count, DIVar, false);
+}
+
+void sapforWriteArrRange(void *, void *Addr, uint64_t Stride,
+    uint64_t Count, void *DIVar, void *) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.accessRange(Addr, Stride, Count, DIVar, true);
+}
+
+void sapforFuncBegin(void *) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.funcBegin();
+}
+
+void sapforFuncEnd(void *) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.funcEnd();
+}
+
+void sapforRegDummyVar(void *DIVar, void *Addr, void *, uint64_t) {
+  sapforRegVar(DIVar, Addr);
+}
+
+void sapforRegDummyArr(void *DIVar, uint64_t ArrSize, void *Addr, void *,
+    uint64_t) {
+  sapforRegArr(DIVar, ArrSize, Addr);
+}
+
+void sapforFuncCallBegin(void *, void *) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.call();
+}
+
+void sapforFuncCallEnd(void *) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.call();
+}
+
+void sapforSLBegin(void *DILoop, uint64_t, uint64_t, uint64_t) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.loopBegin(DILoop);
+}
+
+void sapforSLEnd(void *DILoop) {
+  auto &RT = Runtime::get();
+  ExclusiveLockT Lock(RT);
+  RT.loopEnd(DILoop);
+}
+
+void sapforSLIter(void *DILoop, uint64_t Iter) {
+  auto &RT = Runtime::get();
+  LockT Lock(RT.getMutex());
+  RT.loopIter(DILoop, Iter);
+}
+
+void sapforRegEventBuffer(uint64_t *Buffer) {
+  ThreadEventBuffer = Buffer;
+  ThreadExit.IsActive = true;
+}
+
+void sapforFlushEvents(SapforEvent *Events, uint64_t Size) {
+  for (uint64_t I = 0; I < Size; ++I) {
+    auto Kind = Events[I].Kind;
+    auto *A = Events[I].Args;
+#define ARG(N) reinterpret_cast<void *>(A[N])
+#define IS(F) (Kind == reinterpret_cast<uint64_t>(&F))
+    if (IS(sapforReadVar))
+      sapforReadVar(ARG(0), ARG(1), ARG(2));
+    else if (IS(sapforReadArr))
+      sapforReadArr(ARG(0), ARG(1), ARG(2), ARG(3));
+    else if (IS(sapforWriteVarEnd))
+      sapforWriteVarEnd(ARG(0), ARG(1), ARG(2));
+    else if (IS(sapforWriteArrEnd))
+      sapforWriteArrEnd(ARG(0), ARG(1), ARG(2), ARG(3));
+    else if (IS(sapforReadArrRange))
+      sapforReadArrRange(ARG(0), ARG(1), A[2], A[3], ARG(4), ARG(5));
+    else if (IS(sapforWriteArrRange))
+      sapforWriteArrRange(ARG(0), ARG(1), A[2], A[3], ARG(4), ARG(5));
+    else if (IS(sapforSLIter))
+      sapforSLIter(ARG(0), A[1]);
+    else if (IS(sapforSLBegin))
+      sapforSLBegin(ARG(0), A[1], A[2], A[3]);
+    else if (IS(sapforSLEnd))
+      sapforSLEnd(ARG(0));
+    else if (IS(sapforRegVar))
+      sapforRegVar(ARG(0), ARG(1));
+    else if (IS(sapforRegArr))
+      sapforRegArr(ARG(0), A[1], ARG(2));
+    else if (IS(sapforFuncBegin))
+      sapforFuncBegin(ARG(0));
+    else if (IS(sapforFuncEnd))
+      sapforFuncEnd(ARG(0));
+    else if (IS(sapforFuncCallBegin))
+      sapforFuncCallBegin(ARG(0), ARG(1));
+    else if (IS(sapforFuncCallEnd))
+      sapforFuncCallEnd(ARG(0));
+    else if (IS(sapforRegDummyVar))
+      sapforRegDummyVar(ARG(0), ARG(1), ARG(2), A[3]);
+    else if (IS(sapforRegDummyArr))
+      sapforRegDummyArr(ARG(0), A[1], ARG(2), ARG(3), A[4]);
+#undef IS
+#undef ARG
+  }
+}
+}
@@ -0,0 +1,127 @@
+//===--- AnalysisJobs.cpp ----- Parallel Analysis Jobs ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//===----------------------------------------------------------------------===//
+//
+// This file implements utilities to analyze parts of sources in separate
+// processes which are executed concurrently.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Support/AnalysisJobs.h"
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+
+using namespace llvm;
+using namespace tsar;
+
+bool tsar::executeJobs(StringRef Program, MutableArrayRef<AnalysisJob> Jobs,
+    unsigned MaxProcs) {
+  bool Success = true;
+  auto launch = [&Program, &Success](AnalysisJob &J) {
+    if (sys::fs::createTemporaryFile("tsar-job", "out", J.Out) ||
+        sys::fs::createTemporaryFile("tsar-job", "err", J.Err)) {
+      errs() << "error: unable to create temporary file\n";
+      Success = false;
+      return;
+    }
+    std::vector<StringRef> Args(J.Args.begin(), J.Args.end());
+    Optional<StringRef> Redirects[] = {None, StringRef(J.Out), StringRef(J.Err)};
+    std::string ErrMsg;
+    bool ExecutionFailed = false;
+    J.PI = sys::ExecuteNoWait(Program, Args, None, Redirects, 0, &ErrMsg,
+                              &ExecutionFailed);
+    if (ExecutionFailed) {
+      errs() << "error: unable to execute " << Program << ": " << ErrMsg
+             << "\n";
+      Success = false;
+      return;
+    }
+    J.IsLaunched = true;
+  };
+  auto wait = [&Success](AnalysisJob &J) {
+    if (J.IsLaunched) {
+      std::string ErrMsg;
+      auto Res = sys::Wait(J.PI, 0, true, &ErrMsg);
+      if (Res.ReturnCode != 0) {
+        if (!ErrMsg.empty())
+          errs() << "error: " << ErrMsg << "\n";
+        Success = false;
+      }
+    }
+    for (auto *File : { &J.Out, &J.Err }) {
+      if (File->empty())
+        continue;
+      if (auto Buffer = MemoryBuffer::getFile(*File))
+        (File == &J.Out ? outs() : errs()) << (**Buffer).getBuffer();
+      outs().flush();
+      sys::fs::remove(*File);
+    }
+  };
+  // Processes are waited in order of their creation, so outputs of jobs are
+  // never interleaved.
+  std::size_t NextToWait = 0;
+  for (std::size_t I = 0, EI = Jobs.size(); I < EI; ++I) {
+    if (I >= NextToWait + MaxProcs)
+      wait(Jobs[NextToWait++]);
+    launch(Jobs[I]);
+  }
+  for (auto EI = Jobs.size(); NextToWait < EI; ++NextToWait)
+    wait(Jobs[NextToWait]);
+  return Success;
+}
+
+std::vector<std::string> tsar::getBaseJobArgs(ArrayRef<std::string> Args,
+    ArrayRef<std::string> Sources, ArrayRef<StringRef> Options) {
+  assert(!Args.empty() && "Name of a program must be specified!");
+  std::vector<std::string> BaseArgs{ Args.front() };
+  bool IsCompilerArg = false;
+  for (auto I = Args.begin() + 1, EI = Args.end(); I != EI; ++I) {
+    StringRef Arg = *I;
+    if (!IsCompilerArg) {
+      if (Arg == "--") {
+        IsCompilerArg = true;
+      } else if (is_contained(Sources, *I)) {
+        continue;
+      } else if (is_contained(Options, Arg)) {
+        if (I + 1 != EI)
+          ++I;
+        continue;
+      } else if (any_of(Options, [&Arg](StringRef Opt) {
+                   return Arg.startswith(Opt) &&
+                          Arg.drop_front(Opt.size()).startswith("=");
+                 })) {
+        continue;
+      }
+    }
+    BaseArgs.push_back(*I);
+  }
+  return BaseArgs;
+}
+
+std::vector<std::string> tsar::getJobArgs(ArrayRef<std::string> BaseArgs,
+    ArrayRef<std::string> Sources, ArrayRef<std::string> Extra) {
+  std::vector<std::string> Args(BaseArgs.begin(), BaseArgs.end());
+  auto CompilerArgItr = std::find(Args.begin(), Args.end(), "--");
+  auto InsertItr = Args.insert(CompilerArgItr, Sources.begin(), Sources.end());
+  Args.insert(InsertItr + Sources.size(), Extra.begin(), Extra.end());
+  return Args;
+}
@@ -0,0 +1,72 @@
+//===--- ASTIndex.cpp ----- Index of Function Body --------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements an immutable index of entities in a function body.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Support/Clang/ASTIndex.h"
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/SourceManager.h>
+
+using namespace clang;
+using namespace tsar;
+
+namespace tsar {
+class ASTIndexBuilder : public RecursiveASTVisitor<ASTIndexBuilder> {
+public:
+  ASTIndexBuilder(const SourceManager &SrcMgr, ASTIndex &Index) :
+    mSrcMgr(&SrcMgr), mIndex(&Index) {}
+
+  bool VisitStmt(Stmt *S) {
+    mIndex->mStmts.push_back(S);
+    if (isa<ForStmt>(S) || isa<WhileStmt>(S) || isa<DoStmt>(S))
+      add(S, S->getLocStart(), mIndex->mLoops, mIndex->mLoopsInMacro);
+    else if (isa<CallExpr>(S))
+      add(S, S->getLocStart(), mIndex->mCalls, mIndex->mCallsInMacro);
+    return true;
+  }
+
+  bool VisitVarDecl(VarDecl *D) {
+    add(D, D->getLocStart(), mIndex->mVars, mIndex->mVarsInMacro);
+    return true;
+  }
+
+private:
+  template<class T>
+  void add(T *Entity, SourceLocation Loc, std::vector<T *> &List,
+      ASTIndex::MacroMap<T> &InMacro) {
+    List.push_back(Entity);
+    if (!Loc.isMacroID())
+      return;
+    Loc = mSrcMgr->getExpansionLoc(Loc);
+    if (Loc.isInvalid())
+      return;
+    InMacro[Loc.getRawEncoding()].push_back(Entity);
+  }
+
+  const SourceManager *mSrcMgr;
+  ASTIndex *mIndex;
+};
+}
+
+ASTIndex::ASTIndex(Decl &D, const SourceManager &SrcMgr) {
+  ASTIndexBuilder(SrcMgr, *this).TraverseDecl(&D);
+}
@@ -20,29 +20,92 @@
 // Some function passes (for example DefinedMemoryPass) may use results of
 // module passes and these results becomes invalid after transformations.
 // A pass in this file do nothing but allow us to finish processing of
-// all functions before transformations.
+// all functions before transformations. A barrier also reports memory usage
+// of a finished stage if it is requested.
 //
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Support/PassBarrier.h"
+#include "tsar/Support/GlobalOptions.h"
 #include <bcl/utility.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/Process.h>
+#if defined(__APPLE__)
+# include <mach/mach.h>
+#elif defined(LLVM_ON_UNIX)
+# include <cstdio>
+#endif
 
 using namespace llvm;
+using namespace tsar;
 
 namespace {
 class PassBarrier : public ModulePass, private bcl::Uncopyable {
 public:
   static char ID;
-  PassBarrier() : ModulePass(ID) {
+  explicit PassBarrier(StringRef Stage = "") : ModulePass(ID), mStage(Stage) {
     initializePassBarrierPass(*PassRegistry::getPassRegistry());
   }
 
-  bool runOnModule(Module &M) override { return false; }
+  bool runOnModule(Module &M) override {
+    auto *GOWrapper = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (GOWrapper && GOWrapper->getOptions().PrintMemoryUsage) {
+      // Memory usage at the previous barrier, it is used to print changes.
+      static std::size_t PrevRSS = 0;
+      errs() << "memory usage";
+      if (!mStage.empty())
+        errs() << " after " << mStage;
+      auto RSS = getMemoryUsage();
+      if (RSS > 0) {
+        errs() << ": " << RSS / 1024 << " KiB";
+        if (PrevRSS > 0) {
+          auto Delta = static_cast<long long>(RSS / 1024) -
+                       static_cast<long long>(PrevRSS / 1024);
+          errs() << " (" << (Delta < 0 ? "" : "+") << Delta << " KiB)";
+        }
+        errs() << "\n";
+      } else {
+        errs() << ": unknown\n";
+      }
+      PrevRSS = RSS;
+    }
+    return false;
+  }
+
+private:
+  std::string mStage;
 };
 }
 
 char PassBarrier::ID = 0;
 INITIALIZE_PASS(PassBarrier, "pass-barrier", "Pass Barrier", true, true)
 
-ModulePass *llvm:: createPassBarrier() { return new PassBarrier; }
+ModulePass *llvm:: createPassBarrier(StringRef Stage) {
+  return new PassBarrier(Stage);
+}
+
+std::size_t tsar::getMemoryUsage() {
+#if defined(__APPLE__)
+  mach_task_basic_info_data_t Info;
+  mach_msg_type_number_t Count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&Info), &Count) != KERN_SUCCESS)
+    return 0;
+  return Info.resident_size;
+#elif defined(LLVM_ON_UNIX)
+  // The second field in 'statm' is the number of resident pages.
+  std::FILE *Statm = std::fopen("/proc/self/statm", "r");
+  if (!Statm)
+    return 0;
+  unsigned long long Size, Resident;
+  auto NumRead = std::fscanf(Statm, "%llu %llu", &Size, &Resident);
+  std::fclose(Statm);
+  if (NumRead != 2)
+    return 0;
+  return static_cast<std::size_t>(Resident) * sys::Process::getPageSize();
+#else
+  return 0;
+#endif
+}
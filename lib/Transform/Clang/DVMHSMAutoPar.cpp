@@ -27,6 +27,7 @@
 #include "tsar/Analysis/DFRegionInfo.h"
 #include "tsar/Analysis/Clang/ASTDependenceAnalysis.h"
 #include "tsar/Analysis/Clang/CanonicalLoop.h"
+#include "tsar/Analysis/Clang/GlobalInfoExtractor.h"
 #include "tsar/Analysis/Clang/LoopMatcher.h"
 #include "tsar/Analysis/Clang/PerfectLoop.h"
 #include "tsar/Analysis/Passes.h"
@@ -34,8 +35,14 @@
 #include "tsar/Analysis/Parallel/ParallelLoop.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
 #include "tsar/Support/Clang/Utils.h"
 #include "tsar/Transform/Clang/Passes.h"
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
 
 using namespace clang;
 using namespace llvm;
@@ -45,19 +52,162 @@ using namespace tsar;
 #define DEBUG_TYPE "clang-dvmh-sm-parallel"
 
 namespace {
-/// This pass try to insert OpenMP directives into a source code to obtain
+/// This pass try to insert DVMH directives into a source code to obtain
 /// a parallel program.
+///
+/// Directives are not inserted immediately when a parallel loop is found.
+/// At first, all parallel loops in a function are collected. Then adjacent
+/// loops which are executed on accelerator are merged into a single region
+/// and data transfers (`actual` and `get_actual` directives) are hoisted out
+/// of enclosing sequential loops if host code in these loops does not access
+/// transferred variables.
+///
+/// DVMH does not support first private and last private variables, so copies
+/// of these variables are explicitly created outside the loop. A private
+/// variable is initialized with a copy at the beginning of each iteration and
+/// it is stored to a copy at the end of the last iteration.
+///
+/// DVMH also does not support array sections in a reduction clause, so
+/// a reduction over an array which is accessed through a pointer uses a local
+/// array (a privatized accumulator) with the same number of elements.
 class ClangDVMHSMParallelization : public ClangSMParallelization {
 public:
   static char ID;
   ClangDVMHSMParallelization() : ClangSMParallelization(ID) {
     initializeClangDVMHSMParallelizationPass(*PassRegistry::getPassRegistry());
   }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    ClangSMParallelization::getAnalysisUsage(AU);
+    AU.addRequired<ClangGlobalInfoPass>();
+  }
 private:
+  /// Copy of a first private or last private variable.
+  struct VarCopy {
+    const clang::VarDecl *Var;
+    SmallString<32> Name;
+  };
+
+  /// Local array which accumulates a reduction over an array `Var` which is
+  /// accessed through a pointer. References to `Var` in the loop are replaced
+  /// with references to the local array.
+  struct ReductionCopy {
+    const clang::VarDecl *Var;
+    SmallString<32> Name;
+    /// Name of an induction variable of loops which copy elements.
+    SmallString<32> Idx;
+    /// Number of elements.
+    std::string Size;
+    SmallVector<clang::SourceLocation, 4> Refs;
+  };
+
+  /// Description of a parallel loop in a currently processed function.
+  struct ParallelItem {
+    const clang::ForStmt *AST;
+    const DFLoop *IR;
+    bool HostOnly;
+    SmallString<128> ParallelFor;
+    ClangDependenceAnalyzer::SortedVarListT In;
+    ClangDependenceAnalyzer::SortedVarListT Out;
+    ClangDependenceAnalyzer::SortedVarListT Local;
+    SmallVector<VarCopy, 2> CopyIn;
+    SmallVector<VarCopy, 2> CopyOut;
+    SmallVector<ReductionCopy, 1> CopyReduction;
+
+    bool hasCopies() const {
+      return !CopyIn.empty() || !CopyOut.empty() || !CopyReduction.empty();
+    }
+  };
+
   bool exploitParallelism(const DFLoop &IR, const clang::ForStmt &AST,
     const ClangSMParallelProvider &Provider,
     tsar::ClangDependenceAnalyzer &ASTDepInfo,
     TransformationContext &TfmCtx) override;
+
+  /// Create copies of first private and last private variables and use them
+  /// in the loop body.
+  ///
+  /// \return false if copies can not be created, in this case the source code
+  /// is not changed.
+  bool copyPrivates(const clang::ForStmt &For,
+    const ClangDependenceAnalyzer &ASTRegionAnalysis,
+    TransformationContext &TfmCtx, ParallelItem &Item);
+
+  /// Create local arrays to accumulate reductions over arrays which are
+  /// described with array sections.
+  ///
+  /// References in the loop are not replaced here, so the source code is not
+  /// changed. Use replaceReductions() to update the loop.
+  bool copyReductions(const clang::ForStmt &For,
+    const ClangDependenceAnalyzer &ASTRegionAnalysis,
+    TransformationContext &TfmCtx, ParallelItem &Item);
+
+  /// Replace references to arrays with references to local arrays which
+  /// accumulate reductions.
+  void replaceReductions(const ParallelItem &Item,
+                         TransformationContext &TfmCtx);
+
+  void optimizeFunction(Function &F, ClangSMParallelProvider &Provider,
+    TransformationContext &TfmCtx) override;
+
+  std::vector<ParallelItem> mParallelItems;
+};
+
+/// Variables which are accessed in a host code of a statement.
+struct HostAccessInfo {
+  StringSet<> Names;
+  /// This is set if it is not possible to determine accessed variables,
+  /// for example, due to calls or accesses through pointers.
+  bool Unknown = false;
+};
+
+/// Map from loops which are executed on accelerator to variables which are
+/// accessed in a host code around these loops (for example, to create copies
+/// of first private variables).
+using DeviceLoopMap = DenseMap<const Stmt *, SmallVector<StringRef, 2>>;
+
+/// Collect variables which are accessed in a host code of a statement.
+///
+/// Loops which are executed on accelerator are not a part of a host code.
+class HostAccessVisitor : public RecursiveASTVisitor<HostAccessVisitor> {
+public:
+  HostAccessVisitor(const DeviceLoopMap &DeviceLoops, HostAccessInfo &Info)
+    : mDeviceLoops(DeviceLoops), mInfo(Info) {}
+
+  bool TraverseStmt(Stmt *S) {
+    if (!S)
+      return true;
+    auto LoopItr = mDeviceLoops.find(S);
+    if (LoopItr != mDeviceLoops.end()) {
+      for (auto Name : LoopItr->second)
+        mInfo.Names.insert(Name);
+      return true;
+    }
+    return RecursiveASTVisitor::TraverseStmt(S);
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+    if (auto *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+      mInfo.Names.insert(VD->getName());
+      if (VD->getType()->isPointerType() || VD->getType()->isReferenceType())
+        mInfo.Unknown = true;
+    }
+    return true;
+  }
+
+  bool VisitVarDecl(VarDecl *VD) {
+    mInfo.Names.insert(VD->getName());
+    return true;
+  }
+
+  bool VisitCallExpr(CallExpr *) {
+    mInfo.Unknown = true;
+    return true;
+  }
+
+private:
+  const DeviceLoopMap &mDeviceLoops;
+  HostAccessInfo &mInfo;
 };
 
 void addVarList(const ClangDependenceAnalyzer::SortedVarListT &VarInfoList,
@@ -87,12 +237,12 @@ void addVarList(const ClangDependenceAnalyzer::ReductionVarListT &VarInfoList,
     case trait::Reduction::RK_Mult: RedKind += "product"; break;
     case trait::Reduction::RK_Or: RedKind += "or"; break;
     case trait::Reduction::RK_And: RedKind += "and"; break;
-    case trait::Reduction::RK_Xor: RedKind + "xor "; break;
+    case trait::Reduction::RK_Xor: RedKind += "xor"; break;
     case trait::Reduction::RK_Max: RedKind += "max"; break;
     case trait::Reduction::RK_Min: RedKind += "min"; break;
     default: llvm_unreachable("Unknown reduction kind!"); break;
     }
-    ParallelFor.append({ 'r', 'e', 'd', 'u', 'c', 't', 'i', 'o', 'n' });
+    ParallelFor.append({ ' ', 'r', 'e', 'd', 'u', 'c', 't', 'i', 'o', 'n' });
     ParallelFor.push_back('(');
     auto VarItr = VarInfoList[I].begin(), VarItrE = VarInfoList[I].end();
     ParallelFor.append(RedKind.begin(), RedKind.end());
@@ -126,6 +276,325 @@ unsigned getPerfectNestSize(const DFLoop &DFL,
   }
   return PerfectSize;
 }
+
+/// Collect subscript expressions of accesses to arrays in a statement.
+class ArrayAccessVisitor : public RecursiveASTVisitor<ArrayAccessVisitor> {
+public:
+  /// List of subscripts ordered from the outermost dimension.
+  using SubscriptListT = SmallVector<const Expr *, 4>;
+
+  bool TraverseArraySubscriptExpr(ArraySubscriptExpr *ASE) {
+    SubscriptListT Subscripts;
+    Expr *Base = ASE;
+    while (auto *Curr =
+               dyn_cast<ArraySubscriptExpr>(Base->IgnoreParenImpCasts())) {
+      Subscripts.push_back(Curr->getIdx());
+      Base = Curr->getBase();
+    }
+    for (auto *Idx : Subscripts)
+      if (!TraverseStmt(const_cast<Expr *>(Idx)))
+        return false;
+    std::reverse(Subscripts.begin(), Subscripts.end());
+    if (auto *DRE = dyn_cast<DeclRefExpr>(Base->IgnoreParenImpCasts()))
+      if (auto *VD = dyn_cast<VarDecl>(DRE->getDecl())) {
+        Decls[VD->getName()] = VD;
+        Accesses[VD->getName()].push_back(std::move(Subscripts));
+        return true;
+      }
+    return TraverseStmt(Base);
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+    if (auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      Unsubscripted.insert(VD->getName());
+    return true;
+  }
+
+  /// Subscripts of all accesses to an array with a specified name.
+  StringMap<SmallVector<SubscriptListT, 4>> Accesses;
+  /// Declarations of accessed arrays.
+  StringMap<const VarDecl *> Decls;
+  /// Variables which are accessed without subscripts.
+  StringSet<> Unsubscripted;
+};
+
+/// Return induction variable of a canonical loop or nullptr.
+const VarDecl *getInductionDecl(const ForStmt &For) {
+  auto *Inc = For.getInc();
+  if (!Inc)
+    return nullptr;
+  Inc = Inc->IgnoreParenImpCasts();
+  if (auto *UO = dyn_cast<UnaryOperator>(Inc))
+    Inc = UO->getSubExpr();
+  else if (auto *BO = dyn_cast<BinaryOperator>(Inc))
+    Inc = BO->getLHS();
+  auto *DRE = dyn_cast<DeclRefExpr>(Inc->IgnoreParenImpCasts());
+  return DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+}
+
+/// Return true if a specified expression is a reference to a variable `VD`.
+bool isRefTo(const Expr &E, const VarDecl &VD) {
+  auto *DRE = dyn_cast<DeclRefExpr>(E.IgnoreParenImpCasts());
+  return DRE && DRE->getDecl() == &VD;
+}
+
+/// Return true if a specified statement refers to a variable `VD`.
+bool refersTo(const Stmt &S, const VarDecl &VD) {
+  if (auto *DRE = dyn_cast<DeclRefExpr>(&S))
+    return DRE->getDecl() == &VD;
+  return llvm::any_of(S.children(),
+    [&VD](const Stmt *Child) { return Child && refersTo(*Child, VD); });
+}
+
+/// Collect locations of references to a variable `VD` in a statement.
+///
+/// \return false if a reference is located in a macro.
+bool collectRefs(const Stmt &S, const VarDecl &VD,
+    SmallVectorImpl<SourceLocation> &Refs) {
+  if (auto *DRE = dyn_cast<DeclRefExpr>(&S))
+    if (DRE->getDecl()->getCanonicalDecl() == VD.getCanonicalDecl()) {
+      if (DRE->getLocation().isMacroID())
+        return false;
+      Refs.push_back(DRE->getLocation());
+    }
+  for (auto *Child : S.children())
+    if (Child && !collectRefs(*Child, VD, Refs))
+      return false;
+  return true;
+}
+
+/// Compute offset of a subscript expression in form `I`, `I + C`, `C + I` or
+/// `I - C`, where `I` is an induction variable and `C` is an integer
+/// constant.
+///
+/// \return false if a subscript depends on an induction variable but it does
+/// not match the forms above. Offset remains unset if a subscript does not
+/// depend on an induction variable.
+bool getSubscriptOffset(const Expr &Subscript, const VarDecl &Induction,
+    const ASTContext &ASTCtx, Optional<int64_t> &Offset) {
+  auto *E = Subscript.IgnoreParenImpCasts();
+  if (!refersTo(*E, Induction))
+    return true;
+  if (isRefTo(*E, Induction)) {
+    Offset = 0;
+    return true;
+  }
+  auto *BO = dyn_cast<BinaryOperator>(E);
+  if (!BO || BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub)
+    return false;
+  APSInt C;
+  if (isRefTo(*BO->getLHS(), Induction) &&
+      BO->getRHS()->isIntegerConstantExpr(C, ASTCtx)) {
+    Offset = BO->getOpcode() == BO_Add ? C.getExtValue() : -C.getExtValue();
+    return true;
+  }
+  if (BO->getOpcode() == BO_Add && isRefTo(*BO->getRHS(), Induction) &&
+      BO->getLHS()->isIntegerConstantExpr(C, ASTCtx)) {
+    Offset = C.getExtValue();
+    return true;
+  }
+  return false;
+}
+
+/// Add `across` clause for all variables with loop-carried dependencies.
+///
+/// Widths of dependencies are computed according to subscripts of accesses
+/// to arrays inside the loop. Only one dimension of each array may depend on
+/// the induction variable of the loop. Distances of dependencies ensure that
+/// all of them are known, however array dimensions that carry dependencies
+/// are available at the source level only.
+/// \return false if some dependencies can not be described.
+bool addAcrossClause(const ForStmt &For,
+    const ClangDependenceAnalyzer::ASTRegionTraitInfo &DepInfo,
+    ASTContext &ASTCtx, SmallVectorImpl<char> &Clause) {
+  ClangDependenceAnalyzer::SortedVarListT DepVars;
+  for (auto &Dep : DepInfo.get<trait::Flow>())
+    DepVars.insert(Dep.first);
+  for (auto &Dep : DepInfo.get<trait::Anti>())
+    DepVars.insert(Dep.first);
+  if (DepVars.empty())
+    return true;
+  auto &Diags = ASTCtx.getDiagnostics();
+  auto diagAcross = [&Diags, &For](StringRef Name) {
+    toDiag(Diags, For.getLocStart(), clang::diag::warn_parallel_loop);
+    toDiag(Diags, For.getLocStart(), clang::diag::note_parallel_across_unable)
+        << Name;
+    return false;
+  };
+  auto *Induction = getInductionDecl(For);
+  if (!Induction)
+    return diagAcross(*DepVars.begin());
+  ArrayAccessVisitor Visitor;
+  Visitor.TraverseStmt(const_cast<Stmt *>(For.getBody()));
+  SmallString<64> Across;
+  for (auto &Name : DepVars) {
+    auto AccessItr = Visitor.Accesses.find(Name);
+    if (AccessItr == Visitor.Accesses.end() ||
+        Visitor.Unsubscripted.count(Name))
+      return diagAcross(Name);
+    unsigned Rank = 0;
+    for (auto *Ty = Visitor.Decls[Name]->getType().getTypePtr();
+         auto *ArrayTy = Ty->getAsArrayTypeUnsafe();
+         Ty = ArrayTy->getElementType().getTypePtr())
+      ++Rank;
+    if (Rank == 0)
+      return diagAcross(Name);
+    SmallVector<std::pair<int64_t, int64_t>, 4> Widths(Rank, {0, 0});
+    Optional<unsigned> CarriedDim;
+    for (auto &Subscripts : AccessItr->second) {
+      if (Subscripts.size() != Rank)
+        return diagAcross(Name);
+      for (unsigned Dim = 0; Dim < Rank; ++Dim) {
+        Optional<int64_t> Offset;
+        if (!getSubscriptOffset(*Subscripts[Dim], *Induction, ASTCtx, Offset))
+          return diagAcross(Name);
+        if (!Offset)
+          continue;
+        if (CarriedDim && *CarriedDim != Dim)
+          return diagAcross(Name);
+        CarriedDim = Dim;
+        Widths[Dim].first = std::max(Widths[Dim].first, -*Offset);
+        Widths[Dim].second = std::max(Widths[Dim].second, *Offset);
+      }
+    }
+    if (!CarriedDim ||
+        Widths[*CarriedDim].first == 0 && Widths[*CarriedDim].second == 0)
+      return diagAcross(Name);
+    if (!Across.empty())
+      Across += ", ";
+    Across += Name;
+    for (auto &W : Widths) {
+      Across += '[';
+      Twine(W.first).toVector(Across);
+      Across += ':';
+      Twine(W.second).toVector(Across);
+      Across += ']';
+    }
+  }
+  Clause.append({ ' ', 'a', 'c', 'r', 'o', 's', 's', '(' });
+  Clause.append(Across.begin(), Across.end());
+  Clause.push_back(')');
+  return true;
+}
+
+/// Return true if a variable with a specified name is declared in a specified
+/// compound statement (not in nested statements), so it hides other variables
+/// with the same name at the end of the statement.
+bool isDeclaredIn(const Stmt &S, StringRef Name) {
+  auto *CS = dyn_cast<CompoundStmt>(&S);
+  if (!CS)
+    return false;
+  for (auto *Child : CS->body())
+    if (auto *DS = dyn_cast<DeclStmt>(Child))
+      for (auto *D : DS->decls())
+        if (auto *ND = dyn_cast<NamedDecl>(D))
+          if (ND->getIdentifier() && ND->getName() == Name)
+            return true;
+  return false;
+}
+
+/// Return true if a specified statement contains `continue` which refers to
+/// an outer loop.
+bool hasContinue(const Stmt &S) {
+  if (isa<ContinueStmt>(S))
+    return true;
+  if (isa<ForStmt>(S) || isa<WhileStmt>(S) || isa<DoStmt>(S))
+    return false;
+  return llvm::any_of(S.children(),
+    [](const Stmt *Child) { return Child && hasContinue(*Child); });
+}
+
+/// Build condition which is true on the last iteration of a canonical loop
+/// with a unit step.
+///
+/// \return false if the condition can not be built.
+bool buildLastIterationCond(const ForStmt &For, const VarDecl &Induction,
+    ASTContext &ASTCtx, SmallVectorImpl<char> &Cond) {
+  auto *Inc = For.getInc()->IgnoreParenImpCasts();
+  int Step = 0;
+  if (auto *UO = dyn_cast<UnaryOperator>(Inc)) {
+    Step = UO->isIncrementOp() ? 1 : UO->isDecrementOp() ? -1 : 0;
+  } else if (auto *CAO = dyn_cast<CompoundAssignOperator>(Inc)) {
+    APSInt C;
+    if (CAO->getRHS()->isIntegerConstantExpr(C, ASTCtx) && C == 1)
+      Step = CAO->getOpcode() == BO_AddAssign ? 1 :
+        CAO->getOpcode() == BO_SubAssign ? -1 : 0;
+  }
+  if (Step == 0 || !For.getCond())
+    return false;
+  auto *BO = dyn_cast<BinaryOperator>(For.getCond()->IgnoreParenImpCasts());
+  if (!BO || !BO->isRelationalOp())
+    return false;
+  auto Opcode = BO->getOpcode();
+  const Expr *End = BO->getRHS();
+  if (!isRefTo(*BO->getLHS(), Induction)) {
+    if (!isRefTo(*BO->getRHS(), Induction))
+      return false;
+    End = BO->getLHS();
+    Opcode = BinaryOperator::reverseComparisonOp(Opcode);
+  }
+  StringRef Adjust;
+  switch (Opcode) {
+  case BO_LT: if (Step != 1) return false; Adjust = " - 1"; break;
+  case BO_LE: if (Step != 1) return false; break;
+  case BO_GT: if (Step != -1) return false; Adjust = " + 1"; break;
+  case BO_GE: if (Step != -1) return false; break;
+  default: return false;
+  }
+  if (End->getLocStart().isMacroID() || End->getLocEnd().isMacroID())
+    return false;
+  auto EndText = Lexer::getSourceText(
+      CharSourceRange::getTokenRange(End->getSourceRange()),
+      ASTCtx.getSourceManager(), ASTCtx.getLangOpts());
+  if (EndText.empty())
+    return false;
+  (Twine("if (") + Induction.getName() + " == ").toVector(Cond);
+  if (Adjust.empty()) {
+    Cond.append(EndText.begin(), EndText.end());
+  } else {
+    (Twine("(") + EndText + ")" + Adjust).toVector(Cond);
+  }
+  Cond.push_back(')');
+  return true;
+}
+
+/// Build a new identifier which starts with a specified prefix and does not
+/// conflict with identifiers in a source code.
+void addSuffix(StringRef Prefix, StringSet<> &Identifiers,
+    SmallVectorImpl<char> &Out) {
+  for (unsigned Count = 0;
+    Identifiers.count((Prefix + Twine(Count)).toStringRef(Out));
+    ++Count, Out.clear());
+  Identifiers.insert(StringRef(Out.data(), Out.size()));
+}
+
+/// Return location to insert text after a specified statement.
+SourceLocation getInsertLocAfter(const Stmt &S, ASTContext &ASTCtx) {
+  Token SemiTok;
+  return (!getRawTokenAfter(S.getLocEnd(), ASTCtx.getSourceManager(),
+                            ASTCtx.getLangOpts(), SemiTok) &&
+          SemiTok.is(tok::semi))
+             ? SemiTok.getLocation()
+             : S.getLocEnd();
+}
+
+/// Return compound statement which immediately contains a specified statement.
+const CompoundStmt *getParentCompound(const Stmt &S, ASTContext &ASTCtx) {
+  auto Parents = ASTCtx.getParents(S);
+  return Parents.empty() ? nullptr : Parents[0].get<CompoundStmt>();
+}
+
+/// Return true if `Next` immediately follows `Prev` in the same compound
+/// statement (empty statements are ignored).
+bool isAdjacent(const Stmt &Prev, const Stmt &Next, ASTContext &ASTCtx) {
+  auto *Parent = getParentCompound(Prev, ASTCtx);
+  if (!Parent || Parent != getParentCompound(Next, ASTCtx))
+    return false;
+  auto I = std::find(Parent->body_begin(), Parent->body_end(), &Prev);
+  assert(I != Parent->body_end() && "Statement must be a child of parent!");
+  for (++I; I != Parent->body_end() && isa<NullStmt>(*I); ++I);
+  return I != Parent->body_end() && *I == &Next;
+}
 } // namespace
 
 bool ClangDVMHSMParallelization::exploitParallelism(
@@ -134,72 +603,413 @@ bool ClangDVMHSMParallelization::exploitParallelism(
     tsar::ClangDependenceAnalyzer &ASTRegionAnalysis,
     TransformationContext &TfmCtx) {
   auto &ASTDepInfo = ASTRegionAnalysis.getDependenceInfo();
-  if (!ASTDepInfo.get<trait::FirstPrivate>().empty() ||
-      !ASTDepInfo.get<trait::LastPrivate>().empty())
+  SmallString<64> Across;
+  if (!addAcrossClause(AST, ASTDepInfo, TfmCtx.getContext(), Across))
     return false;
-  SmallString<128> DVMHRegion("#pragma dvm region");
-  SmallString<128> DVMHActual, DVMHGetActual;
+  ParallelItem Item;
+  Item.AST = &AST;
+  Item.IR = &IR;
+  Item.HostOnly = false;
+  if (!copyReductions(AST, ASTRegionAnalysis, TfmCtx, Item) ||
+      !copyPrivates(AST, ASTRegionAnalysis, TfmCtx, Item))
+    return false;
+  replaceReductions(Item, TfmCtx);
+  // Arrays which are accessed through pointers are replaced with local
+  // arrays, so pointers are not used in the loop.
+  auto &Sections = ASTRegionAnalysis.getArraySections();
+  auto &FirstPrivates = ASTDepInfo.get<trait::FirstPrivate>();
+  auto &LastPrivates = ASTDepInfo.get<trait::LastPrivate>();
   auto &PI = Provider.get<ParallelLoopPass>().getParallelLoopInfo();
-  bool HostOnly = false;
   if (!PI[IR.getLoop()].isHostOnly() && ASTRegionAnalysis.evaluateDefUse()) {
-    if (!ASTDepInfo.get<trait::ReadOccurred>().empty()) {
-      DVMHActual += "#pragma dvm actual";
-      addVarList(ASTDepInfo.get<trait::ReadOccurred>(), DVMHActual);
-      DVMHRegion += " in";
-      addVarList(ASTDepInfo.get<trait::ReadOccurred>(), DVMHRegion);
-      DVMHActual += '\n';
-    }
-    if (!ASTDepInfo.get<trait::WriteOccurred>().empty()) {
-      DVMHGetActual += "#pragma dvm get_actual";
-      addVarList(ASTDepInfo.get<trait::WriteOccurred>(), DVMHGetActual);
-      DVMHRegion += " out";
-      addVarList(ASTDepInfo.get<trait::WriteOccurred>(), DVMHRegion);
-      DVMHGetActual += '\n';
-    }
-    if (!ASTDepInfo.get<trait::Private>().empty()) {
-      DVMHRegion += " local";
-      addVarList(ASTDepInfo.get<trait::Private>(), DVMHRegion);
-    }
+    // First private and last private variables are accessed through copies
+    // outside the loop.
+    for (auto &Var : ASTDepInfo.get<trait::ReadOccurred>())
+      if (!FirstPrivates.count(Var) && !Sections.count(Var))
+        Item.In.insert(Var);
+    for (auto &Var : ASTDepInfo.get<trait::WriteOccurred>())
+      if (!LastPrivates.count(Var) && !Sections.count(Var))
+        Item.Out.insert(Var);
+    Item.Local = ASTDepInfo.get<trait::Private>();
+    Item.Local.insert(FirstPrivates.begin(), FirstPrivates.end());
+    Item.Local.insert(LastPrivates.begin(), LastPrivates.end());
   } else {
-    DVMHRegion += " targets(HOST)";
-    HostOnly = true;
+    Item.HostOnly = true;
   }
   auto &PerfectInfo = Provider.get<ClangPerfectLoopPass>().getPerfectLoopInfo();
   auto &CanonicalInfo = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
-  SmallString<128> ParallelFor("#pragma dvm parallel (");
-  if (HostOnly)
+  auto &ParallelFor = Item.ParallelFor;
+  ParallelFor += "#pragma dvm parallel (";
+  // Dependencies are known for the outermost loop in a nest only, so inner
+  // loops of a pipelined nest are executed sequentially.
+  if (Item.HostOnly || !Across.empty())
     ParallelFor += "1";
   else
     Twine(getPerfectNestSize(IR, PerfectInfo, CanonicalInfo))
         .toStringRef(ParallelFor);
   ParallelFor += ")";
-  if (!ASTDepInfo.get<trait::Private>().empty()) {
+  auto Privates = ASTDepInfo.get<trait::Private>();
+  Privates.insert(FirstPrivates.begin(), FirstPrivates.end());
+  Privates.insert(LastPrivates.begin(), LastPrivates.end());
+  if (!Privates.empty()) {
     ParallelFor += " private";
-    addVarList(ASTDepInfo.get<trait::Private>(), ParallelFor);
+    addVarList(Privates, ParallelFor);
   }
-  addVarList(ASTDepInfo.get<trait::Reduction>(), ParallelFor);
+  auto Reductions = ASTDepInfo.get<trait::Reduction>();
+  for (auto &Copy : Item.CopyReduction)
+    for (auto &List : Reductions)
+      if (List.erase(Copy.Var->getName().str()))
+        List.insert(Copy.Name.str().str());
+  addVarList(Reductions, ParallelFor);
+  ParallelFor += Across;
   ParallelFor += '\n';
-  DVMHRegion += "\n{\n";
-  // Add directives to the source code.
-  auto &Rewriter = TfmCtx.getRewriter();
-  Rewriter.InsertTextBefore(AST.getLocStart(), ParallelFor);
-  Rewriter.InsertTextBefore(AST.getLocStart(), DVMHRegion);
-  if (!DVMHActual.empty())
-    Rewriter.InsertTextBefore(AST.getLocStart(), DVMHActual);
+  mParallelItems.push_back(std::move(Item));
+  return true;
+}
+
+bool ClangDVMHSMParallelization::copyPrivates(const ForStmt &For,
+    const ClangDependenceAnalyzer &ASTRegionAnalysis,
+    TransformationContext &TfmCtx, ParallelItem &Item) {
+  auto &DepInfo = ASTRegionAnalysis.getDependenceInfo();
+  auto &FirstPrivates = DepInfo.get<trait::FirstPrivate>();
+  auto &LastPrivates = DepInfo.get<trait::LastPrivate>();
+  if (FirstPrivates.empty() && LastPrivates.empty())
+    return true;
   auto &ASTCtx = TfmCtx.getContext();
-  Token SemiTok;
-  auto InsertLoc = (!getRawTokenAfter(AST.getLocEnd(),
-      ASTCtx.getSourceManager(), ASTCtx.getLangOpts(), SemiTok)
-    && SemiTok.is(tok::semi))
-    ? SemiTok.getLocation() : AST.getLocEnd();
-  Rewriter.InsertTextAfterToken(InsertLoc, "}");
-  if (!DVMHGetActual.empty()) {
-    Rewriter.InsertTextAfterToken(InsertLoc, "\n");
-    Rewriter.InsertTextAfterToken(InsertLoc, DVMHGetActual);
+  auto &Diags = ASTCtx.getDiagnostics();
+  auto diagCopy = [&Diags, &For](StringRef Name) {
+    toDiag(Diags, For.getLocStart(), clang::diag::warn_parallel_loop);
+    toDiag(Diags, For.getLocStart(),
+           clang::diag::note_parallel_copy_private_unable) << Name;
+    return false;
+  };
+  auto findCopyable = [&ASTRegionAnalysis](StringRef Name) -> const VarDecl * {
+    auto *VD = ASTRegionAnalysis.findDecl(Name);
+    return VD && VD->getType()->isArithmeticType() ? VD : nullptr;
+  };
+  SmallVector<const VarDecl *, 2> CopyInVars, CopyOutVars;
+  for (auto &Name : FirstPrivates)
+    if (auto *VD = findCopyable(Name))
+      CopyInVars.push_back(VD);
+    else
+      return diagCopy(Name);
+  // A copy of a last private variable is stored at the end of the loop body,
+  // so the variable must not be hidden there.
+  for (auto &Name : LastPrivates) {
+    auto *VD = findCopyable(Name);
+    if (!VD || isDeclaredIn(*For.getBody(), Name))
+      return diagCopy(Name);
+    CopyOutVars.push_back(VD);
+  }
+  // Copy of a last private variable is stored at the end of the loop body,
+  // so each iteration must reach the end of the body.
+  SmallString<64> LastIterCond;
+  auto *Induction = getInductionDecl(For);
+  if (!CopyOutVars.empty() &&
+      (!Induction || hasContinue(*For.getBody()) ||
+       !buildLastIterationCond(For, *Induction, ASTCtx, LastIterCond)))
+    return diagCopy(CopyOutVars.front()->getName());
+  auto &Identifiers =
+      getAnalysis<ClangGlobalInfoPass>().getRawInfo().Identifiers;
+  SmallString<128> Init, Store;
+  for (auto *VD : CopyInVars) {
+    Item.CopyIn.emplace_back();
+    Item.CopyIn.back().Var = VD;
+    addSuffix((VD->getName() + "_first").str(), Identifiers,
+              Item.CopyIn.back().Name);
+    (Twine(VD->getName()) + " = " + Item.CopyIn.back().Name + ";\n")
+        .toVector(Init);
+  }
+  for (auto *VD : CopyOutVars) {
+    Item.CopyOut.emplace_back();
+    Item.CopyOut.back().Var = VD;
+    addSuffix((VD->getName() + "_last").str(), Identifiers,
+              Item.CopyOut.back().Name);
+    (Twine(Item.CopyOut.back().Name) + "[0] = " + VD->getName() + ";\n")
+        .toVector(Store);
+  }
+  if (!Store.empty()) {
+    if (CopyOutVars.size() > 1)
+      Store = (Twine(LastIterCond) + " {\n" + Store + "}\n").str();
+    else
+      Store = (Twine(LastIterCond) + " " + Store).str();
+  }
+  auto &Rewriter = TfmCtx.getRewriter();
+  auto *Body = For.getBody();
+  if (auto *CS = dyn_cast<CompoundStmt>(Body)) {
+    if (!Init.empty())
+      Rewriter.InsertTextAfterToken(CS->getLBracLoc(),
+                                    (Twine("\n") + Init).str());
+    if (!Store.empty())
+      Rewriter.InsertTextBefore(CS->getRBracLoc(), Store);
+  } else {
+    Rewriter.InsertTextBefore(Body->getLocStart(), (Twine("{\n") + Init).str());
+    Rewriter.InsertTextAfterToken(getInsertLocAfter(*Body, ASTCtx),
+                                  (Twine("\n") + Store + "}").str());
   }
   return true;
 }
 
+bool ClangDVMHSMParallelization::copyReductions(const ForStmt &For,
+    const ClangDependenceAnalyzer &ASTRegionAnalysis,
+    TransformationContext &TfmCtx, ParallelItem &Item) {
+  auto &Sections = ASTRegionAnalysis.getArraySections();
+  if (Sections.empty())
+    return true;
+  auto &Diags = TfmCtx.getContext().getDiagnostics();
+  auto &Identifiers =
+      getAnalysis<ClangGlobalInfoPass>().getRawInfo().Identifiers;
+  for (auto &Section : Sections) {
+    auto *VD = ASTRegionAnalysis.findDecl(Section.first);
+    auto ElementTy = VD ? VD->getType()->getPointeeType() : QualType();
+    SmallVector<SourceLocation, 4> Refs;
+    if (ElementTy.isNull() || !ElementTy->isArithmeticType() ||
+        !collectRefs(For, *VD, Refs)) {
+      toDiag(Diags, For.getLocStart(), clang::diag::warn_parallel_loop);
+      toDiag(Diags, For.getLocStart(),
+             clang::diag::note_parallel_copy_reduction_unable)
+          << Section.first;
+      return false;
+    }
+    Item.CopyReduction.emplace_back();
+    auto &Copy = Item.CopyReduction.back();
+    Copy.Var = VD;
+    Copy.Size = Section.second;
+    Copy.Refs = std::move(Refs);
+    addSuffix((VD->getName() + "_red").str(), Identifiers, Copy.Name);
+    addSuffix("I", Identifiers, Copy.Idx);
+  }
+  return true;
+}
+
+void ClangDVMHSMParallelization::replaceReductions(const ParallelItem &Item,
+    TransformationContext &TfmCtx) {
+  auto &Rewriter = TfmCtx.getRewriter();
+  for (auto &Copy : Item.CopyReduction)
+    for (auto Loc : Copy.Refs)
+      Rewriter.ReplaceText(Loc, Copy.Var->getName().size(), Copy.Name);
+}
+
+void ClangDVMHSMParallelization::optimizeFunction(Function &F,
+    ClangSMParallelProvider &Provider, TransformationContext &TfmCtx) {
+  if (mParallelItems.empty())
+    return;
+  auto &ASTCtx = TfmCtx.getContext();
+  auto &SrcMgr = ASTCtx.getSourceManager();
+  std::sort(mParallelItems.begin(), mParallelItems.end(),
+    [&SrcMgr](const ParallelItem &LHS, const ParallelItem &RHS) {
+      return SrcMgr.isBeforeInTranslationUnit(LHS.AST->getLocStart(),
+                                              RHS.AST->getLocStart());
+  });
+  DeviceLoopMap DeviceLoops;
+  for (auto &Item : mParallelItems)
+    if (!Item.HostOnly) {
+      auto &HostNames = DeviceLoops[Item.AST];
+      for (auto &Copy : Item.CopyIn)
+        HostNames.push_back(Copy.Var->getName());
+      for (auto &Copy : Item.CopyOut)
+        HostNames.push_back(Copy.Var->getName());
+      for (auto &Copy : Item.CopyReduction)
+        HostNames.push_back(Copy.Var->getName());
+    }
+  // Merge adjacent loops which are executed on accelerator into a single
+  // region. Each region contains items in the range [Begin, End).
+  struct RegionInfo {
+    unsigned Begin;
+    unsigned End;
+    ClangDependenceAnalyzer::SortedVarListT In, Out, Local;
+    ClangDependenceAnalyzer::SortedVarListT Actual, GetActual;
+  };
+  std::vector<RegionInfo> Regions;
+  for (unsigned I = 0, EI = mParallelItems.size(); I < EI; ++I) {
+    auto &Item = mParallelItems[I];
+    if (Regions.empty() || Item.HostOnly ||
+        mParallelItems[I - 1].HostOnly || Item.hasCopies() ||
+        mParallelItems[I - 1].hasCopies() ||
+        !isAdjacent(*mParallelItems[I - 1].AST, *Item.AST, ASTCtx)) {
+      Regions.emplace_back();
+      Regions.back().Begin = I;
+    }
+    auto &R = Regions.back();
+    R.End = I + 1;
+    R.In.insert(Item.In.begin(), Item.In.end());
+    R.Out.insert(Item.Out.begin(), Item.Out.end());
+    R.Local.insert(Item.Local.begin(), Item.Local.end());
+  }
+  // Hoist data transfers out of enclosing loops. A transfer of a variable
+  // can be moved before (after) a loop if host code in this loop does not
+  // access this variable. So, host and accelerator copies of the variable
+  // remain consistent inside the loop.
+  auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
+  DenseMap<const Stmt *, HostAccessInfo> HostAccesses;
+  auto findTransferPlace = [&LM, &HostAccesses, &DeviceLoops, &ASTCtx](
+      const DFNode &N, StringRef Var) -> const Stmt * {
+    const Stmt *Place = nullptr;
+    for (auto *P = N.getParent(); P && isa<DFLoop>(P); P = P->getParent()) {
+      auto LMatchItr = LM.find<IR>(cast<DFLoop>(P)->getLoop());
+      if (LMatchItr == LM.end())
+        break;
+      auto *S = LMatchItr->get<AST>();
+      auto Info = HostAccesses.try_emplace(S);
+      if (Info.second)
+        HostAccessVisitor(DeviceLoops, Info.first->second).TraverseStmt(S);
+      if (Info.first->second.Unknown || Info.first->second.Names.count(Var))
+        break;
+      // Directive must not become a body of an outer statement.
+      if (getParentCompound(*S, ASTCtx))
+        Place = S;
+    }
+    return Place;
+  };
+  MapVector<const Stmt *, std::pair<ClangDependenceAnalyzer::SortedVarListT,
+                                    ClangDependenceAnalyzer::SortedVarListT>>
+      Transfers;
+  for (auto &R : Regions) {
+    auto &Item = mParallelItems[R.Begin];
+    if (Item.HostOnly)
+      continue;
+    for (auto &Var : R.In)
+      if (auto *S = findTransferPlace(*Item.IR, Var))
+        Transfers[S].first.insert(Var);
+      else
+        R.Actual.insert(Var);
+    auto &LastItem = mParallelItems[R.End - 1];
+    for (auto &Var : R.Out)
+      if (auto *S = findTransferPlace(*LastItem.IR, Var))
+        Transfers[S].second.insert(Var);
+      else
+        R.GetActual.insert(Var);
+    for (auto &Var : R.In)
+      R.Local.erase(Var);
+    for (auto &Var : R.Out)
+      R.Local.erase(Var);
+  }
+  // Copies of first private, last private and reduction variables are
+  // declared in a block which contains a region. So, transfers of copies are
+  // not hoisted.
+  for (auto &R : Regions) {
+    auto &Item = mParallelItems[R.Begin];
+    if (Item.HostOnly)
+      continue;
+    for (auto &Copy : Item.CopyIn) {
+      R.In.insert(Copy.Name.str().str());
+      R.Actual.insert(Copy.Name.str().str());
+    }
+    // Copy of a last private variable keeps its initial value if the loop
+    // has no iterations, so it is transferred to the accelerator as well.
+    for (auto &Copy : Item.CopyOut) {
+      R.In.insert(Copy.Name.str().str());
+      R.Actual.insert(Copy.Name.str().str());
+      R.Out.insert(Copy.Name.str().str());
+      R.GetActual.insert(Copy.Name.str().str());
+    }
+    for (auto &Copy : Item.CopyReduction) {
+      R.In.insert(Copy.Name.str().str());
+      R.Actual.insert(Copy.Name.str().str());
+      R.Out.insert(Copy.Name.str().str());
+      R.GetActual.insert(Copy.Name.str().str());
+    }
+  }
+  // Add directives to the source code. Regions should be processed before
+  // hoisted transfers because the end of a region may coincide with the end
+  // of an enclosing loop.
+  auto &Rewriter = TfmCtx.getRewriter();
+  auto &PP = ASTCtx.getPrintingPolicy();
+  for (auto &R : Regions) {
+    auto &Item = mParallelItems[R.Begin];
+    SmallString<256> DVMHRegion;
+    if (Item.hasCopies()) {
+      DVMHRegion += "{\n";
+      for (auto &Copy : Item.CopyIn)
+        (Twine(Copy.Var->getType().getUnqualifiedType().getAsString(PP)) +
+         " " + Copy.Name + " = " + Copy.Var->getName() + ";\n")
+            .toVector(DVMHRegion);
+      // Copy of a last private variable is initialized with its original
+      // value because the variable is updated after the region even if
+      // the loop has no iterations.
+      for (auto &Copy : Item.CopyOut)
+        (Twine(Copy.Var->getType().getUnqualifiedType().getAsString(PP)) +
+         " " + Copy.Name + "[1] = {" + Copy.Var->getName() + "};\n")
+            .toVector(DVMHRegion);
+      // Reduction over an array also takes into account initial values of
+      // its elements, so elements are copied to a local array.
+      for (auto &Copy : Item.CopyReduction)
+        (Twine(Copy.Var->getType()->getPointeeType().getUnqualifiedType()
+                   .getAsString(PP)) +
+         " " + Copy.Name + "[" + Copy.Size + "];\n" +
+         "for (int " + Copy.Idx + " = 0; " + Copy.Idx + " < " + Copy.Size +
+         "; ++" + Copy.Idx + ")\n" + Copy.Name + "[" + Copy.Idx + "] = " +
+         Copy.Var->getName() + "[" + Copy.Idx + "];\n")
+            .toVector(DVMHRegion);
+    }
+    if (!R.Actual.empty()) {
+      DVMHRegion += "#pragma dvm actual";
+      addVarList(R.Actual, DVMHRegion);
+      DVMHRegion += '\n';
+    }
+    DVMHRegion += "#pragma dvm region";
+    if (Item.HostOnly) {
+      DVMHRegion += " targets(HOST)";
+    } else {
+      if (!R.In.empty()) {
+        DVMHRegion += " in";
+        addVarList(R.In, DVMHRegion);
+      }
+      if (!R.Out.empty()) {
+        DVMHRegion += " out";
+        addVarList(R.Out, DVMHRegion);
+      }
+      if (!R.Local.empty()) {
+        DVMHRegion += " local";
+        addVarList(R.Local, DVMHRegion);
+      }
+    }
+    DVMHRegion += "\n{\n";
+    DVMHRegion += Item.ParallelFor;
+    Rewriter.InsertTextBefore(Item.AST->getLocStart(), DVMHRegion);
+    for (unsigned I = R.Begin + 1; I < R.End; ++I)
+      Rewriter.InsertTextBefore(mParallelItems[I].AST->getLocStart(),
+                                mParallelItems[I].ParallelFor);
+    SmallString<128> DVMHGetActual("}");
+    if (!R.GetActual.empty()) {
+      DVMHGetActual += "\n#pragma dvm get_actual";
+      addVarList(R.GetActual, DVMHGetActual);
+      DVMHGetActual += '\n';
+    }
+    if (Item.hasCopies()) {
+      if (R.GetActual.empty())
+        DVMHGetActual += '\n';
+      for (auto &Copy : Item.CopyOut)
+        (Twine(Copy.Var->getName()) + " = " + Copy.Name + "[0];\n")
+            .toVector(DVMHGetActual);
+      for (auto &Copy : Item.CopyReduction)
+        (Twine("for (int ") + Copy.Idx + " = 0; " + Copy.Idx + " < " +
+         Copy.Size + "; ++" + Copy.Idx + ")\n" + Copy.Var->getName() + "[" +
+         Copy.Idx + "] = " + Copy.Name + "[" + Copy.Idx + "];\n")
+            .toVector(DVMHGetActual);
+      DVMHGetActual += '}';
+    }
+    Rewriter.InsertTextAfterToken(
+        getInsertLocAfter(*mParallelItems[R.End - 1].AST, ASTCtx),
+        DVMHGetActual);
+  }
+  for (auto &T : Transfers) {
+    if (!T.second.first.empty()) {
+      SmallString<128> DVMHActual("#pragma dvm actual");
+      addVarList(T.second.first, DVMHActual);
+      DVMHActual += '\n';
+      Rewriter.InsertTextBefore(T.first->getLocStart(), DVMHActual);
+    }
+    if (!T.second.second.empty()) {
+      SmallString<128> DVMHGetActual("\n#pragma dvm get_actual");
+      addVarList(T.second.second, DVMHGetActual);
+      DVMHGetActual += '\n';
+      Rewriter.InsertTextAfterToken(getInsertLocAfter(*T.first, ASTCtx),
+                                    DVMHGetActual);
+    }
+  }
+  mParallelItems.clear();
+}
+
 ModulePass *llvm::createClangDVMHSMParallelization() {
   return new ClangDVMHSMParallelization;
 }
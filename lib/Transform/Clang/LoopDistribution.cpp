@@ -0,0 +1,362 @@
+//===- LoopDistribution.cpp ------- Loop Distribution (Clang) ---*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass to distribute loops which can not be executed
+// in parallel as a whole. Statements of a loop body are split into strongly
+// connected components of a statement-level dependence graph and each
+// component is placed into a separate loop. So, loops without loop-carried
+// dependencies can be parallelized later, and recurrences remain sequential.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SharedMemoryAutoPar.h"
+#include "tsar/Analysis/Clang/ASTDependenceAnalysis.h"
+#include "tsar/Analysis/Clang/VariableCollector.h"
+#include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Analysis/Memory/MemoryTraitUtils.h"
+#include "tsar/Analysis/Passes.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
+#include "tsar/Support/Clang/Utils.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Transform/Clang/Passes.h"
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/CallSite.h>
+#include <llvm/IR/IntrinsicInst.h>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-loop-distribution"
+
+namespace {
+/// This pass distributes loops which can not be executed in parallel as
+/// a whole to separate parallel statements from sequential ones.
+class ClangLoopDistribution : public ClangSMParallelization {
+public:
+  static char ID;
+  ClangLoopDistribution() : ClangSMParallelization(ID) {
+    initializeClangLoopDistributionPass(*PassRegistry::getPassRegistry());
+  }
+private:
+  /// Loops which can be executed in parallel as a whole are not distributed,
+  /// however their inner loops are analyzed.
+  ///
+  /// Loops with loop-carried dependencies of a known distance are also
+  /// accepted by the parallel loop analysis (for example, they can be
+  /// pipelined), so try to distribute these loops.
+  bool exploitParallelism(const DFLoop &IR, const clang::ForStmt &AST,
+      const ClangSMParallelProvider &Provider,
+      tsar::ClangDependenceAnalyzer &ASTDepInfo,
+      TransformationContext &TfmCtx) override {
+    auto &DepInfo = ASTDepInfo.getDependenceInfo();
+    if (DepInfo.get<trait::Flow>().empty() &&
+        DepInfo.get<trait::Anti>().empty())
+      return false;
+    return exploitHiddenParallelism(IR, AST, Provider, ASTDepInfo, TfmCtx);
+  }
+
+  bool hasHiddenParallelism() const override { return true; }
+
+  /// Parallel loops are not transformed by this pass, so they are reported
+  /// by passes which parallelize them.
+  bool reportParallelLoops() const override { return false; }
+
+  bool exploitHiddenParallelism(const DFLoop &IR, const clang::ForStmt &AST,
+    const ClangSMParallelProvider &Provider,
+    tsar::ClangDependenceAnalyzer &ASTDepInfo,
+    TransformationContext &TfmCtx) override;
+};
+
+/// Constraints which accesses to the same memory impose on statements of
+/// a loop body.
+enum class AccessKind : uint8_t {
+  /// Accesses do not produce dependencies.
+  NoDependence = 0,
+  /// Accesses produce loop-independent dependencies only, so statements must
+  /// be executed in the original order.
+  Shared,
+  /// Statements must be placed in the same loop, however this loop can be
+  /// executed in parallel.
+  Private,
+  /// Statements must be placed in the same loop and this loop must be
+  /// executed sequentially.
+  Carried
+};
+
+/// Variables which are used to access memory with the same constraints.
+struct MemoryGroup {
+  AccessKind Kind;
+  SmallPtrSet<clang::VarDecl *, 2> Vars;
+};
+
+/// Return constraints which are imposed by accesses to memory with
+/// specified traits.
+AccessKind getAccessKind(const MemoryDescriptor &Dptr) {
+  if (Dptr.is_any<trait::NoAccess, trait::Readonly, trait::Induction>())
+    return AccessKind::NoDependence;
+  if (Dptr.is_any<trait::Flow, trait::Anti, trait::Output,
+                  trait::AddressAccess>())
+    return AccessKind::Carried;
+  if (Dptr.is<trait::DynamicPrivate>())
+    return Dptr.is<trait::Shared>() ? AccessKind::Private : AccessKind::Carried;
+  if (Dptr.is_any<trait::Private, trait::FirstPrivate, trait::LastPrivate,
+                  trait::SecondToLastPrivate, trait::Reduction>())
+    return AccessKind::Private;
+  return AccessKind::Shared;
+}
+
+/// Collect variables which are referenced in a statement.
+struct DeclRefCollector : public clang::RecursiveASTVisitor<DeclRefCollector> {
+  bool VisitDeclRefExpr(clang::DeclRefExpr *DRE) {
+    if (auto *VD = dyn_cast<clang::VarDecl>(DRE->getDecl()))
+      Refs.insert(VD->getCanonicalDecl());
+    return true;
+  }
+
+  SmallPtrSet<clang::VarDecl *, 8> Refs;
+};
+
+/// Return true if a specified statement may transfer control to a statement
+/// which is not nested in it.
+bool hasJump(const clang::Stmt &S) {
+  if (isa<clang::BreakStmt>(S) || isa<clang::ContinueStmt>(S) ||
+      isa<clang::ReturnStmt>(S) || isa<clang::GotoStmt>(S) ||
+      isa<clang::IndirectGotoStmt>(S) || isa<clang::LabelStmt>(S))
+    return true;
+  return llvm::any_of(S.children(),
+    [](const clang::Stmt *Child) { return Child && hasJump(*Child); });
+}
+
+/// Return true if a specified loop contains calls of functions which
+/// access memory. Memory accessed in these calls can not be attributed to
+/// statements of a loop body.
+bool hasMemoryCall(const Loop &L) {
+  for (auto *BB : L.getBlocks())
+    for (auto &I : *BB) {
+      CallSite CS(&I);
+      if (!CS)
+        continue;
+      auto Callee =
+          dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+      if (!Callee)
+        return true;
+      if (isa<IntrinsicInst>(I) &&
+          (isDbgInfoIntrinsic(Callee->getIntrinsicID()) ||
+           isMemoryMarkerIntrinsic(Callee->getIntrinsicID())))
+        continue;
+      if (!Callee->doesNotAccessMemory())
+        return true;
+    }
+  return false;
+}
+} // namespace
+
+bool ClangLoopDistribution::exploitHiddenParallelism(
+    const DFLoop &IR, const clang::ForStmt &AST,
+    const ClangSMParallelProvider &Provider,
+    tsar::ClangDependenceAnalyzer &ASTDepInfo,
+    TransformationContext &TfmCtx) {
+  auto *Body = dyn_cast<clang::CompoundStmt>(AST.getBody());
+  if (!Body || Body->size() < 2 || hasJump(*Body) ||
+      AST.getLocStart().isMacroID() || Body->getRBracLoc().isMacroID() ||
+      llvm::any_of(Body->body(), [](const clang::Stmt *S) {
+        return S->getLocStart().isMacroID() || S->getLocEnd().isMacroID();
+      }) ||
+      hasMemoryCall(*IR.getLoop()))
+    return false;
+  LLVM_DEBUG(dbgs() << "[LOOP DISTRIBUTION]: analyze loop at ";
+             AST.getLocStart().print(
+                 dbgs(), TfmCtx.getRewriter().getSourceMgr());
+             dbgs() << "\n");
+  // Map metadata-level traits to variables.
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  auto &DIDepSet = ASTDepInfo.getDependenceSet();
+  DenseSet<const DIAliasNode *> Coverage;
+  accessCoverage<bcl::SimpleInserter>(DIDepSet, ASTDepInfo.getAliasTree(),
+                                      Coverage, GO.IgnoreRedundantMemory);
+  VariableCollector ASTVars;
+  ASTVars.TraverseStmt(const_cast<clang::ForStmt *>(&AST));
+  SmallVector<MemoryGroup, 16> Groups;
+  for (auto &TS : DIDepSet) {
+    if (!Coverage.count(TS.getNode()))
+      continue;
+    MemoryGroup G{ getAccessKind(TS) };
+    bool HasUnattributed = false;
+    for (auto &T : TS) {
+      if (T->is<trait::Reduction>() && !T->get<trait::Reduction>())
+        G.Kind = AccessKind::Carried;
+      auto Search = ASTVars.findDecl(*T->getMemory(),
+        ASTDepInfo.getASTToClient(), ASTDepInfo.getDIMemoryMatcher());
+      // Only the induction variable of a canonical loop is updated in the
+      // loop header. Other induction variables are updated in statements of
+      // the loop body and produce loop-carried dependencies.
+      if (T->is<trait::Induction>() &&
+          (TS.size() > 1 || Search.second != VariableCollector::CoincideLocal ||
+           Search.first != ASTVars.Induction))
+        G.Kind = AccessKind::Carried;
+      if (Search.first && Search.second != VariableCollector::Implicit)
+        G.Vars.insert(Search.first->getCanonicalDecl());
+      else if (Search.second != VariableCollector::Unknown)
+        HasUnattributed = true;
+    }
+    // Memory which is not explicitly referenced in the loop body can not be
+    // attributed to statements.
+    if (HasUnattributed && G.Kind != AccessKind::NoDependence)
+      return false;
+    if (G.Kind != AccessKind::NoDependence && !G.Vars.empty())
+      Groups.push_back(std::move(G));
+  }
+  for (auto &VarRef : ASTVars.CanonicalRefs)
+    if (!ASTVars.CanonicalLocals.count(VarRef.first) &&
+        llvm::count(VarRef.second, nullptr)) {
+      LLVM_DEBUG(dbgs() << "[LOOP DISTRIBUTION]: variable "
+                        << VarRef.first->getName() << " is not analyzed\n");
+      return false;
+    }
+  // Build statement-level dependence graph, `Reach[I][J]` is set if the J-th
+  // statement must be executed after the I-th statement.
+  SmallVector<clang::Stmt *, 8> Stmts(Body->body_begin(), Body->body_end());
+  auto NumStmts = Stmts.size();
+  std::vector<DeclRefCollector> Refs(NumStmts);
+  for (unsigned I = 0; I < NumStmts; ++I)
+    Refs[I].TraverseStmt(Stmts[I]);
+  std::vector<BitVector> Reach(NumStmts, BitVector(NumStmts));
+  BitVector Sequential(NumStmts);
+  for (auto &G : Groups) {
+    SmallVector<unsigned, 8> Users;
+    for (unsigned I = 0; I < NumStmts; ++I)
+      if (llvm::any_of(G.Vars,
+            [&Refs, I](clang::VarDecl *VD) { return Refs[I].Refs.count(VD); }))
+        Users.push_back(I);
+    for (auto I : Users) {
+      if (G.Kind == AccessKind::Carried)
+        Sequential.set(I);
+      for (auto J : Users)
+        if (I < J || (I > J && G.Kind != AccessKind::Shared))
+          Reach[I].set(J);
+    }
+  }
+  // Variables declared in a loop body must be visible in all statements which
+  // use them.
+  for (unsigned I = 0; I < NumStmts; ++I)
+    if (auto *DS = dyn_cast<clang::DeclStmt>(Stmts[I]))
+      for (auto *D : DS->decls()) {
+        auto *VD = dyn_cast<clang::VarDecl>(D);
+        if (!VD)
+          return false;
+        for (unsigned J = I + 1; J < NumStmts; ++J)
+          if (Refs[J].Refs.count(VD->getCanonicalDecl())) {
+            Reach[I].set(J);
+            Reach[J].set(I);
+          }
+      }
+  for (unsigned K = 0; K < NumStmts; ++K)
+    for (unsigned I = 0; I < NumStmts; ++I)
+      if (Reach[I].test(K))
+        Reach[I] |= Reach[K];
+  // Collect strongly connected components, each component is ordered
+  // by positions of statements in the original loop body.
+  SmallVector<SmallVector<unsigned, 4>, 8> Components;
+  SmallVector<bool, 8> IsParallel;
+  BitVector Visited(NumStmts);
+  for (unsigned I = 0; I < NumStmts; ++I) {
+    if (Visited.test(I))
+      continue;
+    Components.emplace_back();
+    IsParallel.push_back(true);
+    for (unsigned J = I; J < NumStmts; ++J)
+      if (J == I || (Reach[I].test(J) && Reach[J].test(I))) {
+        Visited.set(J);
+        Components.back().push_back(J);
+        if (Sequential.test(J))
+          IsParallel.back() = false;
+      }
+  }
+  auto NumParallel = llvm::count(IsParallel, true);
+  if (Components.size() < 2 || NumParallel == 0 ||
+      NumParallel == static_cast<long>(Components.size())) {
+    LLVM_DEBUG(dbgs() << "[LOOP DISTRIBUTION]: distribution does not expose "
+                         "parallelism\n");
+    return false;
+  }
+  // Order components topologically, the original order is preserved
+  // if possible.
+  SmallVector<unsigned, 8> Order;
+  BitVector Placed(Components.size());
+  while (Order.size() < Components.size())
+    for (unsigned C = 0, CE = Components.size(); C < CE; ++C) {
+      if (Placed.test(C))
+        continue;
+      bool IsReady = true;
+      for (unsigned D = 0; D < CE && IsReady; ++D)
+        IsReady = D == C || Placed.test(D) ||
+          !Reach[Components[D].front()].test(Components[C].front());
+      if (IsReady) {
+        Order.push_back(C);
+        Placed.set(C);
+        break;
+      }
+    }
+  auto &Rewriter = TfmCtx.getRewriter();
+  auto &SrcMgr = Rewriter.getSourceMgr();
+  auto &LangOpts = Rewriter.getLangOpts();
+  auto Header = Rewriter.getRewrittenText(
+    clang::SourceRange(AST.getLocStart(), AST.getRParenLoc()));
+  std::string NewLoops;
+  for (auto C : Order) {
+    NewLoops += Header;
+    NewLoops += " {\n";
+    for (auto I : Components[C]) {
+      auto *S = Stmts[I];
+      clang::SourceLocation End = S->getLocEnd();
+      clang::Token SemiTok;
+      if (!getRawTokenAfter(End, SrcMgr, LangOpts, SemiTok) &&
+          SemiTok.is(clang::tok::semi))
+        End = SemiTok.getLocation();
+      NewLoops +=
+          Rewriter.getRewrittenText(clang::SourceRange(S->getLocStart(), End));
+      NewLoops += '\n';
+    }
+    NewLoops += "}\n";
+  }
+  NewLoops.pop_back();
+  Rewriter.ReplaceText(
+      clang::SourceRange(AST.getLocStart(), Body->getRBracLoc()), NewLoops);
+  toDiag(SrcMgr.getDiagnostics(), AST.getLocStart(),
+         clang::diag::remark_distribution)
+      << static_cast<unsigned>(Components.size())
+      << static_cast<unsigned>(NumParallel);
+  return true;
+}
+
+ModulePass *llvm::createClangLoopDistribution() {
+  return new ClangLoopDistribution;
+}
+
+char ClangLoopDistribution::ID = 0;
+INITIALIZE_SHARED_PARALLELIZATION(ClangLoopDistribution,
+                                  "clang-loop-distribution",
+                                  "Loop Distribution (Clang)")
@@ -28,6 +28,7 @@
 #include "tsar/Analysis/Parallel/Passes.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
 #include "tsar/Transform/Clang/Passes.h"
 
 using namespace llvm;
@@ -94,14 +95,33 @@ struct ClausePrinter {
       default: llvm_unreachable("Unknown reduction kind!"); break;
       }
       auto VarItr = VarInfoList[I].begin(), VarItrE = VarInfoList[I].end();
-      ParallelFor += *VarItr;
-      for (++VarItr; VarItr != VarItrE; ++VarItr)
-        ParallelFor += ", " + *VarItr;
+      addReductionItem(*VarItr);
+      for (++VarItr; VarItr != VarItrE; ++VarItr) {
+        ParallelFor += ", ";
+        addReductionItem(*VarItr);
+      }
       ParallelFor += ')';
     }
   }
 
+  /// Loop-carried dependencies can not be described in OpenMP clauses.
+  template <class Trait> void operator()(
+      const ClangDependenceAnalyzer::DistanceVarListT &) {}
+
+  /// Add a variable or an array section (if the whole array is accessed
+  /// through a pointer) to a list of reduction items.
+  void addReductionItem(const std::string &Name) {
+    ParallelFor += Name;
+    auto SectionItr = Sections.find(Name);
+    if (SectionItr != Sections.end()) {
+      ParallelFor += "[0:";
+      ParallelFor += SectionItr->second;
+      ParallelFor += ']';
+    }
+  }
+
   SmallString<128> &ParallelFor;
+  const ClangDependenceAnalyzer::ArraySectionListT &Sections;
 };
 } // namespace
 
@@ -111,8 +131,18 @@ bool ClangOpenMPParallelization::exploitParallelism(
     const ClangSMParallelProvider &Provider,
     tsar::ClangDependenceAnalyzer &ASTDepInfo,
     TransformationContext &TfmCtx) {
+  auto &DepInfo = ASTDepInfo.getDependenceInfo();
+  if (!DepInfo.get<trait::Flow>().empty() ||
+      !DepInfo.get<trait::Anti>().empty()) {
+    auto &Diags = TfmCtx.getContext().getDiagnostics();
+    toDiag(Diags, AST.getLocStart(), clang::diag::warn_parallel_loop);
+    toDiag(Diags, AST.getLocStart(),
+           clang::diag::note_parallel_dependence_unable);
+    return false;
+  }
   SmallString<128> ParallelFor("#pragma omp parallel for default(shared)");
-  bcl::for_each(ASTDepInfo.getDependenceInfo(), ClausePrinter{ParallelFor});
+  bcl::for_each(ASTDepInfo.getDependenceInfo(),
+                ClausePrinter{ParallelFor, ASTDepInfo.getArraySections()});
   ParallelFor += '\n';
   auto &Rewriter = TfmCtx.getRewriter();
   Rewriter.InsertTextBefore(AST.getLocStart(), ParallelFor);
@@ -0,0 +1,227 @@
+//===- OpenMPSimd.cpp ----- OpenMP Based Vectorization (Clang) --*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass to insert OpenMP simd directives before
+// innermost loops which could be vectorized. Each innermost loop is reported
+// as vectorizable, vectorizable with a safe length or not vectorizable with
+// a reason which prevents vectorization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SharedMemoryAutoPar.h"
+#include "tsar/Analysis/Clang/ASTDependenceAnalysis.h"
+#include "tsar/Analysis/Clang/LoopMatcher.h"
+#include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/Passes.h"
+#include "tsar/Analysis/Parallel/Passes.h"
+#include "tsar/Analysis/Parallel/SIMDLoop.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
+#include "tsar/Support/IRUtils.h"
+#include "tsar/Transform/Clang/Passes.h"
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/LoopInfo.h>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-openmp-simd"
+
+namespace {
+/// This pass try to insert OpenMP simd directives into a source code to
+/// help compilers to vectorize innermost loops.
+class ClangOpenMPSimd : public ClangSMParallelization {
+public:
+  static char ID;
+  ClangOpenMPSimd() : ClangSMParallelization(ID) {
+    initializeClangOpenMPSimdPass(*PassRegistry::getPassRegistry());
+  }
+private:
+  bool exploitParallelism(const DFLoop &IR, const clang::ForStmt &AST,
+    const ClangSMParallelProvider &Provider,
+    tsar::ClangDependenceAnalyzer &ASTDepInfo,
+    TransformationContext &TfmCtx) override;
+
+  /// Report innermost loops which have not been visited.
+  void optimizeFunction(Function &F, ClangSMParallelProvider &Provider,
+                        TransformationContext &TfmCtx) override;
+
+  /// Innermost loops which have been already reported in a current function.
+  SmallPtrSet<const Loop *, 16> mVisitedLoops;
+};
+
+struct SimdClausePrinter {
+  /// Add clause for a `Trait` with variable names from a specified list to
+  /// the end of `Simd` pragma.
+  ///
+  /// Only private and last private variables can be described in a simd
+  /// directive, first private variables are checked before.
+  template <class Trait> void operator()(
+      const ClangDependenceAnalyzer::SortedVarListT &VarInfoList) {
+    if (VarInfoList.empty() ||
+        !std::is_same<Trait, trait::Private>::value &&
+        !std::is_same<Trait, trait::LastPrivate>::value)
+      return;
+    std::string Clause = Trait::tag::toString();
+    Clause.erase(
+        std::remove_if(Clause.begin(), Clause.end(), bcl::isWhitespace),
+        Clause.end());
+    Simd += ' ';
+    Simd += Clause;
+    Simd += '(';
+    auto I = VarInfoList.begin(), EI = VarInfoList.end();
+    Simd += *I;
+    for (++I; I != EI; ++I)
+      Simd += ", " + *I;
+    Simd += ')';
+  }
+
+  /// Add clauses for all reduction variables from a specified list to
+  /// the end of `Simd` pragma.
+  template <class Trait> void operator()(
+      const ClangDependenceAnalyzer::ReductionVarListT &VarInfoList) {
+    unsigned I = trait::Reduction::RK_First;
+    unsigned EI = trait::Reduction::RK_NumberOf;
+    for (; I < EI; ++I) {
+      if (VarInfoList[I].empty())
+        continue;
+      Simd += " reduction(";
+      switch (static_cast<trait::Reduction::Kind>(I)) {
+      case trait::Reduction::RK_Add: Simd += "+:"; break;
+      case trait::Reduction::RK_Mult: Simd += "*:"; break;
+      case trait::Reduction::RK_Or: Simd += "|:"; break;
+      case trait::Reduction::RK_And: Simd += "&:"; break;
+      case trait::Reduction::RK_Xor: Simd += "^:"; break;
+      case trait::Reduction::RK_Max: Simd += "max:"; break;
+      case trait::Reduction::RK_Min: Simd += "min:"; break;
+      default: llvm_unreachable("Unknown reduction kind!"); break;
+      }
+      auto VarItr = VarInfoList[I].begin(), VarItrE = VarInfoList[I].end();
+      addReductionItem(*VarItr);
+      for (++VarItr; VarItr != VarItrE; ++VarItr) {
+        Simd += ", ";
+        addReductionItem(*VarItr);
+      }
+      Simd += ')';
+    }
+  }
+
+  /// Loop-carried dependencies are described in a safelen clause.
+  template <class Trait> void operator()(
+      const ClangDependenceAnalyzer::DistanceVarListT &) {}
+
+  /// Add a variable or an array section (if the whole array is accessed
+  /// through a pointer) to a list of reduction items.
+  void addReductionItem(const std::string &Name) {
+    Simd += Name;
+    auto SectionItr = Sections.find(Name);
+    if (SectionItr != Sections.end()) {
+      Simd += "[0:";
+      Simd += SectionItr->second;
+      Simd += ']';
+    }
+  }
+
+  SmallString<128> &Simd;
+  const ClangDependenceAnalyzer::ArraySectionListT &Sections;
+};
+} // namespace
+
+bool ClangOpenMPSimd::exploitParallelism(
+    const DFLoop &IR, const clang::ForStmt &AST,
+    const ClangSMParallelProvider &Provider,
+    tsar::ClangDependenceAnalyzer &ASTDepInfo,
+    TransformationContext &TfmCtx) {
+  auto *L = IR.getLoop();
+  if (!L->empty())
+    return false;
+  mVisitedLoops.insert(L);
+  auto &Diags = TfmCtx.getContext().getDiagnostics();
+  auto &SL = Provider.get<SIMDLoopPass>().getSIMDLoopInfo();
+  auto SIMDItr = SL.find(L);
+  if (SIMDItr == SL.end() || !SIMDItr->second.isVectorizable()) {
+    toDiag(Diags, AST.getLocStart(), clang::diag::warn_simd_loop);
+    if (SIMDItr != SL.end())
+      toDiag(Diags, AST.getLocStart(), clang::diag::note_simd_unable)
+          << SIMDItr->second.getReasonDescription();
+    return false;
+  }
+  auto &DepInfo = ASTDepInfo.getDependenceInfo();
+  if (!DepInfo.get<trait::FirstPrivate>().empty()) {
+    toDiag(Diags, AST.getLocStart(), clang::diag::warn_simd_loop);
+    for (auto &Name : DepInfo.get<trait::FirstPrivate>())
+      toDiag(Diags, AST.getLocStart(),
+             clang::diag::note_simd_first_private_unable)
+          << Name;
+    return false;
+  }
+  SmallString<128> Simd("#pragma omp simd");
+  if (SIMDItr->second.hasSafeLength()) {
+    Simd += " safelen(";
+    Twine(SIMDItr->second.getSafeLength()).toVector(Simd);
+    Simd += ')';
+    toDiag(Diags, AST.getLocStart(), clang::diag::remark_simd_loop_safelen)
+        << SIMDItr->second.getSafeLength();
+  } else {
+    toDiag(Diags, AST.getLocStart(), clang::diag::remark_simd_loop);
+  }
+  bcl::for_each(DepInfo,
+                SimdClausePrinter{Simd, ASTDepInfo.getArraySections()});
+  Simd += '\n';
+  auto &Rewriter = TfmCtx.getRewriter();
+  Rewriter.InsertTextBefore(AST.getLocStart(), Simd);
+  return true;
+}
+
+void ClangOpenMPSimd::optimizeFunction(Function &F,
+    ClangSMParallelProvider &Provider, TransformationContext &TfmCtx) {
+  auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
+  auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
+  auto &SL = Provider.get<SIMDLoopPass>().getSIMDLoopInfo();
+  auto &Diags = TfmCtx.getContext().getDiagnostics();
+  // Loops which are vectorizable but have not been visited are not in
+  // canonical form or their variables can not be described at the source
+  // level. These loops have been already diagnosed.
+  for_each_loop(LI, [this, &LM, &SL, &Diags](Loop *L) {
+    if (!L->empty() || mVisitedLoops.count(L))
+      return;
+    auto SIMDItr = SL.find(L);
+    if (SIMDItr == SL.end() || SIMDItr->second.isVectorizable())
+      return;
+    auto LMatchItr = LM.find<IR>(L);
+    if (LMatchItr == LM.end())
+      return;
+    auto Loc = LMatchItr->get<AST>()->getLocStart();
+    toDiag(Diags, Loc, clang::diag::warn_simd_loop);
+    toDiag(Diags, Loc, clang::diag::note_simd_unable)
+        << SIMDItr->second.getReasonDescription();
+  });
+  mVisitedLoops.clear();
+}
+
+ModulePass *llvm::createClangOpenMPSimd() {
+  return new ClangOpenMPSimd;
+}
+
+char ClangOpenMPSimd::ID = 0;
+INITIALIZE_SHARED_PARALLELIZATION(ClangOpenMPSimd, "clang-openmp-simd",
+                                  "OpenMP Based Vectorization (Clang)")
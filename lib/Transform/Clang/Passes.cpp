@@ -34,5 +34,8 @@ void llvm::initializeClangTransform(PassRegistry &Registry) {
   initializeClangRenameLocalPassPass(Registry);
   initializeClangDeadDeclsEliminationPass(Registry);
   initializeClangOpenMPParallelizationPass(Registry);
+  initializeClangOpenMPSimdPass(Registry);
+  initializeClangLoopDistributionPass(Registry);
+  initializeClangStructToArraysPass(Registry);
   initializeClangDVMHSMParallelizationPass(Registry);
 }
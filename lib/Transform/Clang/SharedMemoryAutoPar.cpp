@@ -39,7 +39,9 @@
 #include "tsar/Analysis/Memory/DIMemoryTrait.h"
 #include "tsar/Analysis/Memory/MemoryTraitUtils.h"
 #include "tsar/Analysis/Memory/Passes.h"
+#include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Analysis/Parallel/ParallelLoop.h"
+#include "tsar/Analysis/Parallel/SIMDLoop.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
 #include "tsar/Support/Clang/Diagnostic.h"
@@ -53,6 +55,9 @@
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Operator.h>
 #include <llvm/IR/Verifier.h>
 #include <algorithm>
 
@@ -62,6 +67,89 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "clang-shared-parallel"
 
+namespace {
+/// Return true if a reduction is performed on memory which is accessed
+/// through a pointer, for example <*H,?>.
+bool hasDerivedReduction(DIDependenceSet &DIDepSet) {
+  for (auto &TS : DIDepSet) {
+    if (!TS.is<trait::Reduction>())
+      continue;
+    for (auto &T : TS)
+      if (auto *DIEM = dyn_cast<DIEstimateMemory>(T->getMemory()))
+        if (llvm::count(DIEM->getExpression()->getElements(),
+                        dwarf::DW_OP_deref))
+          return true;
+  }
+  return false;
+}
+
+/// Compute number of elements of arrays which are accessed through pointers
+/// in a specified loop.
+///
+/// All accesses to an array in the loop must have a single subscript in
+/// a known non-negative range, for example `H[I[J]]` where `I` is an array
+/// of unsigned char.
+void collectArrayExtents(const Loop &L, ClangSMParallelProvider &Provider,
+    ClangDependenceAnalyzer::ArrayExtentMap &Extents) {
+  auto &SE = Provider.get<ScalarEvolutionWrapperPass>().getSE();
+  auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
+  auto &ASTToClient = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
+  // Number of elements accessed through each base pointer, zero means that
+  // some of accesses can not be analyzed.
+  DenseMap<Value *, uint64_t> BaseExtents;
+  for (auto *BB : L.blocks())
+    for (auto &I : *BB) {
+      Value *Ptr = nullptr;
+      if (auto *LI = dyn_cast<LoadInst>(&I))
+        Ptr = LI->getPointerOperand();
+      else if (auto *SI = dyn_cast<StoreInst>(&I))
+        Ptr = SI->getPointerOperand();
+      auto *GEP = Ptr ? dyn_cast<GEPOperator>(Ptr) : nullptr;
+      if (!GEP)
+        continue;
+      auto *Base = GEP->getPointerOperand();
+      // Offsets are not known if a base pointer is computed in the loop.
+      auto *Stripped = Base->stripPointerCasts();
+      while (auto *BaseGEP = dyn_cast<GEPOperator>(Stripped))
+        Stripped = BaseGEP->getPointerOperand()->stripPointerCasts();
+      if (Stripped != Base) {
+        BaseExtents[Stripped] = 0;
+        continue;
+      }
+      auto &Extent = BaseExtents.try_emplace(Base, 1).first->second;
+      if (Extent == 0)
+        continue;
+      if (GEP->getNumIndices() != 1) {
+        Extent = 0;
+        continue;
+      }
+      auto Range = SE.getSignedRange(SE.getSCEV(*GEP->idx_begin()));
+      if (Range.isFullSet() || Range.getSignedMin().isNegative() ||
+          Range.getSignedMax().getActiveBits() >= 64) {
+        Extent = 0;
+        continue;
+      }
+      Extent = std::max(Extent, Range.getSignedMax().getZExtValue() + 1);
+    }
+  for (auto &BaseExtent : BaseExtents) {
+    if (BaseExtent.second == 0)
+      continue;
+    SmallVector<DIMemoryLocation, 1> DILocs;
+    auto DILoc = findMetadata(BaseExtent.first, DILocs, &DT,
+                              MDSearch::ValueOfVariable);
+    if (!DILoc || DILoc->Expr->getNumElements() != 0)
+      continue;
+    auto MatchItr = ASTToClient.find<MD>(DILoc->Var);
+    if (MatchItr == ASTToClient.end())
+      continue;
+    LLVM_DEBUG(dbgs() << "[SHARED PARALLEL]: array accessed through '"
+                      << MatchItr->get<AST>()->getName() << "' has "
+                      << BaseExtent.second << " elements\n");
+    Extents.try_emplace(MatchItr->get<AST>(), BaseExtent.second);
+  }
+}
+}
+
 void ClangSMParallelizationInfo::addBeforePass(
     legacy::PassManager &Passes) const {
   addImmutableAliasAnalysis(Passes);
@@ -94,32 +182,46 @@ bool ClangSMParallelization::findParallelLoops(
   auto &LM = Provider.get<LoopMatcherPass>().getMatcher();
   auto &SrcMgr = mTfmCtx->getRewriter().getSourceMgr();
   auto &Diags = SrcMgr.getDiagnostics();
-  if (!PL.count(&L))
-    return findParallelLoops(L.begin(), L.end(), F, Provider);
   auto LMatchItr = LM.find<IR>(&L);
-  if (LMatchItr != LM.end())
+  bool IsParallel = PL.count(&L);
+  if (!IsParallel && (LMatchItr == LM.end() || !hasHiddenParallelism()))
+    return findParallelLoops(L.begin(), L.end(), F, Provider);
+  if (IsParallel && LMatchItr != LM.end() && reportParallelLoops())
     toDiag(Diags, LMatchItr->get<AST>()->getLocStart(),
            clang::diag::remark_parallel_loop);
   auto DFL = cast<DFLoop>(RI.getRegionFor(&L));
   auto CanonicalItr = CL.find_as(DFL);
   if (CanonicalItr == CL.end() || !(**CanonicalItr).isCanonical()) {
-    toDiag(Diags, LMatchItr->get<AST>()->getLocStart(),
-           clang::diag::warn_parallel_not_canonical);
+    if (IsParallel && reportParallelLoops())
+      toDiag(Diags, LMatchItr->get<AST>()->getLocStart(),
+             clang::diag::warn_parallel_not_canonical);
     return findParallelLoops(L.begin(), L.end(), F, Provider);
   }
   auto &Socket = mSocketInfo->getActive()->second;
   auto RF =
       Socket.getAnalysis<DIEstimateMemoryPass, DIDependencyAnalysisPass>(F);
-  assert(RF && "Dependence analysis must be available for a parallel loop!");
+  assert((RF || !IsParallel) &&
+         "Dependence analysis must be available for a parallel loop!");
+  if (!RF)
+    return findParallelLoops(L.begin(), L.end(), F, Provider);
   auto &DIAT = RF->value<DIEstimateMemoryPass *>()->getAliasTree();
   auto &DIDepInfo = RF->value<DIDependencyAnalysisPass *>()->getDependencies();
   auto RM = Socket.getAnalysis<AnalysisClientServerMatcherWrapper,
                                  ClonedDIMemoryMatcherWrapper>();
   assert(RM && "Client to server IR-matcher must be available!");
   auto &ClientToServer = **RM->value<AnalysisClientServerMatcherWrapper *>();
-  assert(L.getLoopID() && "ID must be available for a parallel loop!");
-  auto ServerLoopID = cast<MDNode>(*ClientToServer.getMappedMD(L.getLoopID()));
-  auto DIDepSet = DIDepInfo[ServerLoopID];
+  assert((L.getLoopID() || !IsParallel) &&
+         "ID must be available for a parallel loop!");
+  auto ServerLoopID =
+      L.getLoopID() ? ClientToServer.getMappedMD(L.getLoopID()) : None;
+  auto DIDepItr = ServerLoopID ? DIDepInfo.find(cast<MDNode>(*ServerLoopID))
+                               : DIDepInfo.end();
+  if (DIDepItr == DIDepInfo.end()) {
+    assert(!IsParallel &&
+           "Dependence analysis must be available for a parallel loop!");
+    return findParallelLoops(L.begin(), L.end(), F, Provider);
+  }
+  auto DIDepSet = DIDepItr->get<DIDependenceSet>();
   auto *ServerF = cast<Function>(ClientToServer[&F]);
   auto *DIMemoryMatcher =
       (**RM->value<ClonedDIMemoryMatcherWrapper *>())[*ServerF];
@@ -129,6 +231,19 @@ bool ClangSMParallelization::findParallelLoops(
   assert(ForStmt && "Source-level representation of a loop must be available!");
   ClangDependenceAnalyzer RegionAnalysis(const_cast<clang::ForStmt *>(ForStmt),
     *mGlobalOpts, Diags, DIAT, DIDepSet, *DIMemoryMatcher, ASTToClient);
+  // Extents are necessary to describe reductions over arrays which are
+  // accessed through pointers only.
+  if (hasDerivedReduction(DIDepSet)) {
+    ClangDependenceAnalyzer::ArrayExtentMap Extents;
+    collectArrayExtents(L, Provider, Extents);
+    RegionAnalysis.setArrayExtents(std::move(Extents));
+  }
+  if (!IsParallel) {
+    if (exploitHiddenParallelism(*DFL, *ForStmt, Provider, RegionAnalysis,
+                                 *mTfmCtx))
+      return true;
+    return findParallelLoops(L.begin(), L.end(), F, Provider);
+  }
   if (!RegionAnalysis.evaluateDependency())
     return findParallelLoops(L.begin(), L.end(), F, Provider);
   if (!exploitParallelism(*DFL, *ForStmt, Provider, RegionAnalysis, *mTfmCtx))
@@ -270,6 +385,7 @@ bool ClangSMParallelization::runOnModule(Module &M) {
     auto &Provider = getAnalysis<ClangSMParallelProvider>(*F);
     auto &LI = Provider.get<LoopInfoWrapperPass>().getLoopInfo();
     findParallelLoops(LI.begin(), LI.end(), *F, Provider);
+    optimizeFunction(*F, Provider, *mTfmCtx);
   }
   return false;
 }
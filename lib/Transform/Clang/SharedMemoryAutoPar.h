@@ -60,16 +60,21 @@ class CanonicalLoopPass;
 class ClangPerfectLoopPass;
 class ClangDIMemoryMatcherPass;
 class DFRegionInfoPass;
+class DominatorTreeWrapperPass;
 class LoopMatcherPass;
 class LoopInfoWrapperPass;
 class ParallelLoopPass;
+class ScalarEvolutionWrapperPass;
+class SIMDLoopPass;
 
 /// This provider access to function-level analysis results on client.
 using ClangSMParallelProvider =
     FunctionPassAAProvider<AnalysisSocketImmutableWrapper, LoopInfoWrapperPass,
-                           ParallelLoopPass, CanonicalLoopPass, LoopMatcherPass,
-                           DFRegionInfoPass, ClangDIMemoryMatcherPass,
-                           ClangPerfectLoopPass>;
+                           ParallelLoopPass, SIMDLoopPass, CanonicalLoopPass,
+                           LoopMatcherPass, DFRegionInfoPass,
+                           ClangDIMemoryMatcherPass, ClangPerfectLoopPass,
+                           DominatorTreeWrapperPass,
+                           ScalarEvolutionWrapperPass>;
 
 /// This pass try to insert directives into a source code to obtain
 /// a parallel program for a shared memory.
@@ -120,9 +125,39 @@ protected:
     tsar::ClangDependenceAnalyzer &ASTDepInfo,
     tsar::TransformationContext &TfmCtx) = 0;
 
+  /// Exploit parallelism hidden in a loop which can not be executed in
+  /// parallel as a whole.
+  ///
+  /// This function is called for loops in a canonical form only if
+  /// hasHiddenParallelism() returns true. Note, that dependencies have not
+  /// been evaluated in `ASTDepInfo` yet.
+  /// \return true if a specified loop has been transformed and inner loops
+  /// should not be processed.
+  virtual bool exploitHiddenParallelism(const tsar::DFLoop &IR,
+      const clang::ForStmt &AST, const ClangSMParallelProvider &Provider,
+      tsar::ClangDependenceAnalyzer &ASTDepInfo,
+      tsar::TransformationContext &TfmCtx) {
+    return false;
+  }
+
+  /// Return true if exploitHiddenParallelism() is implemented, otherwise
+  /// loops which can not be executed in parallel as a whole are not analyzed.
+  virtual bool hasHiddenParallelism() const { return false; }
+
+  /// Return true if diagnostics about loops which can be executed in parallel
+  /// as a whole should be emitted.
+  virtual bool reportParallelLoops() const { return true; }
+
   /// Perform optimization of parallel loops with a common parent.
   virtual void optimizeLevel(tsar::TransformationContext &TfmCtx) { }
 
+  /// Perform optimization of all parallel loops in a specified function.
+  ///
+  /// This function is called after all loops in the function have been
+  /// processed.
+  virtual void optimizeFunction(Function &F, ClangSMParallelProvider &Provider,
+                                tsar::TransformationContext &TfmCtx) {}
+
 private:
   /// Initialize provider before on the fly passes will be run on client.
   void initializeProviderOnClient(Module &M);
@@ -182,8 +217,10 @@ class ClangSMParallelizationInfo final : public tsar::PassGroupInfo {
   INITIALIZE_PASS_DEPENDENCY(DIMemoryTraitPoolWrapper)                         \
   INITIALIZE_PASS_DEPENDENCY(ClonedDIMemoryMatcherWrapper)                     \
   INITIALIZE_PASS_DEPENDENCY(ParallelLoopPass)                                 \
+  INITIALIZE_PASS_DEPENDENCY(SIMDLoopPass)                                     \
   INITIALIZE_PASS_DEPENDENCY(CanonicalLoopPass)                                \
   INITIALIZE_PASS_DEPENDENCY(ClangRegionCollector)                             \
+  INITIALIZE_PASS_DEPENDENCY(ClangGlobalInfoPass)                              \
   INITIALIZE_PASS_DEPENDENCY(DIMemoryEnvironmentWrapper)                       \
   INITIALIZE_PASS_IN_GROUP_END(passName, arg, name, false, false,              \
                                TransformationQueryManager::getPassRegistry())
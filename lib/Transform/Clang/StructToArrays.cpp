@@ -0,0 +1,349 @@
+//===- StructToArrays.cpp - Array of Structures to Structure of Arrays --*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass which converts arrays of structures proposed
+// by the structure layout advisor to structures of arrays. Only arrays which
+// are not visible outside a translation unit are converted, each field of
+// a structure produces a separate array and each access 'A[I].F' is replaced
+// with 'A_F[I]'.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Clang/DIMemoryMatcher.h"
+#include "tsar/Analysis/Clang/GlobalInfoExtractor.h"
+#include "tsar/Analysis/Memory/Passes.h"
+#include "tsar/Analysis/Memory/StructLayoutAdvisor.h"
+#include "tsar/Core/Query.h"
+#include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/Clang/Diagnostic.h"
+#include "tsar/Support/PassProvider.h"
+#include "tsar/Support/Tags.h"
+#include "tsar/Transform/Clang/Passes.h"
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Rewrite/Core/Rewriter.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Transforms/Scalar.h>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-aos-to-soa"
+
+namespace {
+/// This pass converts arrays of structures to structures of arrays.
+class ClangStructToArrays : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ClangStructToArrays() : ModulePass(ID) {
+    initializeClangStructToArraysPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+private:
+  /// Check that a specified array can be converted, emit diagnostics and
+  /// return `false` otherwise.
+  bool checkDecl(const VarDecl &VD);
+
+  /// Convert a specified array if all its accesses select a field of
+  /// a structure.
+  void convert(VarDecl &VD, StringSet<> &Identifiers);
+
+  TransformationContext *mTfmCtx = nullptr;
+};
+
+using ClangStructToArraysProvider = FunctionPassProvider<
+  TransformationEnginePass,
+  MemoryMatcherImmutableWrapper,
+  ClangDIMemoryMatcherPass>;
+
+/// This visitor collects accesses 'A[I].F' to a specified array 'A'.
+///
+/// If 'A' is used in some other way the traversal is terminated and the
+/// unsupported use is remembered.
+class AoSAccessVisitor : public RecursiveASTVisitor<AoSAccessVisitor> {
+public:
+  explicit AoSAccessVisitor(const VarDecl &VD) : mVD(&VD) {}
+
+  bool TraverseMemberExpr(MemberExpr *ME) {
+    if (!ME->isArrow())
+      if (auto *ASE = dyn_cast<ArraySubscriptExpr>(ME->getBase()->IgnoreParens()))
+        if (auto *DRE =
+                dyn_cast<DeclRefExpr>(ASE->getBase()->IgnoreParenImpCasts()))
+          if (DRE->getDecl()->getCanonicalDecl() == mVD) {
+            mAccesses.emplace_back(ME, DRE);
+            return TraverseStmt(ASE->getIdx());
+          }
+    return RecursiveASTVisitor::TraverseMemberExpr(ME);
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *DRE) {
+    if (DRE->getDecl()->getCanonicalDecl() != mVD)
+      return true;
+    mUnsupported = DRE;
+    return false;
+  }
+
+  /// Return list of collected accesses and references to the array in them.
+  ArrayRef<std::pair<MemberExpr *, DeclRefExpr *>> getAccesses() const {
+    return mAccesses;
+  }
+
+  /// Return reference to the array which does not select a field of
+  /// a structure or `nullptr`.
+  const DeclRefExpr * getUnsupported() const noexcept { return mUnsupported; }
+
+private:
+  const VarDecl *mVD;
+  SmallVector<std::pair<MemberExpr *, DeclRefExpr *>, 16> mAccesses;
+  const DeclRefExpr *mUnsupported = nullptr;
+};
+
+/// Return `true` if a specified type can be a type of a structure field
+/// which is converted to a separate array.
+bool isSupportedFieldType(QualType Ty) {
+  while (auto *ArrayTy = dyn_cast<ConstantArrayType>(Ty.getCanonicalType()))
+    Ty = ArrayTy->getElementType();
+  return Ty->isScalarType();
+}
+
+/// Return unique name of an array which contains values of a specified field.
+std::string getFieldArrayName(StringRef ArrayName, StringRef FieldName,
+    StringSet<> &Identifiers) {
+  SmallString<32> Name;
+  (ArrayName + "_" + FieldName).toVector(Name);
+  auto Size = Name.size();
+  for (unsigned Count = 0; Identifiers.count(Name); ++Count) {
+    Name.resize(Size);
+    (Twine(Count)).toVector(Name);
+  }
+  Identifiers.insert(Name);
+  return Name.str().str();
+}
+
+class ClangStructToArraysInfo final : public PassGroupInfo {
+  void addBeforePass(legacy::PassManager &Passes) const override {
+    // Induction variables should be promoted to registers, otherwise
+    // the structure layout advisor does not recognize traversed arrays.
+    Passes.add(createSROAPass());
+    Passes.add(createMemoryMatcherPass());
+  }
+};
+}
+
+char ClangStructToArrays::ID = 0;
+
+INITIALIZE_PROVIDER_BEGIN(ClangStructToArraysProvider,
+  "clang-aos-to-soa-provider",
+  "Array of Structures to Structure of Arrays (Clang, Provider)")
+  INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+  INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
+  INITIALIZE_PASS_DEPENDENCY(ClangDIMemoryMatcherPass)
+INITIALIZE_PROVIDER_END(ClangStructToArraysProvider,
+  "clang-aos-to-soa-provider",
+  "Array of Structures to Structure of Arrays (Clang, Provider)")
+
+INITIALIZE_PASS_IN_GROUP_BEGIN(ClangStructToArrays, "clang-aos-to-soa",
+  "Array of Structures to Structure of Arrays (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+  INITIALIZE_PASS_IN_GROUP_INFO(ClangStructToArraysInfo);
+  INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+  INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
+  INITIALIZE_PASS_DEPENDENCY(ClangDIGlobalMemoryMatcherPass)
+  INITIALIZE_PASS_DEPENDENCY(ClangGlobalInfoPass)
+  INITIALIZE_PASS_DEPENDENCY(StructLayoutAdvisor)
+  INITIALIZE_PASS_DEPENDENCY(ClangStructToArraysProvider)
+INITIALIZE_PASS_IN_GROUP_END(ClangStructToArrays, "clang-aos-to-soa",
+  "Array of Structures to Structure of Arrays (Clang)", false, false,
+  TransformationQueryManager::getPassRegistry())
+
+ModulePass * llvm::createClangStructToArrays() {
+  return new ClangStructToArrays;
+}
+
+void ClangStructToArrays::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<MemoryMatcherImmutableWrapper>();
+  AU.addRequired<ClangDIGlobalMemoryMatcherPass>();
+  AU.addRequired<ClangGlobalInfoPass>();
+  AU.addRequired<StructLayoutAdvisor>();
+  AU.addRequired<ClangStructToArraysProvider>();
+  AU.setPreservesAll();
+}
+
+bool ClangStructToArrays::runOnModule(Module &M) {
+  mTfmCtx = getAnalysis<TransformationEnginePass>().getContext(M);
+  if (!mTfmCtx || !mTfmCtx->hasInstance()) {
+    M.getContext().emitError("can not transform sources"
+      ": transformation context is not available");
+    return false;
+  }
+  ClangStructToArraysProvider::initialize<TransformationEnginePass>(
+    [&M, this](TransformationEnginePass &TEP) {
+    TEP.setContext(M, mTfmCtx);
+  });
+  auto &MatchInfo = getAnalysis<MemoryMatcherImmutableWrapper>().get();
+  ClangStructToArraysProvider::initialize<MemoryMatcherImmutableWrapper>(
+    [&MatchInfo](MemoryMatcherImmutableWrapper &Matcher) {
+      Matcher.set(MatchInfo);
+  });
+  auto &GlobalMatcher =
+    getAnalysis<ClangDIGlobalMemoryMatcherPass>().getMatcher();
+  auto &Identifiers =
+    getAnalysis<ClangGlobalInfoPass>().getRawInfo().Identifiers;
+  for (auto &Info : getAnalysis<StructLayoutAdvisor>().getCandidates()) {
+    if (!Info.IsLocal || !Info.Var)
+      continue;
+    VarDecl *VD = nullptr;
+    if (Info.Func) {
+      auto &Provider = getAnalysis<ClangStructToArraysProvider>(*Info.Func);
+      auto &Matcher = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
+      auto Itr = Matcher.find<MD>(Info.Var);
+      if (Itr != Matcher.end())
+        VD = Itr->get<AST>();
+    } else {
+      auto Itr = GlobalMatcher.find<MD>(Info.Var);
+      if (Itr != GlobalMatcher.end())
+        VD = Itr->get<AST>();
+    }
+    if (!VD) {
+      LLVM_DEBUG(dbgs() << "[AOS TO SOA]: unable to match array '"
+                        << Info.Name << "' with a declaration\n");
+      continue;
+    }
+    if (checkDecl(*VD))
+      convert(*VD, Identifiers);
+  }
+  return false;
+}
+
+bool ClangStructToArrays::checkDecl(const VarDecl &VD) {
+  auto &Ctx = mTfmCtx->getContext();
+  auto &SrcMgr = Ctx.getSourceManager();
+  auto &Diags = Ctx.getDiagnostics();
+  auto *ArrayTy = Ctx.getAsConstantArrayType(VD.getType());
+  auto *RecordTy = ArrayTy ?
+    ArrayTy->getElementType()->getAs<RecordType>() : nullptr;
+  if (!RecordTy || RecordTy->getDecl()->isUnion() ||
+      ArrayTy->getElementType().hasQualifiers() ||
+      !RecordTy->getDecl()->getDefinition() ||
+      llvm::any_of(RecordTy->getDecl()->getDefinition()->fields(), [](const FieldDecl *FD) {
+        return FD->isBitField() || !isSupportedFieldType(FD->getType());
+      })) {
+    toDiag(Diags, VD.getLocation(), diag::warn_aos_to_soa) << VD.getName();
+    toDiag(Diags, VD.getLocation(), diag::note_aos_to_soa_type_unable);
+    return false;
+  }
+  auto SizeLoc = VD.getTypeSourceInfo()->getTypeLoc().getAs<ArrayTypeLoc>();
+  if (!SizeLoc || !SizeLoc.getSizeExpr() ||
+      VD.getLocStart().isMacroID() || VD.getLocEnd().isMacroID() ||
+      SizeLoc.getSizeExpr()->getLocStart().isMacroID() ||
+      SizeLoc.getSizeExpr()->getLocEnd().isMacroID()) {
+    toDiag(Diags, VD.getLocation(), diag::warn_aos_to_soa) << VD.getName();
+    toDiag(Diags, VD.getLocStart(), diag::note_aos_to_soa_macro_prevent);
+    return false;
+  }
+  // Each declaration is replaced with a list of declarations, so other
+  // declarations in the same statement (including a definition of
+  // a structure) and redeclarations prevent conversion.
+  bool IsSingle = VD.hasInit() || VD.getPreviousDecl() ||
+    VD.getMostRecentDecl() != &VD || !SrcMgr.isInMainFile(VD.getLocation()) ?
+    false : llvm::none_of(VD.getDeclContext()->decls(), [&VD, &SrcMgr](
+        const Decl *D) {
+      return D != &VD &&
+        !SrcMgr.isBeforeInTranslationUnit(D->getLocEnd(), VD.getLocStart()) &&
+        !SrcMgr.isBeforeInTranslationUnit(VD.getLocEnd(), D->getLocStart());
+    });
+  if (!IsSingle) {
+    toDiag(Diags, VD.getLocation(), diag::warn_aos_to_soa) << VD.getName();
+    toDiag(Diags, VD.getLocation(), diag::note_aos_to_soa_decl_unable);
+    return false;
+  }
+  return true;
+}
+
+void ClangStructToArrays::convert(VarDecl &VD, StringSet<> &Identifiers) {
+  auto &Ctx = mTfmCtx->getContext();
+  auto &SrcMgr = Ctx.getSourceManager();
+  auto &Diags = Ctx.getDiagnostics();
+  AoSAccessVisitor Visitor(*VD.getCanonicalDecl());
+  if (VD.isLocalVarDecl())
+    Visitor.TraverseDecl(cast<FunctionDecl>(VD.getDeclContext()));
+  else
+    Visitor.TraverseDecl(Ctx.getTranslationUnitDecl());
+  if (auto *DRE = Visitor.getUnsupported()) {
+    toDiag(Diags, VD.getLocation(), diag::warn_aos_to_soa) << VD.getName();
+    toDiag(Diags, DRE->getLocation(), diag::note_aos_to_soa_access_unable);
+    return;
+  }
+  for (auto &Access : Visitor.getAccesses())
+    if (Access.first->getOperatorLoc().isMacroID() ||
+        Access.first->getMemberLoc().isMacroID() ||
+        Access.second->getLocation().isMacroID()) {
+      toDiag(Diags, VD.getLocation(), diag::warn_aos_to_soa) << VD.getName();
+      toDiag(Diags, Access.first->getLocStart(),
+        diag::note_aos_to_soa_macro_prevent);
+      return;
+    }
+  auto *ArrayTy = Ctx.getAsConstantArrayType(VD.getType());
+  auto *RD = ArrayTy->getElementType()->getAs<RecordType>()->getDecl();
+  auto SizeExpr =
+    VD.getTypeSourceInfo()->getTypeLoc().getAs<ArrayTypeLoc>().getSizeExpr();
+  auto Size = Lexer::getSourceText(
+    CharSourceRange::getTokenRange(SizeExpr->getSourceRange()), SrcMgr,
+    Ctx.getLangOpts());
+  SmallVector<std::string, 8> Names;
+  std::string Decls;
+  raw_string_ostream OS(Decls);
+  for (auto *FD : RD->getDefinition()->fields()) {
+    Names.push_back(getFieldArrayName(VD.getName(), FD->getName(), Identifiers));
+    if (Names.size() > 1)
+      OS << ";\n";
+    if (VD.getStorageClass() == SC_Static)
+      OS << "static ";
+    // Size of an array is the outermost dimension, so it goes right after
+    // the name in the declarator, for example 'float A_F[N][3]'.
+    std::string Declarator = Names.back() + "[" + Size.str() + "]";
+    FD->getType().print(OS, Ctx.getPrintingPolicy(), Declarator);
+  }
+  auto &Rewriter = mTfmCtx->getRewriter();
+  Rewriter.ReplaceText(VD.getSourceRange(), OS.str());
+  for (auto &Access : Visitor.getAccesses()) {
+    auto *FD = cast<FieldDecl>(Access.first->getMemberDecl());
+    Rewriter.ReplaceText(Access.second->getSourceRange(),
+      Names[FD->getFieldIndex()]);
+    Rewriter.RemoveText(SourceRange(Access.first->getOperatorLoc(),
+      Access.first->getMemberLoc()));
+  }
+  toDiag(Diags, VD.getLocation(), diag::remark_aos_to_soa) << VD.getName();
+}
@@ -0,0 +1,472 @@
+//===- FunctionSummary.cpp - Interprocedural Function Summaries -*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements passes to export summaries of externally visible
+// functions after interprocedural analysis and to attach imported summaries
+// to declarations of functions which are defined in other translation units.
+// Summaries are also used to partition sources into shards which are analyzed
+// in separate processes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Transform/IR/FunctionSummary.h"
+#include "tsar/Analysis/Attributes.h"
+#include "tsar/Analysis/Memory/DefinedMemory.h"
+#include "tsar/Analysis/Memory/EstimateMemory.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Transform/IR/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/EquivalenceClasses.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "function-summary"
+
+STATISTIC(NumExportedFunc, "Number of exported function summaries");
+STATISTIC(NumImportedFunc, "Number of declarations with imported summaries");
+
+bool tsar::loadFunctionSummary(StringRef File, summary::Summary &S,
+    std::string *ErrMsg) {
+  auto FileOrErr = MemoryBuffer::getFile(File);
+  if (auto EC = FileOrErr.getError()) {
+    if (ErrMsg)
+      *ErrMsg = "unable to open file: " + EC.message();
+    return false;
+  }
+  json::Parser<> Parser((**FileOrErr).getBuffer().str());
+  if (!Parser.parse(S)) {
+    if (ErrMsg) {
+      *ErrMsg = "unable to parse function summaries";
+      for (auto &D : Parser.errors()) {
+        *ErrMsg += "\n";
+        *ErrMsg += D;
+      }
+    }
+    return false;
+  }
+  return true;
+}
+
+bool tsar::storeFunctionSummary(StringRef File, const summary::Summary &S,
+    std::string *ErrMsg) {
+  std::error_code EC;
+  raw_fd_ostream OS(File, EC, sys::fs::F_Text);
+  if (EC) {
+    if (ErrMsg)
+      *ErrMsg = "unable to open file: " + EC.message();
+    return false;
+  }
+  OS << json::Parser<summary::Summary>::unparse(S) << '\n';
+  return true;
+}
+
+std::vector<std::vector<std::size_t>> tsar::partitionByLocality(
+    ArrayRef<summary::Summary> Summaries, ArrayRef<uint64_t> Weights,
+    unsigned ShardNum) {
+  assert(Summaries.size() == Weights.size() &&
+         "Each source must have a weight!");
+  StringMap<std::size_t> Definitions;
+  for (std::size_t I = 0, EI = Summaries.size(); I < EI; ++I)
+    for (auto &U : Summaries[I][summary::Summary::Units])
+      for (auto &F : U[summary::Unit::Functions])
+        Definitions.try_emplace(F[summary::Function::Name], I);
+  EquivalenceClasses<std::size_t> Related;
+  for (std::size_t I = 0, EI = Summaries.size(); I < EI; ++I) {
+    Related.insert(I);
+    for (auto &U : Summaries[I][summary::Summary::Units])
+      for (auto &Callee : U[summary::Unit::Calls]) {
+        auto DefItr = Definitions.find(Callee);
+        if (DefItr != Definitions.end())
+          Related.unionSets(I, DefItr->second);
+      }
+  }
+  std::vector<std::pair<uint64_t, std::vector<std::size_t>>> Groups;
+  for (auto I = Related.begin(), EI = Related.end(); I != EI; ++I) {
+    if (!I->isLeader())
+      continue;
+    Groups.emplace_back();
+    for (auto MI = Related.member_begin(I), ME = Related.member_end();
+         MI != ME; ++MI) {
+      Groups.back().first += Weights[*MI];
+      Groups.back().second.push_back(*MI);
+    }
+  }
+  std::stable_sort(Groups.begin(), Groups.end(),
+    [](const decltype(Groups)::value_type &LHS,
+       const decltype(Groups)::value_type &RHS) {
+      return LHS.first > RHS.first;
+  });
+  std::vector<uint64_t> Loads(ShardNum, 0);
+  std::vector<std::vector<std::size_t>> Shards(ShardNum);
+  for (auto &G : Groups) {
+    auto Idx = std::min_element(Loads.begin(), Loads.end()) - Loads.begin();
+    Loads[Idx] += G.first;
+    Shards[Idx].insert(Shards[Idx].end(), G.second.begin(), G.second.end());
+  }
+  Shards.erase(std::remove_if(Shards.begin(), Shards.end(),
+    [](const std::vector<std::size_t> &S) { return S.empty(); }), Shards.end());
+  for (auto &S : Shards)
+    std::sort(S.begin(), S.end());
+  return Shards;
+}
+
+namespace {
+/// Convert a memory location accessed in a function `F` to its summary.
+///
+/// Return `false` if the location is not a part of memory pointed to by
+/// an argument of `F` or a part of an externally visible global variable.
+bool exportLocation(const Function &F, const MemoryLocationRange &Loc,
+    summary::Location &SL) {
+  auto &DL = F.getParent()->getDataLayout();
+  int64_t Offset = 0;
+  auto *Base = GetPointerBaseWithConstantOffset(Loc.Ptr, Offset, DL);
+  if (Offset < 0)
+    return false;
+  if (auto *Arg = dyn_cast<Argument>(Base)) {
+    if (Arg->getParent() != &F)
+      return false;
+    SL[summary::Location::Arg] = Arg->getArgNo();
+  } else if (auto *GV = dyn_cast<GlobalVariable>(Base)) {
+    if (GV->hasLocalLinkage() || !GV->hasName())
+      return false;
+    SL[summary::Location::Global] = GV->getName();
+  } else {
+    return false;
+  }
+  SL[summary::Location::Lower] = Offset + Loc.LowerBound;
+  SL[summary::Location::Upper] =
+    Loc.UpperBound == MemoryLocationRange::UnknownSize ?
+      UINT64_MAX : Offset + Loc.UpperBound;
+  return true;
+}
+
+/// Convert a set of memory locations accessed in a function `F` to a list of
+/// summaries, return `false` if some of locations can not be converted.
+///
+/// Locations which are allocated in `F` are ignored.
+bool exportLocations(const Function &F,
+    const MemorySet<MemoryLocationRange> &Locs,
+    std::vector<summary::Location> &Summaries) {
+  auto &DL = F.getParent()->getDataLayout();
+  for (auto &Loc : Locs) {
+    summary::Location SL;
+    if (exportLocation(F, Loc, SL))
+      Summaries.push_back(std::move(SL));
+    else if (!isa<AllocaInst>(GetUnderlyingObject(Loc.Ptr, DL, 0)))
+      return false;
+  }
+  return true;
+}
+
+/// Convert results of interprocedural reach definition analysis for
+/// a function `F` to its summary.
+void exportDefUse(const Function &F, const DefUseSet &DUS,
+    summary::DefUse &S) {
+  if (!DUS.getExplicitUnknowns().empty() || !DUS.getAddressUnknowns().empty())
+    return;
+  // Conversion of an integer to a pointer may produce any address, so
+  // this function may access memory which is not described in its def-use set.
+  if (any_of(instructions(F),
+             [](const Instruction &I) { return isa<IntToPtrInst>(I); }))
+    return;
+  summary::DefUse Tmp;
+  if (!exportLocations(F, DUS.getDefs(), Tmp[summary::DefUse::Defs]) ||
+      !exportLocations(F, DUS.getMayDefs(), Tmp[summary::DefUse::MayDefs]) ||
+      !exportLocations(F, DUS.getUses(), Tmp[summary::DefUse::Uses]))
+    return;
+  auto &DL = F.getParent()->getDataLayout();
+  for (auto *Ptr : DUS.getAddressAccesses()) {
+    auto *GV = dyn_cast<GlobalVariable>(stripPointer(DL, Ptr));
+    if (!GV)
+      continue;
+    if (GV->hasLocalLinkage() || !GV->hasName())
+      return;
+    Tmp[summary::DefUse::Addresses].insert(GV->getName());
+  }
+  Tmp[summary::DefUse::Known] = true;
+  S = std::move(Tmp);
+}
+
+/// Convert a summary of a memory location accessed in a function `F` to
+/// a memory location, return `None` if the location can not be constructed.
+Optional<MemoryLocationRange> importLocation(Function &F,
+    const summary::Location &SL) {
+  Value *Base = nullptr;
+  if (SL[summary::Location::Arg] >= 0) {
+    if (static_cast<unsigned>(SL[summary::Location::Arg]) >= F.arg_size())
+      return None;
+    Base = F.arg_begin() + SL[summary::Location::Arg];
+  } else {
+    Base = F.getParent()->getNamedGlobal(SL[summary::Location::Global]);
+  }
+  if (!Base || !Base->getType()->isPointerTy())
+    return None;
+  return MemoryLocationRange(Base, SL[summary::Location::Lower],
+    SL[summary::Location::Upper] == UINT64_MAX ?
+      MemoryLocationRange::UnknownSize : SL[summary::Location::Upper]);
+}
+
+/// Convert a summary of def-use set for a function `F` to a def-use set.
+///
+/// Return `nullptr` if the summary is not known or it refers to a global
+/// variable which is not available in the module.
+std::unique_ptr<DefUseSet> importDefUse(Function &F,
+    const summary::DefUse &S) {
+  if (!S[summary::DefUse::Known])
+    return nullptr;
+  auto DUS = llvm::make_unique<DefUseSet>();
+  for (auto &SL : S[summary::DefUse::Defs]) {
+    auto Loc = importLocation(F, SL);
+    if (!Loc)
+      return nullptr;
+    DUS->addDef(*Loc);
+    DUS->addExplicitAccess(*Loc);
+  }
+  for (auto &SL : S[summary::DefUse::MayDefs]) {
+    auto Loc = importLocation(F, SL);
+    if (!Loc)
+      return nullptr;
+    DUS->addMayDef(*Loc);
+    DUS->addExplicitAccess(*Loc);
+  }
+  for (auto &SL : S[summary::DefUse::Uses]) {
+    auto Loc = importLocation(F, SL);
+    if (!Loc)
+      return nullptr;
+    DUS->addUse(*Loc);
+    DUS->addExplicitAccess(*Loc);
+  }
+  for (auto &Name : S[summary::DefUse::Addresses]) {
+    auto *GV = F.getParent()->getNamedGlobal(Name);
+    if (!GV)
+      return nullptr;
+    DUS->addAddressAccess(GV);
+  }
+  return DUS;
+}
+
+/// This pass stores summaries of externally visible functions defined in
+/// a module to a file specified with GlobalOptions::SummaryExport.
+///
+/// If the file already exists summaries of the module are appended to it.
+class FunctionSummaryExportPass : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+  FunctionSummaryExportPass() : ModulePass(ID) {
+    initializeFunctionSummaryExportPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<GlobalOptionsImmutableWrapper>();
+    AU.setPreservesAll();
+  }
+};
+
+/// This pass attaches attributes to declarations of functions in accordance
+/// with summaries loaded from a file specified with
+/// GlobalOptions::SummaryUse.
+///
+/// Imported def-use sets are stored as results of interprocedural reach
+/// definition analysis for declarations (see GlobalDefinedMemoryWrapper).
+class FunctionSummaryImportPass : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+  FunctionSummaryImportPass() : ModulePass(ID) {
+    initializeFunctionSummaryImportPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+};
+}
+
+char FunctionSummaryExportPass::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionSummaryExportPass, "summary-export",
+  "Export Function Summaries", true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_END(FunctionSummaryExportPass, "summary-export",
+  "Export Function Summaries", true, true)
+
+ModulePass * llvm::createFunctionSummaryExportPass() {
+  return new FunctionSummaryExportPass;
+}
+
+bool FunctionSummaryExportPass::runOnModule(Module &M) {
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  if (GO.SummaryExport.empty())
+    return false;
+  summary::Summary S;
+  std::string ErrMsg;
+  if (sys::fs::exists(GO.SummaryExport) &&
+      !loadFunctionSummary(GO.SummaryExport, S, &ErrMsg)) {
+    M.getContext().emitError(GO.SummaryExport + ": " + ErrMsg);
+    return false;
+  }
+  InterprocDefUseInfo *GDM = nullptr;
+  if (auto *Wrapper = getAnalysisIfAvailable<GlobalDefinedMemoryWrapper>())
+    if (*Wrapper)
+      GDM = &Wrapper->get();
+  summary::Unit U;
+  U[summary::Unit::File] = M.getSourceFileName();
+  for (auto &F : M) {
+    if (F.isIntrinsic() || F.hasLocalLinkage())
+      continue;
+    if (F.isDeclaration()) {
+      if (!F.use_empty())
+        U[summary::Unit::Calls].insert(F.getName());
+      continue;
+    }
+    summary::Function FS;
+    FS[summary::Function::Name] = F.getName();
+    FS[summary::Function::NoThrow] = F.doesNotThrow();
+    FS[summary::Function::NoMemoryAccess] = F.doesNotAccessMemory();
+    FS[summary::Function::NoGlobalAccess] = F.onlyAccessesArgMemory();
+    FS[summary::Function::ReadOnly] = F.onlyReadsMemory();
+    FS[summary::Function::NoIO] = hasFnAttr(F, AttrKind::NoIO);
+    FS[summary::Function::AlwaysReturn] = hasFnAttr(F, AttrKind::AlwaysReturn);
+    if (GDM) {
+      auto DUItr = GDM->find(&F);
+      if (DUItr != GDM->end())
+        exportDefUse(F, *DUItr->get<DefUseSet>(),
+                     FS[summary::Function::DefUseSet]);
+    }
+    for (auto &Arg : F.args()) {
+      if (!Arg.getType()->isPointerTy())
+        continue;
+      summary::Argument AS;
+      AS[summary::Argument::Index] = Arg.getArgNo();
+      bool NoAccess =
+        F.doesNotAccessMemory() || Arg.hasAttribute(Attribute::ReadNone);
+      AS[summary::Argument::Read] =
+        !NoAccess && !Arg.hasAttribute(Attribute::WriteOnly);
+      AS[summary::Argument::Write] = !NoAccess && !F.onlyReadsMemory() &&
+        !Arg.hasAttribute(Attribute::ReadOnly);
+      AS[summary::Argument::NoCapture] = Arg.hasNoCaptureAttr();
+      // Do not store conservative assumptions.
+      if (AS[summary::Argument::Read] && AS[summary::Argument::Write] &&
+          !AS[summary::Argument::NoCapture])
+        continue;
+      FS[summary::Function::Args].push_back(std::move(AS));
+    }
+    U[summary::Unit::Functions].push_back(std::move(FS));
+    ++NumExportedFunc;
+  }
+  S[summary::Summary::Units].push_back(std::move(U));
+  if (!storeFunctionSummary(GO.SummaryExport, S, &ErrMsg))
+    M.getContext().emitError(GO.SummaryExport + ": " + ErrMsg);
+  return false;
+}
+
+char FunctionSummaryImportPass::ID = 0;
+INITIALIZE_PASS(FunctionSummaryImportPass, "summary-import",
+  "Import Function Summaries", false, false)
+
+ModulePass * llvm::createFunctionSummaryImportPass() {
+  return new FunctionSummaryImportPass;
+}
+
+bool FunctionSummaryImportPass::runOnModule(Module &M) {
+  auto *GOWrapper = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+  if (!GOWrapper || GOWrapper->getOptions().SummaryUse.empty())
+    return false;
+  auto &File = GOWrapper->getOptions().SummaryUse;
+  summary::Summary S;
+  std::string ErrMsg;
+  if (!loadFunctionSummary(File, S, &ErrMsg)) {
+    M.getContext().emitError(File + ": " + ErrMsg);
+    return false;
+  }
+  StringMap<const summary::Function *> Summaries;
+  for (auto &U : S[summary::Summary::Units])
+    for (auto &FS : U[summary::Unit::Functions])
+      Summaries.try_emplace(FS[summary::Function::Name], &FS);
+  InterprocDefUseInfo *GDM = nullptr;
+  if (auto *Wrapper = getAnalysisIfAvailable<GlobalDefinedMemoryWrapper>())
+    if (*Wrapper)
+      GDM = &Wrapper->get();
+  bool Changed = false;
+  for (auto &F : M) {
+    if (!F.isDeclaration() || F.isIntrinsic() || F.hasLocalLinkage())
+      continue;
+    auto SummaryItr = Summaries.find(F.getName());
+    if (SummaryItr == Summaries.end())
+      continue;
+    auto &FS = *SummaryItr->second;
+    if (FS[summary::Function::NoThrow])
+      F.setDoesNotThrow();
+    if (FS[summary::Function::NoMemoryAccess]) {
+      F.setDoesNotAccessMemory();
+    } else if (!F.doesNotAccessMemory()) {
+      if (FS[summary::Function::NoGlobalAccess])
+        F.setOnlyAccessesArgMemory();
+      if (FS[summary::Function::ReadOnly])
+        F.setOnlyReadsMemory();
+    }
+    if (FS[summary::Function::NoIO])
+      addFnAttr(F, AttrKind::NoIO);
+    if (FS[summary::Function::AlwaysReturn])
+      addFnAttr(F, AttrKind::AlwaysReturn);
+    for (auto &AS : FS[summary::Function::Args]) {
+      if (AS[summary::Argument::Index] >= F.arg_size())
+        continue;
+      auto *Arg = F.arg_begin() + AS[summary::Argument::Index];
+      if (!Arg->getType()->isPointerTy())
+        continue;
+      if (AS[summary::Argument::NoCapture])
+        Arg->addAttr(Attribute::NoCapture);
+      if (Arg->hasAttribute(Attribute::ReadNone) ||
+          Arg->hasAttribute(Attribute::ReadOnly) ||
+          Arg->hasAttribute(Attribute::WriteOnly))
+        continue;
+      if (!AS[summary::Argument::Read] && !AS[summary::Argument::Write])
+        Arg->addAttr(Attribute::ReadNone);
+      else if (!AS[summary::Argument::Write])
+        Arg->addAttr(Attribute::ReadOnly);
+      else if (!AS[summary::Argument::Read])
+        Arg->addAttr(Attribute::WriteOnly);
+    }
+    // Unused declarations may be removed later, so do not remember them.
+    if (GDM && !F.use_empty())
+      if (auto DUS = importDefUse(F, FS[summary::Function::DefUseSet]))
+        GDM->try_emplace(&F, std::move(DUS));
+    ++NumImportedFunc;
+    Changed = true;
+  }
+  return Changed;
+}
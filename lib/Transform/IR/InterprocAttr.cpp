@@ -23,6 +23,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include "tsar/Transform/IR/InterprocAttr.h"
+#include "tsar/Analysis/LibraryFunctions.h"
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Support/IRUtils.h"
@@ -42,6 +43,7 @@ using namespace llvm;
 #define DEBUG_TYPE "functionattrs"
 
 STATISTIC(NumLibFunc, "Number of functions marked as sapfor.libfunc");
+STATISTIC(NumSummaryFunc, "Number of functions with known summaries");
 STATISTIC(NumNoIOFunc, "Number of functions marked as sapfor.noio");
 STATISTIC(NumAlwaysRetFunc, "Number of functions marked as sapfor.alwaysreturn");
 STATISTIC(NumDirectUserCalleFunc, "Number of funstions marked as sapfor.direct-user-callee");
@@ -53,6 +55,21 @@ STATISTIC(NumNoUnwindLoop, "Number of loops marked as nounwind");
 STATISTIC(NumReturnsTwiceLoop, "Number of loops marked as returns_twice");
 
 namespace {
+/// This pass adds LLVM attributes to declarations of library functions
+/// in accordance with their summaries (see LibraryFunctions.td).
+struct LibFuncAttrsAnalysis : public ModulePass, private bcl::Uncopyable {
+  static char ID;
+  LibFuncAttrsAnalysis() : ModulePass(ID) {
+    initializeLibFuncAttrsAnalysisPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(llvm::Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+};
+
 /// This pass walks SCCs of the call graph in RPO to deduce and propagate
 /// function attributes.
 ///
@@ -127,6 +144,55 @@ bool addLibFuncAttrsTopDown(Function &F) {
 }
 }
 
+char LibFuncAttrsAnalysis::ID = 0;
+
+INITIALIZE_PASS(LibFuncAttrsAnalysis, "sapfor-libfunc-attrs",
+  "Add attributes to library functions", false, false)
+
+ModulePass * llvm::createLibFuncAttrsAnalysis() {
+  return new LibFuncAttrsAnalysis();
+}
+
+bool LibFuncAttrsAnalysis::runOnModule(llvm::Module &M) {
+  bool Changed = false;
+  for (auto &F : M) {
+    auto *Summary = findLibFuncSummary(F);
+    if (!Summary)
+      continue;
+    if (Summary->is(LibFuncSummary::NoThrow))
+      F.setDoesNotThrow();
+    if (!F.doesNotAccessMemory()) {
+      if (Summary->onlyAccessesArgMemory(F))
+        F.setOnlyAccessesArgMemory();
+      if (Summary->onlyReadsMemory(F))
+        F.setOnlyReadsMemory();
+    }
+    for (auto &Arg : F.args()) {
+      if (!Arg.getType()->isPointerTy())
+        continue;
+      if (Summary->isNoCapture(Arg.getArgNo()))
+        Arg.addAttr(Attribute::NoCapture);
+      if (Arg.hasAttribute(Attribute::ReadNone) ||
+          Arg.hasAttribute(Attribute::ReadOnly) ||
+          Arg.hasAttribute(Attribute::WriteOnly))
+        continue;
+      switch (Summary->getArgAccess(F, Arg.getArgNo())) {
+      case LibFuncArgAccess::NoAccess:
+        Arg.addAttr(Attribute::ReadNone); break;
+      case LibFuncArgAccess::Read:
+        Arg.addAttr(Attribute::ReadOnly); break;
+      case LibFuncArgAccess::Write:
+        Arg.addAttr(Attribute::WriteOnly); break;
+      case LibFuncArgAccess::ReadWrite:
+        break;
+      }
+    }
+    ++NumSummaryFunc;
+    Changed = true;
+  }
+  return Changed;
+}
+
 char RPOFunctionAttrsAnalysis::ID = 0;
 
 INITIALIZE_PASS_BEGIN(RPOFunctionAttrsAnalysis, "rpo-sapfor-functionattrs",
@@ -153,7 +219,7 @@ bool RPOFunctionAttrsAnalysis::runOnModule(llvm::Module &M) {
           continue;
         Worklist.push_back(F);
         LibFunc LibId;
-        HasLibFunc |= TLI.getLibFunc(*F, LibId);
+        HasLibFunc |= TLI.getLibFunc(*F, LibId) || findLibFuncSummary(*F);
       }
     if (HasLibFunc)
       for (std::size_t EIdx = Worklist.size(); CGNIdx < EIdx; ++CGNIdx)
@@ -217,6 +283,11 @@ AttrKind POFunctionAttrsAnalysis::addNoIOAttr() {
   for (auto *SCCF : mSCCFuncs) {
     if (SCCF->isIntrinsic())
       continue;
+    if (auto *Summary = findLibFuncSummary(*SCCF)) {
+      if (Summary->is(LibFuncSummary::InputOutput))
+        return AttrKind::not_attribute;
+      continue;
+    }
     LibFunc LibId;
     // We can not use here 'sapfor.libfunc' attribute to check whether a
     // function is a library function because set of in/out functions contains
@@ -31,6 +31,9 @@ void llvm::initializeIRTransform(PassRegistry &Registry) {
   initializeNoMetadataDSEPassPass(Registry);
   initializePOFunctionAttrsAnalysisPass(Registry);
   initializeRPOFunctionAttrsAnalysisPass(Registry);
+  initializeLibFuncAttrsAnalysisPass(Registry);
+  initializeFunctionSummaryExportPassPass(Registry);
+  initializeFunctionSummaryImportPassPass(Registry);
   initializeLoopAttributesDeductionPassPass(Registry);
   initializeCallExtractorPassPass(Registry);
   initializeFunctionMemoryAttrsAnalysisPass(Registry);
@@ -26,31 +26,40 @@
 #include "tsar/Analysis/DFRegionInfo.h"
 #include "tsar/Analysis/Intrinsics.h"
 #include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Analysis/LibraryFunctions.h"
 #include "tsar/Analysis/Clang/CanonicalLoop.h"
 #include "tsar/Analysis/Clang/MemoryMatcher.h"
+#include "tsar/Analysis/Clang/RegionDirectiveInfo.h"
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Support/PassProvider.h"
 #include "tsar/Transform/IR/MetadataUtils.h"
 #include "tsar/Transform/IR/Utils.h"
 #include "tsar/Unparse/SourceUnparserUtils.h"
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Analysis/ScalarEvolution.h>
 #include <llvm/Analysis/ScalarEvolutionExpander.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/InstIterator.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/Support/Debug.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #include <llvm/Transforms/Utils/Local.h>
 #include <vector>
 
@@ -77,6 +86,7 @@ STATISTIC(NumVariable, "Number of registered variables");
 STATISTIC(NumScalar, "Number of registered scalar variables");
 STATISTIC(NumArray, "Number of registered arrays");
 STATISTIC(NumCall, "Number of registered calls");
+STATISTIC(NumSkippedCall, "Number of calls without memory accesses");
 STATISTIC(NumMemoryAccesses, "Number of registered memory accesses");
 STATISTIC(NumLoad, "Number of registered loads from the memory");
 STATISTIC(NumLoadScalar, "Number of registered loads from scalars");
@@ -84,6 +94,12 @@ STATISTIC(NumLoadArray, "Number of registered loads from arrays");
 STATISTIC(NumStore, "Number of registered stores to the memory");
 STATISTIC(NumStoreScalar, "Number of registered stores to scalars");
 STATISTIC(NumStoreArray, "Number of registered stores to arrays");
+STATISTIC(NumLoadRange, "Number of loads registered once per loop");
+STATISTIC(NumStoreRange, "Number of stores registered once per loop");
+STATISTIC(NumEvent, "Number of buffered events");
+STATISTIC(NumFlush, "Number of explicit flushes of the buffer of events");
+STATISTIC(NumSampledLoop, "Number of loops with sampled iterations");
+STATISTIC(NumLoopOutOfRegion, "Number of loops out of optimization regions");
 
 INITIALIZE_PROVIDER_BEGIN(InstrumentationPassProvider, "instr-llvm-provider",
   "Instrumentation Provider")
@@ -104,6 +120,8 @@ INITIALIZE_PASS_DEPENDENCY(InstrumentationPassProvider)
 INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
 INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
 INITIALIZE_PASS_DEPENDENCY(CallGraphWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ClangRegionCollector)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_END(InstrumentationPass, "instr-llvm",
   "LLVM IR Instrumentation", false, false)
 
@@ -119,6 +137,25 @@ bool InstrumentationPass::runOnModule(Module &M) {
     [&MMWrapper](MemoryMatcherImmutableWrapper &Wrapper) {
       Wrapper.set(*MMWrapper);
   });
+  mRegions.clear();
+  // Regions are available if a source code is processed only, so
+  // they are not required.
+  if (auto *RC = getAnalysisIfAvailable<ClangRegionCollector>()) {
+    auto &RegionInfo = RC->getRegionInfo();
+    auto *GO = getAnalysisIfAvailable<GlobalOptionsImmutableWrapper>();
+    if (!GO || !GO->isSpecified() || GO->getOptions().OptRegions.empty()) {
+      transform(RegionInfo, std::back_inserter(mRegions),
+                [](const OptimizationRegion &R) { return &R; });
+    } else {
+      for (auto &Name : GO->getOptions().OptRegions)
+        if (auto *R = RegionInfo.get(Name))
+          mRegions.push_back(R);
+        else
+          M.getContext().diagnose(DiagnosticInfoInlineAsm(
+            Twine("optimization region with name '") + Name + "' not found",
+            DS_Warning));
+    }
+  }
   Instrumentation::visit(M, *this);
   Function *EntryPoint = nullptr;
   if (!mInstrEntry.empty())
@@ -137,11 +174,15 @@ void InstrumentationPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<InstrumentationPassProvider>();
   AU.addRequired<MemoryMatcherImmutableWrapper>();
   AU.addRequired<CallGraphWrapperPass>();
+  AU.addUsedIfAvailable<ClangRegionCollector>();
+  AU.addUsedIfAvailable<GlobalOptionsImmutableWrapper>();
 }
 
-ModulePass * llvm::createInstrumentationPass(
-    StringRef InstrEntry, ArrayRef<std::string> StartFrom) {
-  return new InstrumentationPass(InstrEntry, StartFrom);
+ModulePass * llvm::createInstrumentationPass(StringRef InstrEntry,
+    ArrayRef<std::string> StartFrom, unsigned EventBufferSize,
+    unsigned SampleFirst, unsigned SamplePeriod, bool RegisterRanges) {
+  return new InstrumentationPass(InstrEntry, StartFrom, EventBufferSize,
+    SampleFirst, SamplePeriod, RegisterRanges);
 }
 
 Function * tsar::createEmptyInitDI(Module &M, Type &IdTy) {
@@ -174,6 +215,71 @@ GlobalVariable * tsar::getOrCreateDIPool(Module &M) {
   return DIPool;
 }
 
+GlobalVariable * tsar::getOrCreateEventBuffer(Module &M, unsigned Size) {
+  auto &Ctx = M.getContext();
+  auto *BufferTy = StructType::get(Ctx,
+    { Type::getInt64Ty(Ctx), ArrayType::get(getEventType(Ctx), Size) });
+  if (auto *Buffer = M.getNamedValue("sapfor.event.buffer")) {
+    if (isa<GlobalVariable>(Buffer) && Buffer->getValueType() == BufferTy &&
+        cast<GlobalVariable>(Buffer)->getMetadata("sapfor.da"))
+      return cast<GlobalVariable>(Buffer);
+    return nullptr;
+  }
+  auto Buffer = new GlobalVariable(M, BufferTy, false,
+    GlobalValue::LinkageTypes::LinkOnceAnyLinkage,
+    ConstantAggregateZero::get(BufferTy), "sapfor.event.buffer", nullptr,
+    GlobalValue::GeneralDynamicTLSModel);
+  assert(Buffer->getName() == "sapfor.event.buffer" &&
+    "Unable to crate a buffer of events!");
+  Buffer->setAlignment(8);
+  Buffer->setMetadata("sapfor.da", MDNode::get(Ctx, {}));
+  return Buffer;
+}
+
+/// Returns `true` if a call of a specified intrinsic can be replaced with
+/// a record in the buffer of events.
+static bool isBufferedEvent(IntrinsicId Id, FunctionType &FuncTy) {
+  switch (Id) {
+  case IntrinsicId::init_di:
+  case IntrinsicId::allocate_pool:
+  case IntrinsicId::decl_types:
+  case IntrinsicId::flush_events:
+  case IntrinsicId::reg_event_buffer:
+    return false;
+  default:
+    return FuncTy.getNumParams() <= EventPayloadSize;
+  }
+}
+
+/// \brief Inserts a call of sapforFlushEvents() before a specified instruction.
+///
+/// All events which are stored in a specified buffer are processed and the
+/// buffer is cleared. If `Size` is `nullptr` the current number of events
+/// is loaded from the buffer.
+static void createFlushEvents(GlobalVariable &Buffer, Value *Size,
+    Instruction &InsertBefore) {
+  auto &Ctx = InsertBefore.getContext();
+  auto InstrMD = MDNode::get(Ctx, {});
+  auto *Int32Ty = Type::getInt32Ty(Ctx);
+  auto *Zero = ConstantInt::get(Int32Ty, 0);
+  auto *One = ConstantInt::get(Int32Ty, 1);
+  auto *SizePtr = ConstantExpr::getInBoundsGetElementPtr(
+    Buffer.getValueType(), &Buffer, ArrayRef<Constant *>{ Zero, Zero });
+  auto *Events = ConstantExpr::getInBoundsGetElementPtr(
+    Buffer.getValueType(), &Buffer, ArrayRef<Constant *>{ Zero, One, Zero });
+  if (!Size) {
+    Size = new LoadInst(SizePtr, "sapfor.ev.size", &InsertBefore);
+    cast<Instruction>(Size)->setMetadata("sapfor.da", InstrMD);
+  }
+  auto *Flush = getDeclaration(InsertBefore.getModule(),
+    IntrinsicId::flush_events);
+  auto *Call = CallInst::Create(Flush, { Events, Size }, "", &InsertBefore);
+  Call->setMetadata("sapfor.da", InstrMD);
+  auto *Reset = new StoreInst(
+    ConstantInt::get(Size->getType(), 0), SizePtr, &InsertBefore);
+  Reset->setMetadata("sapfor.da", InstrMD);
+}
+
 Type * tsar::getInstrIdType(LLVMContext &Ctx) {
   auto InitDIFuncTy = getType(Ctx, IntrinsicId::init_di);
   assert(InitDIFuncTy->getNumParams() > 2 &&
@@ -201,9 +307,59 @@ static void collectCallee(CallGraphNode &CGN,
 }
 
 void Instrumentation::excludeFunctions(Module &M) {
+  auto &CG = mInstrPass->getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  auto Regions = mInstrPass->getRegions();
+  mRegionFunctions.clear();
+  mAfterRegionFunctions.clear();
+  if (!Regions.empty()) {
+    // Note, that region collector also adds callees of functions and loops
+    // in a region to this region. Callers of these functions may use memory
+    // which has been written in a region after a call, so they are also
+    // collected.
+    DenseMap<Function *, SmallVector<Function *, 4>> Callers;
+    for (auto &CGN : CG)
+      if (auto *Caller = CGN.second->getFunction())
+        for (auto &Callee : *CGN.second)
+          if (auto *F = Callee.second->getFunction())
+            Callers[F].push_back(Caller);
+    std::vector<Function *> Worklist;
+    for (auto &F : M)
+      if (std::any_of(Regions.begin(), Regions.end(),
+            [&F](const OptimizationRegion *R) {
+              return R->contain(F) != OptimizationRegion::CS_No;
+            }))
+        Worklist.push_back(&F);
+    while (!Worklist.empty()) {
+      auto *F = Worklist.back();
+      Worklist.pop_back();
+      if (!mRegionFunctions.insert(F).second)
+        continue;
+      auto CallerItr = Callers.find(F);
+      if (CallerItr != Callers.end())
+        Worklist.insert(Worklist.end(), CallerItr->second.begin(),
+          CallerItr->second.end());
+    }
+    // Functions called from functions which execute regions may be called
+    // after some region, so accesses to memory in these functions should
+    // be registered.
+    DenseSet<Function *> Callees;
+    for (auto *F : mRegionFunctions)
+      if (auto CGN = CG[F])
+        collectCallee(*CGN, Callees);
+    for (auto &F : M) {
+      if (mRegionFunctions.count(&F))
+        continue;
+      if (Callees.count(&F)) {
+        mAfterRegionFunctions.insert(&F);
+        continue;
+      }
+      LLVM_DEBUG(dbgs() << "[INSTR]: ignore function out of regions "
+                        << F.getName() << "\n");
+      F.setMetadata("sapfor.da.ignore", MDNode::get(M.getContext(), {}));
+    }
+  }
   if (mInstrPass->getStartFrom().empty())
     return;
-  auto &CG = mInstrPass->getAnalysis<CallGraphWrapperPass>().getCallGraph();
   DenseSet<Function *> TransitiveCallees;
   for (auto &Name : mInstrPass->getStartFrom()) {
     auto F = M.getFunction(Name);
@@ -229,6 +385,16 @@ void Instrumentation::visitModule(Module &M, InstrumentationPass &IP) {
   mTypes.clear();
   auto &Ctx = M.getContext();
   mDIPool = getOrCreateDIPool(M);
+  if (auto BufferSize = IP.getEventBufferSize()) {
+    mEventBuffer = getOrCreateEventBuffer(M, BufferSize);
+    if (mEventBuffer)
+      addNameDAMetadata(*mEventBuffer, "sapfor.da", "sapfor.event.buffer",
+        { ConstantAsMetadata::get(
+            ConstantInt::get(Type::getInt64Ty(Ctx), BufferSize)) });
+    else
+      Ctx.diagnose(DiagnosticInfoInlineAsm("'sapfor.event.buffer' is not "
+        "available, events will not be buffered", DS_Warning));
+  }
   auto IdTy = getInstrIdType(Ctx);
   assert(IdTy && "Offset type must not be null!");
   mInitDIAll = createEmptyInitDI(M, *IdTy);
@@ -424,9 +590,10 @@ void Instrumentation::setMDForSingleUseInstructions(Instruction *From) {
       setMDForSingleUseInstructions(I);
 }
 
-void Instrumentation::loopBeginInstr(Loop *L, DIStringRegister::IdTy DILoopIdx,
-    ScalarEvolution &SE, DominatorTree &DT,
-    DFRegionInfo &RI, const CanonicalLoopSet &CS) {
+std::tuple<Value *, Value *, Value *, bool>
+Instrumentation::loopBeginInstr(Loop *L, DIStringRegister::IdTy DILoopIdx,
+    bool IsSampled, bool HasSampledNested, ScalarEvolution &SE,
+    DominatorTree &DT, DFRegionInfo &RI, const CanonicalLoopSet &CS) {
   auto *Header = L->getHeader();
   auto InstrMD = MDNode::get(Header->getContext(), {});
   Instruction *InsertBefore = nullptr;
@@ -487,6 +654,10 @@ void Instrumentation::loopBeginInstr(Loop *L, DIStringRegister::IdTy DILoopIdx,
     ("line1=" + Twine(DbgLoc.getEnd().getLine()) + "*" +
       "col1=" + Twine(DbgLoc.getEnd().getCol()) + "*").str() :
     std::string("");
+  std::string Sample = IsSampled ?
+    ("sample=" + Twine(mInstrPass->getSampleFirst()) + "," +
+      Twine(mInstrPass->getSamplePeriod()) + "*").str() :
+    HasSampledNested ? std::string("sample=nested*") : std::string("");
   LoopBoundKind BoundFlag = LoopBoundIsUnknown;
   BoundFlag |= Start ? LoopStartIsKnown : LoopBoundIsUnknown;
   BoundFlag |= End ? LoopEndIsKnown : LoopBoundIsUnknown;
@@ -498,15 +669,17 @@ void Instrumentation::loopBeginInstr(Loop *L, DIStringRegister::IdTy DILoopIdx,
   createInitDICall(
     Twine("type=") + "seqloop" + "*" +
     "file=" + Filename + "*" +
-    "bounds=" + Twine(BoundFlag) + "*" +
+    "bounds=" + Twine(BoundFlag) + "*" + Sample +
     StartLoc + EndLoc + "*", DILoopIdx);
   auto *DILoop = createPointerToDI(DILoopIdx, *InsertBefore);
+  auto Bounds = std::make_tuple(Start, End, Step, Signed);
   Start = Start ? Start : ConstantInt::get(SizeTy, 0);
   End = End ? End : ConstantInt::get(SizeTy, 0);
   Step = Step ? Step : ConstantInt::get(SizeTy, 0);
   auto Call = CallInst::Create(
     SLBeginFunc, {DILoop, Start, End, Step}, "", InsertBefore);
   Call->setMetadata("sapfor.da", InstrMD);
+  return Bounds;
 }
 
 void Instrumentation::loopEndInstr(Loop *L, DIStringRegister::IdTy DILoopIdx) {
@@ -534,7 +707,8 @@ void Instrumentation::loopEndInstr(Loop *L, DIStringRegister::IdTy DILoopIdx) {
     }
 }
 
-void Instrumentation::loopIterInstr(Loop *L, DIStringRegister::IdTy DILoopIdx) {
+CallInst * Instrumentation::loopIterInstr(Loop *L,
+    DIStringRegister::IdTy DILoopIdx) {
   assert(L && "Loop must not be null!");
   auto *Header = L->getHeader();
   auto InstrMD = MDNode::get(Header->getContext(), {});
@@ -557,17 +731,426 @@ void Instrumentation::loopIterInstr(Loop *L, DIStringRegister::IdTy DILoopIdx) {
   auto Fun = getDeclaration(Header->getModule(), IntrinsicId::sl_iter);
   auto *Call = CallInst::Create(Fun, {DILoop, CountPHI}, "", Inc);
   Call->setMetadata("sapfor.da", InstrMD);
+  return Call;
+}
+
+bool Instrumentation::isSampled(Loop &L) {
+  if (mInstrPass->getSamplePeriod() == 0 || !L.empty() ||
+      L.getNumBlocks() < 2 || !L.getLoopPreheader())
+    return false;
+  for (auto *BB : L.blocks())
+    for (auto &I : *BB) {
+      CallSite CS(&I);
+      if (!CS || isDbgInfoIntrinsic(CS.getIntrinsicID()) ||
+          isMemoryMarkerIntrinsic(CS.getIntrinsicID()))
+        continue;
+      auto *Callee = dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+      if (!Callee)
+        return false;
+      if (Callee->isDeclaration() || Callee->getMetadata("sapfor.da") ||
+          Callee->getMetadata("sapfor.da.ignore"))
+        continue;
+      return false;
+    }
+  return true;
+}
+
+void Instrumentation::sampleLoop(SampledLoop &SL) {
+  auto *Header = SL.Header;
+  auto *F = Header->getParent();
+  LLVM_DEBUG(dbgs() << "[INSTR]: sample loop " << Header->getName() << "\n");
+  // Blocks have been inserted into the function after construction of
+  // LoopInfo, so the loop body is recalculated.
+  SmallPtrSet<BasicBlock *, 16> Body;
+  SmallVector<BasicBlock *, 16> Worklist(SL.Latches.begin(), SL.Latches.end());
+  while (!Worklist.empty()) {
+    auto *BB = Worklist.pop_back_val();
+    if (BB == Header || !Body.insert(BB).second)
+      continue;
+    Worklist.append(pred_begin(BB), pred_end(BB));
+  }
+  if (Body.empty())
+    return;
+  // Values which are used outside the loop body can not be cloned without
+  // construction of new PHI nodes, so we do not sample such loops.
+  for (auto *BB : Body)
+    for (auto &I : *BB)
+      for (auto &U : I.uses()) {
+        auto *UserBB = cast<Instruction>(U.getUser())->getParent();
+        if (auto *Phi = dyn_cast<PHINode>(U.getUser()))
+          UserBB = Phi->getIncomingBlock(U);
+        if (!Body.count(UserBB))
+          return;
+      }
+  SmallVector<BasicBlock *, 16> Blocks;
+  for (auto &BB : *F)
+    if (Body.count(&BB))
+      Blocks.push_back(&BB);
+  ValueToValueMapTy VMap;
+  SmallVector<BasicBlock *, 16> Clones;
+  for (auto *BB : Blocks) {
+    auto *Clone = CloneBasicBlock(BB, VMap, ".sample", F);
+    VMap[BB] = Clone;
+    Clones.push_back(Clone);
+  }
+  remapInstructionsInBlocks(Clones, VMap);
+  // Update PHI nodes in the header and in exits of the loop.
+  for (auto *BB : Blocks) {
+    auto *Clone = cast<BasicBlock>(VMap[BB]);
+    for (auto *SuccBB : successors(Clone)) {
+      if (Body.count(SuccBB))
+        continue;
+      for (auto &Phi : SuccBB->phis()) {
+        auto Idx = Phi.getBasicBlockIndex(BB);
+        if (Idx < 0)
+          continue;
+        auto *V = Phi.getIncomingValue(Idx);
+        auto VItr = VMap.find(V);
+        Phi.addIncoming(VItr != VMap.end() ? VItr->second : V, Clone);
+      }
+    }
+  }
+  // Remove instrumentation from the clone.
+  for (auto *Clone : Clones) {
+    SmallVector<CallInst *, 16> Calls;
+    for (auto &I : *Clone)
+      if (auto *Call = dyn_cast<CallInst>(&I)) {
+        auto *Callee = dyn_cast<Function>(
+          Call->getCalledValue()->stripPointerCasts());
+        IntrinsicId LibId;
+        if (Callee && Call->getMetadata("sapfor.da") &&
+            getTsarLibFunc(Callee->getName(), LibId))
+          Calls.push_back(Call);
+      }
+    for (auto *Call : Calls) {
+      SmallVector<Instruction *, 4> Ops;
+      for (auto &Arg : Call->arg_operands())
+        if (auto *I = dyn_cast<Instruction>(Arg))
+          Ops.push_back(I);
+      Call->eraseFromParent();
+      for (auto *I : Ops)
+        if (I->use_empty() && I->getMetadata("sapfor.da"))
+          deleteDeadInstructions(I);
+    }
+  }
+  // Dispatch iterations between instrumented and uninstrumented versions.
+  // Note, that the call of sapforSLIter() remains in the header, so accesses
+  // in the header are always registered with the current iteration number.
+  auto &Ctx = F->getContext();
+  auto InstrMD = MDNode::get(Ctx, {});
+  auto *Count = SL.Iter->getArgOperand(1);
+  auto *CountTy = Count->getType();
+  auto *HeaderTerm = Header->getTerminator();
+  SmallDenseMap<BasicBlock *, BasicBlock *, 2> Dispatches;
+  for (unsigned SuccIdx = 0, SuccIdxE = HeaderTerm->getNumSuccessors();
+       SuccIdx < SuccIdxE; ++SuccIdx) {
+    auto *SuccBB = HeaderTerm->getSuccessor(SuccIdx);
+    if (!Body.count(SuccBB))
+      continue;
+    auto &DispatchBB = Dispatches[SuccBB];
+    if (!DispatchBB) {
+      DispatchBB = BasicBlock::Create(Ctx, "sapfor.sample", F, SuccBB);
+      auto *InstrBB =
+        BasicBlock::Create(Ctx, "sapfor.sample.instr", F, SuccBB);
+      auto *ToInstr = BranchInst::Create(SuccBB, InstrBB);
+      ToInstr->setMetadata("sapfor.da", InstrMD);
+      auto *IsFirst = new ICmpInst(*DispatchBB, ICmpInst::ICMP_ULE, Count,
+        ConstantInt::get(CountTy, mInstrPass->getSampleFirst()),
+        "sapfor.sample.first");
+      IsFirst->setMetadata("sapfor.da", InstrMD);
+      auto *Rem = BinaryOperator::Create(BinaryOperator::URem, Count,
+        ConstantInt::get(CountTy, mInstrPass->getSamplePeriod()), "",
+        DispatchBB);
+      Rem->setMetadata("sapfor.da", InstrMD);
+      auto *IsPeriod = new ICmpInst(*DispatchBB, ICmpInst::ICMP_EQ, Rem,
+        ConstantInt::get(CountTy, 0), "sapfor.sample.period");
+      IsPeriod->setMetadata("sapfor.da", InstrMD);
+      auto *IsInstr = BinaryOperator::Create(BinaryOperator::Or, IsFirst,
+        IsPeriod, "sapfor.sample.instr", DispatchBB);
+      IsInstr->setMetadata("sapfor.da", InstrMD);
+      auto *CloneBB = cast<BasicBlock>(VMap[SuccBB]);
+      auto *Dispatch = BranchInst::Create(InstrBB, CloneBB, IsInstr,
+        DispatchBB);
+      Dispatch->setMetadata("sapfor.da", InstrMD);
+      for (auto &Phi : SuccBB->phis()) {
+        auto Idx = Phi.getBasicBlockIndex(Header);
+        if (Idx >= 0)
+          Phi.setIncomingBlock(Idx, InstrBB);
+      }
+      for (auto &Phi : CloneBB->phis()) {
+        auto Idx = Phi.getBasicBlockIndex(Header);
+        if (Idx >= 0)
+          Phi.setIncomingBlock(Idx, DispatchBB);
+      }
+    }
+    HeaderTerm->setSuccessor(SuccIdx, DispatchBB);
+  }
+  ++NumSampledLoop;
+}
+
+namespace {
+/// Replaces reads of induction variables of canonical loops with expressions
+/// which are available at the entry of a specified loop.
+///
+/// Instrumentation is performed before promotion of variables to registers,
+/// so induction variables are stored in memory and addresses of accessed
+/// elements are not add recurrences. A read of an induction variable of
+/// the loop `L` is replaced with {start,+,step}<L> and a read of an induction
+/// variable of an outer loop is replaced with its value at the entry of `L`.
+class InductionRewriter : public SCEVRewriteVisitor<InductionRewriter> {
+public:
+  using InductionMap =
+    DenseMap<Value *, std::pair<Loop *, const CanonicalLoopInfo *>>;
+  using EntryValueGetter = function_ref<Value *(Value &)>;
+
+  InductionRewriter(ScalarEvolution &SE, Loop &L,
+      const InductionMap &Inductions, EntryValueGetter GetEntryValue) :
+    SCEVRewriteVisitor(SE), mLoop(&L), mInductions(&Inductions),
+    mGetEntryValue(GetEntryValue) {}
+
+  const SCEV * visitUnknown(const SCEVUnknown *Expr) {
+    auto *Load = dyn_cast<LoadInst>(Expr->getValue());
+    if (!Load || Load->isVolatile() || !mLoop->contains(Load))
+      return Expr;
+    auto InductionItr = mInductions->find(Load->getPointerOperand());
+    if (InductionItr == mInductions->end())
+      return Expr;
+    auto *InductionLoop = InductionItr->second.first;
+    // The only write to an induction variable of a canonical loop is
+    // an increment in the loop latch.
+    auto *Latch = InductionLoop->getLoopLatch();
+    if (!Latch || Latch == Load->getParent())
+      return Expr;
+    auto *Start = SE.getUnknown(
+      mGetEntryValue(*Load->getPointerOperand()));
+    if (InductionLoop != mLoop)
+      return Start;
+    auto *CanonLoop = InductionItr->second.second;
+    auto *Step = CanonLoop->getStep();
+    if (!Step || Step->getType() != Start->getType() ||
+        !SE.isLoopInvariant(Step, mLoop))
+      return Expr;
+    return SE.getAddRecExpr(Start, Step, mLoop,
+      CanonLoop->isSigned() ? SCEV::FlagNSW : SCEV::FlagAnyWrap);
+  }
+
+private:
+  Loop *mLoop;
+  const InductionMap *mInductions;
+  EntryValueGetter mGetEntryValue;
+};
+}
+
+/// \brief Returns number of executions of a body of a canonical loop.
+///
+/// The loop must exit from its header only, so the body is executed when
+/// `induction <predicate> end` holds. Specified bounds of the loop must have
+/// the same integer type. This function returns `nullptr` if number of
+/// iterations can not be represented as SCEV.
+static const SCEV * computeTripCount(const CanonicalLoopInfo &CanonLoop,
+    Value *Start, Value *End, bool Signed, ScalarEvolution &SE) {
+  auto *StepC = dyn_cast_or_null<SCEVConstant>(CanonLoop.getStep());
+  if (!StepC || StepC->getAPInt().getMinSignedBits() > 64)
+    return nullptr;
+  auto StepVal = StepC->getAPInt().getSExtValue();
+  if (StepVal == 0)
+    return nullptr;
+  auto *Ty = Start->getType();
+  auto *StartSCEV = SE.getSCEV(Start);
+  auto *EndSCEV = SE.getSCEV(End);
+  bool IsIncrement = StepVal > 0;
+  switch (CanonLoop.getPredicate()) {
+  case CmpInst::ICMP_SLT: case CmpInst::ICMP_ULT:
+    if (!IsIncrement)
+      return nullptr;
+    break;
+  case CmpInst::ICMP_SLE: case CmpInst::ICMP_ULE:
+    if (!IsIncrement)
+      return nullptr;
+    EndSCEV = SE.getAddExpr(EndSCEV, SE.getOne(Ty));
+    break;
+  case CmpInst::ICMP_SGT: case CmpInst::ICMP_UGT:
+    if (IsIncrement)
+      return nullptr;
+    break;
+  case CmpInst::ICMP_SGE: case CmpInst::ICMP_UGE:
+    if (IsIncrement)
+      return nullptr;
+    EndSCEV = SE.getMinusSCEV(EndSCEV, SE.getOne(Ty));
+    break;
+  default:
+    return nullptr;
+  }
+  auto getMax = [&SE, Signed](const SCEV *LHS, const SCEV *RHS) {
+    return Signed ? SE.getSMaxExpr(LHS, RHS) : SE.getUMaxExpr(LHS, RHS);
+  };
+  auto *Distance = IsIncrement ?
+    SE.getMinusSCEV(getMax(EndSCEV, StartSCEV), StartSCEV) :
+    SE.getMinusSCEV(getMax(StartSCEV, EndSCEV), EndSCEV);
+  auto *AbsStep = SE.getConstant(Ty, IsIncrement ? StepVal : -StepVal);
+  return SE.getUDivExpr(
+    SE.getAddExpr(Distance, SE.getMinusSCEV(AbsStep, SE.getOne(Ty))),
+    AbsStep);
+}
+
+void Instrumentation::regStridedAccesses(Loop *L, Value *Start, Value *End,
+    Value *Step, bool Signed, LoopInfo &LI, ScalarEvolution &SE,
+    DominatorTree &DT, DFRegionInfo &RI, const CanonicalLoopSet &CS) {
+  assert(L && "Loop must not be null!");
+  auto *Preheader = L->getLoopPreheader();
+  auto *Latch = L->getLoopLatch();
+  if (!Preheader || !Latch || L->getExitingBlock() != L->getHeader() ||
+      !Start || !End || !Step)
+    return;
+  auto CanonItr = CS.find_as(RI.getRegionFor(L));
+  if (CanonItr == CS.end() || !(*CanonItr)->isCanonical())
+    return;
+  auto *M = Preheader->getModule();
+  auto &Ctx = M->getContext();
+  auto *SizeTy = dyn_cast<IntegerType>(
+    getType(Ctx, IntrinsicId::read_arr_range)->getParamType(2));
+  assert(SizeTy && "Stride must have an integer type!");
+  assert(getType(Ctx, IntrinsicId::read_arr_range)->getParamType(3) == SizeTy &&
+    "Stride and count have different types!");
+  if (Start->getType() != SizeTy || End->getType() != SizeTy)
+    return;
+  auto *TripCount = computeTripCount(**CanonItr, Start, End, Signed, SE);
+  if (!TripCount)
+    return;
+  InductionRewriter::InductionMap Inductions;
+  for (auto *Outer = L; Outer; Outer = Outer->getParentLoop()) {
+    auto OuterItr = CS.find_as(RI.getRegionFor(Outer));
+    if (OuterItr != CS.end() && (*OuterItr)->isCanonical() &&
+        (*OuterItr)->getInduction())
+      Inductions.try_emplace((*OuterItr)->getInduction(), Outer, *OuterItr);
+  }
+  auto &InsertBefore = *Preheader->getTerminator();
+  auto InstrMD = MDNode::get(Ctx, {});
+  DenseMap<Value *, LoadInst *> EntryValues;
+  auto getEntryValue = [&EntryValues, &InsertBefore, &InstrMD](Value &V) {
+    auto Itr = EntryValues.try_emplace(&V, nullptr).first;
+    if (!Itr->second) {
+      Itr->second = new LoadInst(&V, V.getName() + ".entry", &InsertBefore);
+      Itr->second->setMetadata("sapfor.da", InstrMD);
+    }
+    return Itr->second;
+  };
+  InductionRewriter Rewriter(SE, *L, Inductions, getEntryValue);
+  auto &DL = M->getDataLayout();
+  Value *Count = nullptr;
+  bool IsCountUnknown = false;
+  for (auto *BB : L->blocks()) {
+    if (IsCountUnknown)
+      break;
+    // Accesses from inner loops and accesses which may be not executed at some
+    // iterations are ignored.
+    if (LI.getLoopFor(BB) != L || BB == L->getHeader() ||
+        !DT.dominates(BB, Latch))
+      continue;
+    for (auto &I : *BB) {
+      if (I.getMetadata("sapfor.da"))
+        continue;
+      Value *Ptr = nullptr;
+      IntrinsicId Id;
+      if (auto *Load = dyn_cast<LoadInst>(&I)) {
+        if (Load->isVolatile())
+          continue;
+        Ptr = Load->getPointerOperand();
+        Id = IntrinsicId::read_arr_range;
+      } else if (auto *Store = dyn_cast<StoreInst>(&I)) {
+        if (Store->isVolatile())
+          continue;
+        Ptr = Store->getPointerOperand();
+        Id = IntrinsicId::write_arr_range;
+      } else {
+        continue;
+      }
+      auto *BasePtr = Ptr->stripInBoundsOffsets();
+      if (auto *BaseInst = dyn_cast<Instruction>(BasePtr))
+        if (L->contains(BaseInst) ||
+            !DT.dominates(BaseInst->getParent(), L->getHeader()))
+          continue;
+      auto *AddRec =
+        dyn_cast<SCEVAddRecExpr>(Rewriter.visit(SE.getSCEV(Ptr)));
+      if (!AddRec || AddRec->getLoop() != L || !AddRec->isAffine())
+        continue;
+      auto *AddrSCEV = AddRec->getStart();
+      auto *StrideSCEV = AddRec->getStepRecurrence(SE);
+      if (!SE.isLoopInvariant(AddrSCEV, L) ||
+          !isSafeToExpandAt(AddrSCEV, &InsertBefore, SE) ||
+          !isSafeToExpandAt(StrideSCEV, &InsertBefore, SE))
+        continue;
+      auto *Stride = computeSCEV(StrideSCEV, *SizeTy, true, SE, DT,
+        InsertBefore);
+      if (!Stride)
+        continue;
+      if (!Count &&
+          !(Count = computeSCEV(TripCount, *SizeTy, false, SE, DT,
+            InsertBefore))) {
+        IsCountUnknown = true;
+        break;
+      }
+      LLVM_DEBUG(dbgs() << "[INSTR]: register strided access ";
+        I.print(dbgs()); dbgs() << "\n");
+      SCEVExpander Exp(SE, DL, "");
+      auto *Addr = Exp.expandCodeFor(
+        AddrSCEV, Type::getInt8PtrTy(Ctx), &InsertBefore);
+      if (auto *AddrInst = dyn_cast<Instruction>(Addr))
+        setMDForDeadInstructions(AddrInst);
+      auto OpIdx = regMemoryBase(BasePtr, InsertBefore);
+      auto *DILoc = createPointerToDI(
+        regDebugLoc(I.getDebugLoc()), InsertBefore);
+      auto *DIVar = createPointerToDI(OpIdx, InsertBefore);
+      auto *ArrayBase = new BitCastInst(BasePtr, Type::getInt8PtrTy(Ctx),
+        BasePtr->getName() + ".arraybase", &InsertBefore);
+      ArrayBase->setMetadata("sapfor.da", InstrMD);
+      auto *Fun = getDeclaration(M, Id);
+      auto *Call = CallInst::Create(Fun,
+        { DILoc, Addr, Stride, Count, DIVar, ArrayBase }, "", &InsertBefore);
+      Call->setMetadata("sapfor.da", InstrMD);
+      mStridedAccesses.insert(&I);
+      if (Id == IntrinsicId::read_arr_range)
+        ++NumLoadRange;
+      else
+        ++NumStoreRange;
+    }
+  }
+  for (auto &EntryValue : EntryValues)
+    if (EntryValue.second->use_empty())
+      EntryValue.second->eraseFromParent();
 }
 
 void Instrumentation::regLoops(llvm::Function &F, llvm::LoopInfo &LI,
     llvm::ScalarEvolution &SE, llvm::DominatorTree &DT,
     DFRegionInfo &RI, const CanonicalLoopSet &CS) {
-  for_each_loop(LI, [this, &SE, &DT, &RI, &CS, &F](Loop *L) {
+  for_each_loop(LI, [this, &LI, &SE, &DT, &RI, &CS, &F](Loop *L) {
+    if (!isInRegion(*L->getHeader())) {
+      ++NumLoopOutOfRegion;
+      return;
+    }
     LLVM_DEBUG(dbgs()<<"[INSTR]: process loop " << L->getHeader()->getName() <<"\n");
     auto Idx = mDIStrings.regItem(LoopUnique(&F, L)).first;
-    loopBeginInstr(L, Idx, SE, DT, RI, CS);
+    Value *Start, *End, *Step;
+    bool Signed;
+    bool IsSampled = isSampled(*L);
+    // Accesses in nested sampled loops are registered partially, so traits of
+    // the whole loop are also collected for some iterations only.
+    bool HasSampledNested = !IsSampled &&
+      llvm::any_of(L->getLoopsInPreorder(), [this, L](Loop *Nested) {
+        return Nested != L && isInRegion(*Nested->getHeader()) &&
+          isSampled(*Nested);
+      });
+    std::tie(Start, End, Step, Signed) = loopBeginInstr(L, Idx, IsSampled,
+      HasSampledNested, SE, DT, RI, CS);
+    if (mInstrPass->registerRanges())
+      regStridedAccesses(L, Start, End, Step, Signed, LI, SE, DT, RI, CS);
     loopEndInstr(L, Idx);
-    loopIterInstr(L, Idx);
+    auto *IterCall = loopIterInstr(L, Idx);
+    if (IsSampled) {
+      SmallVector<BasicBlock *, 2> Latches;
+      L->getLoopLatches(Latches);
+      mSampledLoops.push_back(SampledLoop{ L->getHeader(), Latches, IterCall });
+    }
     ++NumLoop;
   });
 }
@@ -589,6 +1172,117 @@ void Instrumentation::visit(Function &F) {
   visitFunction(F);
   visit(F.begin(), F.end());
   mDT = nullptr;
+  mStridedAccesses.clear();
+  for (auto &SL : mSampledLoops)
+    sampleLoop(SL);
+  mSampledLoops.clear();
+  bufferEvents(F);
+}
+
+void Instrumentation::bufferEvents(Function &F) {
+  if (!mEventBuffer)
+    return;
+  SmallVector<std::pair<CallInst *, IntrinsicId>, 32> Events;
+  SmallVector<Instruction *, 8> Boundaries;
+  for (auto &I : instructions(F)) {
+    CallSite CS(&I);
+    if (!CS)
+      continue;
+    auto *Callee = dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+    if (!Callee)
+      continue;
+    IntrinsicId LibId;
+    if (getTsarLibFunc(Callee->getName(), LibId)) {
+      if (LibId == IntrinsicId::flush_events ||
+          LibId == IntrinsicId::reg_event_buffer)
+        continue;
+      if (isa<CallInst>(I) &&
+          isBufferedEvent(LibId, *Callee->getFunctionType()))
+        Events.emplace_back(cast<CallInst>(&I), LibId);
+      else
+        Boundaries.push_back(&I);
+    } else if (CS.doesNotReturn()) {
+      Boundaries.push_back(&I);
+    }
+  }
+  for (auto *I : Boundaries) {
+    createFlushEvents(*mEventBuffer, nullptr, *I);
+    ++NumFlush;
+  }
+  for (auto &Event : Events)
+    bufferEvent(*Event.first, Event.second);
+}
+
+void Instrumentation::bufferEvent(CallInst &Call, IntrinsicId Id) {
+  LLVM_DEBUG(dbgs() << "[INSTR]: buffer event "; Call.print(dbgs());
+    dbgs() << "\n");
+  auto &Ctx = Call.getContext();
+  auto InstrMD = MDNode::get(Ctx, {});
+  auto *Int32Ty = Type::getInt32Ty(Ctx);
+  auto *Int64Ty = Type::getInt64Ty(Ctx);
+  auto *Zero = ConstantInt::get(Int32Ty, 0);
+  auto *SizePtr = ConstantExpr::getInBoundsGetElementPtr(
+    mEventBuffer->getValueType(), mEventBuffer,
+    ArrayRef<Constant *>{ Zero, Zero });
+  auto *Size = new LoadInst(SizePtr, "sapfor.ev.size", &Call);
+  Size->setMetadata("sapfor.da", InstrMD);
+  auto Capacity = mInstrPass->getEventBufferSize();
+  // The buffer is rarely empty, so registration should be placed out of
+  // hot path. Registration of an empty buffer allows a runtime library to flush
+  // events of each thread when this thread or the whole program exits.
+  auto *IsEmpty = new ICmpInst(&Call, ICmpInst::ICMP_EQ, Size,
+    ConstantInt::get(Int64Ty, 0), "sapfor.ev.empty");
+  IsEmpty->setMetadata("sapfor.da", InstrMD);
+  auto *Weights = MDBuilder(Ctx).createBranchWeights(1,
+    std::max(Capacity, 2u) - 1);
+  auto *RegTerm = SplitBlockAndInsertIfThen(IsEmpty, &Call, false, Weights);
+  RegTerm->setMetadata("sapfor.da", InstrMD);
+  IsEmpty->getParent()->getTerminator()->setMetadata("sapfor.da", InstrMD);
+  auto *RegBuffer = CallInst::Create(
+    getDeclaration(Call.getModule(), IntrinsicId::reg_event_buffer),
+    { SizePtr }, "", RegTerm);
+  RegBuffer->setMetadata("sapfor.da", InstrMD);
+  auto *Event = GetElementPtrInst::CreateInBounds(mEventBuffer,
+    { Zero, ConstantInt::get(Int32Ty, 1), Size }, "sapfor.ev", &Call);
+  Event->setMetadata("sapfor.da", InstrMD);
+  auto storeField = [&Call, Event, Int32Ty, Zero, InstrMD](
+      unsigned FieldNo, Value *V) {
+    auto *FieldPtr = GetElementPtrInst::CreateInBounds(Event,
+      { Zero, ConstantInt::get(Int32Ty, FieldNo) }, "", &Call);
+    FieldPtr->setMetadata("sapfor.da", InstrMD);
+    auto *Store = new StoreInst(V, FieldPtr, &Call);
+    Store->setMetadata("sapfor.da", InstrMD);
+  };
+  // Address of an intrinsic identifies an event, so a runtime library does
+  // not depend on the order of intrinsics in IntrinsicId.
+  storeField(0, ConstantExpr::getPtrToInt(
+    getDeclaration(Call.getModule(), Id), Int64Ty));
+  for (unsigned I = 0, EI = Call.getNumArgOperands(); I < EI; ++I) {
+    Value *Arg = Call.getArgOperand(I);
+    if (Arg->getType() != Int64Ty) {
+      auto *Cast = Arg->getType()->isPointerTy() ?
+        new PtrToIntInst(Arg, Int64Ty, "", &Call) :
+        CastInst::CreateIntegerCast(Arg, Int64Ty, false, "", &Call);
+      Cast->setMetadata("sapfor.da", InstrMD);
+      Arg = Cast;
+    }
+    storeField(I + 1, Arg);
+  }
+  auto *NextSize = BinaryOperator::CreateNUW(BinaryOperator::Add, Size,
+    ConstantInt::get(Int64Ty, 1), "sapfor.ev.next", &Call);
+  NextSize->setMetadata("sapfor.da", InstrMD);
+  auto *StoreSize = new StoreInst(NextSize, SizePtr, &Call);
+  StoreSize->setMetadata("sapfor.da", InstrMD);
+  auto *IsFull = new ICmpInst(&Call, ICmpInst::ICMP_EQ, NextSize,
+    ConstantInt::get(Int64Ty, Capacity), "sapfor.ev.full");
+  IsFull->setMetadata("sapfor.da", InstrMD);
+  // The buffer is rarely full, so flush should be placed out of hot path.
+  auto *FlushTerm = SplitBlockAndInsertIfThen(IsFull, &Call, false, Weights);
+  FlushTerm->setMetadata("sapfor.da", InstrMD);
+  IsFull->getParent()->getTerminator()->setMetadata("sapfor.da", InstrMD);
+  createFlushEvents(*mEventBuffer, NextSize, *FlushTerm);
+  Call.eraseFromParent();
+  ++NumEvent;
 }
 
 void Instrumentation::regFunction(Value &F, Type *ReturnTy, unsigned Rank,
@@ -646,9 +1340,69 @@ void Instrumentation::visitFunction(llvm::Function &F) {
   auto &CanonicalLoop = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
   auto &SE = Provider.get<ScalarEvolutionWrapperPass>().getSE();
   mDT = &Provider.get<DominatorTreeWrapperPass>().getDomTree();
+  collectRegionBlocks(F, LoopInfo);
   regLoops(F, LoopInfo, SE, *mDT, RegionInfo, CanonicalLoop);
 }
 
+void Instrumentation::collectRegionBlocks(Function &F, LoopInfo &LI) {
+  mRegionBlocks.clear();
+  mAfterRegionBlocks.clear();
+  auto Regions = mInstrPass->getRegions();
+  mIsFunctionInRegion = Regions.empty() ||
+    std::any_of(Regions.begin(), Regions.end(),
+      [&F](const OptimizationRegion *R) {
+        auto Status = R->contain(F);
+        return Status == OptimizationRegion::CS_Always ||
+          Status == OptimizationRegion::CS_Condition;
+      });
+  if (mIsFunctionInRegion)
+    return;
+  if (mAfterRegionFunctions.count(&F)) {
+    for (auto &BB : F)
+      mAfterRegionBlocks.insert(&BB);
+    return;
+  }
+  // Function contains some loops from regions only. Outermost loops which
+  // are in regions are collected, inner loops are processed implicitly.
+  std::vector<Loop *> Worklist(LI.begin(), LI.end());
+  std::vector<BasicBlock *> AfterWorklist;
+  while (!Worklist.empty()) {
+    auto *L = Worklist.back();
+    Worklist.pop_back();
+    if (std::any_of(Regions.begin(), Regions.end(),
+          [L](const OptimizationRegion *R) { return R->contain(*L); })) {
+      mRegionBlocks.insert(L->block_begin(), L->block_end());
+      SmallVector<BasicBlock *, 4> ExitBlocks;
+      L->getExitBlocks(ExitBlocks);
+      AfterWorklist.insert(AfterWorklist.end(), ExitBlocks.begin(),
+        ExitBlocks.end());
+    } else {
+      Worklist.insert(Worklist.end(), L->begin(), L->end());
+    }
+  }
+  // Code after a call of a function which executes some region may use
+  // memory written in this region.
+  for (auto &I : instructions(F)) {
+    CallSite CS(&I);
+    if (!CS)
+      continue;
+    auto *Callee = dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+    if (Callee && mRegionFunctions.count(Callee))
+      AfterWorklist.push_back(I.getParent());
+  }
+  while (!AfterWorklist.empty()) {
+    auto *BB = AfterWorklist.back();
+    AfterWorklist.pop_back();
+    if (mRegionBlocks.count(BB) || !mAfterRegionBlocks.insert(BB).second)
+      continue;
+    for (auto *SuccBB : successors(BB))
+      AfterWorklist.push_back(SuccBB);
+  }
+  LLVM_DEBUG(dbgs() << "[INSTR]: number of basic blocks in regions "
+                    << mRegionBlocks.size() << ", after regions "
+                    << mAfterRegionBlocks.size() << "\n");
+}
+
 void Instrumentation::regArgs(Function &F, LoadInst *DIFunc) {
   auto InstrMD = MDNode::get(F.getContext(), {});
   auto *BytePtrTy = Type::getInt8PtrTy(F.getContext());
@@ -730,6 +1484,8 @@ void Instrumentation::visitCallSite(llvm::CallSite CS) {
     return;
   DIStringRegister::IdTy FuncIdx = 0;
   auto *Inst = CS.getInstruction();
+  if (!isInRegion(*Inst->getParent()))
+    return;
   LLVM_DEBUG(dbgs() << "[INSTR]: process "; Inst->print(dbgs()); dbgs() << "\n");
   auto *M = Inst->getModule();
   if (auto *Callee = llvm::dyn_cast<llvm::Function>(
@@ -742,6 +1498,17 @@ void Instrumentation::visitCallSite(llvm::CallSite CS) {
     if(Callee->getMetadata("sapfor.da") ||
        getTsarLibFunc(Callee->getName(), LibId))
       return;
+    // Calls of library functions which do not access memory (for example,
+    // math functions) do not produce any events for the dynamic analyzer.
+    if (auto *Summary = findLibFuncSummary(*Callee))
+      if (Summary->onlyAccessesArgMemory(*Callee) &&
+          Summary->onlyReadsMemory(*Callee) &&
+          llvm::none_of(CS.args(), [](const llvm::Use &Arg) {
+            return Arg->getType()->isPointerTy();
+          })) {
+        ++NumSkippedCall;
+        return;
+      }
     FuncIdx = mDIStrings[Callee];
   } else {
     auto CalledValue = CS.getCalledValue();
@@ -776,24 +1543,7 @@ Instrumentation::regMemoryAccessArgs(Value *Ptr, const DebugLoc &DbgLoc,
     Instruction &InsertBefore) {
   auto &Ctx = InsertBefore.getContext();
   auto BasePtr = Ptr->stripInBoundsOffsets();
-  DIStringRegister::IdTy OpIdx = 0;
-  if (auto AI = dyn_cast<AllocaInst>(BasePtr)) {
-    OpIdx = mDIStrings[AI];
-  } else if (auto GV = dyn_cast<GlobalVariable>(BasePtr)) {
-    OpIdx = mDIStrings[GV];
-  } else {
-    auto Info = mDIStrings.regItem(BasePtr);
-    OpIdx = Info.first;
-    if (Info.second) {
-      auto M = InsertBefore.getModule();
-      assert(mDT && "Dominator tree must not be null!");
-      auto DIM =
-        buildDIMemory(MemoryLocation(BasePtr), Ctx, M->getDataLayout(), *mDT);
-      auto ArraySize = ConstantInt::get(Type::getInt64Ty(Ctx), 1);
-      regValue(BasePtr, BasePtr->getType(), ArraySize,
-        DIM ? &*DIM : nullptr, OpIdx, InsertBefore, *InsertBefore.getModule());
-    }
-  }
+  auto OpIdx = regMemoryBase(BasePtr, InsertBefore);
   auto DbgLocIdx = regDebugLoc(DbgLoc);
   auto DILoc = createPointerToDI(DbgLocIdx, InsertBefore);
   auto Addr = new BitCastInst(Ptr,
@@ -813,6 +1563,26 @@ Instrumentation::regMemoryAccessArgs(Value *Ptr, const DebugLoc &DbgLoc,
   return std::make_tuple(DILoc, Addr, DIVar, ArrayBase);
 }
 
+auto Instrumentation::regMemoryBase(Value *BasePtr,
+    Instruction &InsertBefore) -> DIStringRegister::IdTy {
+  if (auto AI = dyn_cast<AllocaInst>(BasePtr))
+    return mDIStrings[AI];
+  if (auto GV = dyn_cast<GlobalVariable>(BasePtr))
+    return mDIStrings[GV];
+  auto Info = mDIStrings.regItem(BasePtr);
+  if (Info.second) {
+    auto &Ctx = InsertBefore.getContext();
+    auto M = InsertBefore.getModule();
+    assert(mDT && "Dominator tree must not be null!");
+    auto DIM =
+      buildDIMemory(MemoryLocation(BasePtr), Ctx, M->getDataLayout(), *mDT);
+    auto ArraySize = ConstantInt::get(Type::getInt64Ty(Ctx), 1);
+    regValue(BasePtr, BasePtr->getType(), ArraySize,
+      DIM ? &*DIM : nullptr, Info.first, InsertBefore, *M);
+  }
+  return Info.first;
+}
+
 void Instrumentation::visitInstruction(Instruction &I) {
   if (I.mayReadOrWriteMemory()) {
     SmallString<64> IStr;
@@ -830,7 +1600,8 @@ void Instrumentation::visitInstruction(Instruction &I) {
 }
 
 void Instrumentation::regReadMemory(Instruction &I, Value &Ptr) {
-  if (I.getMetadata("sapfor.da"))
+  if (I.getMetadata("sapfor.da") || mStridedAccesses.count(&I) ||
+      (!isInRegion(*I.getParent()) && !isAfterRegion(*I.getParent())))
     return;
   LLVM_DEBUG(dbgs() << "[INSTR]: process "; I.print(dbgs()); dbgs() << "\n");
   auto *M = I.getModule();
@@ -851,7 +1622,8 @@ void Instrumentation::regReadMemory(Instruction &I, Value &Ptr) {
 }
 
 void Instrumentation::regWriteMemory(Instruction &I, Value &Ptr) {
-  if (I.getMetadata("sapfor.da"))
+  if (I.getMetadata("sapfor.da") || mStridedAccesses.count(&I) ||
+      (!isInRegion(*I.getParent()) && !isAfterRegion(*I.getParent())))
     return;
   LLVM_DEBUG(dbgs() << "[INSTR]: process "; I.print(dbgs()); dbgs() << "\n");
   BasicBlock::iterator InsertBefore(I);
@@ -1270,6 +2042,32 @@ void tsar::visitEntryPoint(Function &Entry, ArrayRef<Module *> Modules) {
   }
   auto *EntryM = Entry.getParent();
   assert(EntryM && "Entry point must be in a module!");
+  // All modules share the same buffer of events, so it is enough to flush
+  // the buffer before exit from the entry point.
+  Optional<uint64_t> EventBufferSize;
+  for (auto *M : Modules) {
+    auto NamedMD = M->getNamedMetadata("sapfor.da");
+    if (!NamedMD)
+      continue;
+    auto *BufferMD = getMDOfKind(*NamedMD, "sapfor.event.buffer");
+    if (!BufferMD)
+      continue;
+    auto *Size = extractMD<ConstantInt>(*BufferMD).first;
+    if (!Size ||
+        (EventBufferSize && *EventBufferSize != Size->getZExtValue()))
+      report_fatal_error(Twine("'sapfor.event.buffer' is not available for ") +
+        M->getSourceFileName());
+    EventBufferSize = Size->getZExtValue();
+  }
+  if (EventBufferSize) {
+    auto *Buffer = getOrCreateEventBuffer(*EntryM, *EventBufferSize);
+    if (!Buffer)
+      report_fatal_error(Twine("'sapfor.event.buffer' is not available for ") +
+        EntryM->getSourceFileName());
+    for (auto &BB : Entry)
+      if (isa<ReturnInst>(BB.getTerminator()))
+        createFlushEvents(*Buffer, nullptr, *BB.getTerminator());
+  }
   auto *InsertBefore = &Entry.getEntryBlock().front();
   auto AllocatePoolFunc = getDeclaration(EntryM, IntrinsicId::allocate_pool);
   auto PoolSizeV = ConstantInt::get(PoolSizeTy, PoolSize);
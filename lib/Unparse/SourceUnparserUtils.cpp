@@ -28,12 +28,15 @@
 #include "tsar/Unparse/CSourceUnparser.h"
 #include "tsar/Unparse/FortranSourceUnparser.h"
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
+#include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
+#include <llvm/ADT/SmallString.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/BinaryFormat/Dwarf.h>
 #include <llvm/Support/ErrorHandling.h>
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/CallSite.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
 
 using namespace llvm;
 
@@ -88,6 +91,41 @@ bool unparsePrint(unsigned DWLang,
   return false;
 }
 
+/// Returns a cached source-level representation of a specified memory,
+/// the location is unparsed if there is no cached representation.
+static const DIMemoryEnvironment::SourceRepresentation &
+getSourceRepresentation(unsigned DWLang, const DIEstimateMemory &M,
+    bool IsMinimal) {
+  auto &Env = const_cast<DIEstimateMemory &>(M).getEnv();
+  auto &Reprs = Env.getSourceRepresentations()[&M];
+  for (auto &R : Reprs)
+    if (R.DWLang == DWLang && R.IsMinimal == IsMinimal)
+      return R;
+  DIMemoryLocation Loc{
+    const_cast<DIVariable *>(M.getVariable()),
+    const_cast<DIExpression *>(M.getExpression()), nullptr, M.isTemplate() };
+  SmallString<32> Str;
+  auto IsValid = unparseToString(DWLang, Loc, Str, IsMinimal);
+  Reprs.push_back({ DWLang, IsMinimal, IsValid, Str.str() });
+  return Reprs.back();
+}
+
+bool unparseToString(unsigned DWLang,
+    const DIEstimateMemory &M, llvm::SmallVectorImpl<char> &S, bool IsMinimal) {
+  auto &R = getSourceRepresentation(DWLang, M, IsMinimal);
+  if (R.IsValid)
+    S.append(R.Str.begin(), R.Str.end());
+  return R.IsValid;
+}
+
+bool unparsePrint(unsigned DWLang,
+    const DIEstimateMemory &M, llvm::raw_ostream &OS, bool IsMinimal) {
+  auto &R = getSourceRepresentation(DWLang, M, IsMinimal);
+  if (R.IsValid)
+    OS << R.Str;
+  return R.IsValid;
+}
+
 bool unparseDump(unsigned DWLang, const DIMemoryLocation &Loc, bool IsMinimal) {
   switch (DWLang) {
   case dwarf::DW_LANG_C:
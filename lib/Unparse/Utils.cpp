@@ -131,7 +131,7 @@ void printDILocationSource(unsigned DWLang,
       return;
     }
     O << "<";
-    if (!unparsePrint(DWLang, TmpLoc, O))
+    if (!unparsePrint(DWLang, *EM, O))
       O << "?" << TmpLoc.Var->getName() << "?";
     printDbgLoc();
     O << ", ";
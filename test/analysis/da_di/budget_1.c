@@ -0,0 +1,55 @@
+double U[100], V[100];
+
+void foo() {
+  // Each loop needs more than one dependence test, so the budget is
+  // exhausted twice, but the warning is emitted only once.
+  for (int I = 1; I < 100; ++I)
+    U[I] = U[I - 1] + 1;
+  for (int I = 0; I < 100; ++I)
+    V[I] = V[I] * 2;
+}
+//CHECK: warning: budget_1.c:6:3: in function foo void (): analysis budget exceeded, conservative dependencies are assumed
+//CHECK: 
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK:  loop at depth 1 budget_1.c:6:3
+//CHECK:    output:
+//CHECK:     <U, 800>
+//CHECK:    anti:
+//CHECK:     <U, 800>
+//CHECK:    flow:
+//CHECK:     <U, 800>
+//CHECK:    induction:
+//CHECK:     <I:6:12, 4>:[Int,1,100,1]
+//CHECK:    lock:
+//CHECK:     <I:6:12, 4>
+//CHECK:    header access:
+//CHECK:     <I:6:12, 4>
+//CHECK:    explicit access:
+//CHECK:     <I:6:12, 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:6:12, 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:6:12, 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:6:12, 4> <U, 800>
+//CHECK:  loop at depth 1 budget_1.c:8:3
+//CHECK:    output:
+//CHECK:     <V, 800>
+//CHECK:    anti:
+//CHECK:     <V, 800>
+//CHECK:    flow:
+//CHECK:     <V, 800>
+//CHECK:    induction:
+//CHECK:     <I:8:12, 4>:[Int,0,100,1]
+//CHECK:    lock:
+//CHECK:     <I:8:12, 4>
+//CHECK:    header access:
+//CHECK:     <I:8:12, 4>
+//CHECK:    explicit access:
+//CHECK:     <I:8:12, 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:8:12, 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:8:12, 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:8:12, 4> <V, 800>
@@ -0,0 +1,41 @@
+void set(int *X);
+
+void bar(int N, int * restrict A) {
+  for (int I = 0; I < N; ++I) {
+    int X;
+    // The imported summary states that 'set' always writes 'X', so 'X' is
+    // private.
+    set(&X);
+    A[I] = X;
+  }
+}
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'bar':
+//CHECK:  loop at depth 1 summary_1.c:4:3
+//CHECK:    shared:
+//CHECK:     <*A:3:32, ?>
+//CHECK:    first private:
+//CHECK:     <*A:3:32, ?>
+//CHECK:    dynamic private:
+//CHECK:     <*A:3:32, ?>
+//CHECK:    private:
+//CHECK:     <X:5:9, 4>
+//CHECK:    induction:
+//CHECK:     <I:4:12, 4>:[Int,0,,1]
+//CHECK:    read only:
+//CHECK:     <A:3:32, 8> | <N:3:14, 4>
+//CHECK:    lock:
+//CHECK:     <I:4:12, 4> | <N:3:14, 4>
+//CHECK:    header access:
+//CHECK:     <I:4:12, 4> | <N:3:14, 4>
+//CHECK:    explicit access:
+//CHECK:     <A:3:32, 8> | <I:4:12, 4> | <N:3:14, 4> | <X:5:9, 4>
+//CHECK:    address access:
+//CHECK:     <X:5:9, 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <A:3:32, 8> <I:4:12, 4> <N:3:14, 4> <X:5:9, 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:4:12, 4> <N:3:14, 4>
+//CHECK:    address access (separate):
+//CHECK:     <X:5:9, 4>
+//CHECK:    direct access (separate):
+//CHECK:     <*A:3:32, ?> <A:3:32, 8> <I:4:12, 4> <N:3:14, 4> <X:5:9, 4>
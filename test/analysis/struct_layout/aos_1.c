@@ -0,0 +1,18 @@
+struct Particle {
+  double X, Y, Z;
+  double VX, VY, VZ;
+  double Mass;
+  int Id;
+};
+
+static struct Particle P[1000];
+
+void move(double DT) {
+  for (int I = 0; I < 1000; ++I)
+    P[I].X += P[I].VX * DT;
+}
+//CHECK: Printing analysis 'Structure Layout Advisor':
+//CHECK: array 'P' of structures 'Particle' (64 bytes) is local to translation unit
+//CHECK:   accessed fields: X VX
+//CHECK:   structure of arrays saves 48000 of 64000 bytes
+//CHECK:   hot/cold splitting saves 48000 of 64000 bytes, cold fields: Y Z VY VZ Mass Id
@@ -92,6 +92,20 @@ void sapforWriteArrEnd(void *DILoc, void *Addr, void *DIVar, void *ArrBase) {
   printf("DIVar = %s\nDILoc = %s\n\n", DIVar, DILoc);
 }
 
+void sapforReadArrRange(void *DILoc, void *Addr, uint64_t Stride,
+    uint64_t Count, void *DIVar, void *ArrBase) {
+  printf("called sapforReadArrRange\n");
+  printf("DIVar = %s\nDILoc = %s\nStride = %ju\nCount = %ju\n\n",
+    DIVar, DILoc, Stride, Count);
+}
+
+void sapforWriteArrRange(void *DILoc, void *Addr, uint64_t Stride,
+    uint64_t Count, void *DIVar, void *ArrBase) {
+  printf("called sapforWriteArrRange\n");
+  printf("DIVar = %s\nDILoc = %s\nStride = %ju\nCount = %ju\n\n",
+    DIVar, DILoc, Stride, Count);
+}
+
 //===--------------------- Registration of a function ---------------------===//
 void sapforFuncBegin(void *DIFunc) {
   printf("called sapforFuncBegin\n");
@@ -166,4 +180,64 @@ void sapforSLIter(void *DILoop, uint64_t Iter) {
   printf("DILoop = %s\n\n", DILoop);
   printf("Iteration = %lld\n", Iter);
 }
+
+//===------------------- Processing of buffered events --------------------===//
+// Each record contains address of a function which should be called and
+// its arguments (see -instr-buffer option).
+struct SapforEvent {
+  uint64_t Kind;
+  uint64_t Args[6];
+};
+
+void sapforFlushEvents(SapforEvent *Events, uint64_t Size) {
+  printf("called sapforFlushEvents\n");
+  printf("Size = %ju\n\n", Size);
+  for (uint64_t I = 0; I < Size; ++I) {
+    auto Kind = Events[I].Kind;
+    auto *A = Events[I].Args;
+#define ARG(N) reinterpret_cast<void *>(A[N])
+    if (Kind == reinterpret_cast<uint64_t>(&sapforRegVar))
+      sapforRegVar(ARG(0), ARG(1));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforRegArr))
+      sapforRegArr(ARG(0), A[1], ARG(2));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforReadVar))
+      sapforReadVar(ARG(0), ARG(1), ARG(2));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforReadArr))
+      sapforReadArr(ARG(0), ARG(1), ARG(2), ARG(3));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforWriteVarEnd))
+      sapforWriteVarEnd(ARG(0), ARG(1), ARG(2));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforWriteArrEnd))
+      sapforWriteArrEnd(ARG(0), ARG(1), ARG(2), ARG(3));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforReadArrRange))
+      sapforReadArrRange(ARG(0), ARG(1), A[2], A[3], ARG(4), ARG(5));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforWriteArrRange))
+      sapforWriteArrRange(ARG(0), ARG(1), A[2], A[3], ARG(4), ARG(5));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforFuncBegin))
+      sapforFuncBegin(ARG(0));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforFuncEnd))
+      sapforFuncEnd(ARG(0));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforRegDummyVar))
+      sapforRegDummyVar(ARG(0), ARG(1), ARG(2), A[3]);
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforRegDummyArr))
+      sapforRegDummyArr(ARG(0), A[1], ARG(2), ARG(3), A[4]);
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforFuncCallBegin))
+      sapforFuncCallBegin(ARG(0), ARG(1));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforFuncCallEnd))
+      sapforFuncCallEnd(ARG(0));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforSLBegin))
+      sapforSLBegin(ARG(0), A[1], A[2], A[3]);
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforSLEnd))
+      sapforSLEnd(ARG(0));
+    else if (Kind == reinterpret_cast<uint64_t>(&sapforSLIter))
+      sapforSLIter(ARG(0), A[1]);
+    else
+      printf("unknown event %ju\n\n", Kind);
+#undef ARG
+  }
+}
+
+void sapforRegEventBuffer(uint64_t *Buffer) {
+  printf("called sapforRegEventBuffer\n");
+  printf("Buffer = %p\n\n", Buffer);
+}
 }
@@ -0,0 +1,8 @@
+double A[100], B[100];
+
+void foo() {
+  // Accesses are registered at each iteration without -instr-range.
+  for (int I = 0; I < 100; ++I)
+    A[I] = B[I] + 1;
+}
+//CHECK: 0
@@ -0,0 +1,183 @@
+//===--- Runtime.cpp ---------- Runtime Benchmark ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark measures throughput (events per second) of the reference
+// runtime library. It emulates events which are produced by the following
+// instrumented loop nest:
+//
+// for (I = 0; I < Size; ++I)
+//   for (J = 1; J < Size; ++J)
+//     A[J] = A[J - 1] + X;
+//
+// Events are passed to the runtime with direct calls and with buffers
+// (see sapforFlushEvents()).
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Runtime/Runtime.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+void *Pool[5];
+char DIFile[] = "type=file_name*file=bench.c**";
+char DIOuter[] = "type=seqloop*file=bench.c*bounds=0*line1=1*col1=1**";
+char DIInner[] = "type=seqloop*file=bench.c*bounds=0*line1=2*col1=3**";
+char DIArray[] =
+  "type=arr_name*rank=1*vtype=0*file=bench.c*line1=1*col1=1*name1=A*local=0**";
+char DIScalar[] =
+  "type=var_name*vtype=0*file=bench.c*line1=1*col1=1*name1=X*local=0**";
+
+void initialize() {
+  void **P;
+  sapforAllocatePool(&P, 5);
+  uint64_t Ids[] = { 0 };
+  uint64_t Sizes[] = { 64 };
+  sapforDeclTypes(1, Ids, Sizes);
+  sapforInitDI(&Pool[0], DIFile, 0);
+  sapforInitDI(&Pool[1], DIOuter, 1);
+  sapforInitDI(&Pool[2], DIInner, 2);
+  sapforInitDI(&Pool[3], DIArray, 3);
+  sapforInitDI(&Pool[4], DIScalar, 4);
+}
+
+void runDirect(std::vector<uint64_t> &A, uint64_t &X) {
+  auto Size = A.size();
+  sapforRegArr(Pool[3], Size, A.data());
+  sapforRegVar(Pool[4], &X);
+  sapforSLBegin(Pool[1], 0, Size - 1, 1);
+  for (uint64_t I = 0; I < Size; ++I) {
+    sapforSLIter(Pool[1], I + 1);
+    sapforSLBegin(Pool[2], 1, Size - 1, 1);
+    for (uint64_t J = 1; J < Size; ++J) {
+      sapforSLIter(Pool[2], J);
+      sapforReadArr(Pool[0], &A[J - 1], Pool[3], A.data());
+      sapforReadVar(Pool[0], &X, Pool[4]);
+      A[J] = A[J - 1] + X;
+      sapforWriteArrEnd(Pool[0], &A[J], Pool[3], A.data());
+    }
+    sapforSLEnd(Pool[2]);
+  }
+  sapforSLEnd(Pool[1]);
+}
+
+class EventBuffer {
+public:
+  explicit EventBuffer(std::size_t Capacity) : mEvents(Capacity) {}
+  ~EventBuffer() { flush(); }
+
+  template<class... ArgsT> void push(void *Intrinsic, ArgsT... Args) {
+    auto &E = mEvents[mSize];
+    E.Kind = reinterpret_cast<uint64_t>(Intrinsic);
+    uint64_t Values[] = { toInt(Args)... };
+    for (std::size_t I = 0; I < sizeof...(Args); ++I)
+      E.Args[I] = Values[I];
+    if (++mSize == mEvents.size())
+      flush();
+  }
+
+  void flush() {
+    sapforFlushEvents(mEvents.data(), mSize);
+    mSize = 0;
+  }
+
+private:
+  static uint64_t toInt(void *V) { return reinterpret_cast<uint64_t>(V); }
+  static uint64_t toInt(uint64_t V) { return V; }
+
+  std::vector<SapforEvent> mEvents;
+  std::size_t mSize = 0;
+};
+
+void runBuffered(std::vector<uint64_t> &A, uint64_t &X, std::size_t Capacity) {
+  auto Size = A.size();
+  EventBuffer B(Capacity);
+  auto *Read = reinterpret_cast<void *>(&sapforReadVar);
+  auto *ReadArr = reinterpret_cast<void *>(&sapforReadArr);
+  auto *WriteArr = reinterpret_cast<void *>(&sapforWriteArrEnd);
+  auto *Iter = reinterpret_cast<void *>(&sapforSLIter);
+  auto *Begin = reinterpret_cast<void *>(&sapforSLBegin);
+  auto *End = reinterpret_cast<void *>(&sapforSLEnd);
+  B.push(reinterpret_cast<void *>(&sapforRegArr), Pool[3], Size,
+    static_cast<void *>(A.data()));
+  B.push(reinterpret_cast<void *>(&sapforRegVar), Pool[4],
+    static_cast<void *>(&X));
+  B.push(Begin, Pool[1], uint64_t(0), Size - 1, uint64_t(1));
+  for (uint64_t I = 0; I < Size; ++I) {
+    B.push(Iter, Pool[1], I + 1);
+    B.push(Begin, Pool[2], uint64_t(1), Size - 1, uint64_t(1));
+    for (uint64_t J = 1; J < Size; ++J) {
+      B.push(Iter, Pool[2], J);
+      B.push(ReadArr, Pool[0], static_cast<void *>(&A[J - 1]), Pool[3],
+        static_cast<void *>(A.data()));
+      B.push(Read, Pool[0], static_cast<void *>(&X), Pool[4]);
+      A[J] = A[J - 1] + X;
+      B.push(WriteArr, Pool[0], static_cast<void *>(&A[J]), Pool[3],
+        static_cast<void *>(A.data()));
+    }
+    B.push(End, Pool[2]);
+  }
+  B.push(End, Pool[1]);
+}
+
+template<class FuncT> void measure(const std::string &Name, FuncT &&F) {
+  auto NumEvents = tsar::rt::getNumberOfEvents();
+  auto Start = std::chrono::high_resolution_clock::now();
+  F();
+  auto End = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> Diff = End - Start;
+  NumEvents = tsar::rt::getNumberOfEvents() - NumEvents;
+  std::cout << Name << "events " << NumEvents << ", time (.s) "
+    << Diff.count() << ", events per second "
+    << static_cast<uint64_t>(NumEvents / Diff.count()) << "\n";
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <size of array> [capacity of event buffer]\n";
+  if (Argc < 2) {
+    std::cerr << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 3) {
+    std::cerr << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  std::size_t Capacity = (Argc > 2) ? std::atoll(Argv[2]) : 1024;
+  if (Size < 2) {
+    std::cerr << "error: invalid size of array\n" << Help;
+    return 3;
+  }
+  if (Capacity == 0) {
+    std::cerr << "error: invalid capacity of event buffer\n" << Help;
+    return 4;
+  }
+  initialize();
+  std::vector<uint64_t> A(Size, 1);
+  uint64_t X = 1;
+  measure("  direct calls: ", [&A, &X]() { runDirect(A, X); });
+  measure("  buffered events: ",
+    [&A, &X, Capacity]() { runBuffered(A, X, Capacity); });
+  return tsar::rt::writeResults() ? 0 : 5;
+}
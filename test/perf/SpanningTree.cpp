@@ -0,0 +1,355 @@
+//===- SpanningTree.cpp ------- Spanning Tree Benchmark ---------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark compares different implementations of ancestor and lowest
+// common ancestor queries in a spanning tree:
+// - numbers of nodes are stored in a map and the lowest common ancestor is
+//   found by walking up parents (previous implementation),
+// - numbers of nodes are stored in a map and the lowest common ancestor is
+//   found with the Euler tour and the sparse table,
+// - numbers of nodes are stored in nodes and the lowest common ancestor is
+//   found with the Euler tour and the sparse table (alias trees).
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Core/tsar-config.h>
+#include <tsar/ADT/GraphNumbering.h>
+#include <tsar/ADT/SpanningTreeRelation.h>
+#include <llvm/ADT/GraphTraits.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+struct Node {
+  Node *Parent = nullptr;
+  std::vector<Node *> Children;
+  std::size_t Depth = 0;
+  mutable SpanningTreeNumber mSpanningTreeNumber;
+};
+
+/// Tree which stores numbers of nodes in nodes (as alias trees do).
+struct Tree {
+  std::vector<std::unique_ptr<Node>> Nodes;
+  mutable std::shared_ptr<SpanningTreeNumbering<Node *>> mSpanningTree;
+
+  const Node * getTopLevelNode() const { return Nodes.front().get(); }
+};
+
+/// Tree which numbers are stored in a map.
+struct MapTree {
+  Tree *T;
+};
+}
+
+namespace llvm {
+template<> struct GraphTraits<Node *> {
+  using NodeRef = Node *;
+  static NodeRef getEntryNode(Node *N) noexcept { return N; }
+  using ChildIteratorType = std::vector<Node *>::iterator;
+  static ChildIteratorType child_begin(NodeRef N) {
+    return N->Children.begin();
+  }
+  static ChildIteratorType child_end(NodeRef N) { return N->Children.end(); }
+};
+
+template<> struct GraphTraits<Inverse<Node *>> {
+  using NodeRef = Node *;
+  static NodeRef getEntryNode(Inverse<Node *> N) noexcept { return N.Graph; }
+  using ChildIteratorType = Node **;
+  static ChildIteratorType child_begin(NodeRef N) { return &N->Parent; }
+  static ChildIteratorType child_end(NodeRef N) {
+    return N->Parent ? &N->Parent + 1 : &N->Parent;
+  }
+};
+
+template<> struct GraphTraits<Tree *> : public GraphTraits<Node *> {
+  static NodeRef getEntryNode(Tree *T) noexcept { return T->Nodes[0].get(); }
+  static std::size_t size(Tree *T) { return T->Nodes.size(); }
+};
+
+template<> struct GraphTraits<Inverse<Tree *>> :
+  public GraphTraits<Inverse<Node *>> {};
+
+template<> struct GraphTraits<MapTree> : public GraphTraits<Node *> {
+  static NodeRef getEntryNode(MapTree T) noexcept {
+    return T.T->Nodes[0].get();
+  }
+  static std::size_t size(MapTree T) { return T.T->Nodes.size(); }
+};
+
+template<> struct GraphTraits<Inverse<MapTree>> :
+  public GraphTraits<Inverse<Node *>> {};
+}
+
+namespace tsar {
+template<> struct SpanningTreeTraits<Tree *> :
+  public IntrusiveSpanningTreeTraits<Tree *, Tree, Node> {};
+}
+
+namespace {
+/// Previous implementation of a relation between nodes in a spanning tree.
+class ParentWalkRelation {
+public:
+  explicit ParentWalkRelation(MapTree T) { numberGraph(T, &mNumbering); }
+
+  TreeRelation compare(Node *LHS, Node *RHS) const {
+    if (LHS == RHS)
+      return TR_EQUAL;
+    auto LeftItr = mNumbering.find(LHS);
+    auto RightItr = mNumbering.find(RHS);
+    if (LeftItr->get<Preorder>() < RightItr->get<Preorder>() &&
+        LeftItr->get<ReversePostorder>() < RightItr->get<ReversePostorder>())
+      return TR_ANCESTOR;
+    if (LeftItr->get<Preorder>() > RightItr->get<Preorder>() &&
+        LeftItr->get<ReversePostorder>() > RightItr->get<ReversePostorder>())
+      return TR_DESCENDANT;
+    return TR_UNREACHABLE;
+  }
+
+  Node * findParent(Node *N) const {
+    return N->Parent && compare(N, N->Parent) == TR_DESCENDANT ?
+      N->Parent : nullptr;
+  }
+
+  Node * findLCA(Node *const *BeginItr, Node *const *EndItr) const {
+    auto *LCA = findParent(*BeginItr);
+    if (!LCA)
+      return nullptr;
+    for (auto CurrItr = BeginItr + 1; CurrItr != EndItr; ++CurrItr) {
+      auto R = compare(LCA, *CurrItr);
+      for (; R == TR_UNREACHABLE || R == TR_EQUAL;
+             R = compare(LCA, *CurrItr))
+        if (!(LCA = findParent(LCA)))
+          return nullptr;
+      if (R == TR_DESCENDANT && !(LCA = findParent(*CurrItr)))
+        return nullptr;
+    }
+    return LCA;
+  }
+
+private:
+  GraphNumbering<Node *> mNumbering;
+};
+
+using TimeT = std::chrono::duration<double>;
+
+/// Builds a random tree, a parent of each node is chosen from the last
+/// (1 - 1/Width) part of already built nodes, so a larger `Width` produces
+/// a wider tree.
+std::unique_ptr<Tree> initializeTree(std::size_t Size, std::size_t Width) {
+  auto T = make_unique<Tree>();
+  T->Nodes.reserve(Size);
+  T->Nodes.push_back(make_unique<Node>());
+  for (std::size_t I = 1; I < Size; ++I) {
+    auto First = I / Width < I ? I / Width : I - 1;
+    auto *Parent = T->Nodes[First + std::rand() % (I - First)].get();
+    T->Nodes.push_back(make_unique<Node>());
+    auto *N = T->Nodes.back().get();
+    N->Parent = Parent;
+    N->Depth = Parent->Depth + 1;
+    Parent->Children.push_back(N);
+  }
+  return T;
+}
+
+/// Returns a list of random nodes, each query uses `QuerySize` nodes.
+std::vector<Node *> initializeQueries(const Tree &T, std::size_t Size,
+    std::size_t QuerySize) {
+  std::vector<Node *> Queries(Size * QuerySize);
+  for (auto &N : Queries)
+    N = T.Nodes[std::rand() % T.Nodes.size()].get();
+  return Queries;
+}
+
+template<class RelationT>
+TimeT compareTime(const RelationT &STR, const std::vector<Node *> &Queries,
+    std::size_t &Sum) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  for (std::size_t I = 0, EI = Queries.size(); I + 1 < EI; I += 2)
+    Sum += STR.compare(Queries[I], Queries[I + 1]);
+  auto End = std::chrono::high_resolution_clock::now();
+  return End - Start;
+}
+
+TimeT findLCATime(const ParentWalkRelation &STR,
+    const std::vector<Node *> &Queries, std::size_t QuerySize,
+    std::size_t &Sum) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  for (std::size_t I = 0, EI = Queries.size(); I < EI; I += QuerySize)
+    if (auto *LCA = STR.findLCA(&Queries[I], &Queries[I] + QuerySize))
+      Sum += LCA->Depth;
+  auto End = std::chrono::high_resolution_clock::now();
+  return End - Start;
+}
+
+template<class GraphType>
+TimeT findLCATime(const SpanningTreeRelation<GraphType> &STR,
+    const std::vector<Node *> &Queries, std::size_t QuerySize,
+    std::size_t &Sum) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  for (std::size_t I = 0, EI = Queries.size(); I < EI; I += QuerySize)
+    if (auto LCA = findLCA(STR, &Queries[I], &Queries[I] + QuerySize))
+      Sum += (*LCA)->Depth;
+  auto End = std::chrono::high_resolution_clock::now();
+  return End - Start;
+}
+
+void run(std::size_t Size, std::size_t Width, std::size_t QueryNum,
+    std::size_t QuerySize, unsigned MaxIter) {
+  TimeT BuildPW(0), BuildMap(0), BuildIntr(0), BuildIntrCached(0);
+  TimeT ComparePW(0), CompareMap(0), CompareIntr(0);
+  TimeT LCAPW(0), LCAMap(0), LCAIntr(0);
+  std::size_t CompareSumPW{ 0 }, CompareSumMap{ 0 }, CompareSumIntr{ 0 };
+  std::size_t LCASumPW{ 0 }, LCASumMap{ 0 }, LCASumIntr{ 0 };
+  for (unsigned I = 0; I < MaxIter; ++I) {
+    auto T = initializeTree(Size, Width);
+    auto Queries = initializeQueries(*T, QueryNum, QuerySize);
+    auto Start = std::chrono::high_resolution_clock::now();
+    ParentWalkRelation PW(MapTree{ T.get() });
+    auto End = std::chrono::high_resolution_clock::now();
+    BuildPW += End - Start;
+    ComparePW += compareTime(PW, Queries, CompareSumPW);
+    LCAPW += findLCATime(PW, Queries, QuerySize, LCASumPW);
+    Start = std::chrono::high_resolution_clock::now();
+    SpanningTreeRelation<MapTree> Map(MapTree{ T.get() });
+    End = std::chrono::high_resolution_clock::now();
+    BuildMap += End - Start;
+    CompareMap += compareTime(Map, Queries, CompareSumMap);
+    LCAMap += findLCATime(Map, Queries, QuerySize, LCASumMap);
+    Start = std::chrono::high_resolution_clock::now();
+    SpanningTreeRelation<Tree *> Intr(T.get());
+    End = std::chrono::high_resolution_clock::now();
+    BuildIntr += End - Start;
+    // Numbering is shared between relations until a tree is changed.
+    Start = std::chrono::high_resolution_clock::now();
+    SpanningTreeRelation<Tree *> IntrCached(T.get());
+    End = std::chrono::high_resolution_clock::now();
+    BuildIntrCached += End - Start;
+    CompareIntr += compareTime(IntrCached, Queries, CompareSumIntr);
+    LCAIntr += findLCATime(IntrCached, Queries, QuerySize, LCASumIntr);
+  }
+  outs() << "Results for " << __FILE__ << " benchmark\n";
+  outs() << "  date " << __DATE__ << "\n";
+  outs() << "  compiler ";
+#if defined __GNUC__
+  outs() << "GCC " << __GNUC__;
+#elif defined __clang__
+  outs() << "Clang " << __clang__;
+#elif defined _MSC_VER
+  outs() << "Microsoft " << _MSC_VER;
+#else
+  outs() << "unknown";
+#endif
+  outs() << "\n";
+  outs() << "  LLVM version " << LLVM_VERSION_STRING << "\n";
+  outs() << "  TSAR version " << TSAR_VERSION_STRING << "\n";
+  outs() << "  number of nodes " << Size << "\n";
+  outs() << "  average number of children " << Width << "\n";
+  outs() << "  number of queries " << QueryNum << "\n";
+  outs() << "  number of nodes in a query " << QuerySize << "\n";
+  outs() << "  number of iterations " << MaxIter << "\n";
+  outs() << "\n";
+  if (CompareSumMap == CompareSumPW && CompareSumIntr == CompareSumPW)
+    outs() << "  results of compare() are correct\n";
+  else
+    outs() << "  results of compare() are NOT correct\n";
+  if (LCASumMap == LCASumPW && LCASumIntr == LCASumPW)
+    outs() << "  results of findLCA() are correct\n";
+  else
+    outs() << "  results of findLCA() are NOT correct\n";
+  outs() << "\n";
+  std::multimap<double, std::string> Time;
+  Time.emplace((BuildPW / MaxIter).count(),
+    "  parent walk (map) construction time (.s) ");
+  Time.emplace((BuildMap / MaxIter).count(),
+    "  Euler tour (map) construction time (.s) ");
+  Time.emplace((BuildIntr / MaxIter).count(),
+    "  Euler tour (intrusive) construction time (.s) ");
+  Time.emplace((BuildIntrCached / MaxIter).count(),
+    "  Euler tour (intrusive, shared) construction time (.s) ");
+  for (auto &T : Time)
+    outs() << T.second << T.first << "\n";
+  outs() << "\n";
+  Time.clear();
+  Time.emplace((ComparePW / MaxIter).count(),
+    "  parent walk (map) compare() time (.s) ");
+  Time.emplace((CompareMap / MaxIter).count(),
+    "  Euler tour (map) compare() time (.s) ");
+  Time.emplace((CompareIntr / MaxIter).count(),
+    "  Euler tour (intrusive) compare() time (.s) ");
+  for (auto &T : Time)
+    outs() << T.second << T.first << "\n";
+  outs() << "\n";
+  Time.clear();
+  Time.emplace((LCAPW / MaxIter).count(),
+    "  parent walk (map) findLCA() time (.s) ");
+  Time.emplace((LCAMap / MaxIter).count(),
+    "  Euler tour (map) findLCA() time (.s) ");
+  Time.emplace((LCAIntr / MaxIter).count(),
+    "  Euler tour (intrusive) findLCA() time (.s) ");
+  for (auto &T : Time)
+    outs() << T.second << T.first << "\n";
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <number of nodes> [average number of children]"
+    "[number of queries] [number of nodes in a query] [number of iterations]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 6) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  std::size_t Width = (Argc > 2) ? std::atoll(Argv[2]) : 4;
+  std::size_t QueryNum = (Argc > 3) ? std::atoll(Argv[3]) : 1000000;
+  std::size_t QuerySize = (Argc > 4) ? std::atoll(Argv[4]) : 2;
+  unsigned MaxIter = (Argc > 5) ? std::atoi(Argv[5]) : 5;
+  if (Size == 0) {
+    errs() << "error: invalid number of nodes\n" << Help;
+    return 3;
+  }
+  if (Width == 0) {
+    errs() << "error: invalid average number of children\n" << Help;
+    return 4;
+  }
+  if (QueryNum == 0 || QuerySize == 0) {
+    errs() << "error: invalid number of queries\n" << Help;
+    return 5;
+  }
+  if (MaxIter == 0) {
+    errs() << "error: invalid number of iterations\n" << Help;
+    return 6;
+  }
+  run(Size, Width, QueryNum, QuerySize, MaxIter);
+  return 0;
+}
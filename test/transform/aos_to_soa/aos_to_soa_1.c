@@ -0,0 +1,16 @@
+#define N 1000
+
+struct Particle {
+  double X, Y, Z;
+  double VX, VY, VZ;
+};
+
+static struct Particle P[N];
+
+void move(double DT) {
+  for (int I = 0; I < N; ++I)
+    P[I].X += P[I].VX * DT;
+}
+//CHECK: aos_to_soa_1.c:8:24: remark: array of structures 'P' has been converted to structure of arrays
+//CHECK: static struct Particle P[N];
+//CHECK:                        ^
@@ -0,0 +1,18 @@
+#define N 1000
+
+struct Particle {
+  double X, Y, Z;
+  double VX, VY, VZ;
+};
+
+static double P_X[N];
+static double P_Y[N];
+static double P_Z[N];
+static double P_VX[N];
+static double P_VY[N];
+static double P_VZ[N];
+
+void move(double DT) {
+  for (int I = 0; I < N; ++I)
+    P_X[I] += P_VX[I] * DT;
+}
@@ -0,0 +1,20 @@
+struct Particle {
+  double X, Y, Z;
+  double VX, VY, VZ;
+};
+
+static struct Particle P[1000];
+
+struct Particle get(int I) { return P[I]; }
+
+void move(double DT) {
+  for (int I = 0; I < 1000; ++I)
+    P[I].X += P[I].VX * DT;
+}
+//CHECK: aos_to_soa_2.c:6:24: warning: unable to convert array of structures 'P' to structure of arrays
+//CHECK: static struct Particle P[1000];
+//CHECK:                        ^
+//CHECK: aos_to_soa_2.c:8:37: note: array is accessed without selection of a structure field
+//CHECK: struct Particle get(int I) { return P[I]; }
+//CHECK:                                     ^
+//CHECK: 1 warning generated.
@@ -0,0 +1,27 @@
+double A[100];
+
+void init() {
+  for (int I = 0; I < 100; ++I)
+    A[I] = I;
+}
+
+void shift() {
+  double B[100];
+  for (int I = 0; I < 100; ++I)
+    B[I] = A[I];
+  for (int I = 0; I < 99; ++I)
+    A[I] = B[I + 1];
+}
+
+int main() {
+#pragma spf region name(init)
+  {
+    init();
+  }
+#pragma spf region name(shift)
+  {
+    shift();
+  }
+  return 0;
+}
+//CHECK: 
@@ -0,0 +1,36 @@
+#pragma dvm template [100] distribute [block]
+void *dvmh_temp1;
+
+#pragma dvm template [100] distribute [block]
+void *dvmh_temp0;
+
+#pragma dvm array align([iEx1] with dvmh_temp0[iEx1])
+double A[100];
+
+void init() {
+  for (int I = 0; I < 100; ++I)
+    A[I] = I;
+}
+
+void shift() {
+#pragma dvm array align([iEx1] with dvmh_temp1[iEx1])
+  double B[100];
+  for (int I = 0; I < 100; ++I)
+    B[I] = A[I];
+  for (int I = 0; I < 99; ++I)
+    A[I] = B[I + 1];
+}
+
+int main() {
+#pragma spf region name(init)
+  {
+    init();
+  }
+#pragma spf region name(shift)
+#pragma dvm realign(A[iEx1] with dvmh_temp1[iEx1])
+  {
+    shift();
+  }
+#pragma dvm realign(A[iEx1] with dvmh_temp0[iEx1])
+  return 0;
+}
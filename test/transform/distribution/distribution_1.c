@@ -0,0 +1,11 @@
+double A[100], B[100], C[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I) {
+    A[I] = A[I - 1] + 1;
+    B[I] = C[I] * 2;
+  }
+}
+//CHECK: distribution_1.c:4:3: remark: loop has been distributed into 2 loops, 1 of them may be executed in parallel
+//CHECK:   for (int I = 1; I < 100; ++I) {
+//CHECK:   ^
@@ -0,0 +1,9 @@
+double A[100], B[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I) {
+    A[I] = B[I - 1] + 1;
+    B[I] = A[I] * 2;
+  }
+}
+//CHECK: 
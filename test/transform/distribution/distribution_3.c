@@ -0,0 +1,12 @@
+double A[100], B[100], C[100];
+
+void bar(double *);
+
+void foo() {
+  for (int I = 1; I < 100; ++I) {
+    A[I] = A[I - 1] + 1;
+    B[I] = C[I] * 2;
+    bar(&C[I]);
+  }
+}
+//CHECK: 
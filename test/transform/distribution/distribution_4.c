@@ -0,0 +1,11 @@
+double A[100], B[100], C[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I) {
+    A[I] = A[I - 1] + 1;
+    if (C[I] < 0)
+      continue;
+    B[I] = C[I] * 2;
+  }
+}
+//CHECK: 
@@ -0,0 +1,10 @@
+double A[100], B[100], C[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I) {
+    double T = C[I] * 2;
+    A[I] = A[I - 1] + T;
+    B[I] = T;
+  }
+}
+//CHECK: 
@@ -0,0 +1,9 @@
+double A[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I)
+    A[I] = A[I - 1] + 1;
+}
+//CHECK: across_1.c:4:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 1; I < 100; ++I)
+//CHECK:   ^
@@ -0,0 +1,12 @@
+double A[100];
+
+void foo() {
+#pragma dvm actual(A)
+#pragma dvm region in(A) out(A)
+  {
+#pragma dvm parallel (1) across(A[1:0])
+    for (int I = 1; I < 100; ++I)
+      A[I] = A[I - 1] + 1;
+  }
+#pragma dvm get_actual(A)
+}
@@ -0,0 +1,10 @@
+double A[100][100];
+
+void foo() {
+  for (int I = 1; I < 99; ++I)
+    for (int J = 0; J < 100; ++J)
+      A[I][J] = A[I - 1][J] + A[I + 1][J];
+}
+//CHECK: across_2.c:4:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 1; I < 99; ++I)
+//CHECK:   ^
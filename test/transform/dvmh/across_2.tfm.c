@@ -0,0 +1,13 @@
+double A[100][100];
+
+void foo() {
+#pragma dvm actual(A)
+#pragma dvm region in(A) out(A)
+  {
+#pragma dvm parallel (1) across(A[1:1][0:0])
+    for (int I = 1; I < 99; ++I)
+      for (int J = 0; J < 100; ++J)
+        A[I][J] = A[I - 1][J] + A[I + 1][J];
+  }
+#pragma dvm get_actual(A)
+}
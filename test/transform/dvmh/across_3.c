@@ -0,0 +1,17 @@
+double A[100];
+
+void foo() {
+  // Width of the dependence can not be computed for a non-unit stride.
+  for (int I = 1; I < 50; ++I)
+    A[2 * I] = A[2 * I - 2] + 1;
+}
+//CHECK: across_3.c:5:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 1; I < 50; ++I)
+//CHECK:   ^
+//CHECK: across_3.c:5:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 1; I < 50; ++I)
+//CHECK:   ^
+//CHECK: across_3.c:5:3: note: unable to describe loop-carried dependence of 'A' in across clause
+//CHECK:   for (int I = 1; I < 50; ++I)
+//CHECK:   ^
+//CHECK: 1 warning generated.
@@ -0,0 +1,13 @@
+int J;
+double A[100];
+
+void foo() {
+  // 'J' is both first private and last private.
+  for (int I = 0; I < 100; ++I) {
+    J = I + 1;
+    A[I] = I + J;
+  }
+}
+//CHECK: private_1.c:6:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
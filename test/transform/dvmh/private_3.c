@@ -0,0 +1,12 @@
+int J;
+double A[100];
+
+void foo() {
+  for (int I = 99; I >= 0; --I) {
+    J = I + 1;
+    A[I] = I + J;
+  }
+}
+//CHECK: private_3.c:5:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 99; I >= 0; --I) {
+//CHECK:   ^
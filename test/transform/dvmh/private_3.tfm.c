@@ -0,0 +1,23 @@
+int J;
+double A[100];
+
+void foo() {
+  {
+    int J_first0 = J;
+    int J_last0[1] = {J};
+#pragma dvm actual(A, J_first0, J_last0)
+#pragma dvm region in(A, J_first0, J_last0) out(A, J_last0) local(J)
+    {
+#pragma dvm parallel (1) private(J)
+      for (int I = 99; I >= 0; --I) {
+        J = J_first0;
+        J = I + 1;
+        A[I] = I + J;
+        if (I == 0)
+          J_last0[0] = J;
+      }
+    }
+#pragma dvm get_actual(A, J_last0)
+    J = J_last0[0];
+  }
+}
@@ -0,0 +1,22 @@
+int J;
+double A[100];
+
+void foo() {
+  // Copy of a last private variable can not be stored at the end of the body.
+  for (int I = 0; I < 100; ++I) {
+    J = I + 1;
+    if (J > 50)
+      continue;
+    A[I] = I + J;
+  }
+}
+//CHECK: private_4.c:6:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_4.c:6:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_4.c:6:3: note: unable to create copy of first or last private variable 'J'
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: 1 warning generated.
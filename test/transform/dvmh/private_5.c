@@ -0,0 +1,20 @@
+int J;
+double A[100];
+
+void foo() {
+  // The last iteration can not be computed for a non-unit step.
+  for (int I = 0; I < 100; I += 2) {
+    J = I + 1;
+    A[I] = I + J;
+  }
+}
+//CHECK: private_5.c:6:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; I += 2) {
+//CHECK:   ^
+//CHECK: private_5.c:6:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 0; I < 100; I += 2) {
+//CHECK:   ^
+//CHECK: private_5.c:6:3: note: unable to create copy of first or last private variable 'J'
+//CHECK:   for (int I = 0; I < 100; I += 2) {
+//CHECK:   ^
+//CHECK: 1 warning generated.
@@ -0,0 +1,22 @@
+struct S {
+  int X;
+} J;
+double A[100];
+
+void foo() {
+  // Only variables of arithmetic types are copied.
+  for (int I = 0; I < 100; ++I) {
+    J.X = I + 1;
+    A[I] = I + J.X;
+  }
+}
+//CHECK: private_6.c:8:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_6.c:8:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_6.c:8:3: note: unable to create copy of first or last private variable 'J'
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: 1 warning generated.
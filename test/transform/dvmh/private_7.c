@@ -0,0 +1,22 @@
+int J;
+double A[100], B[100];
+
+void foo() {
+  // Global 'J' is hidden by a local variable at the end of the body.
+  for (int I = 0; I < 100; ++I) {
+    J = I + 1;
+    A[I] = J;
+    int J = I;
+    B[I] = J;
+  }
+}
+//CHECK: private_7.c:6:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_7.c:6:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: private_7.c:6:3: note: unable to create copy of first or last private variable 'J'
+//CHECK:   for (int I = 0; I < 100; ++I) {
+//CHECK:   ^
+//CHECK: 1 warning generated.
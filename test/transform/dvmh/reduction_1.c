@@ -0,0 +1,11 @@
+double A[100][10], S[10];
+
+void foo() {
+  // Sum of columns is a reduction over the whole array.
+  for (int I = 0; I < 100; ++I)
+    for (int J = 0; J < 10; ++J)
+      S[J] += A[I][J];
+}
+//CHECK: reduction_1.c:5:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
@@ -0,0 +1,14 @@
+double A[100][10], S[10];
+
+void foo() {
+  // Sum of columns is a reduction over the whole array.
+#pragma dvm actual(A, S)
+#pragma dvm region in(A, S) out(S)
+  {
+#pragma dvm parallel (2) reduction(sum(S))
+    for (int I = 0; I < 100; ++I)
+      for (int J = 0; J < 10; ++J)
+        S[J] += A[I][J];
+  }
+#pragma dvm get_actual(S)
+}
@@ -0,0 +1,9 @@
+double A[100], S[10];
+
+void foo() {
+  for (int I = 0; I < 100; ++I)
+    S[I % 10] += A[I];
+}
+//CHECK: reduction_2.c:4:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
@@ -0,0 +1,12 @@
+double A[100], S[10];
+
+void foo() {
+#pragma dvm actual(A, S)
+#pragma dvm region in(A, S) out(S)
+  {
+#pragma dvm parallel (1) reduction(sum(S))
+    for (int I = 0; I < 100; ++I)
+      S[I % 10] += A[I];
+  }
+#pragma dvm get_actual(S)
+}
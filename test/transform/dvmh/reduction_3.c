@@ -0,0 +1,11 @@
+double A[100];
+
+void foo(double S[10]) {
+  // Reduction over an array which is accessed through a pointer is
+  // accumulated in a local array.
+  for (int I = 0; I < 100; ++I)
+    S[I % 10] += A[I];
+}
+//CHECK: reduction_3.c:6:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
@@ -0,0 +1,21 @@
+double A[100];
+
+void foo(double S[10]) {
+  // Reduction over an array which is accessed through a pointer is
+  // accumulated in a local array.
+  {
+    double S_red0[10];
+    for (int I0 = 0; I0 < 10; ++I0)
+      S_red0[I0] = S[I0];
+#pragma dvm actual(A, S_red0)
+#pragma dvm region in(A, S_red0) out(S_red0)
+    {
+#pragma dvm parallel (1) reduction(sum(S_red0))
+      for (int I = 0; I < 100; ++I)
+        S_red0[I % 10] += A[I];
+    }
+#pragma dvm get_actual(S_red0)
+    for (int I0 = 0; I0 < 10; ++I0)
+      S[I0] = S_red0[I0];
+  }
+}
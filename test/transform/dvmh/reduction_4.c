@@ -0,0 +1,10 @@
+double A[100], B[100], S[10];
+
+void foo() {
+  // Array is also read outside the update, so it is not a reduction.
+  for (int I = 0; I < 100; ++I) {
+    S[I % 10] += A[I];
+    B[I] = S[0];
+  }
+}
+//CHECK: 
@@ -0,0 +1,15 @@
+double A[100], B[100];
+
+void foo() {
+  // Adjacent loops are executed in a single region.
+  for (int I = 0; I < 100; ++I)
+    A[I] = I;
+  for (int I = 0; I < 100; ++I)
+    B[I] = A[I] + 1;
+}
+//CHECK: region_1.c:5:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
+//CHECK: region_1.c:7:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
@@ -0,0 +1,16 @@
+double A[100], B[100];
+
+void foo() {
+  // Adjacent loops are executed in a single region.
+#pragma dvm actual(A, B)
+#pragma dvm region in(A, B) out(A, B)
+  {
+#pragma dvm parallel (1)
+    for (int I = 0; I < 100; ++I)
+      A[I] = I;
+#pragma dvm parallel (1)
+    for (int I = 0; I < 100; ++I)
+      B[I] = A[I] + 1;
+  }
+#pragma dvm get_actual(A, B)
+}
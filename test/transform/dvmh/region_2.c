@@ -0,0 +1,17 @@
+double A[100], B[100];
+
+void foo() {
+  // Data transfers are hoisted out of the time step loop.
+  for (int T = 0; T < 10; ++T) {
+    for (int I = 1; I < 99; ++I)
+      B[I] = A[I - 1] + A[I + 1];
+    for (int I = 1; I < 99; ++I)
+      A[I] = B[I];
+  }
+}
+//CHECK: region_2.c:6:5: remark: parallel execution of loop is possible
+//CHECK:     for (int I = 1; I < 99; ++I)
+//CHECK:     ^
+//CHECK: region_2.c:8:5: remark: parallel execution of loop is possible
+//CHECK:     for (int I = 1; I < 99; ++I)
+//CHECK:     ^
@@ -0,0 +1,18 @@
+double A[100], B[100];
+
+void foo() {
+  // Data transfers are hoisted out of the time step loop.
+#pragma dvm actual(A, B)
+  for (int T = 0; T < 10; ++T) {
+#pragma dvm region in(A, B) out(A, B)
+    {
+#pragma dvm parallel (1)
+      for (int I = 1; I < 99; ++I)
+        B[I] = A[I - 1] + A[I + 1];
+#pragma dvm parallel (1)
+      for (int I = 1; I < 99; ++I)
+        A[I] = B[I];
+    }
+  }
+#pragma dvm get_actual(A, B)
+}
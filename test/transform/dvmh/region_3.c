@@ -0,0 +1,19 @@
+double A[100], B[100];
+
+void foo() {
+  // Host code in the time step loop accesses arrays, so transfers are not
+  // hoisted.
+  for (int T = 0; T < 10; ++T) {
+    for (int I = 1; I < 99; ++I)
+      B[I] = A[I - 1] + A[I + 1];
+    A[0] = B[1];
+    for (int I = 1; I < 99; ++I)
+      A[I] = B[I];
+  }
+}
+//CHECK: region_3.c:7:5: remark: parallel execution of loop is possible
+//CHECK:     for (int I = 1; I < 99; ++I)
+//CHECK:     ^
+//CHECK: region_3.c:10:5: remark: parallel execution of loop is possible
+//CHECK:     for (int I = 1; I < 99; ++I)
+//CHECK:     ^
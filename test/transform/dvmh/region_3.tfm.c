@@ -0,0 +1,25 @@
+double A[100], B[100];
+
+void foo() {
+  // Host code in the time step loop accesses arrays, so transfers are not
+  // hoisted.
+  for (int T = 0; T < 10; ++T) {
+#pragma dvm actual(A, B)
+#pragma dvm region in(A, B) out(B)
+    {
+#pragma dvm parallel (1)
+      for (int I = 1; I < 99; ++I)
+        B[I] = A[I - 1] + A[I + 1];
+    }
+#pragma dvm get_actual(B)
+    A[0] = B[1];
+#pragma dvm actual(A, B)
+#pragma dvm region in(A, B) out(A)
+    {
+#pragma dvm parallel (1)
+      for (int I = 1; I < 99; ++I)
+        A[I] = B[I];
+    }
+#pragma dvm get_actual(A)
+  }
+}
@@ -0,0 +1,16 @@
+double A[100], B[100];
+
+void bar();
+
+void foo() {
+  // A call in the time step loop may access arrays, so transfers are not
+  // hoisted.
+  for (int T = 0; T < 10; ++T) {
+    for (int I = 1; I < 99; ++I)
+      B[I] = A[I - 1] + A[I + 1];
+    bar();
+  }
+}
+//CHECK: region_4.c:9:5: remark: parallel execution of loop is possible
+//CHECK:     for (int I = 1; I < 99; ++I)
+//CHECK:     ^
@@ -0,0 +1,19 @@
+double A[100], B[100];
+
+void bar();
+
+void foo() {
+  // A call in the time step loop may access arrays, so transfers are not
+  // hoisted.
+  for (int T = 0; T < 10; ++T) {
+#pragma dvm actual(A, B)
+#pragma dvm region in(A, B) out(B)
+    {
+#pragma dvm parallel (1)
+      for (int I = 1; I < 99; ++I)
+        B[I] = A[I - 1] + A[I + 1];
+    }
+#pragma dvm get_actual(B)
+    bar();
+  }
+}
@@ -0,0 +1,16 @@
+double A[100];
+
+void foo() {
+  for (int I = 1; I < 100; ++I)
+    A[I] = A[I - 1] + 1;
+}
+//CHECK: carried_1.c:4:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 1; I < 100; ++I)
+//CHECK:   ^
+//CHECK: carried_1.c:4:3: warning: unable to create parallel directive
+//CHECK:   for (int I = 1; I < 100; ++I)
+//CHECK:   ^
+//CHECK: carried_1.c:4:3: note: loop-carried dependence prevents parallel execution
+//CHECK:   for (int I = 1; I < 100; ++I)
+//CHECK:   ^
+//CHECK: 1 warning generated.
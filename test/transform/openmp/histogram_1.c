@@ -0,0 +1,7 @@
+void histogram(int N, const unsigned char *restrict Img, int *restrict H) {
+  for (int I = 0; I < N; ++I)
+    H[Img[I]] += 1;
+}
+//CHECK: histogram_1.c:2:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < N; ++I)
+//CHECK:   ^
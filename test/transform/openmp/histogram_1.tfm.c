@@ -0,0 +1,5 @@
+void histogram(int N, const unsigned char *restrict Img, int *restrict H) {
+#pragma omp parallel for default(shared) reduction(+ : H[0 : 256])
+  for (int I = 0; I < N; ++I)
+    H[Img[I]] += 1;
+}
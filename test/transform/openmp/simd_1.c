@@ -0,0 +1,12 @@
+double A[100];
+
+void foo() {
+  for (int I = 0; I < 96; ++I)
+    A[I + 4] = A[I] + 1;
+}
+//CHECK: simd_1.c:4:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < 96; ++I)
+//CHECK:   ^
+//CHECK: simd_1.c:4:3: remark: vectorization of loop is possible if at most 4 iterations are executed concurrently
+//CHECK:   for (int I = 0; I < 96; ++I)
+//CHECK:   ^
@@ -0,0 +1,7 @@
+double A[100];
+
+void foo() {
+#pragma omp simd safelen(4)
+  for (int I = 0; I < 96; ++I)
+    A[I + 4] = A[I] + 1;
+}
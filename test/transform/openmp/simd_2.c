@@ -0,0 +1,12 @@
+double sum(int N, double *A) {
+  double S = 0;
+  for (int I = 0; I < N; ++I)
+    S += A[I];
+  return S;
+}
+//CHECK: simd_2.c:3:3: remark: parallel execution of loop is possible
+//CHECK:   for (int I = 0; I < N; ++I)
+//CHECK:   ^
+//CHECK: simd_2.c:3:3: remark: vectorization of loop is possible
+//CHECK:   for (int I = 0; I < N; ++I)
+//CHECK:   ^
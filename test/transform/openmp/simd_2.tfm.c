@@ -0,0 +1,7 @@
+double sum(int N, double *A) {
+  double S = 0;
+#pragma omp simd reduction(+:S)
+  for (int I = 0; I < N; ++I)
+    S += A[I];
+  return S;
+}
@@ -0,0 +1,13 @@
+void bar(double *X);
+
+void foo(double *A) {
+  for (int I = 0; I < 100; ++I)
+    bar(&A[I]);
+}
+//CHECK: simd_4.c:4:3: warning: unable to create simd directive
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
+//CHECK: simd_4.c:4:3: note: call of a function which accesses memory prevents vectorization
+//CHECK:   for (int I = 0; I < 100; ++I)
+//CHECK:   ^
+//CHECK: 1 warning generated.
@@ -1413,7 +1413,7 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
             if (!TmpLoc.isValid()) {
               AddressOS << "sapfor.invalid";
             } else {
-              if (!unparsePrint(dwarf::DW_LANG_C, TmpLoc, AddressOS))
+              if (!unparsePrint(dwarf::DW_LANG_C, *ClonedDIEM, AddressOS))
                 AddressOS << "?";
               auto Size = TmpLoc.getSize();
               if (Size != MemoryLocation::UnknownSize)
@@ -28,8 +28,10 @@
 #include <llvm/Support/ManagedStatic.h>
 #include <llvm/Support/PrettyStackTrace.h>
 #include <llvm/Support/Signals.h>
+#include <llvm/TableGen/Error.h>
 #include <llvm/TableGen/Main.h>
 #include <llvm/TableGen/Record.h>
+#include <algorithm>
 
 using namespace llvm;
 
@@ -38,6 +40,7 @@ enum ActionType {
   GenTSARIntrinsicsDefs,
   GenTSARDirectivesDefs,
   GenTSARAttrubutesDefs,
+  GenTSARLibraryFunctionsDefs,
 };
 
 namespace {
@@ -50,7 +53,10 @@ namespace {
          cl::values(clEnumValN(GenTSARIntrinsicsDefs,"gen-tsar-intrinsics-defs",
                                "Generate TSAR intrinsics definitions")),
          cl::values(clEnumValN(GenTSARAttrubutesDefs,"gen-tsar-attributes-defs",
-                               "Generate TSAR attributes definitions")));
+                               "Generate TSAR attributes definitions")),
+         cl::values(clEnumValN(GenTSARLibraryFunctionsDefs,
+                               "gen-tsar-library-functions-defs",
+                               "Generate TSAR library functions definitions")));
 
 void GenFileHeader(raw_ostream &OS) {
   OS << "\
@@ -301,6 +307,60 @@ void GenAttributeNameList(raw_ostream &OS, RecordKeeper &Records) {
   OS << "#endif\n\n";
 }
 
+//===----------------------------------------------------------------------===//
+// Generate TSAR library functions definitions.
+//===----------------------------------------------------------------------===//
+
+void GenLibraryFunctionTables(raw_ostream &OS, RecordKeeper &Records) {
+  auto Funcs = Records.getAllDerivedDefinitions("LibraryFunction");
+  std::sort(Funcs.begin(), Funcs.end(), [](Record *LHS, Record *RHS) {
+    return LHS->getValueAsString("Name") < RHS->getValueAsString("Name");
+  });
+  for (unsigned I = 1, EI = Funcs.size(); I < EI; ++I)
+    if (Funcs[I - 1]->getValueAsString("Name") ==
+        Funcs[I]->getValueAsString("Name"))
+      PrintFatalError(Funcs[I]->getLoc(), "Library function '" +
+        Funcs[I]->getValueAsString("Name") + "' is already defined");
+  OS << "// Library function summaries sorted by name\n";
+  OS << "// #define LIBRARY_FUNCTION(Name, Properties, VarArgAccess, "
+        "ArgStart, ArgEnd) ...\n";
+  OS << "// #define PROPERTY(Kind) ...\n";
+  OS << "#ifdef GET_LIBRARY_FUNCTION_TABLE\n";
+  unsigned Offset = 0;
+  for (Record *Rec : Funcs) {
+    OS << "  LIBRARY_FUNCTION(\"";
+    OS.write_escaped(Rec->getValueAsString("Name")) << "\",";
+    for (Record *Property : Rec->getValueAsListOfDefs("Properties"))
+      OS << " PROPERTY(" << Property->getName() << ")";
+    auto NumArgs = Rec->getValueAsListOfDefs("Args").size();
+    OS << ", " << Rec->getValueAsDef("VarArgAccess")->getName()
+       << ", " << Offset << ", " << Offset + NumArgs << ")\n";
+    Offset += NumArgs;
+  }
+  OS << "#endif\n\n";
+  OS << "// Summaries of pointer arguments in the order of library functions\n";
+  OS << "// #define ARGUMENT(Idx, Access, NoCapture) ...\n";
+  OS << "#ifdef GET_LIBRARY_FUNCTION_ARGUMENT_TABLE\n";
+  for (Record *Rec : Funcs) {
+    auto Args = Rec->getValueAsListOfDefs("Args");
+    std::sort(Args.begin(), Args.end(), [](Record *LHS, Record *RHS) {
+      return LHS->getValueAsInt("Idx") < RHS->getValueAsInt("Idx");
+    });
+    for (unsigned I = 0, EI = Args.size(); I < EI; ++I) {
+      if (I > 0 &&
+          Args[I - 1]->getValueAsInt("Idx") == Args[I]->getValueAsInt("Idx"))
+        PrintFatalError(Rec->getLoc(), "Argument " +
+          Twine(Args[I]->getValueAsInt("Idx")) + " of library function '" +
+          Rec->getValueAsString("Name") + "' is described twice");
+      OS << "  ARGUMENT(" << Args[I]->getValueAsInt("Idx") << ", "
+         << Args[I]->getValueAsDef("Access")->getName() << ", "
+         << (Args[I]->getValueAsBit("NoCapture") ? "true" : "false") << ")";
+      OS << "                // " << Rec->getValueAsString("Name") << "\n";
+    }
+  }
+  OS << "#endif\n\n";
+}
+
 bool LLVMTableGenMain(raw_ostream &OS, RecordKeeper &Records) {
   GenFileHeader(OS);
   switch (Action) {
@@ -323,6 +383,9 @@ bool LLVMTableGenMain(raw_ostream &OS, RecordKeeper &Records) {
     GenAttributeIdList(OS, Records);
     GenAttributeNameList(OS, Records);
     break;
+  case GenTSARLibraryFunctionsDefs:
+    GenLibraryFunctionTables(OS, Records);
+    break;
   case GenTSARDirectivesDefs:
     GenExprKindList(OS, Records);
     GenNamespaceIdList(OS, Records);